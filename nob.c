@@ -1,5 +1,8 @@
 #define DEV
 
+// Uncomment to compile out profiler zones inserted with @Profile meta notes.
+// #define PROFILE_NOTES_DISABLE
+
 
 // Defining flags.
 #ifdef DEV
@@ -19,6 +22,7 @@
 #define BIN_DIR     "bin"
 #define BUILD_DIR   "build"
 #define SRC_DIR     "src"
+#define RES_DIR     "res"
 
 
 
@@ -93,6 +97,70 @@ bool nob_cmd_append_all_in_dir(Nob_Cmd *cmd, const char *directory, const char *
 }
 
 
+/**
+ * Removes argument equal to "item" from the command, if there is one.
+ */
+void nob_cmd_remove(Nob_Cmd *cmd, const char *item) {
+    for (size_t i = 0; i < cmd->count; i++) {
+        if (strcmp(cmd->items[i], item) == 0) {
+            memmove(cmd->items + i, cmd->items + i + 1, (cmd->count - i - 1) * sizeof(cmd->items[0]));
+            cmd->count--;
+            return;
+        }
+    }
+}
+
+
+/**
+ * Appends paths of all files with one of the formats inside directory and its subdirectories.
+ */
+bool nob_cmd_append_all_in_dir_recursively(Nob_Cmd *cmd, const char *directory, const char **file_formats, size_t file_formats_count) {
+    Nob_File_Paths paths = {0};
+    if (!nob_read_entire_dir(directory, &paths)) return false;
+
+    Nob_String_Builder path_builder = {0};
+    bool result = true;
+
+    for (size_t i = 0; i < paths.count && result; i++) {
+        if (strcmp(paths.items[i], ".") == 0) continue;
+        if (strcmp(paths.items[i], "..") == 0) continue;
+
+        path_builder.count = 0;
+        nob_sb_append_cstr(&path_builder, directory);
+        nob_sb_append_cstr(&path_builder, "/");
+        nob_sb_append_cstr(&path_builder, paths.items[i]);
+        nob_sb_append_null(&path_builder);
+
+        Nob_File_Type type = nob_get_file_type(path_builder.items);
+        if (type == NOB_FILE_DIRECTORY) {
+            result = nob_cmd_append_all_in_dir_recursively(cmd, path_builder.items, file_formats, file_formats_count);
+            continue;
+        }
+
+        char *format = strrchr(path_builder.items, '.');
+        if (type != NOB_FILE_REGULAR || format == NULL) continue;
+
+        for (size_t f = 0; f < file_formats_count; f++) {
+            if (strcmp(format, file_formats[f]) != 0) continue;
+
+            char *saved = save_string(path_builder.items);
+            if (saved == NULL) {
+                nob_log(NOB_ERROR, "Couldn't save string, not enough space.");
+                result = false;
+                break;
+            }
+
+            nob_cmd_append(cmd, saved);
+        }
+    }
+
+    nob_sb_free(path_builder);
+    nob_da_free(paths);
+
+    return result;
+}
+
+
 /**
  * Compiles all .c files inside directory into .o files.
  */
@@ -162,10 +230,16 @@ bool nob_cc_compile_objs(Nob_Cmd *cmd, const char *source, const char *output) {
  *
  *      $ ./nob
  *
+ * Cook images inside res into .tex files, only images that changed are cooked again:
+ *
+ *      $ ./nob cook
+ *
  */
 int main(int argc, char **argv) {
     NOB_GO_REBUILD_URSELF(argc, argv);
 
+    bool cook = argc > 1 && strcmp(argv[1], "cook") == 0;
+
     Nob_Cmd cmd = {0};
 
     // Create basic dirs if they don't exist.
@@ -220,6 +294,45 @@ int main(int argc, char **argv) {
     reset_saved_strings();
 
 
+    // Building bench.exe, it only needs core, meta lexer, vars and particles, so it doesn't depend on meta generated files.
+    nob_cc(&cmd);
+    nob_cc_flags(&cmd);
+    nob_cc_output(&cmd, BIN_DIR"/bench.exe");
+    nob_cc_includes(&cmd);
+    nob_cmd_append_all_in_dir(&cmd, SRC_DIR"/bench", ".c");
+    nob_cmd_append(&cmd, SRC_DIR"/meta/lexer.c", SRC_DIR"/game/vars.c", SRC_DIR"/game/particles.c");
+    nob_cmd_append(&cmd, "-L"BIN_DIR, "-lcore");
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    reset_saved_strings();
+
+
+    // Building cook.exe, it only needs core and stb_image.
+    nob_cc(&cmd);
+    nob_cc_flags(&cmd);
+    nob_cc_output(&cmd, BIN_DIR"/cook.exe");
+    nob_cc_includes(&cmd);
+    nob_cmd_append_all_in_dir(&cmd, SRC_DIR"/cook", ".c");
+    nob_cmd_append(&cmd, "-L"BIN_DIR, "-lcore");
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    reset_saved_strings();
+
+
+    // Running cook.exe instead of building the game.
+    if (cook) {
+        const char *image_formats[] = { ".png", ".jpg" };
+
+        nob_cmd_append(&cmd, BIN_DIR"/cook.exe");
+        if (!nob_cmd_append_all_in_dir_recursively(&cmd, RES_DIR, image_formats, NOB_ARRAY_LEN(image_formats))) return 1;
+
+        if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+        reset_saved_strings();
+
+        return 0;
+    }
+
+
     // Running meta.exe
     nob_cmd_append(&cmd, BIN_DIR"/meta.exe");
     nob_cmd_append(&cmd, "-in");
@@ -249,6 +362,9 @@ int main(int argc, char **argv) {
     nob_cc_flags(&cmd);
     nob_cc_output(&cmd, BIN_DIR"/main.exe");
     nob_cmd_append(&cmd, "-I"BUILD_DIR"/"SRC_DIR);
+#ifdef PROFILE_NOTES_DISABLE
+    nob_cmd_append(&cmd, "-DPROFILE_NOTES_DISABLE");
+#endif
 
     // nob_cmd_append(&cmd, BUILD_DIR"/"SRC_DIR"/meta_generated.c");
     nob_cmd_append_all_in_dir(&cmd, BUILD_DIR"/"SRC_DIR"/game", ".c");
@@ -259,6 +375,30 @@ int main(int argc, char **argv) {
     if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
     reset_saved_strings();
 
+
+    // Building test.exe, it links the same meta generated game files as main.exe, except the one with main().
+    // Tests themselves are not meta processed, so build/src comes first for game headers to be the generated ones.
+    nob_cc(&cmd);
+    nob_cc_flags(&cmd);
+    nob_cc_output(&cmd, BIN_DIR"/test.exe");
+    nob_cmd_append(&cmd, "-I"BUILD_DIR"/"SRC_DIR);
+    nob_cc_includes(&cmd);
+#ifdef PROFILE_NOTES_DISABLE
+    nob_cmd_append(&cmd, "-DPROFILE_NOTES_DISABLE");
+#endif
+    // Vertex stream test wraps the ring in the fallback mode, hardware that needs it is rare, so it is tested here.
+    nob_cmd_append(&cmd, "-DVERTEX_STREAM_FORCE_MODE=VERTEX_STREAM_ORPHAN");
+
+    nob_cmd_append_all_in_dir(&cmd, SRC_DIR"/test", ".c");
+    nob_cmd_append_all_in_dir(&cmd, BUILD_DIR"/"SRC_DIR"/game", ".c");
+    nob_cmd_remove(&cmd, BUILD_DIR"/"SRC_DIR"/game/main.c");
+
+    nob_cmd_append(&cmd, "-L"BIN_DIR, "-lcore");
+    nob_cc_libs(&cmd);
+
+    if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+    reset_saved_strings();
+
     return 0;
 }
 
@@ -2,19 +2,20 @@
 
 #ifdef VERTEX
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec4 color;
-layout(location = 2) in vec2 uv0;
-layout(location = 3) in float tex_index;
-layout(location = 4) in float mask_index;
+// Packing should match "Quad_Vertex" struct.
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color;         // @Packed: unorm8.
+layout(location = 2) in vec2 uv0;           // @Packed: unorm16.
+layout(location = 3) in float tex_index;    // @Packed: u8.
+layout(location = 4) in float mask_index;   // @Packed: u8.
 
 layout(location = 0) uniform mat4 pr_matrix;
 layout(location = 4) uniform mat4 ml_matrix;
 
 out vec4 v_color;
 out vec2 v_uv0;
-out float v_tex_index;
-out float v_mask_index;
+flat out float v_tex_index;
+flat out float v_mask_index;
 
 void main() {
     v_color = color;
@@ -22,7 +23,7 @@ void main() {
     v_tex_index = tex_index;
     v_mask_index = mask_index;
 
-    gl_Position = pr_matrix * ml_matrix * vec4(position, 1.0);
+    gl_Position = pr_matrix * ml_matrix * vec4(position, 0.0, 1.0);
 }
 
 #endif
@@ -33,17 +34,27 @@ layout(location = 0) out vec4 color;
 
 in vec4 v_color;
 in vec2 v_uv0;
-in float v_tex_index;
-in float v_mask_index;
+flat in float v_tex_index;
+flat in float v_mask_index;
 
 layout(location = 8) uniform sampler2D u_textures[32];
 
+// Mask slots with 128 bit set are distance fields with edge at 0.5, others are coverage.
+float mask_alpha(int mask_index, vec2 uv) {
+    float value = texture(u_textures[mask_index & 127], uv).x;
+    if (mask_index < 128) {
+        return value;
+    }
+    float width = max(fwidth(value), 0.0001) * 0.5;
+    return smoothstep(0.5 - width, 0.5 + width, value);
+}
+
 void main() {
     int tex_index = int(v_tex_index);
     int mask_index = int(v_mask_index);
 
-    // Base color.
-    if (tex_index == -1) {
+    // Base color, slot 255 means no texture.
+    if (tex_index == 255) {
         color = v_color;
     }
     else {
@@ -51,8 +62,8 @@ void main() {
     }
 
     // Applying mask.
-    if (mask_index != -1) {
-        color.w = texture(u_textures[mask_index], v_uv0).x * color.w;
+    if (mask_index != 255) {
+        color.w = mask_alpha(mask_index, v_uv0) * color.w;
     }
 
 
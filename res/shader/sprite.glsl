@@ -0,0 +1,86 @@
+#version 430 core
+
+// @Instanced.
+
+#ifdef VERTEX
+
+// Packing should match "Sprite_Instance" struct.
+layout(location = 0) in vec2 center;
+layout(location = 1) in vec2 half_size;
+layout(location = 2) in float rotation;
+layout(location = 3) in vec4 color;         // @Packed: unorm8.
+layout(location = 4) in vec4 uv_rect;       // @Packed: unorm16.
+layout(location = 5) in float tex_index;    // @Packed: u8.
+layout(location = 6) in float mask_index;   // @Packed: u8.
+
+layout(location = 0) uniform mat4 pr_matrix;
+layout(location = 4) uniform mat4 ml_matrix;
+
+out vec4 v_color;
+out vec2 v_uv0;
+flat out float v_tex_index;
+flat out float v_mask_index;
+
+// Unit quad as triangle strip: bottom left, bottom right, top left, top right.
+const vec2 corners[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
+
+void main() {
+    vec2 corner = corners[gl_VertexID];
+
+    v_color = color;
+    v_uv0 = mix(uv_rect.xy, uv_rect.zw, corner);
+    v_tex_index = tex_index;
+    v_mask_index = mask_index;
+
+    vec2 local = (corner * 2.0 - 1.0) * half_size;
+    float c = cos(rotation);
+    float s = sin(rotation);
+    vec2 position = center + vec2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    gl_Position = pr_matrix * ml_matrix * vec4(position, 0.0, 1.0);
+}
+
+#endif
+
+#ifdef FRAGMENT
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_color;
+in vec2 v_uv0;
+flat in float v_tex_index;
+flat in float v_mask_index;
+
+layout(location = 8) uniform sampler2D u_textures[32];
+
+// Mask slots with 128 bit set are distance fields with edge at 0.5, others are coverage.
+float mask_alpha(int mask_index, vec2 uv) {
+    float value = texture(u_textures[mask_index & 127], uv).x;
+    if (mask_index < 128) {
+        return value;
+    }
+    float width = max(fwidth(value), 0.0001) * 0.5;
+    return smoothstep(0.5 - width, 0.5 + width, value);
+}
+
+void main() {
+    int tex_index = int(v_tex_index);
+    int mask_index = int(v_mask_index);
+
+    // Base color, slot 255 means no texture.
+    if (tex_index == 255) {
+        color = v_color;
+    }
+    else {
+        color = texture(u_textures[tex_index], v_uv0);
+    }
+
+    // Applying mask.
+    if (mask_index != 255) {
+        color.w = mask_alpha(mask_index, v_uv0) * color.w;
+    }
+
+
+}
+
+#endif
@@ -1,28 +1,36 @@
 #version 430 core
 
+// @Instanced.
+
 #ifdef VERTEX
 
-layout(location = 0) in vec3 position;
-layout(location = 1) in vec4 color;
-layout(location = 2) in vec2 uv0;
-layout(location = 3) in vec2 size;
-layout(location = 4) in float mask_index;
+// Packing should match "UI_Quad_Instance" struct.
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec2 size;
+layout(location = 2) in vec4 color;         // @Packed: unorm8.
+layout(location = 3) in vec4 uv_rect;       // @Packed: unorm16.
+layout(location = 4) in float mask_index;   // @Packed: u8.
 
 layout(location = 0) uniform mat4 pr_matrix;
 layout(location = 4) uniform mat4 ml_matrix;
 
 out vec4 v_color;
 out vec2 v_uv0;
-out vec2 v_size;
-out float v_mask_index;
+flat out vec2 v_size;
+flat out float v_mask_index;
+
+// Unit quad as triangle strip: bottom left, bottom right, top left, top right.
+const vec2 corners[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 1.0));
 
 void main() {
+    vec2 corner = corners[gl_VertexID];
+
     v_color = color;
-    v_uv0 = uv0;
+    v_uv0 = mix(uv_rect.xy, uv_rect.zw, corner);
     v_size = size;
     v_mask_index = mask_index;
 
-    gl_Position = pr_matrix * ml_matrix * vec4(position, 1.0);
+    gl_Position = pr_matrix * ml_matrix * vec4(position + corner * size, 0.0, 1.0);
 }
 
 #endif
@@ -36,17 +44,28 @@ layout(location = 8) uniform sampler2D u_textures[32];
 
 in vec4 v_color;
 in vec2 v_uv0;
-in vec2 v_size;
-in float v_mask_index;
+flat in vec2 v_size;
+flat in float v_mask_index;
 
 #define ROUNDNESS 3.0
 #define BORDER 1.0
 #define AA 1.0
 
+// Mask slots with 128 bit set are distance fields with edge at 0.5, others are coverage.
+float mask_alpha(int mask_index, vec2 uv) {
+    float value = texture(u_textures[mask_index & 127], uv).x;
+    if (mask_index < 128) {
+        return value;
+    }
+    float width = max(fwidth(value), 0.0001) * 0.5;
+    return smoothstep(0.5 - width, 0.5 + width, value);
+}
+
 void main() {
     int mask_index = int(v_mask_index);
 
-    if (mask_index == -1) {
+    // Slot 255 means no mask, so rect is drawn.
+    if (mask_index == 255) {
         vec2 uv = (v_uv0 - 0.5) * 2;
         vec2 scale = vec2(v_size.x / ROUNDNESS * 0.5, v_size.y / ROUNDNESS * 0.5);
         uv.x *= scale.x;
@@ -63,7 +82,7 @@ void main() {
         color = vec4(fill_rgb, alpha);
     } else {
         color = v_color;
-        color.w = texture(u_textures[mask_index], v_uv0).x * color.w;
+        color.w = mask_alpha(mask_index, v_uv0) * color.w;
     }
 
 }
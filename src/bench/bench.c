@@ -0,0 +1,264 @@
+#include "bench/bench.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/file.h"
+#include "core/structs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define BENCH_TARGET_NS     50000000ull     // Each measured run should take at least 50ms.
+#define BENCH_MAX_OPS       1000000000ll
+#define BENCH_SAMPLES       5
+
+#ifdef NDEBUG
+static const char *BENCH_BUILD = "release";
+#else
+static const char *BENCH_BUILD = "debug";
+#endif
+
+
+
+void bench_start(Bench *b) {
+    b->start_ns = get_time_ns();
+}
+
+void bench_stop(Bench *b) {
+    b->elapsed_ns += get_time_ns() - b->start_ns;
+}
+
+
+
+static Bench bench_run_ops(Bench_Case *bench_case, s64 ops) {
+    Bench b = { .ops = ops };
+    bench_case->procedure(&b);
+    return b;
+}
+
+static int bench_compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+Bench_Result bench_run(Bench_Case *bench_case) {
+    // Growing ops count until single run is long enough to measure.
+    s64 ops = 1;
+    Bench b = bench_run_ops(bench_case, ops);
+
+    while (b.elapsed_ns < BENCH_TARGET_NS && ops < BENCH_MAX_OPS) {
+        s64 next = ops * 100;
+        if (b.elapsed_ns > 0) {
+            // Predicting needed ops with 20% overshoot, but not growing more than 100x at once.
+            next = (s64)((double)BENCH_TARGET_NS * 1.2 * (double)ops / (double)b.elapsed_ns);
+            next = next > ops * 100 ? ops * 100 : next;
+        }
+        ops = next > ops ? next : ops + 1;
+        ops = ops > BENCH_MAX_OPS ? BENCH_MAX_OPS : ops;
+
+        b = bench_run_ops(bench_case, ops);
+    }
+
+    // Sampling, reporting the median.
+    double samples[BENCH_SAMPLES];
+    for (s64 i = 0; i < BENCH_SAMPLES; i++) {
+        b = bench_run_ops(bench_case, ops);
+        samples[i] = (double)b.elapsed_ns / (double)ops;
+    }
+
+    qsort(samples, BENCH_SAMPLES, sizeof(double), bench_compare_doubles);
+    double ns_per_op = samples[BENCH_SAMPLES / 2];
+
+    return (Bench_Result) {
+        .name           = CSTR((char *)bench_case->name),
+        .ops            = ops,
+        .ns_per_op      = ns_per_op,
+        .ops_per_second = ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0,
+        .bytes_per_op   = (double)b.bytes_per_op,
+    };
+}
+
+
+
+
+
+int bench_write_json(Bench_Result *results, s64 count, char *file_path) {
+    FILE *file = stdout;
+    if (file_path != NULL) {
+        file = fopen(file_path, "wb");
+        if (file == NULL) {
+            printf_err("Couldn't open '%s' to write benchmark results.\n", file_path);
+            return 1;
+        }
+    }
+
+    fprintf(file, "{\n  \"build\": \"%s\",\n  \"benchmarks\": [\n", BENCH_BUILD);
+    for (s64 i = 0; i < count; i++) {
+        fprintf(file, "    { \"name\": \"%.*s\", \"ops\": %lld, \"ns_per_op\": %.3f, \"ops_per_second\": %.1f, \"bytes_per_op\": %.1f }%s\n",
+                (int)results[i].name.length, results[i].name.data, (long long)results[i].ops, results[i].ns_per_op, results[i].ops_per_second, results[i].bytes_per_op, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if (file != stdout) {
+        fclose(file);
+    }
+
+    return 0;
+}
+
+
+
+
+
+/**
+ * Finds "key" inside of the JSON object and returns value that follows it, value ends at ',', '}' or '"'.
+ * Returns empty string if key is not found.
+ */
+static String bench_json_value(String object, String key) {
+    s64 index = str_find(object, key);
+    if (index == -1) {
+        return STR(0, object.data);
+    }
+
+    String value = str_eat_chars(object, index + key.length);
+    value = str_eat_chars(value, str_find_char_left(value, ':') + 1);
+    value = str_eat_spaces(value);
+
+    if (value.length > 0 && value.data[0] == '"') {
+        value = str_eat_chars(value, 1);
+        return str_substring(value, 0, str_find_char_left(value, '"'));
+    }
+
+    s64 end = 0;
+    while (end < value.length && value.data[end] != ',' && value.data[end] != '}' && value.data[end] != '\n') {
+        end++;
+    }
+    return str_substring(value, 0, end);
+}
+
+static double bench_json_number(String object, String key) {
+    String value = bench_json_value(object, key);
+
+    char buffer[64];
+    s64 length = value.length < 63 ? value.length : 63;
+    memcpy(buffer, value.data, length);
+    buffer[length] = '\0';
+
+    return strtod(buffer, NULL);
+}
+
+/**
+ * Reads results written by "bench_write_json()", names point into "content".
+ */
+static Bench_Result *bench_read_json(String content, String *build) {
+    Bench_Result *results = array_list_make(Bench_Result, 32, &std_allocator);
+
+    *build = bench_json_value(content, CSTR("\"build\""));
+
+    s64 index = str_find(content, CSTR("\"benchmarks\""));
+    if (index == -1) {
+        return results;
+    }
+    String rest = str_eat_chars(content, index);
+
+    while (true) {
+        s64 open = str_find_char_left(rest, '{');
+        if (open == -1) break;
+        rest = str_eat_chars(rest, open);
+
+        s64 close = str_find_char_left(rest, '}');
+        if (close == -1) break;
+
+        String object = str_substring(rest, 0, close + 1);
+        rest = str_eat_chars(rest, close + 1);
+
+        Bench_Result result = {
+            .name           = bench_json_value(object, CSTR("\"name\"")),
+            .ops            = (s64)bench_json_number(object, CSTR("\"ops\"")),
+            .ns_per_op      = bench_json_number(object, CSTR("\"ns_per_op\"")),
+            .ops_per_second = bench_json_number(object, CSTR("\"ops_per_second\"")),
+            .bytes_per_op   = bench_json_number(object, CSTR("\"bytes_per_op\"")),
+        };
+        array_list_append(&results, result);
+    }
+
+    return results;
+}
+
+int bench_compare(char *old_path, char *new_path, double threshold_percent) {
+    String old_content = read_file_into_str(old_path, &std_allocator);
+    if (old_content.data == NULL) {
+        printf_err("Couldn't read '%s'.\n", old_path);
+        return -1;
+    }
+
+    String new_content = read_file_into_str(new_path, &std_allocator);
+    if (new_content.data == NULL) {
+        printf_err("Couldn't read '%s'.\n", new_path);
+        allocator_free(&std_allocator, old_content.data);
+        return -1;
+    }
+
+    String old_build, new_build;
+    Bench_Result *old_results = bench_read_json(old_content, &old_build);
+    Bench_Result *new_results = bench_read_json(new_content, &new_build);
+
+    if (!str_equals(old_build, new_build)) {
+        printf("Warning: comparing '%.*s' build against '%.*s' build, results are not comparable.\n\n", (int)old_build.length, old_build.data, (int)new_build.length, new_build.data);
+    }
+
+    printf("%-36s %14s %14s %10s\n", "benchmark", "old ns/op", "new ns/op", "change");
+
+    s64 regressions = 0;
+    for (u32 i = 0; i < array_list_length(&new_results); i++) {
+        Bench_Result *new_result = new_results + i;
+
+        Bench_Result *old_result = NULL;
+        for (u32 j = 0; j < array_list_length(&old_results); j++) {
+            if (str_equals(old_results[j].name, new_result->name)) {
+                old_result = old_results + j;
+                break;
+            }
+        }
+
+        if (old_result == NULL) {
+            printf("%-36.*s %14s %14.3f %10s\n", (int)new_result->name.length, new_result->name.data, "-", new_result->ns_per_op, "new");
+            continue;
+        }
+
+        double change = old_result->ns_per_op > 0.0 ? (new_result->ns_per_op - old_result->ns_per_op) / old_result->ns_per_op * 100.0 : 0.0;
+        bool regressed = change > threshold_percent;
+        regressions += regressed;
+
+        printf("%-36.*s %14.3f %14.3f %+9.1f%%%s\n", (int)new_result->name.length, new_result->name.data, old_result->ns_per_op, new_result->ns_per_op, change, regressed ? "  REGRESSION" : "");
+    }
+
+    for (u32 j = 0; j < array_list_length(&old_results); j++) {
+        bool found = false;
+        for (u32 i = 0; i < array_list_length(&new_results); i++) {
+            if (str_equals(old_results[j].name, new_results[i].name)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            printf("%-36.*s %14.3f %14s %10s\n", (int)old_results[j].name.length, old_results[j].name.data, old_results[j].ns_per_op, "-", "removed");
+        }
+    }
+
+    if (regressions > 0) {
+        printf("\n%lld benchmark(s) regressed by more than %.1f%%.\n", (long long)regressions, threshold_percent);
+    }
+
+    array_list_free(&old_results);
+    array_list_free(&new_results);
+    allocator_free(&std_allocator, old_content.data);
+    allocator_free(&std_allocator, new_content.data);
+
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/**
+ * Benchmarks.
+ *
+ * Each benchmark is a procedure that runs its operation "b->ops" times between "bench_start()" and "bench_stop()":
+ *
+ *      void bench_foo(Bench *b) {
+ *          ... setup, not measured ...
+ *          bench_start(b);
+ *          for (s64 i = 0; i < b->ops; i++) {
+ *              foo();
+ *          }
+ *          bench_stop(b);
+ *          b->bytes_per_op = ...;  // Optional.
+ *      }
+ *
+ * Harness grows "ops" until a run takes long enough, then repeats the run several times and reports the median.
+ */
+
+#include "core/type.h"
+#include "core/str.h"
+
+#include <stdbool.h>
+
+
+typedef struct bench {
+    s64 ops;            // How many operations benchmark should run.
+    u64 elapsed_ns;     // Measured time, accumulated by bench_start / bench_stop pairs.
+    u64 start_ns;
+    s64 bytes_per_op;   // Bytes processed or allocated by one operation, 0 if not meaningful.
+} Bench;
+
+typedef void (*Bench_Procedure)(Bench *b);
+
+typedef struct bench_case {
+    const char *name;
+    Bench_Procedure procedure;
+} Bench_Case;
+
+typedef struct bench_result {
+    String name;
+    s64 ops;
+    double ns_per_op;
+    double ops_per_second;
+    double bytes_per_op;
+} Bench_Result;
+
+
+void bench_start(Bench *b);
+
+void bench_stop(Bench *b);
+
+/**
+ * Keeps the compiler from optimizing away value that is otherwise unused.
+ */
+#define bench_keep(value) __asm__ volatile("" : : "g"(value) : "memory")
+
+
+
+/**
+ * Runs single benchmark case and returns its result.
+ */
+Bench_Result bench_run(Bench_Case *bench_case);
+
+/**
+ * Writes results as JSON into file, or stdout if "file_path" is NULL.
+ * Returns 0 on success.
+ */
+int bench_write_json(Bench_Result *results, s64 count, char *file_path);
+
+/**
+ * Compares two JSON files written by "bench_write_json()".
+ * Returns 0 if there are no benchmarks slower than "threshold_percent", 1 if there are, and -1 on error.
+ */
+int bench_compare(char *old_path, char *new_path, double threshold_percent);
+
+
+
+// Benchmark cases, each module registers its own.
+extern Bench_Case bench_cases_core[];
+extern s64 bench_cases_core_count;
+
+extern Bench_Case bench_cases_tools[];
+extern s64 bench_cases_tools_count;
+
+extern Bench_Case bench_cases_game[];
+extern s64 bench_cases_game_count;
+
+#endif
@@ -0,0 +1,602 @@
+#include "bench/bench.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/num.h"
+#include "core/mathf.h"
+#include "core/arena.h"
+#include "core/structs.h"
+#include "core/raster.h"
+#include "core/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Structs.
+ */
+
+#define BENCH_LIST_LENGTH   4096
+#define BENCH_KEYS_COUNT    4096
+#define BENCH_KEY_LENGTH    16
+
+static char bench_keys[BENCH_KEYS_COUNT][BENCH_KEY_LENGTH];
+static char bench_missing_keys[BENCH_KEYS_COUNT][BENCH_KEY_LENGTH];
+
+static void bench_keys_init() {
+    static bool initted = false;
+    if (initted) return;
+    initted = true;
+
+    for (s64 i = 0; i < BENCH_KEYS_COUNT; i++) {
+        (void)snprintf(bench_keys[i], BENCH_KEY_LENGTH, "key_%05lld", (long long)i);
+        (void)snprintf(bench_missing_keys[i], BENCH_KEY_LENGTH, "missing_%05lld", (long long)i);
+    }
+}
+
+#define BENCH_KEY(keys, i) (u32)strlen(keys[(i) % BENCH_KEYS_COUNT]), keys[(i) % BENCH_KEYS_COUNT]
+
+
+static void bench_array_list_append(Bench *b) {
+    u32 *list = array_list_make(u32, BENCH_LIST_LENGTH, &std_allocator);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        if (array_list_length(&list) == BENCH_LIST_LENGTH) {
+            array_list_clear(&list);
+        }
+        array_list_append(&list, (u32)i);
+    }
+    bench_stop(b);
+
+    array_list_free(&list);
+    b->bytes_per_op = sizeof(u32);
+}
+
+static void bench_array_list_append_grow(Bench *b) {
+    u32 *list = array_list_make(u32, 1, &std_allocator);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        if (array_list_length(&list) == BENCH_LIST_LENGTH) {
+            array_list_free(&list);
+            list = array_list_make(u32, 1, &std_allocator);
+        }
+        array_list_append(&list, (u32)i);
+    }
+    bench_stop(b);
+
+    array_list_free(&list);
+    b->bytes_per_op = sizeof(u32);
+}
+
+static void bench_array_list_append_multiple(Bench *b) {
+    float quad[48] = {0};
+    float *list = array_list_make(float, BENCH_LIST_LENGTH * 48, &std_allocator);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        if (array_list_length(&list) == BENCH_LIST_LENGTH * 48) {
+            array_list_clear(&list);
+        }
+        (void)array_list_append_multiple(&list, quad, 48);
+    }
+    bench_stop(b);
+
+    array_list_free(&list);
+    b->bytes_per_op = sizeof(quad);
+}
+
+/**
+ * @Important: Hash table stores pointers into its keys array list, which is sized by initial capacity and dangles once it reallocates.
+ * So tables here are made big enough up front and remade instead of refilled, that also keeps growth out of the measurements.
+ */
+#define BENCH_TABLE_CAPACITY (BENCH_KEYS_COUNT * 2)
+
+static void bench_hash_table_put(Bench *b) {
+    bench_keys_init();
+
+    s64 put = 0;
+    while (put < b->ops) {
+        u64 *table = hash_table_make(u64, BENCH_TABLE_CAPACITY, &std_allocator);
+        s64 count = mini(b->ops - put, BENCH_KEYS_COUNT);
+
+        bench_start(b);
+        for (s64 i = 0; i < count; i++) {
+            hash_table_put(&table, (u64)i, BENCH_KEY(bench_keys, i));
+        }
+        bench_stop(b);
+
+        hash_table_free(&table);
+        put += count;
+    }
+}
+
+static void bench_hash_table_get(Bench *b) {
+    bench_keys_init();
+    u64 *table = hash_table_make(u64, BENCH_TABLE_CAPACITY, &std_allocator);
+    for (s64 i = 0; i < BENCH_KEYS_COUNT; i++) {
+        hash_table_put(&table, (u64)i, BENCH_KEY(bench_keys, i));
+    }
+
+    u64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        u64 *item = hash_table_get(&table, BENCH_KEY(bench_keys, i * 7));
+        sum += *item;
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    hash_table_free(&table);
+}
+
+static void bench_hash_table_get_miss(Bench *b) {
+    bench_keys_init();
+    u64 *table = hash_table_make(u64, BENCH_TABLE_CAPACITY, &std_allocator);
+    for (s64 i = 0; i < BENCH_KEYS_COUNT; i++) {
+        hash_table_put(&table, (u64)i, BENCH_KEY(bench_keys, i));
+    }
+
+    u64 found = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        found += hash_table_get(&table, BENCH_KEY(bench_missing_keys, i * 7)) != NULL;
+    }
+    bench_stop(b);
+    bench_keep(found);
+
+    hash_table_free(&table);
+}
+
+static void bench_hash_table_remove(Bench *b) {
+    bench_keys_init();
+
+    s64 removed = 0;
+    while (removed < b->ops) {
+        // Filling table, not measured.
+        u64 *table = hash_table_make(u64, BENCH_TABLE_CAPACITY, &std_allocator);
+        for (s64 i = 0; i < BENCH_KEYS_COUNT; i++) {
+            hash_table_put(&table, (u64)i, BENCH_KEY(bench_keys, i));
+        }
+
+        s64 count = mini(b->ops - removed, BENCH_KEYS_COUNT);
+
+        bench_start(b);
+        for (s64 i = 0; i < count; i++) {
+            hash_table_remove(&table, BENCH_KEY(bench_keys, i));
+        }
+        bench_stop(b);
+
+        hash_table_free(&table);
+        removed += count;
+    }
+}
+
+static void bench_looped_array_append(Bench *b) {
+    u64 *array = looped_array_make(u64, 256, &std_allocator);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        looped_array_append(&array, (u64)i);
+    }
+    bench_stop(b);
+
+    looped_array_free(&array);
+    b->bytes_per_op = sizeof(u64);
+}
+
+static void bench_looped_array_get(Bench *b) {
+    u64 *array = looped_array_make(u64, 256, &std_allocator);
+    for (s64 i = 0; i < 300; i++) {
+        looped_array_append(&array, (u64)i);
+    }
+
+    u64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += looped_array_get(&array, (u32)(i & 255));
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    looped_array_free(&array);
+}
+
+static void bench_arena_alloc(Bench *b) {
+    Arena arena = arena_make(1024 * KB);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        if (arena_size(&arena) + 32 > 1024 * KB) {
+            arena_clear(&arena);
+        }
+        void *ptr = arena_alloc(&arena, 32);
+        bench_keep(ptr);
+    }
+    bench_stop(b);
+
+    arena_free(&arena);
+    b->bytes_per_op = 32;
+}
+
+
+
+
+
+/**
+ * Strings.
+ * Scanners run over the same generated text: words, spaces and new lines, with the searched symbols only at the end.
+ */
+
+#define BENCH_TEXT_LENGTH (64 * KB)
+
+static char bench_text_data[BENCH_TEXT_LENGTH];
+static String bench_text;
+
+static void bench_text_init() {
+    if (bench_text.data != NULL) return;
+
+    static const char *words[] = { "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit" };
+
+    u32 seed = 1;
+    s64 length = 0;
+    while (length < BENCH_TEXT_LENGTH - 64) {
+        seed = seed * 1103515245u + 12345u;
+        const char *word = words[(seed >> 16) % 8];
+        s64 word_length = strlen(word);
+        memcpy(bench_text_data + length, word, word_length);
+        length += word_length;
+        bench_text_data[length++] = (seed >> 24) % 8 == 0 ? '\n' : ' ';
+    }
+
+    memcpy(bench_text_data + length, "needle_string#", 14);
+    length += 14;
+
+    bench_text = STR(length, bench_text_data);
+}
+
+static const String BENCH_INTS[] = {
+    STR_BUFFER("0"), STR_BUFFER("42"), STR_BUFFER("-17"), STR_BUFFER("1000000"), STR_BUFFER("123456789"), STR_BUFFER("-9876543210"), STR_BUFFER("65535"), STR_BUFFER("7"),
+};
+
+static const String BENCH_FLOATS[] = {
+    STR_BUFFER("0.5"), STR_BUFFER("3.14159"), STR_BUFFER("-2.75"), STR_BUFFER("100.0"), STR_BUFFER("1e-3"), STR_BUFFER("0.8"), STR_BUFFER("6.02e23"), STR_BUFFER("128"),
+};
+
+static const char *BENCH_FLOATS_CSTR[] = {
+    "0.5", "3.14159", "-2.75", "100.0", "1e-3", "0.8", "6.02e23", "128",
+};
+
+static const float BENCH_FLOAT_VALUES[] = {
+    0.5f, 3.14159f, -2.75f, 100.0f, 1e-3f, 0.8f, 6.02e23f, 1.0f / 3.0f,
+};
+
+
+static void bench_str_find(Bench *b) {
+    bench_text_init();
+
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += str_find(bench_text, CSTR("needle_string"));
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    b->bytes_per_op = bench_text.length;
+}
+
+static void bench_str_find_char_left(Bench *b) {
+    bench_text_init();
+
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += str_find_char_left(bench_text, '#');
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    b->bytes_per_op = bench_text.length;
+}
+
+static void bench_str_count_chars(Bench *b) {
+    bench_text_init();
+
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += str_count_chars(bench_text, '\n');
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    b->bytes_per_op = bench_text.length;
+}
+
+static void bench_str_tokenize(Bench *b) {
+    bench_text_init();
+
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        String rest = bench_text;
+        while (true) {
+            rest = str_eat_spaces(rest);
+            if (rest.length <= 0) break;
+
+            String word = str_get_until_space(rest);
+            rest = str_eat_chars(rest, word.length);
+            sum++;
+        }
+    }
+    bench_stop(b);
+    bench_keep(sum);
+
+    b->bytes_per_op = bench_text.length;
+}
+
+static void bench_str_parse_int(Bench *b) {
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += str_parse_int(BENCH_INTS[i & 7]);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_str_parse_float(Bench *b) {
+    float sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += str_parse_float(BENCH_FLOATS[i & 7]);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_num_parse_f32(Bench *b) {
+    float sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += num_parse_f32(BENCH_FLOATS[i & 7]);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_strtof(Bench *b) {
+    float sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += strtof(BENCH_FLOATS_CSTR[i & 7], NULL);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_num_format_f32(Bench *b) {
+    char buffer[NUM_F32_MAX_CHARS];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += num_format_f32(BENCH_FLOAT_VALUES[i & 7], buffer);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_snprintf_float(Bench *b) {
+    char buffer[32];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += snprintf(buffer, sizeof(buffer), "%.9g", BENCH_FLOAT_VALUES[i & 7]);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_num_format_s64(Bench *b) {
+    char buffer[NUM_S64_MAX_CHARS];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += num_format_s64(i * 7919 - 1000000, buffer);
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_snprintf_int(Bench *b) {
+    char buffer[32];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += snprintf(buffer, sizeof(buffer), "%lld", (long long)(i * 7919 - 1000000));
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_str_format(Bench *b) {
+    char buffer[128];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        String result = str_format(STR(sizeof(buffer), buffer), "Vert count: %u, position: (%2.2f, %2.2f) %s\n", (u32)i, BENCH_FLOAT_VALUES[i & 7], BENCH_FLOAT_VALUES[(i + 1) & 7], "ok");
+        sum += result.length;
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+static void bench_snprintf_format(Bench *b) {
+    char buffer[128];
+    s64 sum = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        sum += snprintf(buffer, sizeof(buffer), "Vert count: %u, position: (%2.2f, %2.2f) %s\n", (u32)i, BENCH_FLOAT_VALUES[i & 7], BENCH_FLOAT_VALUES[(i + 1) & 7], "ok");
+    }
+    bench_stop(b);
+    bench_keep(sum);
+}
+
+
+
+
+/**
+ * Logging.
+ * Measures what caller of "log_print()" pays, records are logged in batches that fit into the ring, and flushing them isn't measured.
+ * @Important: On single core machine writer thread runs in the middle of the batch, so result includes writing too.
+ */
+
+#define BENCH_LOG_BATCH 1000
+
+static void bench_log_print(Bench *b) {
+    FILE *output = tmpfile();
+    if (output == NULL) {
+        return;
+    }
+    log_set_output(output);
+
+    for (s64 i = 0; i < b->ops; i += BENCH_LOG_BATCH) {
+        s64 batch_end = i + BENCH_LOG_BATCH < b->ops ? i + BENCH_LOG_BATCH : b->ops;
+
+        bench_start(b);
+        for (s64 j = i; j < batch_end; j++) {
+            LOG_WARNING("Record %lld of %s, %.2f ms.", (long long)j, "bench", BENCH_FLOAT_VALUES[j & 7]);
+        }
+        bench_stop(b);
+
+        log_flush();
+    }
+
+    log_set_output(stderr);
+    (void)fclose(output);
+}
+
+
+
+
+/**
+ * Raster.
+ * Frames are drawn with fixed amount of threads, so results are comparable between machines with different core counts.
+ * One op is the whole frame: recording, binning and shading.
+ */
+
+#define BENCH_RASTER_WIDTH      1280
+#define BENCH_RASTER_HEIGHT     720
+#define BENCH_RASTER_THREADS    4
+#define BENCH_RASTER_GLYPH_SIZE 16
+
+static u8 bench_raster_glyph_pixels[BENCH_RASTER_GLYPH_SIZE * BENCH_RASTER_GLYPH_SIZE];
+static Raster_Texture bench_raster_glyph = { BENCH_RASTER_GLYPH_SIZE, BENCH_RASTER_GLYPH_SIZE, 1, bench_raster_glyph_pixels };
+
+/**
+ * Round dot that works both as coverage and distance field mask.
+ */
+static void bench_raster_glyph_init() {
+    for (s32 y = 0; y < BENCH_RASTER_GLYPH_SIZE; y++) {
+        for (s32 x = 0; x < BENCH_RASTER_GLYPH_SIZE; x++) {
+            float dx = (float)x + 0.5f - BENCH_RASTER_GLYPH_SIZE * 0.5f;
+            float dy = (float)y + 0.5f - BENCH_RASTER_GLYPH_SIZE * 0.5f;
+            float value = 0.5f + (BENCH_RASTER_GLYPH_SIZE * 0.35f - sqrtf(dx * dx + dy * dy)) / BENCH_RASTER_GLYPH_SIZE;
+            bench_raster_glyph_pixels[y * BENCH_RASTER_GLYPH_SIZE + x] = (u8)(clamp(value, 0.0f, 1.0f) * 255.0f);
+        }
+    }
+}
+
+static void bench_raster_quad(Raster *raster, float x, float y, float size, Vec4f color, Raster_Texture *mask, bool distance_field) {
+    Raster_Vertex corners[4] = {
+        { { x,          y },        color, { 0.0f, 1.0f } },
+        { { x + size,   y },        color, { 1.0f, 1.0f } },
+        { { x,          y + size }, color, { 0.0f, 0.0f } },
+        { { x + size,   y + size }, color, { 1.0f, 0.0f } },
+    };
+    raster_triangle(raster, corners, NULL, mask, distance_field);
+    raster_triangle(raster, corners + 1, NULL, mask, distance_field);
+}
+
+static void bench_raster_frame(Bench *b, s32 quads_count, float size, Raster_Texture *mask, bool distance_field) {
+    bench_raster_glyph_init();
+
+    Raster raster;
+    raster_init(&raster, BENCH_RASTER_WIDTH, BENCH_RASTER_HEIGHT, BENCH_RASTER_THREADS);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        raster_clear(&raster, 0xFF333333);
+
+        u32 seed = 1;
+        for (s32 q = 0; q < quads_count; q++) {
+            seed = seed * 1664525u + 1013904223u;
+            float x = (float)(seed >> 8 & 0x7FF) * ((BENCH_RASTER_WIDTH - size) / 2048.0f);
+            float y = (float)(seed >> 19) * ((BENCH_RASTER_HEIGHT - size) / 8192.0f);
+            bench_raster_quad(&raster, x, y, size, vec4f_make(0.2f, 0.6f, 0.9f, 0.75f), mask, distance_field);
+        }
+
+        raster_flush(&raster);
+    }
+    bench_stop(b);
+    bench_keep(raster.pixels[0]);
+
+    raster_free(&raster);
+}
+
+static void bench_raster_rects(Bench *b) {
+    bench_raster_frame(b, 2000, 48.0f, NULL, false);
+}
+
+static void bench_raster_text(Bench *b) {
+    bench_raster_frame(b, 8000, 12.0f, &bench_raster_glyph, false);
+}
+
+static void bench_raster_text_distance_field(Bench *b) {
+    bench_raster_frame(b, 8000, 12.0f, &bench_raster_glyph, true);
+}
+
+
+
+
+
+Bench_Case bench_cases_core[] = {
+    { "array_list_append",          bench_array_list_append },
+    { "array_list_append_grow",     bench_array_list_append_grow },
+    { "array_list_append_multiple", bench_array_list_append_multiple },
+    { "hash_table_put",             bench_hash_table_put },
+    { "hash_table_get",             bench_hash_table_get },
+    { "hash_table_get_miss",        bench_hash_table_get_miss },
+    { "hash_table_remove",          bench_hash_table_remove },
+    { "looped_array_append",        bench_looped_array_append },
+    { "looped_array_get",           bench_looped_array_get },
+    { "arena_alloc",                bench_arena_alloc },
+
+    { "str_find",                   bench_str_find },
+    { "str_find_char_left",         bench_str_find_char_left },
+    { "str_count_chars",            bench_str_count_chars },
+    { "str_tokenize",               bench_str_tokenize },
+    { "str_parse_int",              bench_str_parse_int },
+    { "str_parse_float",            bench_str_parse_float },
+    { "num_parse_f32",              bench_num_parse_f32 },
+    { "strtof",                     bench_strtof },
+    { "num_format_f32",             bench_num_format_f32 },
+    { "snprintf_float",             bench_snprintf_float },
+    { "num_format_s64",             bench_num_format_s64 },
+    { "snprintf_int",               bench_snprintf_int },
+    { "str_format",                 bench_str_format },
+    { "snprintf_format",            bench_snprintf_format },
+
+    { "log_print",                  bench_log_print },
+
+    { "raster_rects",               bench_raster_rects },
+    { "raster_text",                bench_raster_text },
+    { "raster_text_distance_field", bench_raster_text_distance_field },
+};
+
+s64 bench_cases_core_count = sizeof(bench_cases_core) / sizeof(bench_cases_core[0]);
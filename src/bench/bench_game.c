@@ -0,0 +1,90 @@
+#include "bench/bench.h"
+
+#include "game/particles.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+
+#include <stdlib.h>
+
+
+/**
+ * Particles.
+ * Million particles that live longer than the benchmark, so every update moves all of them and compaction only scans.
+ */
+
+#define BENCH_PARTICLES_COUNT   (1024 * 1024)
+#define BENCH_PARTICLES_EMIT    1000
+
+static void bench_particles_fill(Particles *particles) {
+    srand(1);
+    for (u32 i = 0; i < BENCH_PARTICLES_COUNT; i++) {
+        Vec2f position = vec2f_make(randf() * 100.0f, randf() * 100.0f);
+        Vec2f velocity = vec2f_make(randf() - 0.5f, randf() - 0.5f);
+        particles_add(particles, position, velocity, 1.0e9f, 1.0f, VEC4F_WHITE, VEC4F_BLACK);
+    }
+    particles->gravity = vec2f_make(0.0f, -9.8f);
+    particles->drag = 0.1f;
+}
+
+static void bench_particles_update_threads(Bench *b, s32 threads_count) {
+    Particles particles;
+    particles_init(&particles, BENCH_PARTICLES_COUNT, threads_count);
+    bench_particles_fill(&particles);
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        particles_update(&particles, 1.0f / 60.0f);
+    }
+    bench_stop(b);
+    b->bytes_per_op = (s64)BENCH_PARTICLES_COUNT * 11 * 2 * sizeof(float);  // Fields read and written by update.
+
+    particles_free(&particles);
+}
+
+static void bench_particles_update(Bench *b) {
+    bench_particles_update_threads(b, 1);
+}
+
+static void bench_particles_update_threads4(Bench *b) {
+    bench_particles_update_threads(b, 4);
+}
+
+static void bench_particles_emit(Bench *b) {
+    Particles particles;
+    particles_init(&particles, BENCH_PARTICLES_EMIT, 1);
+
+    Particle_Emitter emitter = {
+        .rate           = BENCH_PARTICLES_EMIT,
+        .position_spread = 10.0f,
+        .velocity       = vec2f_make(0.0f, 5.0f),
+        .velocity_spread = 1.0f,
+        .life_min       = 1.0f,
+        .life_max       = 2.0f,
+        .size_min       = 1.0f,
+        .size_max       = 2.0f,
+        .color_start    = VEC4F_WHITE,
+        .color_end      = VEC4F_BLACK,
+    };
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        particles.count = 0;
+        particles_emit(&particles, &emitter, 1.0f);
+    }
+    bench_stop(b);
+    bench_keep(particles.count);
+
+    particles_free(&particles);
+}
+
+
+
+Bench_Case bench_cases_game[] = {
+    { "particles_update_1m",            bench_particles_update },
+    { "particles_update_1m_threads4",   bench_particles_update_threads4 },
+    { "particles_emit_1k",              bench_particles_emit },
+};
+
+s64 bench_cases_game_count = sizeof(bench_cases_game) / sizeof(bench_cases_game[0]);
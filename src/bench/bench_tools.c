@@ -0,0 +1,183 @@
+#include "bench/bench.h"
+
+#include "game/vars.h"
+#include "meta/lexer.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/file.h"
+#include "core/typeinfo.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * Vars.
+ * Loads generated file into the tree of one struct with integer and float fields, same as game does with introspected structs.
+ */
+
+#define BENCH_VARS_FIELDS       16      // Per type.
+#define BENCH_VARS_SECTIONS     2000
+#define BENCH_VARS_FILE         "bench_generated.vars"
+
+typedef struct bench_vars {
+    s64 ints[BENCH_VARS_FIELDS];
+    float floats[BENCH_VARS_FIELDS];
+} Bench_Vars;
+
+static Bench_Vars bench_vars;
+
+static Type_Info bench_vars_s64     = { INTEGER, STR_BUFFER("s64"), 8, 8, .t_integer = { 64, true } };
+static Type_Info bench_vars_float   = { FLOAT, STR_BUFFER("float"), 4, 4, .t_float = { 32 } };
+static Type_Info bench_vars_type;
+
+static Type_Info_Struct_Member bench_vars_members[BENCH_VARS_FIELDS * 2];
+static char bench_vars_member_names[BENCH_VARS_FIELDS * 2][8];
+
+static Vars_Tree bench_vars_tree;
+
+
+static void bench_vars_init() {
+    static bool initted = false;
+    if (initted) return;
+    initted = true;
+
+    // Type info.
+    for (s64 i = 0; i < BENCH_VARS_FIELDS; i++) {
+        s64 length = snprintf(bench_vars_member_names[i], 8, "i%lld", (long long)i);
+        bench_vars_members[i] = (Type_Info_Struct_Member) { &bench_vars_s64, STR(length, bench_vars_member_names[i]), offsetof(Bench_Vars, ints) + i * sizeof(s64) };
+
+        length = snprintf(bench_vars_member_names[BENCH_VARS_FIELDS + i], 8, "f%lld", (long long)i);
+        bench_vars_members[BENCH_VARS_FIELDS + i] = (Type_Info_Struct_Member) { &bench_vars_float, STR(length, bench_vars_member_names[BENCH_VARS_FIELDS + i]), offsetof(Bench_Vars, floats) + i * sizeof(float) };
+    }
+
+    bench_vars_type = (Type_Info) { STRUCT, STR_BUFFER("Bench_Vars"), sizeof(Bench_Vars), 8, .t_struct = { BENCH_VARS_FIELDS * 2, bench_vars_members } };
+
+    vars_tree_begin();
+    vars_tree_add(&bench_vars_type, (u8 *)&bench_vars, CSTR("bench"));
+    bench_vars_tree = vars_tree_build();
+}
+
+/**
+ * Generates file with the same section repeated, like many tweaked structs.
+ * Returns size of the file or -1 on error.
+ */
+static s64 bench_vars_write_file() {
+    FILE *file = fopen(BENCH_VARS_FILE, "wb");
+    if (file == NULL) {
+        printf_err("Couldn't create '%s'.\n", BENCH_VARS_FILE);
+        return -1;
+    }
+
+    for (s64 section = 0; section < BENCH_VARS_SECTIONS; section++) {
+        fprintf(file, "# Section %lld.\n[bench]\n\n", (long long)section);
+        for (s64 i = 0; i < BENCH_VARS_FIELDS; i++) {
+            fprintf(file, "i%-8lld %lld\n", (long long)i, (long long)(section * 31 + i));
+            fprintf(file, "f%-8lld %.4f\n", (long long)i, (double)section * 0.25 + (double)i);
+        }
+        fprintf(file, "\n");
+    }
+
+    s64 size = ftell(file);
+    fclose(file);
+
+    return size;
+}
+
+static void bench_vars_load_file(Bench *b) {
+    bench_vars_init();
+
+    s64 file_size = bench_vars_write_file();
+    if (file_size < 0) return;
+
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        vars_load_file(CSTR(BENCH_VARS_FILE), &bench_vars_tree);
+    }
+    bench_stop(b);
+
+    (void)remove(BENCH_VARS_FILE);
+    b->bytes_per_op = file_size;
+}
+
+
+
+
+
+/**
+ * Meta lexer.
+ * Lexes synthetic source that has all kinds of tokens meta cares about.
+ */
+
+#define BENCH_LEXER_REPEATS 2000
+
+static const char *BENCH_LEXER_CHUNK =
+    "#include \"core/core.h\"\n"
+    "\n"
+    "/**\n"
+    " * Multiline comment, with @Important: notes inside.\n"
+    " */\n"
+    "@Introspect;\n"
+    "typedef struct entity {\n"
+    "    Vec2f position;\n"
+    "    float *verticies;\n"
+    "    s64 count; // One line comment.\n"
+    "} Entity;\n"
+    "\n"
+    "#define ENTITY_MAX 1024\n"
+    "\n"
+    "void entity_update(Entity *entity, float delta_time) {\n"
+    "    for (s64 i = 0; i < entity->count; i++) {\n"
+    "        entity->verticies[i] = entity->verticies[i] * 0.5f + delta_time;\n"
+    "    }\n"
+    "    printf(\"Updated %lld verticies.\\n\", entity->count);\n"
+    "}\n"
+    "\n";
+
+static String bench_lexer_source;
+
+static void bench_lexer_init() {
+    if (bench_lexer_source.data != NULL) return;
+
+    s64 chunk_length = strlen(BENCH_LEXER_CHUNK);
+    char *data = malloc(chunk_length * BENCH_LEXER_REPEATS);
+    for (s64 i = 0; i < BENCH_LEXER_REPEATS; i++) {
+        memcpy(data + i * chunk_length, BENCH_LEXER_CHUNK, chunk_length);
+    }
+
+    bench_lexer_source = STR(chunk_length * BENCH_LEXER_REPEATS, data); // @Leak.
+}
+
+static void bench_meta_lexer(Bench *b) {
+    bench_lexer_init();
+
+    s64 tokens = 0;
+    bench_start(b);
+    for (s64 i = 0; i < b->ops; i++) {
+        Lexer lexer;
+        lexer_init(&lexer, bench_lexer_source);
+
+        while (lexer_next_token(&lexer).type != TOKEN_ZERO) {
+            tokens++;
+        }
+    }
+    bench_stop(b);
+    bench_keep(tokens);
+
+    b->bytes_per_op = bench_lexer_source.length;
+}
+
+
+
+
+
+Bench_Case bench_cases_tools[] = {
+    { "vars_load_file",             bench_vars_load_file },
+    { "meta_lexer",                 bench_meta_lexer },
+};
+
+s64 bench_cases_tools_count = sizeof(bench_cases_tools) / sizeof(bench_cases_tools[0]);
@@ -0,0 +1,98 @@
+#include "core/core.h"
+#include "core/str.h"
+
+#include "bench/bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+
+/**
+ *  How to use:
+ *
+ *      Run all benchmarks, or only ones which names contain filter, and write JSON results to stdout or file:
+ *      $ bench.exe [-filter ...] [-out ...]
+ *
+ *      Compare two runs, returns 1 if any benchmark got slower by more than threshold percent (10 by default):
+ *      $ bench.exe -compare old.json new.json [-threshold ...]
+ *
+ */
+int main(int argc, char **argv) {
+
+    char *output_path = NULL;
+    char *filter = NULL;
+
+    char *compare_old = NULL;
+    char *compare_new = NULL;
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-out") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+
+        } else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+
+        } else if (strcmp(argv[i], "-compare") == 0 && i + 2 < argc) {
+            compare_old = argv[++i];
+            compare_new = argv[++i];
+
+        } else if (strcmp(argv[i], "-threshold") == 0 && i + 1 < argc) {
+            threshold = strtod(argv[++i], NULL);
+
+        } else {
+            printf_err("Unknown or incomplete command line option: '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+
+    if (compare_old != NULL) {
+        int result = bench_compare(compare_old, compare_new, threshold);
+        return result < 0 ? 2 : result;
+    }
+
+
+    struct {
+        Bench_Case *cases;
+        s64 count;
+    } groups[] = {
+        { bench_cases_core,  bench_cases_core_count },
+        { bench_cases_tools, bench_cases_tools_count },
+        { bench_cases_game,  bench_cases_game_count },
+    };
+
+    s64 cases_count = 0;
+    for (s64 g = 0; g < (s64)(sizeof(groups) / sizeof(groups[0])); g++) {
+        cases_count += groups[g].count;
+    }
+
+    Bench_Result *results = malloc(sizeof(Bench_Result) * cases_count);
+    s64 results_count = 0;
+
+    for (s64 g = 0; g < (s64)(sizeof(groups) / sizeof(groups[0])); g++) {
+        for (s64 i = 0; i < groups[g].count; i++) {
+            Bench_Case *bench_case = groups[g].cases + i;
+
+            if (filter != NULL && strstr(bench_case->name, filter) == NULL) {
+                continue;
+            }
+
+            Bench_Result result = bench_run(bench_case);
+            results[results_count++] = result;
+
+            // Progress goes to stderr, so stdout stays valid JSON.
+            (void)fprintf(stderr, "%-36s %12.3f ns/op\n", bench_case->name, result.ns_per_op);
+        }
+    }
+
+    int error = bench_write_json(results, results_count, output_path);
+
+    free(results);
+
+    return error;
+}
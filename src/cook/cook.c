@@ -0,0 +1,64 @@
+#include "core/core.h"
+#include "core/tex.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+
+
+/**
+ *  How to use:
+ *
+ *      Cook images into ".tex" files next to them, images that didn't change since the last cook are skipped:
+ *      $ cook.exe [-bc3] [-premultiplied] image.png ...
+ *
+ *      Returns 1 if any image failed to cook.
+ *
+ */
+int main(int argc, char **argv) {
+
+    Tex_Format format = TEX_FORMAT_RGBA8;
+    u8 flags = 0;
+
+    s32 cooked_count = 0;
+    s32 skipped_count = 0;
+    s32 failed_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-bc3") == 0) {
+            format = TEX_FORMAT_BC3;
+            continue;
+
+        } else if (strcmp(argv[i], "-premultiplied") == 0) {
+            flags |= TEX_COOK_PREMULTIPLIED;
+            continue;
+
+        } else if (argv[i][0] == '-') {
+            printf_err("Unknown command line option: '%s'\n", argv[i]);
+            return 1;
+        }
+
+        char tex_path[512];
+        if (!tex_path_from_image(argv[i], tex_path, sizeof(tex_path))) {
+            printf_err("Path is too long: '%s'\n", argv[i]);
+            failed_count++;
+            continue;
+        }
+
+        bool cooked;
+        if (!tex_cook_file(argv[i], tex_path, format, flags, &cooked)) {
+            failed_count++;
+        } else if (cooked) {
+            printf("Cooked '%s'.\n", tex_path);
+            cooked_count++;
+        } else {
+            skipped_count++;
+        }
+    }
+
+    printf("Cooked %d, up to date %d, failed %d.\n", cooked_count, skipped_count, failed_count);
+
+    return failed_count > 0;
+}
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdatomic.h>
 
 
 /**
@@ -30,22 +31,46 @@ void allocator_destroy(Allocator *allocator) {
 }
 
 // Std.
+// Counters are relaxed atomics, std_allocator could be used from any thread.
+static _Atomic u64 std_allocations     = 0;
+static _Atomic u64 std_reallocations   = 0;
+static _Atomic u64 std_frees           = 0;
+static _Atomic u64 std_bytes_requested = 0;
+
 void *std_malloc(Allocator_Header *header, u64 size) {
+    atomic_fetch_add_explicit(&std_allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&std_bytes_requested, size, memory_order_relaxed);
     return malloc(size);
 }
 
 void *std_calloc(Allocator_Header *header, u64 size) {
+    atomic_fetch_add_explicit(&std_allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&std_bytes_requested, size, memory_order_relaxed);
     return calloc(1, size);
 }
 
 void *std_realloc(Allocator_Header *header, void *ptr, u64 size) {
+    atomic_fetch_add_explicit(&std_reallocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&std_bytes_requested, size, memory_order_relaxed);
     return realloc(ptr, size);
 }
 
 void std_free(Allocator_Header *header, void *ptr) {
+    if (ptr != NULL) {
+        atomic_fetch_add_explicit(&std_frees, 1, memory_order_relaxed);
+    }
     free(ptr);
 }
 
+Allocator_Stats std_allocator_stats() {
+    return (Allocator_Stats) {
+        .allocations        = atomic_load_explicit(&std_allocations, memory_order_relaxed),
+        .reallocations      = atomic_load_explicit(&std_reallocations, memory_order_relaxed),
+        .frees              = atomic_load_explicit(&std_frees, memory_order_relaxed),
+        .bytes_requested    = atomic_load_explicit(&std_bytes_requested, memory_order_relaxed),
+    };
+}
+
 Allocator std_allocator = (Allocator) {
     .ptr = NULL,
     .alc_alloc = std_malloc,
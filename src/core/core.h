@@ -7,6 +7,8 @@
 #ifndef OS
 #   if _WIN32
 #       define OS WINDOWS
+#   elif __linux__
+#       define OS LINUX
 #   endif
 #endif
 
@@ -78,6 +80,19 @@ typedef struct allocator {
 // Std.
 extern Allocator std_allocator;
 
+typedef struct allocator_stats {
+    u64 allocations;        // Alloc and zero alloc calls.
+    u64 reallocations;
+    u64 frees;
+    u64 bytes_requested;    // Sum of sizes passed to alloc, zero alloc and realloc calls.
+} Allocator_Stats;
+
+/**
+ * Returns counters of all calls made through std_allocator since program start.
+ * @Important: Memory that is allocated with plain malloc is not counted.
+ */
+Allocator_Stats std_allocator_stats();
+
 // Allocator interface.
 void *allocator_alloc(Allocator *allocator, u64 size);
 void *allocator_zero_alloc(Allocator *allocator, u64 size);
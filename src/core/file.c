@@ -45,6 +45,7 @@ String read_file_into_str(char *file_name, Allocator *allocator) {
     FILE *file = fopen(file_name, "rb");
     if (file == NULL) {
         printf_err("Couldn't open the file '%s'.\n", file_name);
+        return STR(0, NULL);
     }
 
     (void)fseek(file, 0, SEEK_END);
@@ -57,14 +58,16 @@ String read_file_into_str(char *file_name, Allocator *allocator) {
         printf_err("Memory allocation for string buffer failed while reading the file '%s'.\n", file_name);
         (void)fclose(file);
         str.length = 0;
+        return str;
     }
 
     if (fread(str.data, 1, file_size, file) != file_size) {
         printf_err("Failure reading the file '%s'.\n", file_name);
         (void)fclose(file);
-        free(str.data);
+        allocator_free(allocator, str.data);
         str.data = NULL;
         str.length = 0;
+        return str;
     }
 
     (void)fclose(file);
@@ -1,13 +1,23 @@
 #include "core/log.h"
+#include "core/type.h"
+#include "core/thread.h"
+#include "core/num.h"
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <signal.h>
 #include <time.h>
+#include <stdatomic.h>
+#include <errno.h>
 
 #if defined(_WIN32)
-    #include <windows.h>
+#include <io.h>
 #else
-    #include <pthread.h>
+#include <unistd.h>
 #endif
 
 #define ANSI_BLUE   "\x1b[34m"
@@ -17,95 +27,1210 @@
 
 static Log_Level log_minimum_level  = 0;
 static FILE *log_output             = NULL;
+static int log_output_fd            = 2; // Descriptor of "log_output" for crash writing, which can't go through stdio.
 
 void log_set_minimum_level(Log_Level level) {
     log_minimum_level = level;
 }
 
 void log_set_output(FILE *stream) {
+    log_flush();
     log_output = stream;
+#if defined(_WIN32)
+    log_output_fd = stream != NULL ? _fileno(stream) : 2;
+#else
+    log_output_fd = stream != NULL ? fileno(stream) : 2;
+#endif
 }
 
-void log_print(Log_Level level, const char *file_name, s64 line, const char *function_name, char *format, ...) {
-    if (level < log_minimum_level)
-        return;
 
-    if (log_output == NULL)
-        log_output = stderr;
 
-    va_list args;
-    va_start(args, format);
 
+/**
+ * Prefix.
+ * Local time is only recomputed when the second changes, the rest of the date is reused from the cached string.
+ */
+
+static time_t log_cached_second = -1;
+static char log_cached_time[80];
+
+static void log_write_prefix(FILE *out, Log_Level level, struct timespec ts, u64 thread_id, const char *file_name, s64 line, const char *function_name) {
     // Print log level.
     switch(level) {
         case LOG_LEVEL_INFO:
 #ifdef LOG_INFO_COLOR
-            fprintf(log_output, ANSI_BLUE"[INFO]"ANSI_RESET);
+            fputs(ANSI_BLUE"[INFO]"ANSI_RESET, out);
 #else
-            fprintf(log_output, "[INFO]");
+            fputs("[INFO]", out);
 #endif
             break;
         case LOG_LEVEL_WARNING:
 #ifdef LOG_INFO_COLOR
-            fprintf(log_output, ANSI_YELLOW"[WARN]"ANSI_RESET);
+            fputs(ANSI_YELLOW"[WARN]"ANSI_RESET, out);
 #else
-            fprintf(log_output, "[WARN]");
+            fputs("[WARN]", out);
 #endif
             break;
         case LOG_LEVEL_ERROR:
 #ifdef LOG_INFO_COLOR
-            fprintf(log_output, ANSI_RED"[ERRO]"ANSI_RESET);
+            fputs(ANSI_RED"[ERRO]"ANSI_RESET, out);
 #else
-            fprintf(log_output, "[ERRO]");
+            fputs("[ERRO]", out);
 #endif
             break;
     }
 
 #ifdef LOG_INFO_TIME
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-
-    struct tm tm;
+    if (ts.tv_sec != log_cached_second) {
+        struct tm tm;
 #if defined(_WIN32)
-    localtime_s(&tm, &ts.tv_sec);
+        localtime_s(&tm, &ts.tv_sec);
 #else
-    localtime_r(&ts.tv_sec, &tm);
+        localtime_r(&ts.tv_sec, &tm);
 #endif
+        snprintf(log_cached_time, sizeof(log_cached_time), "%04d-%02d-%02d %02d:%02d:%02d",
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+        log_cached_second = ts.tv_sec;
+    }
 
-    fprintf(log_output, " %04d-%02d-%02d %02d:%02d:%02d.%03ld",
-            tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec, ts.tv_nsec / 1000000);
+    fprintf(out, " %s.%03ld", log_cached_time, ts.tv_nsec / 1000000);
+#else
+    (void)ts;
 #endif
 
 #ifdef LOG_INFO_THREAD
+    fprintf(out, " [TID %llu]", (unsigned long long)thread_id);
+#else
+    (void)thread_id;
+#endif
+
+
+#ifdef LOG_INFO_FILE
+    fprintf(out, " %s", file_name);
+#else
+    (void)file_name;
+#endif
+
+#ifdef LOG_INFO_LINE
+    fprintf(out, ":%lld", (long long)line);
+#else
+    (void)line;
+#endif
+
+#ifdef LOG_INFO_FUNC
+    fprintf(out, " %s():", function_name);
+#else
+    (void)function_name;
+#endif
+
+
+    fputc(' ', out);
+}
+
+
+
+
+#ifndef LOG_ASYNC
+
+void log_print(Log_Level level, const char *file_name, s64 line, const char *function_name, char *format, ...) {
+    if (level < log_minimum_level)
+        return;
+
+    if (log_output == NULL)
+        log_output = stderr;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    va_list args;
+    va_start(args, format);
 
+    log_write_prefix(log_output, level, ts, thread_current_id(), file_name, line, function_name);
+
+    vfprintf(log_output, format, args);
+
+    fputc('\n', log_output);
+
+    fflush(log_output); // Ensure it's written.
+    va_end(args);
+}
+
+void log_flush() {
+    if (log_output != NULL) {
+        fflush(log_output);
+    }
+}
+
+#else
+
+
+
+
+/**
+ * Asynchronous logging.
+ *
+ * Each thread that logs gets its own single producer / single consumer ring, registered once in "log_rings" list.
+ * When thread exits its ring is marked, and once writer drains it, ring is moved to "log_rings_free" list and given to the next thread that registers.
+ * Caller only walks the format string to capture arguments in 8 byte slots, %s strings are copied in place, since they may not outlive the call.
+ * Writer thread merges rings by timestamp, and formats each conversion through "fprintf()" with the captured value.
+ * When rings are empty writer sleeps on condition variable, that producers signal on commit.
+ *
+ * Record layout in the ring: Log_Record header, then argument slots, everything 8 byte aligned.
+ * If record doesn't fit before the end of the ring, rest of the ring is skipped with padding record, or left as is if it is smaller than the header.
+ *
+ * @Important: When ring is full, caller writes all pending records itself before capturing its own, so bursts are slower but nothing is dropped.
+ */
+
+#define LOG_RING_CAPACITY       (256 * 1024)
+#define LOG_RECORD_MAX_SIZE     (4 * 1024)
+#define LOG_RECORD_PADDING      0xff
+#define LOG_WRITER_WAIT_MS      100
+#define LOG_RINGS_SOFT_LIMIT    64      // Past that many rings new thread waits for rings of exited ones to drain, instead of making another.
+
+typedef struct log_record {
+    u32 size;
+    u8 level;
+    s64 line;
+    const char *file_name;
+    const char *function_name;
+    const char *format;
+    s64 time_sec;
+    s64 time_nsec;
+} Log_Record;
+
+/**
+ * Producer and consumer positions are kept on separate cache lines, producer also keeps its own copy of the read position and reloads it only when the ring looks full.
+ */
+typedef struct log_ring {
+    _Atomic u64 write;
+    u64 cached_read;
+    u64 thread_id;
+    struct log_ring *next;
+    u8 padding0[32];
+
+    _Atomic u64 read;
+    u64 drain_end;              // Write position when current drain started, records after it are left for the next one.
+    atomic_bool exited;         // Set when owner thread exits, ring is reused once it is drained.
+    u8 padding1[47];
+
+    u8 data[LOG_RING_CAPACITY];
+} Log_Ring;
+
+static _Atomic(Log_Ring *) log_rings = NULL;
+static Log_Ring *log_rings_free = NULL;        // Rings of exited threads, guarded by "log_register_mutex".
+static s64 log_rings_count = 0;                 // Both lists together, guarded by "log_register_mutex".
+static _Thread_local Log_Ring *log_thread_ring = NULL;
+
+// Thread exit is noticed through destructor of thread local key, value of the key is thread's ring.
 #if defined(_WIN32)
-    fprintf(log_output, " [TID %lu]", GetCurrentThreadId());
+static DWORD log_ring_key = FLS_OUT_OF_INDEXES;
 #else
-    fprintf(log_output, " [TID %lu]", (unsigned long)pthread_self());
+static pthread_key_t log_ring_key;
+static bool log_ring_key_created = false;
 #endif
 
+static Mutex log_register_mutex = MUTEX_INIT;
+static Mutex log_writer_mutex   = MUTEX_INIT;
+static Thread log_writer_thread;
+static atomic_bool log_writer_started = false;
+
+// Writer sleeps on the condition when rings are empty, producers only signal it when it is sleeping.
+static Mutex log_wake_mutex     = MUTEX_INIT;
+static Condition log_wake       = CONDITION_INIT;
+static atomic_bool log_writer_sleeping = false;
+
+
+#define log_align(size) (((size) + 7) & ~(u64)7)
+
+
+
+/**
+ * Format conversions.
+ */
+
+typedef enum log_length : u8 {
+    LOG_LENGTH_NONE,
+    LOG_LENGTH_HH,
+    LOG_LENGTH_H,
+    LOG_LENGTH_L,
+    LOG_LENGTH_LL,
+    LOG_LENGTH_Z,
+    LOG_LENGTH_J,
+    LOG_LENGTH_T,
+    LOG_LENGTH_LONG_DOUBLE,
+} Log_Length;
+
+typedef struct log_spec {
+    const char *start;
+    s64 size;
+    s32 stars;
+    bool has_precision;
+    Log_Length length;
+    char conversion;
+} Log_Spec;
+
+/**
+ * Parses conversion spec starting at '%', returns pointer right after the conversion character.
+ */
+static const char *log_parse_spec(const char *c, Log_Spec *spec) {
+    *spec = (Log_Spec) { .start = c };
+    c++;
+
+    while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') c++;
+
+    if (*c == '*') {
+        spec->stars++;
+        c++;
+    } else {
+        while (*c >= '0' && *c <= '9') c++;
+    }
+
+    if (*c == '.') {
+        spec->has_precision = true;
+        c++;
+        if (*c == '*') {
+            spec->stars++;
+            c++;
+        } else {
+            while (*c >= '0' && *c <= '9') c++;
+        }
+    }
+
+    switch (*c) {
+        case 'h':
+            c++;
+            spec->length = LOG_LENGTH_H;
+            if (*c == 'h') {
+                c++;
+                spec->length = LOG_LENGTH_HH;
+            }
+            break;
+        case 'l':
+            c++;
+            spec->length = LOG_LENGTH_L;
+            if (*c == 'l') {
+                c++;
+                spec->length = LOG_LENGTH_LL;
+            }
+            break;
+        case 'z': c++; spec->length = LOG_LENGTH_Z; break;
+        case 'j': c++; spec->length = LOG_LENGTH_J; break;
+        case 't': c++; spec->length = LOG_LENGTH_T; break;
+        case 'L': c++; spec->length = LOG_LENGTH_LONG_DOUBLE; break;
+    }
+
+    spec->conversion = *c;
+    if (*c != '\0') c++;
+
+    spec->size = c - spec->start;
+    return c;
+}
+
+
+
+/**
+ * Capture.
+ */
+
+static Log_Ring *log_ring_register();
+
+static inline bool log_capture_slot(u8 **cursor, u8 *end, u64 value) {
+    if (*cursor + sizeof(u64) > end) return false;
+    memcpy(*cursor, &value, sizeof(u64));
+    *cursor += sizeof(u64);
+    return true;
+}
+
+static inline bool log_capture_string(u8 **cursor, u8 *end, const char *str, s64 precision) {
+    if (str == NULL) {
+        str = "(null)";
+    }
+
+    u64 length = precision >= 0 ? strnlen(str, precision) : strlen(str);
+    u64 space  = end - *cursor;
+
+    if (space < sizeof(u64) + 8) return false;
+
+    // Long strings are truncated to what fits into the record.
+    if (sizeof(u64) + length + 1 > space) {
+        length = space - sizeof(u64) - 1;
+    }
+
+    log_capture_slot(cursor, end, length);
+    memcpy(*cursor, str, length);
+    (*cursor)[length] = '\0';
+    *cursor += log_align(length + 1);
+    return true;
+}
+
+static u8 *log_capture_args(u8 *cursor, u8 *end, const char *format, va_list args) {
+    for (const char *c = format; *c; ) {
+        if (*c != '%') {
+            c++;
+            continue;
+        }
+
+        Log_Spec spec;
+        c = log_parse_spec(c, &spec);
+
+        s64 precision = -1;
+        for (s32 i = 0; i < spec.stars; i++) {
+            s32 star = va_arg(args, int);
+            if (!log_capture_slot(&cursor, end, (u64)(s64)star)) return cursor;
+            if (spec.has_precision && i == spec.stars - 1) precision = star;
+        }
+
+        u64 value = 0;
+
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+                switch (spec.length) {
+                    case LOG_LENGTH_L:  value = (u64)(s64)va_arg(args, long); break;
+                    case LOG_LENGTH_LL: value = (u64)(s64)va_arg(args, long long); break;
+                    case LOG_LENGTH_Z:  value = (u64)va_arg(args, size_t); break;
+                    case LOG_LENGTH_J:  value = (u64)(s64)va_arg(args, intmax_t); break;
+                    case LOG_LENGTH_T:  value = (u64)(s64)va_arg(args, ptrdiff_t); break;
+                    default:            value = (u64)(s64)va_arg(args, int); break;
+                }
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                switch (spec.length) {
+                    case LOG_LENGTH_L:  value = (u64)va_arg(args, unsigned long); break;
+                    case LOG_LENGTH_LL: value = (u64)va_arg(args, unsigned long long); break;
+                    case LOG_LENGTH_Z:  value = (u64)va_arg(args, size_t); break;
+                    case LOG_LENGTH_J:  value = (u64)va_arg(args, uintmax_t); break;
+                    case LOG_LENGTH_T:  value = (u64)va_arg(args, ptrdiff_t); break;
+                    default:            value = (u64)va_arg(args, unsigned int); break;
+                }
+                break;
+            case 'c':
+                value = (u64)va_arg(args, int);
+                break;
+            case 'f': case 'F':
+            case 'e': case 'E':
+            case 'g': case 'G':
+            case 'a': case 'A': {
+                double d = spec.length == LOG_LENGTH_LONG_DOUBLE ? (double)va_arg(args, long double) : va_arg(args, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            }
+            case 'p':
+            case 'n':
+                value = (u64)(uintptr_t)va_arg(args, void *);
+                break;
+            case 's':
+                if (!log_capture_string(&cursor, end, va_arg(args, const char *), precision)) return cursor;
+                continue;
+            default:
+                // '%%' or unknown conversion, takes no argument.
+                continue;
+        }
+
+        if (!log_capture_slot(&cursor, end, value)) return cursor;
+    }
+
+    return cursor;
+}
+
+/**
+ * Reserves contiguous LOG_RECORD_MAX_SIZE bytes at the write position, returns NULL if there is no space.
+ * Record is captured in place, then "log_ring_commit()" publishes only the bytes actually used.
+ */
+static u8 *log_ring_reserve(Log_Ring *ring) {
+    u64 write  = atomic_load_explicit(&ring->write, memory_order_relaxed);
+    u64 offset = write % LOG_RING_CAPACITY;
+    u64 tail   = LOG_RING_CAPACITY - offset;
+    u64 needed = tail < LOG_RECORD_MAX_SIZE ? tail + LOG_RECORD_MAX_SIZE : LOG_RECORD_MAX_SIZE;
+
+    if (LOG_RING_CAPACITY - (write - ring->cached_read) < needed) {
+        ring->cached_read = atomic_load_explicit(&ring->read, memory_order_acquire);
+
+        if (LOG_RING_CAPACITY - (write - ring->cached_read) < needed) {
+            return NULL;
+        }
+    }
+
+    if (tail < LOG_RECORD_MAX_SIZE) {
+        if (tail >= sizeof(Log_Record)) {
+            Log_Record *padding = (Log_Record *)(ring->data + offset);
+            padding->size = (u32)tail;
+            padding->level = LOG_RECORD_PADDING;
+        }
+
+        // Consumer can skip padding right away.
+        atomic_store_explicit(&ring->write, write + tail, memory_order_release);
+        offset = 0;
+    }
+
+    return ring->data + offset;
+}
+
+static inline void log_ring_commit(Log_Ring *ring, u64 size) {
+    // Pairs with the writer setting the flag and then checking rings, so either it sees this record or it is woken up.
+    // Locked add orders the flag load after the commit by itself, without separate fence.
+    // Only producer that clears the flag signals, so others don't take the mutex until writer gets to run.
+    atomic_fetch_add_explicit(&ring->write, size, memory_order_seq_cst);
+    if (atomic_load_explicit(&log_writer_sleeping, memory_order_seq_cst) && atomic_exchange(&log_writer_sleeping, false)) {
+        mutex_lock(&log_wake_mutex);
+        condition_signal(&log_wake);
+        mutex_unlock(&log_wake_mutex);
+    }
+}
+
+void log_print(Log_Level level, const char *file_name, s64 line, const char *function_name, char *format, ...) {
+    if (level < log_minimum_level)
+        return;
+
+    Log_Ring *ring = log_thread_ring;
+    if (ring == NULL) {
+        ring = log_ring_register();
+        if (ring == NULL) return;
+    }
+
+    u8 *buffer = log_ring_reserve(ring);
+
+    if (buffer == NULL) {
+        // Writer is behind, so caller does its work, after that whole ring is free.
+        log_flush();
+        buffer = log_ring_reserve(ring);
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    Log_Record *record = (Log_Record *)buffer;
+    *record = (Log_Record) {
+        .level          = level,
+        .line           = line,
+        .file_name      = file_name,
+        .function_name  = function_name,
+        .format         = format,
+        .time_sec       = ts.tv_sec,
+        .time_nsec      = ts.tv_nsec,
+    };
+
+    va_list args;
+    va_start(args, format);
+    u8 *end = log_capture_args(buffer + sizeof(Log_Record), buffer + LOG_RECORD_MAX_SIZE, format, args);
+    va_end(args);
+
+    record->size = (u32)log_align(end - buffer);
+
+    log_ring_commit(ring, record->size);
+}
+
+
+
+/**
+ * Writing.
+ */
+
+static inline u64 log_read_slot(const u8 **cursor, const u8 *end) {
+    u64 value = 0;
+    if (*cursor + sizeof(u64) <= end) {
+        memcpy(&value, *cursor, sizeof(u64));
+        *cursor += sizeof(u64);
+    }
+    return value;
+}
+
+#define log_fprintf_arg(out, spec_buffer, stars, star, value)                                              \
+    ((stars) == 0 ? fprintf(out, spec_buffer, value) :                                                      \
+     (stars) == 1 ? fprintf(out, spec_buffer, star[0], value) :                                             \
+                    fprintf(out, spec_buffer, star[0], star[1], value))
+
+static void log_write_message(FILE *out, const char *format, const u8 *cursor, const u8 *end) {
+    char spec_buffer[32];
+
+    for (const char *c = format; *c; ) {
+        if (*c != '%') {
+            const char *literal = c;
+            while (*c && *c != '%') c++;
+            fwrite(literal, 1, c - literal, out);
+            continue;
+        }
+
+        Log_Spec spec;
+        c = log_parse_spec(c, &spec);
+
+        if (spec.conversion == '%') {
+            fputc('%', out);
+            continue;
+        }
+
+        if (spec.size >= (s64)sizeof(spec_buffer)) {
+            fwrite(spec.start, 1, spec.size, out);
+            continue;
+        }
+
+        memcpy(spec_buffer, spec.start, spec.size);
+        spec_buffer[spec.size] = '\0';
+
+        int star[2] = { 0 };
+        for (s32 i = 0; i < spec.stars; i++) {
+            star[i] = (int)(s64)log_read_slot(&cursor, end);
+        }
+
+        if (spec.conversion == 's') {
+            // Capture could've stopped early on the record size limit.
+            const char *str = "";
+            if (cursor + sizeof(u64) < end) {
+                u64 length = log_read_slot(&cursor, end);
+                str = (const char *)cursor;
+                cursor += log_align(length + 1);
+            }
+            log_fprintf_arg(out, spec_buffer, spec.stars, star, str);
+            continue;
+        }
+
+        u64 value;
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                value = log_read_slot(&cursor, end);
+                switch (spec.length) {
+                    case LOG_LENGTH_L:  log_fprintf_arg(out, spec_buffer, spec.stars, star, (long)value); break;
+                    case LOG_LENGTH_LL: log_fprintf_arg(out, spec_buffer, spec.stars, star, (long long)value); break;
+                    case LOG_LENGTH_Z:  log_fprintf_arg(out, spec_buffer, spec.stars, star, (size_t)value); break;
+                    case LOG_LENGTH_J:  log_fprintf_arg(out, spec_buffer, spec.stars, star, (intmax_t)value); break;
+                    case LOG_LENGTH_T:  log_fprintf_arg(out, spec_buffer, spec.stars, star, (ptrdiff_t)value); break;
+                    default:            log_fprintf_arg(out, spec_buffer, spec.stars, star, (int)value); break;
+                }
+                break;
+            case 'c':
+                value = log_read_slot(&cursor, end);
+                log_fprintf_arg(out, spec_buffer, spec.stars, star, (int)value);
+                break;
+            case 'f': case 'F':
+            case 'e': case 'E':
+            case 'g': case 'G':
+            case 'a': case 'A': {
+                value = log_read_slot(&cursor, end);
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                if (spec.length == LOG_LENGTH_LONG_DOUBLE) {
+                    log_fprintf_arg(out, spec_buffer, spec.stars, star, (long double)d);
+                } else {
+                    log_fprintf_arg(out, spec_buffer, spec.stars, star, d);
+                }
+                break;
+            }
+            case 'p':
+                value = log_read_slot(&cursor, end);
+                log_fprintf_arg(out, spec_buffer, spec.stars, star, (void *)(uintptr_t)value);
+                break;
+            case 'n':
+                // Can't write back into caller's memory anymore.
+                log_read_slot(&cursor, end);
+                break;
+            default:
+                fwrite(spec.start, 1, spec.size, out);
+                break;
+        }
+    }
+}
+
+/**
+ * Returns record at the read position of the ring, skipping padding, or NULL if ring is drained up to "drain_end".
+ */
+static Log_Record *log_ring_peek(Log_Ring *ring) {
+    u64 write = ring->drain_end;
+    u64 read  = atomic_load_explicit(&ring->read, memory_order_relaxed);
+
+    while (read != write) {
+        u64 offset = read % LOG_RING_CAPACITY;
+        u64 tail   = LOG_RING_CAPACITY - offset;
+
+        if (tail < sizeof(Log_Record)) {
+            read += tail;
+            continue;
+        }
+
+        Log_Record *record = (Log_Record *)(ring->data + offset);
+        if (record->level == LOG_RECORD_PADDING) {
+            read += record->size;
+            continue;
+        }
+
+        atomic_store_explicit(&ring->read, read, memory_order_release);
+        return record;
+    }
+
+    atomic_store_explicit(&ring->read, read, memory_order_release);
+    return NULL;
+}
+
+static void log_ring_pop(Log_Ring *ring, Log_Record *record) {
+    u64 read = atomic_load_explicit(&ring->read, memory_order_relaxed);
+    atomic_store_explicit(&ring->read, read + record->size, memory_order_release);
+}
+
+/**
+ * Moves drained rings of exited threads from "log_rings" into "log_rings_free".
+ * @Important: Should be called with "log_writer_mutex" locked, every walk over "log_rings" is done under it.
+ */
+static void log_rings_recycle() {
+    mutex_lock(&log_register_mutex);
+
+    Log_Ring *previous = NULL;
+    Log_Ring *ring = atomic_load_explicit(&log_rings, memory_order_acquire);
+    while (ring != NULL) {
+        Log_Ring *next = ring->next;
+
+        // Owner can't write after it exited, so empty ring stays empty.
+        if (atomic_load(&ring->exited) && atomic_load(&ring->write) == atomic_load(&ring->read)) {
+            if (previous == NULL) {
+                atomic_store_explicit(&log_rings, next, memory_order_release);
+            } else {
+                previous->next = next;
+            }
+            ring->next = log_rings_free;
+            log_rings_free = ring;
+        } else {
+            previous = ring;
+        }
+
+        ring = next;
+    }
+
+    mutex_unlock(&log_register_mutex);
+}
+
+/**
+ * Marks records committed so far as the ones to drain, so busy producers can't keep drain going forever, returns list of rings.
+ */
+static Log_Ring *log_rings_drain_start() {
+    Log_Ring *rings = atomic_load_explicit(&log_rings, memory_order_acquire);
+    for (Log_Ring *ring = rings; ring != NULL; ring = ring->next) {
+        ring->drain_end = atomic_load_explicit(&ring->write, memory_order_acquire);
+    }
+    return rings;
+}
+
+/**
+ * Returns the oldest record of all rings and writes its ring into "oldest_ring", or returns NULL if they are drained.
+ */
+static Log_Record *log_rings_oldest(Log_Ring *rings, Log_Ring **oldest_ring) {
+    Log_Record *oldest = NULL;
+    *oldest_ring = NULL;
+
+    for (Log_Ring *ring = rings; ring != NULL; ring = ring->next) {
+        Log_Record *record = log_ring_peek(ring);
+        if (record == NULL) continue;
+
+        if (oldest == NULL || record->time_sec < oldest->time_sec || (record->time_sec == oldest->time_sec && record->time_nsec < oldest->time_nsec)) {
+            oldest = record;
+            *oldest_ring = ring;
+        }
+    }
+
+    return oldest;
+}
+
+/**
+ * Writes every record committed before the call in timestamp order, returns number of records written.
+ * @Important: Should be called with "log_writer_mutex" locked.
+ */
+static s64 log_drain() {
+    FILE *out = log_output == NULL ? stderr : log_output;
+    s64 written = 0;
+
+    Log_Ring *rings = log_rings_drain_start();
+
+    while (true) {
+        Log_Ring *oldest_ring;
+        Log_Record *oldest = log_rings_oldest(rings, &oldest_ring);
+        if (oldest == NULL) break;
+
+        struct timespec ts = { .tv_sec = oldest->time_sec, .tv_nsec = oldest->time_nsec };
+        log_write_prefix(out, oldest->level, ts, oldest_ring->thread_id, oldest->file_name, oldest->line, oldest->function_name);
+        log_write_message(out, oldest->format, (const u8 *)oldest + sizeof(Log_Record), (const u8 *)oldest + oldest->size);
+        fputc('\n', out);
+
+        log_ring_pop(oldest_ring, oldest);
+        written++;
+    }
+
+    if (written > 0) {
+        fflush(out);
+    }
+
+    log_rings_recycle();
+
+    return written;
+}
+
+/**
+ * Returns true if any ring has records that aren't written yet.
+ * @Important: Should be called with "log_writer_mutex" locked, since drain can move rings out of the list.
+ */
+static bool log_rings_pending() {
+    for (Log_Ring *ring = atomic_load_explicit(&log_rings, memory_order_acquire); ring != NULL; ring = ring->next) {
+        if (atomic_load(&ring->write) != atomic_load(&ring->read)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void log_writer_procedure(void *data) {
+    (void)data;
+
+    while (true) {
+        mutex_lock(&log_writer_mutex);
+        s64 written = log_drain();
+        mutex_unlock(&log_writer_mutex);
+
+        if (written > 0) {
+            continue;
+        }
+
+        // Records committed before the flag is seen are caught by the check, the ones after it signal.
+        mutex_lock(&log_wake_mutex);
+        atomic_store(&log_writer_sleeping, true);
+
+        mutex_lock(&log_writer_mutex);
+        bool pending = log_rings_pending();
+        mutex_unlock(&log_writer_mutex);
+
+        if (!pending) {
+            condition_wait(&log_wake, &log_wake_mutex, LOG_WRITER_WAIT_MS);
+        }
+        atomic_store(&log_writer_sleeping, false);
+        mutex_unlock(&log_wake_mutex);
+    }
+}
+
+void log_flush() {
+    mutex_lock(&log_writer_mutex);
+    log_drain();
+    mutex_unlock(&log_writer_mutex);
+}
+
+
+
+/**
+ * Crash writing.
+ * Signal handler can't use stdio, it may have been interrupted in the middle of "fprintf()" holding the stream lock.
+ * So each record is formatted into a static line by hand, and the line is given to write(2) on output's descriptor.
+ * Conversions keep their width and precision, but not the flags, %e, %g and %a are written as %f, which is enough to read what happened.
+ */
+
+#define LOG_CRASH_LINE_SIZE 4096
+
+typedef struct log_line {
+    char data[LOG_CRASH_LINE_SIZE];
+    s64 length;
+} Log_Line;
+
+static Log_Line log_crash_line;
+
+static void log_line_put(Log_Line *line, const char *data, s64 length) {
+    s64 space = LOG_CRASH_LINE_SIZE - 1 - line->length;
+    if (length > space) length = space;
+    memcpy(line->data + line->length, data, length);
+    line->length += length;
+}
+
+static void log_line_put_string(Log_Line *line, const char *string) {
+    log_line_put(line, string, strlen(string));
+}
+
+/**
+ * Puts converted value padded to the width, '-' flag is the only one that is kept, since it is the only one that changes where text goes.
+ */
+static void log_line_put_padded(Log_Line *line, const Log_Spec *spec, s32 width, const char *data, s64 length) {
+    bool left = spec->start[1] == '-';
+    for (s64 i = length; !left && i < width; i++) log_line_put(line, " ", 1);
+    log_line_put(line, data, length);
+    for (s64 i = length; left && i < width; i++) log_line_put(line, " ", 1);
+}
+
+static s64 log_format_unsigned(u64 value, u32 base, bool upper, char *buffer) {
+    const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char reversed[24];
+    s64 length = 0;
+    do {
+        reversed[length++] = digits[value % base];
+        value /= base;
+    } while (value != 0);
+
+    for (s64 i = 0; i < length; i++) {
+        buffer[i] = reversed[length - 1 - i];
+    }
+    return length;
+}
+
+/**
+ * Writes "value" with "precision" <= 9 digits after the dot, last digit might be off by one since it's computed in doubles.
+ * Values that don't fit into 64 bits are written as the shortest float.
+ */
+static s64 log_format_fixed(double value, s32 precision, char *buffer) {
+    s64 length = num_format_fixed(value, precision, buffer);
+    if (length >= 0) return length;
+
+    if (!(value > -1e18 && value < 1e18)) return num_format_f32((float)value, buffer);
+
+    length = 0;
+    if (value < 0) {
+        buffer[length++] = '-';
+        value = -value;
+    }
+
+    u64 scale = 1;
+    for (s32 i = 0; i < precision; i++) scale *= 10;
+
+    u64 whole = (u64)value;
+    u64 fraction = (u64)((value - (double)whole) * (double)scale + 0.5);
+    if (fraction >= scale) {
+        whole += 1;
+        fraction -= scale;
+    }
+
+    length += num_format_u64(whole, buffer + length);
+    if (precision > 0) {
+        buffer[length++] = '.';
+        for (s32 i = precision - 1; i >= 0; i--) {
+            buffer[length + i] = '0' + fraction % 10;
+            fraction /= 10;
+        }
+        length += precision;
+    }
+    return length;
+}
+
+/**
+ * Reads width and precision written into the spec, the ones given with '*' are taken from "star".
+ */
+static void log_spec_numbers(const Log_Spec *spec, const int *star, s32 *width, s32 *precision) {
+    const char *c = spec->start + 1;
+    s32 stars_used = 0;
+    *width = 0;
+    *precision = -1;
+
+    while (*c == '-' || *c == '+' || *c == ' ' || *c == '#' || *c == '0') c++;
+
+    if (*c == '*') {
+        *width = star[stars_used++];
+        c++;
+    } else {
+        while (*c >= '0' && *c <= '9') *width = *width * 10 + (*c++ - '0');
+    }
+
+    if (*c == '.') {
+        c++;
+        *precision = 0;
+        if (*c == '*') {
+            *precision = star[stars_used];
+        } else {
+            while (*c >= '0' && *c <= '9') *precision = *precision * 10 + (*c++ - '0');
+        }
+    }
+}
+
+static void log_line_put_message(Log_Line *line, const char *format, const u8 *cursor, const u8 *end) {
+    char number[32];
+
+    for (const char *c = format; *c; ) {
+        if (*c != '%') {
+            const char *literal = c;
+            while (*c && *c != '%') c++;
+            log_line_put(line, literal, c - literal);
+            continue;
+        }
+
+        Log_Spec spec;
+        c = log_parse_spec(c, &spec);
+
+        if (spec.conversion == '%') {
+            log_line_put(line, "%", 1);
+            continue;
+        }
+
+        int star[2] = { 0 };
+        for (s32 i = 0; i < spec.stars; i++) {
+            star[i] = (int)(s64)log_read_slot(&cursor, end);
+        }
+
+        s32 width, precision;
+        log_spec_numbers(&spec, star, &width, &precision);
+
+        if (spec.conversion == 's') {
+            const char *str = "";
+            u64 length = 0;
+            if (cursor + sizeof(u64) < end) {
+                length = log_read_slot(&cursor, end);
+                str = (const char *)cursor;
+                cursor += log_align(length + 1);
+            }
+            if (precision >= 0 && (u64)precision < length) length = precision;
+            log_line_put_padded(line, &spec, width, str, length);
+            continue;
+        }
+
+        u64 value = 0;
+        s64 length = 0;
+        switch (spec.conversion) {
+            case 'd':
+            case 'i':
+                value = log_read_slot(&cursor, end);
+                switch (spec.length) {
+                    case LOG_LENGTH_HH: value = (u64)(s64)(signed char)value; break;
+                    case LOG_LENGTH_H:  value = (u64)(s64)(short)value; break;
+                    case LOG_LENGTH_NONE: value = (u64)(s64)(int)value; break;
+                    default: break;
+                }
+                length = num_format_s64((s64)value, number);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                value = log_read_slot(&cursor, end);
+                switch (spec.length) {
+                    case LOG_LENGTH_HH: value = (unsigned char)value; break;
+                    case LOG_LENGTH_H:  value = (unsigned short)value; break;
+                    case LOG_LENGTH_NONE: value = (unsigned int)value; break;
+                    default: break;
+                }
+                length = log_format_unsigned(value, spec.conversion == 'o' ? 8 : spec.conversion == 'u' ? 10 : 16, spec.conversion == 'X', number);
+                break;
+            case 'p':
+                value = log_read_slot(&cursor, end);
+                number[0] = '0';
+                number[1] = 'x';
+                length = 2 + log_format_unsigned(value, 16, false, number + 2);
+                break;
+            case 'c':
+                number[0] = (char)log_read_slot(&cursor, end);
+                length = 1;
+                break;
+            case 'f': case 'F':
+            case 'e': case 'E':
+            case 'g': case 'G':
+            case 'a': case 'A': {
+                value = log_read_slot(&cursor, end);
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                length = log_format_fixed(d, precision < 0 ? 6 : precision > 9 ? 9 : precision, number);
+                break;
+            }
+            case 'n':
+                log_read_slot(&cursor, end);
+                continue;
+            default:
+                log_line_put(line, spec.start, spec.size);
+                continue;
+        }
+
+        log_line_put_padded(line, &spec, width, number, length);
+    }
+}
+
+static void log_line_put_prefix(Log_Line *line, const Log_Record *record, u64 thread_id) {
+    char number[NUM_S64_MAX_CHARS];
+
+    switch (record->level) {
+#ifdef LOG_INFO_COLOR
+        case LOG_LEVEL_INFO:    log_line_put_string(line, ANSI_BLUE"[INFO]"ANSI_RESET); break;
+        case LOG_LEVEL_WARNING: log_line_put_string(line, ANSI_YELLOW"[WARN]"ANSI_RESET); break;
+        case LOG_LEVEL_ERROR:   log_line_put_string(line, ANSI_RED"[ERRO]"ANSI_RESET); break;
+#else
+        case LOG_LEVEL_INFO:    log_line_put_string(line, "[INFO]"); break;
+        case LOG_LEVEL_WARNING: log_line_put_string(line, "[WARN]"); break;
+        case LOG_LEVEL_ERROR:   log_line_put_string(line, "[ERRO]"); break;
+#endif
+    }
+
+#ifdef LOG_INFO_TIME
+    // Local time can't be computed in signal handler, so only records of the cached second get the date.
+    log_line_put(line, " ", 1);
+    if (record->time_sec == log_cached_second) {
+        log_line_put_string(line, log_cached_time);
+    } else {
+        log_line_put(line, number, num_format_s64(record->time_sec, number));
+    }
+
+    char millis[4] = { '.', '0' + (record->time_nsec / 100000000) % 10, '0' + (record->time_nsec / 10000000) % 10, '0' + (record->time_nsec / 1000000) % 10 };
+    log_line_put(line, millis, sizeof(millis));
 #endif
 
+#ifdef LOG_INFO_THREAD
+    log_line_put_string(line, " [TID ");
+    log_line_put(line, number, num_format_u64(thread_id, number));
+    log_line_put(line, "]", 1);
+#else
+    (void)thread_id;
+#endif
 
 #ifdef LOG_INFO_FILE
-    fprintf(log_output, " %s", file_name);
+    log_line_put(line, " ", 1);
+    log_line_put_string(line, record->file_name);
 #endif
 
 #ifdef LOG_INFO_LINE
-    fprintf(log_output, ":%d", line);
+    log_line_put(line, ":", 1);
+    log_line_put(line, number, num_format_s64(record->line, number));
 #endif
 
 #ifdef LOG_INFO_FUNC
-    fprintf(log_output, " %s():", function_name);
+    log_line_put(line, " ", 1);
+    log_line_put_string(line, record->function_name);
+    log_line_put(line, "():", 3);
+#endif
+
+    log_line_put(line, " ", 1);
+}
+
+static void log_write_all(int fd, const char *data, s64 length) {
+    while (length > 0) {
+#if defined(_WIN32)
+        s64 written = _write(fd, data, (unsigned int)length);
+#else
+        s64 written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) continue;
 #endif
+        if (written <= 0) return;
+        data += written;
+        length -= written;
+    }
+}
 
+/**
+ * Same as "log_drain()", but only with async-signal-safe calls, rings aren't recycled.
+ * @Important: Should be called with "log_writer_mutex" locked.
+ */
+static void log_drain_crash() {
+    Log_Ring *rings = log_rings_drain_start();
 
-    fprintf(log_output, " ");
+    while (true) {
+        Log_Ring *oldest_ring;
+        Log_Record *oldest = log_rings_oldest(rings, &oldest_ring);
+        if (oldest == NULL) break;
 
-    vfprintf(log_output, format, args);
+        Log_Line *line = &log_crash_line;
+        line->length = 0;
+        log_line_put_prefix(line, oldest, oldest_ring->thread_id);
+        log_line_put_message(line, oldest->format, (const u8 *)oldest + sizeof(Log_Record), (const u8 *)oldest + oldest->size);
+        line->data[line->length++] = '\n';
 
-    fprintf(log_output, "\n");
+        log_write_all(log_output_fd, line->data, line->length);
 
-    fflush(log_output); // Ensure it's written.
-    va_end(args);
+        log_ring_pop(oldest_ring, oldest);
+    }
+}
+
+static void log_crash_handler(int signal_number) {
+    // Writer thread might be the one that crashed while holding the lock, so not waiting forever.
+    for (s32 attempt = 0; attempt < 100; attempt++) {
+        if (mutex_try_lock(&log_writer_mutex)) {
+            log_drain_crash();
+            mutex_unlock(&log_writer_mutex);
+            break;
+        }
+        thread_sleep_ms(1);
+    }
+
+    signal(signal_number, SIG_DFL);
+    raise(signal_number);
+}
+
+static void log_exit_handler() {
+    log_flush();
+}
+
+/**
+ * Called on the exiting thread, ring isn't touched by it anymore.
+ * If thread logs again from later destructors, it registers another ring.
+ */
+#if defined(_WIN32)
+static VOID WINAPI log_ring_thread_exit(PVOID data) {
+#else
+static void log_ring_thread_exit(void *data) {
+#endif
+    Log_Ring *ring = data;
+    if (ring == NULL) {
+        return;
+    }
+
+    log_thread_ring = NULL;
+    atomic_store(&ring->exited, true);
+}
+
+/**
+ * Creates ring for the calling thread, or reuses one of exited thread, and starts the writer thread on first call.
+ */
+static Log_Ring *log_ring_register() {
+    mutex_lock(&log_register_mutex);
+
+    // Writer can be behind threads that come and go, then rings of exited ones are drained here, so their count stays bounded.
+    if (log_rings_free == NULL && log_rings_count >= LOG_RINGS_SOFT_LIMIT) {
+        mutex_unlock(&log_register_mutex);
+        log_flush();
+        mutex_lock(&log_register_mutex);
+    }
+
+    Log_Ring *ring = log_rings_free;
+    if (ring != NULL) {
+        log_rings_free = ring->next;
+        ring->cached_read = atomic_load(&ring->read);
+        atomic_store(&ring->exited, false);
+    } else {
+        ring = calloc(1, sizeof(Log_Ring));
+        if (ring == NULL) {
+            mutex_unlock(&log_register_mutex);
+            return NULL;
+        }
+        log_rings_count++;
+    }
+
+    ring->thread_id = thread_current_id();
+
+    ring->next = atomic_load_explicit(&log_rings, memory_order_relaxed);
+    atomic_store_explicit(&log_rings, ring, memory_order_release);
+
+#if defined(_WIN32)
+    if (log_ring_key == FLS_OUT_OF_INDEXES) {
+        log_ring_key = FlsAlloc(log_ring_thread_exit);
+    }
+    if (log_ring_key != FLS_OUT_OF_INDEXES) {
+        FlsSetValue(log_ring_key, ring);
+    }
+#else
+    if (!log_ring_key_created) {
+        log_ring_key_created = pthread_key_create(&log_ring_key, log_ring_thread_exit) == 0;
+    }
+    if (log_ring_key_created) {
+        pthread_setspecific(log_ring_key, ring);
+    }
+#endif
+
+    if (!atomic_load(&log_writer_started)) {
+        atomic_store(&log_writer_started, true);
+
+        atexit(log_exit_handler);
+        signal(SIGSEGV, log_crash_handler);
+        signal(SIGABRT, log_crash_handler);
+        signal(SIGFPE,  log_crash_handler);
+        signal(SIGILL,  log_crash_handler);
+
+        if (!thread_create(&log_writer_thread, log_writer_procedure, NULL)) {
+            fprintf(stderr, "Couldn't start log writer thread, logs will only be written on flush.\n");
+        }
+    }
+
+    mutex_unlock(&log_register_mutex);
+
+    log_thread_ring = ring;
+    return ring;
 }
+
+#endif
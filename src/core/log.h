@@ -23,6 +23,12 @@ typedef enum log_level : u8 {
 #define LOG_INFO_LINE
 #define LOG_INFO_FUNC
 
+/**
+ * With LOG_ASYNC, "log_print()" only captures the record (level, callsite, timestamp, arguments) into the calling thread's ring buffer, formatting and writing is done by background writer thread.
+ * Comment it out to format and write synchronously on the caller thread.
+ */
+#define LOG_ASYNC
+
 
 #define LOG_INFO(format, ...)       log_print(LOG_LEVEL_INFO, __FILE__, __LINE__, __func__, format, ##__VA_ARGS__)
 #define LOG_WARNING(format, ...)    log_print(LOG_LEVEL_WARNING, __FILE__, __LINE__, __func__, format, ##__VA_ARGS__)
@@ -44,4 +50,10 @@ void log_set_output(FILE *stream);
  */
 void log_print(Log_Level level, const char *file_name, s64 line, const char *function_name, char *format, ...);
 
+/**
+ * Blocks until every record logged so far is written to the output.
+ * @Important: Called automatically at exit and on crash signals, call it manually only before handing output stream to someone else.
+ */
+void log_flush();
+
 #endif
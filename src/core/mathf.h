@@ -302,6 +302,10 @@ static inline bool aabb_touches_point(AABB *box, Vec2f point) {
     return value_inside_domain(box->p0.x, box->p1.x, point.x) && value_inside_domain(box->p0.y, box->p1.y, point.y);
 }
 
+static inline bool aabb_touches_aabb(AABB *a, AABB *b) {
+    return a->p0.x <= b->p1.x && b->p0.x <= a->p1.x && a->p0.y <= b->p1.y && b->p0.y <= a->p1.y;
+}
+
 
 // Rework obb with static inline functions, NOT macros.
 typedef struct oriented_bounding_box {
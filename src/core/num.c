@@ -0,0 +1,740 @@
+#include "core/num.h"
+#include "core/type.h"
+#include "core/str.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+
+
+
+/**
+ * Integer formatting.
+ * Digits are written two at a time from the end, length is computed up front from the bit width, so there is no branching per digit.
+ */
+
+static const char NUM_DIGIT_PAIRS[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const u64 NUM_POW10[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+    10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+static inline s64 num_count_digits(u64 value) {
+    // 1233 / 4096 is approximation of log10(2).
+    s64 t = ((64 - __builtin_clzll(value | 1)) * 1233) >> 12;
+    return t - ((value | 1) < NUM_POW10[t]) + 1;
+}
+
+static inline void num_write_digits(u64 value, char *end) {
+    while (value >= 100) {
+        u64 pair = (value % 100) * 2;
+        value /= 100;
+        end -= 2;
+        memcpy(end, NUM_DIGIT_PAIRS + pair, 2);
+    }
+
+    if (value >= 10) {
+        end -= 2;
+        memcpy(end, NUM_DIGIT_PAIRS + value * 2, 2);
+    } else {
+        *(--end) = (char)('0' + value);
+    }
+}
+
+s64 num_format_u64(u64 value, char *buffer) {
+    s64 length = num_count_digits(value);
+    num_write_digits(value, buffer + length);
+    return length;
+}
+
+s64 num_format_s64(s64 value, char *buffer) {
+    u64 negative = value < 0;
+    u64 magnitude = negative ? (u64)0 - (u64)value : (u64)value;
+
+    buffer[0] = '-';
+    return negative + num_format_u64(magnitude, buffer + negative);
+}
+
+
+
+
+
+/**
+ * Integer parsing.
+ */
+
+s64 num_parse_s64(String str) {
+    s64 i = 0;
+    u64 negative = 0;
+
+    if (i < str.length && (str.data[i] == '-' || str.data[i] == '+')) {
+        negative = str.data[i] == '-';
+        i++;
+    }
+
+    u64 result = 0;
+    for (; i < str.length && (u8)(str.data[i] - '0') <= 9; i++) {
+        result = result * 10 + (u64)(str.data[i] - '0');
+    }
+
+    return (s64)(negative ? (u64)0 - result : result);
+}
+
+
+
+
+/**
+ * Float parsing.
+ * Decimal is first reduced to "w * 10^q" with at most 19 significant digits in "w", then converted to float.
+ * @Important: Tables are truncated 128 bit normalized powers of five for q in [ NUM_F32_SMALLEST_POW10, NUM_F32_LARGEST_POW10 ], generated the same way as in the Eisel-Lemire paper.
+ */
+
+#define NUM_F32_SMALLEST_POW10  -65
+#define NUM_F32_LARGEST_POW10    38
+#define NUM_F32_MANTISSA_BITS    23
+#define NUM_F32_MINIMUM_EXPONENT -127
+#define NUM_F32_INFINITE_POWER   0xff
+
+static const u64 NUM_POW5_128[] = {
+    0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull, // 5^-65
+    0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull, // 5^-64
+    0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull, // 5^-63
+    0x83a3eeeef9153e89ull, 0x1953cf68300424acull, // 5^-62
+    0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull, // 5^-61
+    0xcdb02555653131b6ull, 0x3792f412cb06794dull, // 5^-60
+    0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull, // 5^-59
+    0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull, // 5^-58
+    0xc8de047564d20a8bull, 0xf245825a5a445275ull, // 5^-57
+    0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull, // 5^-56
+    0x9ced737bb6c4183dull, 0x55464dd69685606bull, // 5^-55
+    0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull, // 5^-54
+    0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull, // 5^-53
+    0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull, // 5^-52
+    0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull, // 5^-51
+    0xef73d256a5c0f77cull, 0x963e66858f6d4440ull, // 5^-50
+    0x95a8637627989aadull, 0xdde7001379a44aa8ull, // 5^-49
+    0xbb127c53b17ec159ull, 0x5560c018580d5d52ull, // 5^-48
+    0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull, // 5^-47
+    0x9226712162ab070dull, 0xcab3961304ca70e8ull, // 5^-46
+    0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull, // 5^-45
+    0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull, // 5^-44
+    0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull, // 5^-43
+    0xb267ed1940f1c61cull, 0x55f038b237591ed3ull, // 5^-42
+    0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull, // 5^-41
+    0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull, // 5^-40
+    0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull, // 5^-39
+    0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull, // 5^-38
+    0x881cea14545c7575ull, 0x7e50d64177da2e54ull, // 5^-37
+    0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull, // 5^-36
+    0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull, // 5^-35
+    0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull, // 5^-34
+    0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull, // 5^-33
+    0xcfb11ead453994baull, 0x67de18eda5814af2ull, // 5^-32
+    0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull, // 5^-31
+    0xa2425ff75e14fc31ull, 0xa1258379a94d028dull, // 5^-30
+    0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull, // 5^-29
+    0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull, // 5^-28
+    0x9e74d1b791e07e48ull, 0x775ea264cf55347eull, // 5^-27
+    0xc612062576589ddaull, 0x95364afe032a819eull, // 5^-26
+    0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull, // 5^-25
+    0x9abe14cd44753b52ull, 0xc4926a9672793543ull, // 5^-24
+    0xc16d9a0095928a27ull, 0x75b7053c0f178294ull, // 5^-23
+    0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull, // 5^-22
+    0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull, // 5^-21
+    0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull, // 5^-20
+    0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull, // 5^-19
+    0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull, // 5^-18
+    0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull, // 5^-17
+    0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull, // 5^-16
+    0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull, // 5^-15
+    0xb424dc35095cd80full, 0x538484c19ef38c95ull, // 5^-14
+    0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull, // 5^-13
+    0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull, // 5^-12
+    0xafebff0bcb24aafeull, 0xf78f69a51539d749ull, // 5^-11
+    0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull, // 5^-10
+    0x89705f4136b4a597ull, 0x31680a88f8953031ull, // 5^-9
+    0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull, // 5^-8
+    0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull, // 5^-7
+    0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull, // 5^-6
+    0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull, // 5^-5
+    0xd1b71758e219652bull, 0xd3c36113404ea4a9ull, // 5^-4
+    0x83126e978d4fdf3bull, 0x645a1cac083126eaull, // 5^-3
+    0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull, // 5^-2
+    0xccccccccccccccccull, 0xcccccccccccccccdull, // 5^-1
+    0x8000000000000000ull, 0x0000000000000000ull, // 5^0
+    0xa000000000000000ull, 0x0000000000000000ull, // 5^1
+    0xc800000000000000ull, 0x0000000000000000ull, // 5^2
+    0xfa00000000000000ull, 0x0000000000000000ull, // 5^3
+    0x9c40000000000000ull, 0x0000000000000000ull, // 5^4
+    0xc350000000000000ull, 0x0000000000000000ull, // 5^5
+    0xf424000000000000ull, 0x0000000000000000ull, // 5^6
+    0x9896800000000000ull, 0x0000000000000000ull, // 5^7
+    0xbebc200000000000ull, 0x0000000000000000ull, // 5^8
+    0xee6b280000000000ull, 0x0000000000000000ull, // 5^9
+    0x9502f90000000000ull, 0x0000000000000000ull, // 5^10
+    0xba43b74000000000ull, 0x0000000000000000ull, // 5^11
+    0xe8d4a51000000000ull, 0x0000000000000000ull, // 5^12
+    0x9184e72a00000000ull, 0x0000000000000000ull, // 5^13
+    0xb5e620f480000000ull, 0x0000000000000000ull, // 5^14
+    0xe35fa931a0000000ull, 0x0000000000000000ull, // 5^15
+    0x8e1bc9bf04000000ull, 0x0000000000000000ull, // 5^16
+    0xb1a2bc2ec5000000ull, 0x0000000000000000ull, // 5^17
+    0xde0b6b3a76400000ull, 0x0000000000000000ull, // 5^18
+    0x8ac7230489e80000ull, 0x0000000000000000ull, // 5^19
+    0xad78ebc5ac620000ull, 0x0000000000000000ull, // 5^20
+    0xd8d726b7177a8000ull, 0x0000000000000000ull, // 5^21
+    0x878678326eac9000ull, 0x0000000000000000ull, // 5^22
+    0xa968163f0a57b400ull, 0x0000000000000000ull, // 5^23
+    0xd3c21bcecceda100ull, 0x0000000000000000ull, // 5^24
+    0x84595161401484a0ull, 0x0000000000000000ull, // 5^25
+    0xa56fa5b99019a5c8ull, 0x0000000000000000ull, // 5^26
+    0xcecb8f27f4200f3aull, 0x0000000000000000ull, // 5^27
+    0x813f3978f8940984ull, 0x4000000000000000ull, // 5^28
+    0xa18f07d736b90be5ull, 0x5000000000000000ull, // 5^29
+    0xc9f2c9cd04674edeull, 0xa400000000000000ull, // 5^30
+    0xfc6f7c4045812296ull, 0x4d00000000000000ull, // 5^31
+    0x9dc5ada82b70b59dull, 0xf020000000000000ull, // 5^32
+    0xc5371912364ce305ull, 0x6c28000000000000ull, // 5^33
+    0xf684df56c3e01bc6ull, 0xc732000000000000ull, // 5^34
+    0x9a130b963a6c115cull, 0x3c7f400000000000ull, // 5^35
+    0xc097ce7bc90715b3ull, 0x4b9f100000000000ull, // 5^36
+    0xf0bdc21abb48db20ull, 0x1e86d40000000000ull, // 5^37
+    0x96769950b50d88f4ull, 0x1314448000000000ull, // 5^38
+};
+
+static const float NUM_F32_EXACT_POW10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+static inline void num_mul_128(u64 a, u64 b, u64 *high, u64 *low) {
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (u64)(product >> 64);
+    *low  = (u64)product;
+}
+
+static float num_parse_f32_fallback(String str) {
+    char stack_buffer[128];
+    char *buffer = str.length < (s64)sizeof(stack_buffer) ? stack_buffer : malloc(str.length + 1);
+
+    memcpy(buffer, str.data, str.length);
+    buffer[str.length] = '\0';
+
+    float result = strtof(buffer, NULL);
+
+    if (buffer != stack_buffer) {
+        free(buffer);
+    }
+
+    return result;
+}
+
+/**
+ * Eisel-Lemire conversion of "w * 10^q" into float bits without the sign.
+ * Returns false if the result can't be decided from 128 bit product.
+ */
+static bool num_eisel_lemire_f32(u64 w, s64 q, u32 *bits) {
+    if (w == 0 || q < NUM_F32_SMALLEST_POW10) {
+        *bits = 0;
+        return true;
+    }
+
+    if (q > NUM_F32_LARGEST_POW10) {
+        *bits = (u32)NUM_F32_INFINITE_POWER << NUM_F32_MANTISSA_BITS;
+        return true;
+    }
+
+    s64 lz = __builtin_clzll(w);
+    w <<= lz;
+
+    // Only upper bits of the product matter, second half of power is used only when the first one leaves them ambiguous.
+    const u64 precision_mask = 0xffffffffffffffffull >> (NUM_F32_MANTISSA_BITS + 3);
+    s64 index = 2 * (q - NUM_F32_SMALLEST_POW10);
+
+    u64 high, low;
+    num_mul_128(w, NUM_POW5_128[index], &high, &low);
+
+    if ((high & precision_mask) == precision_mask) {
+        u64 second_high, second_low;
+        num_mul_128(w, NUM_POW5_128[index + 1], &second_high, &second_low);
+        low += second_high;
+        if (second_high > low) {
+            high++;
+        }
+    }
+
+    if (low == 0xffffffffffffffffull && (q < -27 || q > 55)) {
+        return false;
+    }
+
+    s64 upper_bit = (s64)(high >> 63);
+    s64 shift = upper_bit + 64 - NUM_F32_MANTISSA_BITS - 3;
+    u64 mantissa = high >> shift;
+
+    // floor(log2(10^q)) + 63.
+    s64 power2 = (((152170 + 65536) * q) >> 16) + 63 + upper_bit - lz - NUM_F32_MINIMUM_EXPONENT;
+
+    if (power2 <= 0) {
+        // Subnormal.
+        if (-power2 + 1 >= 64) {
+            *bits = 0;
+            return true;
+        }
+
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < (1ull << NUM_F32_MANTISSA_BITS) ? 0 : 1;
+
+        *bits = (u32)(mantissa & ((1ull << NUM_F32_MANTISSA_BITS) - 1)) | ((u32)power2 << NUM_F32_MANTISSA_BITS);
+        return true;
+    }
+
+    // Exactly halfway between two floats, round to even, possible only for small q.
+    if (low <= 1 && q >= -17 && q <= 10 && (mantissa & 3) == 1 && (mantissa << shift) == high) {
+        mantissa &= ~1ull;
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+
+    if (mantissa >= (2ull << NUM_F32_MANTISSA_BITS)) {
+        mantissa = 1ull << NUM_F32_MANTISSA_BITS;
+        power2++;
+    }
+
+    mantissa &= ~(1ull << NUM_F32_MANTISSA_BITS);
+
+    if (power2 >= NUM_F32_INFINITE_POWER) {
+        *bits = (u32)NUM_F32_INFINITE_POWER << NUM_F32_MANTISSA_BITS;
+        return true;
+    }
+
+    *bits = (u32)mantissa | ((u32)power2 << NUM_F32_MANTISSA_BITS);
+    return true;
+}
+
+float num_parse_f32(String str) {
+    s64 i = 0;
+    bool negative = false;
+
+    if (i < str.length && (str.data[i] == '-' || str.data[i] == '+')) {
+        negative = str.data[i] == '-';
+        i++;
+    }
+
+    // Symmetric with "num_format_f32()" output.
+    if (str.length - i >= 3 && !memcmp(str.data + i, "inf", 3)) {
+        return negative ? -INFINITY : INFINITY;
+    }
+
+    if (str.length - i >= 3 && !memcmp(str.data + i, "nan", 3)) {
+        return NAN;
+    }
+
+    u64 w = 0;
+    s64 digits = 0;
+    s64 exponent = 0;
+    bool leading = true;
+
+    for (; i < str.length && (u8)(str.data[i] - '0') <= 9; i++) {
+        if (leading && str.data[i] == '0') continue;
+        leading = false;
+        if (digits < 19) {
+            w = w * 10 + (u64)(str.data[i] - '0');
+        } else {
+            exponent++;
+        }
+        digits++;
+    }
+
+    if (i < str.length && str.data[i] == '.') {
+        i++;
+        for (; i < str.length && (u8)(str.data[i] - '0') <= 9; i++) {
+            if (leading && str.data[i] == '0') {
+                exponent--;
+                continue;
+            }
+            leading = false;
+            if (digits < 19) {
+                w = w * 10 + (u64)(str.data[i] - '0');
+                exponent--;
+            }
+            digits++;
+        }
+    }
+
+    if (i < str.length && (str.data[i] == 'e' || str.data[i] == 'E')) {
+        s64 j = i + 1;
+        bool exponent_negative = false;
+
+        if (j < str.length && (str.data[j] == '-' || str.data[j] == '+')) {
+            exponent_negative = str.data[j] == '-';
+            j++;
+        }
+
+        if (j < str.length && (u8)(str.data[j] - '0') <= 9) {
+            s64 explicit_exponent = 0;
+            for (; j < str.length && (u8)(str.data[j] - '0') <= 9; j++) {
+                if (explicit_exponent < 100000) {
+                    explicit_exponent = explicit_exponent * 10 + (str.data[j] - '0');
+                }
+            }
+            exponent += exponent_negative ? -explicit_exponent : explicit_exponent;
+            i = j;
+        }
+    }
+
+    // Dropped digits make "w" a truncation, rounding can't be decided without them.
+    if (digits > 19) {
+        return num_parse_f32_fallback(STR(i, str.data));
+    }
+
+    // Clinger fast path, both operands are exact, so single correctly rounded operation gives correct result.
+    if (exponent >= -10 && exponent <= 10 && w <= (1ull << (NUM_F32_MANTISSA_BITS + 1))) {
+        float value = (float)w;
+        value = exponent < 0 ? value / NUM_F32_EXACT_POW10[-exponent] : value * NUM_F32_EXACT_POW10[exponent];
+        return negative ? -value : value;
+    }
+
+    u32 bits;
+    if (!num_eisel_lemire_f32(w, exponent, &bits)) {
+        return num_parse_f32_fallback(STR(i, str.data));
+    }
+
+    bits |= (u32)negative << 31;
+
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+
+
+
+/**
+ * Shortest float formatting.
+ * Port of Ryu "f2s" (Ulf Adams, 2018), computes the shortest decimal in the rounding interval of the float.
+ */
+
+#define NUM_F32_BIAS 127
+#define NUM_POW5_INV_BITCOUNT 59
+#define NUM_POW5_BITCOUNT 61
+
+static const u64 NUM_POW5_INV_SPLIT[] = {
+    576460752303423489u, 461168601842738791u, 368934881474191033u, 295147905179352826u,
+    472236648286964522u, 377789318629571618u, 302231454903657294u, 483570327845851670u,
+    386856262276681336u, 309485009821345069u, 495176015714152110u, 396140812571321688u,
+    316912650057057351u, 507060240091291761u, 405648192073033409u, 324518553658426727u,
+    519229685853482763u, 415383748682786211u, 332306998946228969u, 531691198313966350u,
+    425352958651173080u, 340282366920938464u, 544451787073501542u, 435561429658801234u,
+    348449143727040987u, 557518629963265579u, 446014903970612463u, 356811923176489971u,
+    570899077082383953u, 456719261665907162u, 365375409332725730u,
+};
+static const u64 NUM_POW5_SPLIT[] = {
+    1152921504606846976u, 1441151880758558720u, 1801439850948198400u, 2251799813685248000u,
+    1407374883553280000u, 1759218604441600000u, 2199023255552000000u, 1374389534720000000u,
+    1717986918400000000u, 2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+    2097152000000000000u, 1310720000000000000u, 1638400000000000000u, 2048000000000000000u,
+    1280000000000000000u, 1600000000000000000u, 2000000000000000000u, 1250000000000000000u,
+    1562500000000000000u, 1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+    1907348632812500000u, 1192092895507812500u, 1490116119384765625u, 1862645149230957031u,
+    1164153218269348144u, 1455191522836685180u, 1818989403545856475u, 2273736754432320594u,
+    1421085471520200371u, 1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+    1734723475976807094u, 2168404344971008868u, 1355252715606880542u, 1694065894508600678u,
+    2117582368135750847u, 1323488980084844279u, 1654361225106055349u, 2067951531382569187u,
+    1292469707114105741u, 1615587133892632177u, 2019483917365790221u, 1262177448353618888u,
+};
+
+// Bit length of 5^e, for 0 <= e <= 3528.
+static inline s32 num_pow5_bits(s32 e) {
+    return (s32)(((u32)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)), for 0 <= e <= 1650.
+static inline u32 num_log10_pow2(s32 e) {
+    return ((u32)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)), for 0 <= e <= 2620.
+static inline u32 num_log10_pow5(s32 e) {
+    return ((u32)e * 732923) >> 20;
+}
+
+static inline u32 num_pow5_factor(u32 value) {
+    u32 count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count;
+}
+
+static inline bool num_multiple_of_pow5(u32 value, u32 p) {
+    return num_pow5_factor(value) >= p;
+}
+
+static inline bool num_multiple_of_pow2(u32 value, u32 p) {
+    return (value & ((1u << p) - 1)) == 0;
+}
+
+static inline u32 num_mul_shift(u32 m, u64 factor, s32 shift) {
+    u64 bits0 = (u64)m * (u32)factor;
+    u64 bits1 = (u64)m * (u32)(factor >> 32);
+    u64 sum = (bits0 >> 32) + bits1;
+    return (u32)(sum >> (shift - 32));
+}
+
+/**
+ * Computes shortest "mantissa * 10^exponent" for finite non zero float given by raw ieee fields.
+ */
+static void num_f32_to_decimal(u32 ieee_mantissa, u32 ieee_exponent, u32 *out_mantissa, s32 *out_exponent) {
+    s32 e2;
+    u32 m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - NUM_F32_BIAS - NUM_F32_MANTISSA_BITS - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (s32)ieee_exponent - NUM_F32_BIAS - NUM_F32_MANTISSA_BITS - 2;
+        m2 = (1u << NUM_F32_MANTISSA_BITS) | ieee_mantissa;
+    }
+
+    bool accept_bounds = (m2 & 1) == 0;
+
+    // Rounding interval is [ mm, mp ] around mv, all scaled by 4.
+    u32 mv = 4 * m2;
+    u32 mp = 4 * m2 + 2;
+    u32 mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    u32 mm = 4 * m2 - 1 - mm_shift;
+
+    u32 vr, vp, vm;
+    s32 e10;
+    bool vm_is_trailing_zeros = false;
+    bool vr_is_trailing_zeros = false;
+    u8 last_removed_digit = 0;
+
+    if (e2 >= 0) {
+        u32 q = num_log10_pow2(e2);
+        e10 = (s32)q;
+        s32 k = NUM_POW5_INV_BITCOUNT + num_pow5_bits((s32)q) - 1;
+        s32 i = -e2 + (s32)q + k;
+        vr = num_mul_shift(mv, NUM_POW5_INV_SPLIT[q], i);
+        vp = num_mul_shift(mp, NUM_POW5_INV_SPLIT[q], i);
+        vm = num_mul_shift(mm, NUM_POW5_INV_SPLIT[q], i);
+
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            s32 l = NUM_POW5_INV_BITCOUNT + num_pow5_bits((s32)(q - 1)) - 1;
+            last_removed_digit = (u8)(num_mul_shift(mv, NUM_POW5_INV_SPLIT[q - 1], -e2 + (s32)q - 1 + l) % 10);
+        }
+
+        if (q <= 9) {
+            if (mv % 5 == 0) {
+                vr_is_trailing_zeros = num_multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_is_trailing_zeros = num_multiple_of_pow5(mm, q);
+            } else {
+                vp -= num_multiple_of_pow5(mp, q);
+            }
+        }
+    } else {
+        u32 q = num_log10_pow5(-e2);
+        e10 = (s32)q + e2;
+        s32 i = -e2 - (s32)q;
+        s32 k = num_pow5_bits(i) - NUM_POW5_BITCOUNT;
+        s32 j = (s32)q - k;
+        vr = num_mul_shift(mv, NUM_POW5_SPLIT[i], j);
+        vp = num_mul_shift(mp, NUM_POW5_SPLIT[i], j);
+        vm = num_mul_shift(mm, NUM_POW5_SPLIT[i], j);
+
+        if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+            j = (s32)q - 1 - (num_pow5_bits(i + 1) - NUM_POW5_BITCOUNT);
+            last_removed_digit = (u8)(num_mul_shift(mv, NUM_POW5_SPLIT[i + 1], j) % 10);
+        }
+
+        if (q <= 1) {
+            vr_is_trailing_zeros = true;
+            if (accept_bounds) {
+                vm_is_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 31) {
+            vr_is_trailing_zeros = num_multiple_of_pow2(mv, q - 1);
+        }
+    }
+
+    // Removing digits while interval still contains more than one candidate.
+    s32 removed = 0;
+    u32 output;
+    if (vm_is_trailing_zeros || vr_is_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_is_trailing_zeros &= vm % 10 == 0;
+            vr_is_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = (u8)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        if (vm_is_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_is_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = (u8)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+
+        if (vr_is_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+            // Exactly halfway, round to even.
+            last_removed_digit = 4;
+        }
+
+        output = vr + ((vr == vm && (!accept_bounds || !vm_is_trailing_zeros)) || last_removed_digit >= 5);
+    } else {
+        while (vp / 10 > vm / 10) {
+            last_removed_digit = (u8)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        output = vr + (vr == vm || last_removed_digit >= 5);
+    }
+
+    *out_mantissa = output;
+    *out_exponent = e10 + removed;
+}
+
+s64 num_format_f32(float value, char *buffer) {
+    u32 bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    u32 ieee_mantissa = bits & ((1u << NUM_F32_MANTISSA_BITS) - 1);
+    u32 ieee_exponent = (bits >> NUM_F32_MANTISSA_BITS) & NUM_F32_INFINITE_POWER;
+    s64 written = 0;
+
+    if (ieee_exponent == NUM_F32_INFINITE_POWER && ieee_mantissa != 0) {
+        memcpy(buffer, "nan", 3);
+        return 3;
+    }
+
+    if (bits >> 31) {
+        buffer[written++] = '-';
+    }
+
+    if (ieee_exponent == NUM_F32_INFINITE_POWER) {
+        memcpy(buffer + written, "inf", 3);
+        return written + 3;
+    }
+
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        memcpy(buffer + written, "0.0", 3);
+        return written + 3;
+    }
+
+    u32 mantissa;
+    s32 exponent;
+    num_f32_to_decimal(ieee_mantissa, ieee_exponent, &mantissa, &exponent);
+
+    char digits[NUM_U64_MAX_CHARS];
+    s64 length = num_format_u64(mantissa, digits);
+
+    // Decimal exponent of the first digit, value is "d.ddd * 10^point".
+    s64 point = exponent + length - 1;
+
+    if (point >= -5 && point < 9) {
+        if (point < 0) {
+            buffer[written++] = '0';
+            buffer[written++] = '.';
+            for (s64 i = 0; i < -point - 1; i++) {
+                buffer[written++] = '0';
+            }
+            memcpy(buffer + written, digits, length);
+            written += length;
+        } else if (point + 1 >= length) {
+            memcpy(buffer + written, digits, length);
+            written += length;
+            for (s64 i = length; i < point + 1; i++) {
+                buffer[written++] = '0';
+            }
+            buffer[written++] = '.';
+            buffer[written++] = '0';
+        } else {
+            memcpy(buffer + written, digits, point + 1);
+            written += point + 1;
+            buffer[written++] = '.';
+            memcpy(buffer + written, digits + point + 1, length - point - 1);
+            written += length - point - 1;
+        }
+
+        return written;
+    }
+
+    buffer[written++] = digits[0];
+    if (length > 1) {
+        buffer[written++] = '.';
+        memcpy(buffer + written, digits + 1, length - 1);
+        written += length - 1;
+    }
+    buffer[written++] = 'e';
+    written += num_format_s64(point, buffer + written);
+
+    return written;
+}
+
+
+
+
+/**
+ * Fixed precision formatting.
+ * Float times 10^precision has at most 24 + 21 significant bits for precision <= 9, so the product is exact in double and rounding it to integer gives the same digits as "printf()".
+ */
+
+s64 num_format_fixed(double value, s32 precision, char *buffer) {
+    if (precision < 0 || precision > 9 || (double)(float)value != value) {
+        return -1;
+    }
+
+    double scaled = nearbyint(fabs(value) * (double)NUM_POW10[precision]);
+    if (!(scaled < 9223372036854775808.0)) {
+        return -1;
+    }
+
+    u64 integer = (u64)scaled;
+    s64 written = 0;
+
+    if (signbit(value)) {
+        buffer[written++] = '-';
+    }
+
+    written += num_format_u64(integer / NUM_POW10[precision], buffer + written);
+
+    if (precision > 0) {
+        buffer[written++] = '.';
+        u64 fraction = integer % NUM_POW10[precision];
+        s64 fraction_length = num_count_digits(fraction);
+        for (s64 i = fraction_length; i < precision; i++) {
+            buffer[written++] = '0';
+        }
+        written += num_format_u64(fraction, buffer + written);
+    }
+
+    return written;
+}
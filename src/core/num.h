@@ -0,0 +1,61 @@
+#ifndef NUM_H
+#define NUM_H
+
+/**
+ * Numeric conversion.
+ * Parsing and formatting of numbers without going through libc "strto*()" and "printf()" family.
+ */
+
+#include "core/type.h"
+#include "core/str.h"
+
+
+/**
+ * Maximum number of characters "num_format_*()" functions can write, buffers passed to them should be at least that big.
+ * @Important: Formatting functions do not write null terminator.
+ */
+#define NUM_S64_MAX_CHARS 20
+#define NUM_U64_MAX_CHARS 20
+#define NUM_F32_MAX_CHARS 16
+#define NUM_FIXED_MAX_CHARS 24
+
+
+
+/**
+ * Parses signed integer in the form "[+-]digits".
+ * Parsing stops at the first non digit character, overflow wraps around.
+ */
+s64 num_parse_s64(String str);
+
+/**
+ * Parses float in the form "[+-]digits[.digits][(e|E)[+-]digits]", result is correctly rounded to nearest float.
+ * Uses Clinger fast path when it is exact, Eisel-Lemire algorithm otherwise, and falls back to "strtof()" in the rare cases Eisel-Lemire can't decide rounding or input has more than 19 significant digits.
+ * Also accepts "inf" and "nan" as written by "num_format_f32()".
+ * Parsing stops at the first character that doesn't fit the form above.
+ */
+float num_parse_f32(String str);
+
+/**
+ * Writes decimal representation of "value" into "buffer", returns number of characters written.
+ */
+s64 num_format_u64(u64 value, char *buffer);
+
+s64 num_format_s64(s64 value, char *buffer);
+
+/**
+ * Writes the shortest decimal representation of "value" that parses back to exactly the same float (Ryu algorithm).
+ * Values with decimal exponent in [ -5, 9 ) are written in fixed notation "123.25", "0.001", "3.0", others in scientific "1.5e-7", "3.4028235e38".
+ * Returns number of characters written.
+ */
+s64 num_format_f32(float value, char *buffer);
+
+/**
+ * Writes "value" in fixed notation with "precision" digits after the dot, same as "%.*f" with the same precision would.
+ * Only handles values exactly representable as float with "precision" <= 9 whose scaled value fits into 63 bits.
+ * Returns number of characters written, or -1 if "value" can't be handled, in which case nothing is written.
+ */
+s64 num_format_fixed(double value, s32 precision, char *buffer);
+
+
+
+#endif
@@ -0,0 +1,352 @@
+#include "core/profile.h"
+#include "core/type.h"
+#include "core/core.h"
+#include "core/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+
+#ifdef PROFILE_ENABLED
+
+/**
+ * Each thread records finished zones into its own single producer / single consumer ring.
+ * Main thread is the only consumer, it drains every ring into the current frame in "profile_frame_end()".
+ * When thread exits its slot is reused by the next new thread once its ring is drained, so threads that come and go are all profiled.
+ * @Important: Events that don't fit into the ring or into the frame are dropped and counted in frame's "dropped_count".
+ */
+
+#define PROFILE_THREAD_EVENTS 4096
+
+typedef struct profile_thread {
+    _Atomic u64 write;
+    _Atomic u64 read;
+    _Atomic u64 dropped;
+    atomic_bool exited;         // Set when owner thread exits, slot is reused once ring is drained.
+    u64 thread_id;
+    u16 index;
+    u16 depth;
+    Profile_Event events[PROFILE_THREAD_EVENTS];
+} Profile_Thread;
+
+static Profile_Thread *profile_threads[PROFILE_MAX_THREADS];
+static _Atomic s64 profile_threads_count = 0;
+static Mutex profile_threads_mutex = MUTEX_INIT;
+
+static _Thread_local Profile_Thread *profile_thread = NULL;
+
+// Thread exit is noticed through destructor of thread local key, value of the key is thread's slot.
+#if defined(_WIN32)
+static DWORD profile_thread_key = FLS_OUT_OF_INDEXES;
+#else
+static pthread_key_t profile_thread_key;
+static bool profile_thread_key_created = false;
+#endif
+
+static Profile_Frame *profile_frames = NULL;
+static s64 profile_frames_written = 0;
+static u64 profile_frame_start_ns = 0;
+
+
+
+/**
+ * Called on the exiting thread, slot isn't written by it anymore.
+ * If thread profiles again from later destructors, it registers again.
+ */
+#if defined(_WIN32)
+static VOID WINAPI profile_thread_exit(PVOID data) {
+#else
+static void profile_thread_exit(void *data) {
+#endif
+    Profile_Thread *thread = data;
+    if (thread == NULL) {
+        return;
+    }
+
+    profile_thread = NULL;
+    atomic_store(&thread->exited, true);
+}
+
+/**
+ * Takes slot of exited thread which ring is drained, or makes a new one, returns NULL if all PROFILE_MAX_THREADS are in use.
+ */
+static Profile_Thread *profile_thread_register() {
+    mutex_lock(&profile_threads_mutex);
+
+    s64 count = atomic_load(&profile_threads_count);
+
+    // Owner can't write after it exited, so drained ring stays drained.
+    Profile_Thread *thread = NULL;
+    for (s64 i = 0; i < count; i++) {
+        Profile_Thread *slot = profile_threads[i];
+        if (atomic_load(&slot->exited) && atomic_load(&slot->write) == atomic_load(&slot->read)) {
+            thread = slot;
+            break;
+        }
+    }
+
+    if (thread == NULL) {
+        if (count >= PROFILE_MAX_THREADS) {
+            mutex_unlock(&profile_threads_mutex);
+            return NULL;
+        }
+
+        thread = calloc(1, sizeof(Profile_Thread));
+        if (thread == NULL) {
+            mutex_unlock(&profile_threads_mutex);
+            return NULL;
+        }
+
+        thread->index = (u16)count;
+        profile_threads[count] = thread;
+        atomic_store_explicit(&profile_threads_count, count + 1, memory_order_release);
+    }
+
+    thread->thread_id = thread_current_id();
+    thread->depth = 0;
+    atomic_store(&thread->exited, false);
+
+#if defined(_WIN32)
+    if (profile_thread_key == FLS_OUT_OF_INDEXES) {
+        profile_thread_key = FlsAlloc(profile_thread_exit);
+    }
+    if (profile_thread_key != FLS_OUT_OF_INDEXES) {
+        FlsSetValue(profile_thread_key, thread);
+    }
+#else
+    if (!profile_thread_key_created) {
+        profile_thread_key_created = pthread_key_create(&profile_thread_key, profile_thread_exit) == 0;
+    }
+    if (profile_thread_key_created) {
+        pthread_setspecific(profile_thread_key, thread);
+    }
+#endif
+
+    mutex_unlock(&profile_threads_mutex);
+
+    profile_thread = thread;
+    return thread;
+}
+
+Profile_Zone profile_zone_begin(const char *name) {
+    Profile_Thread *thread = profile_thread;
+    if (thread == NULL) {
+        thread = profile_thread_register();
+    }
+
+    if (thread != NULL) {
+        thread->depth++;
+    }
+
+    return (Profile_Zone) { name, get_time_ns(), 0 };
+}
+
+Profile_Zone profile_zone_begin_ex(const char *name, bool sampled, u64 threshold_ns) {
+    if (!sampled) {
+        return (Profile_Zone) { NULL, 0, 0 };
+    }
+
+    Profile_Zone zone = profile_zone_begin(name);
+    zone.threshold_ns = threshold_ns;
+    return zone;
+}
+
+void profile_zone_end(Profile_Zone *zone) {
+    if (zone->name == NULL) {
+        return;
+    }
+
+    u64 end_ns = get_time_ns();
+
+    Profile_Thread *thread = profile_thread;
+    if (thread == NULL) {
+        return;
+    }
+
+    thread->depth--;
+
+    if (end_ns - zone->start_ns < zone->threshold_ns) {
+        return;
+    }
+
+    u64 write = atomic_load_explicit(&thread->write, memory_order_relaxed);
+    u64 read  = atomic_load_explicit(&thread->read, memory_order_acquire);
+
+    if (write - read >= PROFILE_THREAD_EVENTS) {
+        atomic_fetch_add_explicit(&thread->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    thread->events[write % PROFILE_THREAD_EVENTS] = (Profile_Event) {
+        .name           = zone->name,
+        .start_ns       = zone->start_ns,
+        .end_ns         = end_ns,
+        .thread_index   = thread->index,
+        .depth          = thread->depth,
+    };
+
+    atomic_store_explicit(&thread->write, write + 1, memory_order_release);
+}
+
+void profile_frame_end() {
+    u64 now = get_time_ns();
+
+    if (profile_frames == NULL) {
+        profile_frames = malloc(sizeof(Profile_Frame) * PROFILE_FRAME_COUNT);
+        if (profile_frames == NULL) {
+            printf_err("Couldn't allocate %llu bytes for profiler frames.\n", (unsigned long long)(sizeof(Profile_Frame) * PROFILE_FRAME_COUNT));
+            return;
+        }
+        profile_frame_start_ns = now;
+    }
+
+    Profile_Frame *frame = profile_frames + (profile_frames_written % PROFILE_FRAME_COUNT);
+    frame->start_ns = profile_frame_start_ns;
+    frame->end_ns = now;
+    frame->event_count = 0;
+    frame->dropped_count = 0;
+
+    // Slots are reused under the mutex, so owner of the slot doesn't change while it is drained.
+    mutex_lock(&profile_threads_mutex);
+
+    s64 threads_count = atomic_load_explicit(&profile_threads_count, memory_order_acquire);
+
+    for (s64 i = 0; i < threads_count; i++) {
+        Profile_Thread *thread = profile_threads[i];
+        frame->thread_ids[i] = thread->thread_id;
+
+        u64 write = atomic_load_explicit(&thread->write, memory_order_acquire);
+        u64 read  = atomic_load_explicit(&thread->read, memory_order_relaxed);
+
+        for (; read < write; read++) {
+            if (frame->event_count >= PROFILE_FRAME_MAX_EVENTS) {
+                frame->dropped_count += write - read;
+                read = write;
+                break;
+            }
+
+            frame->events[frame->event_count++] = thread->events[read % PROFILE_THREAD_EVENTS];
+        }
+
+        atomic_store_explicit(&thread->read, read, memory_order_release);
+        frame->dropped_count += atomic_exchange_explicit(&thread->dropped, 0, memory_order_relaxed);
+    }
+
+    mutex_unlock(&profile_threads_mutex);
+
+    profile_frames_written++;
+    profile_frame_start_ns = now;
+}
+
+s64 profile_frame_count() {
+    return profile_frames_written < PROFILE_FRAME_COUNT ? profile_frames_written : PROFILE_FRAME_COUNT;
+}
+
+Profile_Frame *profile_frame_get(s64 age) {
+    if (age < 0 || age >= profile_frame_count()) {
+        return NULL;
+    }
+
+    return profile_frames + ((profile_frames_written - 1 - age) % PROFILE_FRAME_COUNT);
+}
+
+u64 profile_thread_id(u16 thread_index) {
+    mutex_lock(&profile_threads_mutex);
+    u64 thread_id = thread_index < atomic_load(&profile_threads_count) ? profile_threads[thread_index]->thread_id : 0;
+    mutex_unlock(&profile_threads_mutex);
+
+    return thread_id;
+}
+
+/**
+ * Writes string as JSON string literal, zone names can be any C string.
+ */
+static void profile_write_json_string(FILE *file, const char *string) {
+    fputc('"', file);
+    for (const char *c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+            fputc(*c, file);
+        } else if ((u8)*c < 0x20) {
+            fprintf(file, "\\u%04x", (u8)*c);
+        } else {
+            fputc(*c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+bool profile_dump_chrome_trace(const char *file_path) {
+    FILE *file = fopen(file_path, "w");
+    if (file == NULL) {
+        printf_err("Couldn't open '%s' to write profile trace.\n", file_path);
+        return false;
+    }
+
+    // Trace event format: timestamps and durations are in microseconds.
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    for (s64 age = profile_frame_count() - 1; age >= 0; age--) {
+        Profile_Frame *frame = profile_frame_get(age);
+
+        fprintf(file, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":\"frames\",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"events\":%lld,\"dropped\":%lld}}",
+                first ? "" : ",\n", frame->start_ns / 1000.0, (frame->end_ns - frame->start_ns) / 1000.0, (long long)frame->event_count, (long long)frame->dropped_count);
+        first = false;
+
+        for (s64 i = 0; i < frame->event_count; i++) {
+            Profile_Event *event = frame->events + i;
+            fprintf(file, ",\n{\"name\":");
+            profile_write_json_string(file, event->name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+                    (unsigned long long)frame->thread_ids[event->thread_index], event->start_ns / 1000.0, (event->end_ns - event->start_ns) / 1000.0);
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    return true;
+}
+
+#else
+
+Profile_Zone profile_zone_begin(const char *name) {
+    return (Profile_Zone) { name, 0, 0 };
+}
+
+Profile_Zone profile_zone_begin_ex(const char *name, bool sampled, u64 threshold_ns) {
+    (void)sampled;
+    (void)threshold_ns;
+    return (Profile_Zone) { name, 0, 0 };
+}
+
+void profile_zone_end(Profile_Zone *zone) {
+    (void)zone;
+}
+
+void profile_frame_end() {
+}
+
+s64 profile_frame_count() {
+    return 0;
+}
+
+Profile_Frame *profile_frame_get(s64 age) {
+    (void)age;
+    return NULL;
+}
+
+u64 profile_thread_id(u16 thread_index) {
+    (void)thread_index;
+    return 0;
+}
+
+bool profile_dump_chrome_trace(const char *file_path) {
+    printf_err("Couldn't write '%s', profiler is compiled out.\n", file_path);
+    return false;
+}
+
+#endif
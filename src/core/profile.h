@@ -0,0 +1,142 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/**
+ * Profiler.
+ *
+ * Scoped zones record their start and end time into the calling thread's buffer:
+ *
+ *      void foo() {
+ *          PROFILE_ZONE("foo");
+ *          ...
+ *      } // Zone ends here.
+ *
+ * Once per frame "profile_frame_end()" collects all thread buffers into the ring of last PROFILE_FRAME_COUNT frames, which can be inspected or dumped as Chrome trace.
+ *
+ * Functions can also be instrumented with the @Profile meta note, which inserts PROFILE_NOTE at the top of the function body:
+ *
+ *      @Profile;                       // Every call.
+ *      @Profile(sample = 8);           // Every 8th call.
+ *      @Profile(threshold_us = 50);    // Only calls that took at least 50 microseconds.
+ *
+ * @Important: Compiled out in release (NDEBUG), or when PROFILE_DISABLE is defined, zones expand to nothing then.
+ * PROFILE_NOTES_DISABLE compiles out only zones inserted by @Profile notes.
+ */
+
+#include "core/type.h"
+
+#include <stdbool.h>
+
+
+#if !defined(NDEBUG) && !defined(PROFILE_DISABLE)
+#   define PROFILE_ENABLED
+#endif
+
+
+#define PROFILE_FRAME_COUNT         128
+#define PROFILE_FRAME_MAX_EVENTS    1024
+#define PROFILE_MAX_THREADS         16      // Threads profiled at once, slots of exited threads are reused.
+
+
+typedef struct profile_zone {
+    const char *name;           // NULL if zone is skipped by sampling.
+    u64 start_ns;
+    u64 threshold_ns;           // Zones shorter than this are not recorded.
+} Profile_Zone;
+
+typedef struct profile_event {
+    const char *name;
+    u64 start_ns;
+    u64 end_ns;
+    u16 thread_index;
+    u16 depth;
+} Profile_Event;
+
+typedef struct profile_frame {
+    u64 start_ns;
+    u64 end_ns;
+    s64 event_count;
+    s64 dropped_count;
+    u64 thread_ids[PROFILE_MAX_THREADS];    // OS id of the thread by "Profile_Event.thread_index", since slot may belong to other thread in later frames.
+    Profile_Event events[PROFILE_FRAME_MAX_EVENTS];
+} Profile_Frame;
+
+
+
+#ifdef PROFILE_ENABLED
+
+#define PROFILE_CONCAT_(a, b)   a##b
+#define PROFILE_CONCAT(a, b)    PROFILE_CONCAT_(a, b)
+
+/**
+ * Opens zone that is closed when enclosing scope ends, "name" should be a string literal or otherwise outlive the profiler.
+ */
+#define PROFILE_ZONE(name)      Profile_Zone PROFILE_CONCAT(_profile_zone_, __LINE__) __attribute__((cleanup(profile_zone_end))) = profile_zone_begin(name)
+
+#define PROFILE_FUNCTION()      PROFILE_ZONE(__func__)
+
+/**
+ * Same as PROFILE_ZONE, but records only every "sample_rate"-th entry of the scope, and only if it took at least "threshold_ns".
+ */
+#define PROFILE_ZONE_EX(name, sample_rate, threshold_ns)\
+    static _Thread_local u32 PROFILE_CONCAT(_profile_sample_, __LINE__) = 0;\
+    Profile_Zone PROFILE_CONCAT(_profile_zone_, __LINE__) __attribute__((cleanup(profile_zone_end))) = profile_zone_begin_ex(name, PROFILE_CONCAT(_profile_sample_, __LINE__)++ % (sample_rate) == 0, threshold_ns)
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_ZONE_EX(name, sample_rate, threshold_ns)
+
+#endif
+
+/**
+ * Zone inserted by @Profile meta note.
+ */
+#ifndef PROFILE_NOTES_DISABLE
+#   define PROFILE_NOTE(name, sample_rate, threshold_ns)    PROFILE_ZONE_EX(name, sample_rate, threshold_ns)
+#else
+#   define PROFILE_NOTE(name, sample_rate, threshold_ns)
+#endif
+
+
+
+Profile_Zone profile_zone_begin(const char *name);
+
+/**
+ * Returns skipped zone if "sampled" is false.
+ */
+Profile_Zone profile_zone_begin_ex(const char *name, bool sampled, u64 threshold_ns);
+
+void profile_zone_end(Profile_Zone *zone);
+
+/**
+ * Closes current frame: moves events recorded by all threads since the last call into the frame ring.
+ * Should be called once per frame by the main thread.
+ */
+void profile_frame_end();
+
+/**
+ * Returns number of collected frames available, at most PROFILE_FRAME_COUNT.
+ */
+s64 profile_frame_count();
+
+/**
+ * Returns collected frame, "age" 0 is the most recent one, or NULL if there is no such frame.
+ */
+Profile_Frame *profile_frame_get(s64 age);
+
+/**
+ * Returns OS id of the thread that records events with "thread_index" now, ids of the past frames are in "Profile_Frame.thread_ids".
+ */
+u64 profile_thread_id(u16 thread_index);
+
+/**
+ * Writes all collected frames as Chrome "about:tracing" / Perfetto JSON trace file.
+ * Returns false if file couldn't be written or profiler is compiled out.
+ */
+bool profile_dump_chrome_trace(const char *file_path);
+
+
+
+#endif
@@ -0,0 +1,665 @@
+#include "core/raster.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/thread.h"
+#include "core/structs.h"
+#include "core/log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+
+/**
+ * Edge functions are evaluated for 4 pixels of a row at once.
+ * Compiling with RASTER_NO_SIMD forces the scalar loop, which is what vectorized path is verified against,
+ * both compute every value the same way, so they give the same pixels.
+ */
+#if !defined(RASTER_NO_SIMD) && defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define RASTER_SIMD 1
+
+#else
+
+#define RASTER_SIMD 0
+
+#endif
+
+#define RASTER_WORKER_WAIT_MS 100
+
+
+
+/**
+ * Shading.
+ */
+
+static float texel(Raster_Texture *texture, s32 x, s32 y, s32 component) {
+    if (component >= texture->channels) {
+        return component == 3 ? 1.0f : 0.0f;
+    }
+    return (float)texture->pixels[((s64)y * texture->width + x) * texture->channels + component] * (1.0f / 255.0f);
+}
+
+/**
+ * Libm floorf and fmaxf / fminf are calls without SSE4.1 and finite math, these are inlined.
+ */
+static s32 floor_to_int(float value) {
+    s32 result = (s32)value;
+    return (float)result > value ? result - 1 : result;
+}
+
+static float saturate(float value) {
+    return value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+}
+
+static s32 clamp_int(s32 value, s32 max) {
+    return value < 0 ? 0 : (value > max ? max : value);
+}
+
+/**
+ * Bilinear sample with clamp to edge, texel centers are at half texel, like GL_LINEAR.
+ */
+static Vec4f sample(Raster_Texture *texture, float u, float v, s32 components) {
+    float tx = u * (float)texture->width - 0.5f;
+    float ty = v * (float)texture->height - 0.5f;
+    s32 ix = floor_to_int(tx);
+    s32 iy = floor_to_int(ty);
+    float fx = tx - (float)ix;
+    float fy = ty - (float)iy;
+
+    s32 x0 = clamp_int(ix, texture->width - 1);
+    s32 y0 = clamp_int(iy, texture->height - 1);
+    s32 x1 = clamp_int(ix + 1, texture->width - 1);
+    s32 y1 = clamp_int(iy + 1, texture->height - 1);
+
+    float result[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    for (s32 c = 0; c < components; c++) {
+        float bottom = lerp(texel(texture, x0, y0, c), texel(texture, x1, y0, c), fx);
+        float top    = lerp(texel(texture, x0, y1, c), texel(texture, x1, y1, c), fx);
+        result[c] = lerp(bottom, top, fy);
+    }
+    return vec4f_make(result[0], result[1], result[2], result[3]);
+}
+
+static float smoothstep(float edge0, float edge1, float x) {
+    float t = saturate((x - edge0) / (edge1 - edge0));
+    return t * t * (3.0f - 2.0f * t);
+}
+
+/**
+ * Same as "mask_alpha()" in "quad.glsl", derivative is taken by sampling one pixel to the right and one down, instead of from the 2x2 pixel quad.
+ */
+static float mask_alpha(Raster_Primitive *primitive, float u, float v) {
+    float value = sample(primitive->mask, u, v, 1).x;
+    if (!primitive->distance_field) {
+        return value;
+    }
+
+    float value_x = sample(primitive->mask, u + primitive->plane_dx[4], v + primitive->plane_dx[5], 1).x;
+    float value_y = sample(primitive->mask, u + primitive->plane_dy[4], v + primitive->plane_dy[5], 1).x;
+    float change = fabsf(value_x - value) + fabsf(value_y - value);
+    float width = (change > 0.0001f ? change : 0.0001f) * 0.5f;
+    return smoothstep(0.5f - width, 0.5f + width, value);
+}
+
+static u8 unorm8(float value) {
+    return (u8)(saturate(value) * 255.0f + 0.5f);
+}
+
+/**
+ * GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA for all channels, alpha included.
+ */
+static void blend(u8 *destination, Vec4f color) {
+    if (color.w <= 0.0f) {
+        return;
+    }
+
+    float keep = 1.0f - color.w;
+    destination[0] = unorm8(color.x * color.w + (float)destination[0] * (1.0f / 255.0f) * keep);
+    destination[1] = unorm8(color.y * color.w + (float)destination[1] * (1.0f / 255.0f) * keep);
+    destination[2] = unorm8(color.z * color.w + (float)destination[2] * (1.0f / 255.0f) * keep);
+    destination[3] = unorm8(color.w * color.w + (float)destination[3] * (1.0f / 255.0f) * keep);
+}
+
+static float plane(Raster_Primitive *primitive, s32 index, float x, float y) {
+    return primitive->plane_dx[index] * x + primitive->plane_dy[index] * y + primitive->plane_base[index];
+}
+
+static void shade(Raster *raster, Raster_Primitive *primitive, s32 x, s32 y) {
+    float cx = (float)x + 0.5f;
+    float cy = (float)y + 0.5f;
+
+    Vec4f color;
+    if (primitive->texture == NULL) {
+        color = vec4f_make(plane(primitive, 0, cx, cy), plane(primitive, 1, cx, cy), plane(primitive, 2, cx, cy), plane(primitive, 3, cx, cy));
+    }
+    else {
+        color = sample(primitive->texture, plane(primitive, 4, cx, cy), plane(primitive, 5, cx, cy), 4);
+    }
+
+    if (primitive->mask != NULL) {
+        color.w *= mask_alpha(primitive, plane(primitive, 4, cx, cy), plane(primitive, 5, cx, cy));
+    }
+
+    blend(raster->pixels + ((s64)y * raster->width + x) * 4, color);
+}
+
+
+
+/**
+ * Tiles.
+ */
+
+static bool edge_inside(Raster_Primitive *primitive, s32 edge, float value) {
+    return value > 0.0f || (value == 0.0f && primitive->edge_inclusive[edge]);
+}
+
+static void tile_triangle(Raster *raster, Raster_Primitive *primitive, s32 tx0, s32 ty0, s32 tx1, s32 ty1) {
+    s32 x0 = maxi(primitive->x0, tx0);
+    s32 y0 = maxi(primitive->y0, ty0);
+    s32 x1 = mini(primitive->x1, tx1);
+    s32 y1 = mini(primitive->y1, ty1);
+
+    for (s32 y = y0; y < y1; y++) {
+        float cy = (float)y + 0.5f;
+        float row[3];
+        for (s32 e = 0; e < 3; e++) {
+            row[e] = primitive->edge_b[e] * cy + primitive->edge_c[e];
+        }
+
+        s32 x = x0;
+
+#if RASTER_SIMD
+        __m128 zero = _mm_setzero_ps();
+        __m128 lane_offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (; x + 4 <= x1; x += 4) {
+            __m128 cx = _mm_add_ps(_mm_set1_ps((float)x), lane_offsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (s32 e = 0; e < 3; e++) {
+                __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(primitive->edge_a[e]), cx), _mm_set1_ps(row[e]));
+                __m128 edge = _mm_cmpgt_ps(value, zero);
+                if (primitive->edge_inclusive[e]) {
+                    edge = _mm_or_ps(edge, _mm_cmpeq_ps(value, zero));
+                }
+                inside = _mm_and_ps(inside, edge);
+            }
+
+            u32 mask = (u32)_mm_movemask_ps(inside);
+            while (mask != 0) {
+                u32 lane = __builtin_ctz(mask);
+                shade(raster, primitive, x + lane, y);
+                mask &= mask - 1;
+            }
+        }
+#endif
+
+        for (; x < x1; x++) {
+            float cx = (float)x + 0.5f;
+            bool inside = true;
+            for (s32 e = 0; e < 3; e++) {
+                inside = inside && edge_inside(primitive, e, primitive->edge_a[e] * cx + row[e]);
+            }
+            if (inside) {
+                shade(raster, primitive, x, y);
+            }
+        }
+    }
+}
+
+static void tile_line(Raster *raster, Raster_Primitive *primitive, s32 tx0, s32 ty0, s32 tx1, s32 ty1) {
+    Vec2f p0 = primitive->line_p0;
+    Vec2f p1 = primitive->line_p1;
+    Vec4f color = vec4f_make(primitive->plane_base[0], primitive->plane_base[1], primitive->plane_base[2], primitive->plane_base[3]);
+
+    float dx = p1.x - p0.x;
+    float dy = p1.y - p0.y;
+    s32 steps = (s32)ceilf(fmaxf(fabsf(dx), fabsf(dy)));
+
+    for (s32 i = 0; i <= steps; i++) {
+        float t = steps == 0 ? 0.0f : (float)i / (float)steps;
+        s32 x = floor_to_int(p0.x + dx * t);
+        s32 y = floor_to_int(p0.y + dy * t);
+        if (x >= tx0 && x < tx1 && y >= ty0 && y < ty1) {
+            blend(raster->pixels + ((s64)y * raster->width + x) * 4, color);
+        }
+    }
+}
+
+static void tile_draw(Raster *raster, s32 tile) {
+    s32 tx0 = (tile % raster->tiles_x) * RASTER_TILE_SIZE;
+    s32 ty0 = (tile / raster->tiles_x) * RASTER_TILE_SIZE;
+    s32 tx1 = mini(tx0 + RASTER_TILE_SIZE, raster->width);
+    s32 ty1 = mini(ty0 + RASTER_TILE_SIZE, raster->height);
+
+    u32 *bin = raster->bins[tile];
+    for (u32 i = 0; i < array_list_length(&bin); i++) {
+        Raster_Primitive *primitive = &raster->primitives[bin[i]];
+        if (primitive->line) {
+            tile_line(raster, primitive, tx0, ty0, tx1, ty1);
+        } else {
+            tile_triangle(raster, primitive, tx0, ty0, tx1, ty1);
+        }
+    }
+}
+
+/**
+ * Takes tiles until there are none left, called by workers and the flushing thread.
+ */
+static void tiles_run(Raster *raster) {
+    s32 tiles_count = raster->tiles_x * raster->tiles_y;
+    for (;;) {
+        s32 tile = atomic_fetch_add(&raster->next_tile, 1);
+        if (tile >= tiles_count) {
+            return;
+        }
+        tile_draw(raster, tile);
+    }
+}
+
+static void worker_procedure(void *data) {
+    Raster *raster = data;
+    u64 generation = 0;
+
+    mutex_lock(&raster->mutex);
+    for (;;) {
+        while (!raster->quit && raster->work_generation == generation) {
+            condition_wait(&raster->work_started, &raster->mutex, RASTER_WORKER_WAIT_MS);
+        }
+        if (raster->quit) {
+            break;
+        }
+        generation = raster->work_generation;
+        mutex_unlock(&raster->mutex);
+
+        tiles_run(raster);
+
+        mutex_lock(&raster->mutex);
+        raster->workers_busy--;
+        if (raster->workers_busy == 0) {
+            condition_signal(&raster->work_finished);
+        }
+    }
+    mutex_unlock(&raster->mutex);
+}
+
+static void primitive_bin(Raster *raster, u32 index) {
+    Raster_Primitive *primitive = &raster->primitives[index];
+    if (primitive->x0 >= primitive->x1 || primitive->y0 >= primitive->y1) {
+        return;
+    }
+
+    s32 tx0 = primitive->x0 / RASTER_TILE_SIZE;
+    s32 ty0 = primitive->y0 / RASTER_TILE_SIZE;
+    s32 tx1 = (primitive->x1 - 1) / RASTER_TILE_SIZE;
+    s32 ty1 = (primitive->y1 - 1) / RASTER_TILE_SIZE;
+
+    for (s32 ty = ty0; ty <= ty1; ty++) {
+        for (s32 tx = tx0; tx <= tx1; tx++) {
+            array_list_append(&raster->bins[ty * raster->tiles_x + tx], index);
+        }
+    }
+}
+
+/**
+ * Clips float bounds to the framebuffer, max is exclusive.
+ */
+static void primitive_bounds(Raster *raster, Raster_Primitive *primitive, float min_x, float min_y, float max_x, float max_y) {
+    primitive->x0 = (s32)clamp(floorf(min_x), 0.0f, (float)raster->width);
+    primitive->y0 = (s32)clamp(floorf(min_y), 0.0f, (float)raster->height);
+    primitive->x1 = (s32)clamp(ceilf(max_x), 0.0f, (float)raster->width);
+    primitive->y1 = (s32)clamp(ceilf(max_y), 0.0f, (float)raster->height);
+}
+
+
+
+void raster_init(Raster *raster, s32 width, s32 height, s32 threads_count) {
+    *raster = (Raster) {0};
+
+    raster->width       = width;
+    raster->height      = height;
+    raster->pixels      = allocator_zero_alloc(&std_allocator, (u64)width * height * 4);
+    raster->primitives  = array_list_make(Raster_Primitive, 256, &std_allocator);
+
+    raster->tiles_x     = (width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    raster->tiles_y     = (height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    raster->bins        = allocator_alloc(&std_allocator, raster->tiles_x * raster->tiles_y * sizeof(u32 *));
+    for (s32 i = 0; i < raster->tiles_x * raster->tiles_y; i++) {
+        raster->bins[i] = array_list_make(u32, 64, &std_allocator);
+    }
+
+    raster->mutex           = (Mutex) MUTEX_INIT;
+    raster->work_started    = (Condition) CONDITION_INIT;
+    raster->work_finished   = (Condition) CONDITION_INIT;
+
+    threads_count = mini(maxi(threads_count, 1), RASTER_MAX_THREADS);
+    for (s32 i = 0; i < threads_count - 1; i++) {
+        if (!thread_create(&raster->workers[raster->workers_count], worker_procedure, raster)) {
+            LOG_WARNING("Couldn't start rasterizer worker, using %d threads.", raster->workers_count + 1);
+            break;
+        }
+        raster->workers_count++;
+    }
+}
+
+void raster_free(Raster *raster) {
+    mutex_lock(&raster->mutex);
+    raster->quit = true;
+    condition_broadcast(&raster->work_started);
+    mutex_unlock(&raster->mutex);
+
+    for (s32 i = 0; i < raster->workers_count; i++) {
+        thread_join(raster->workers[i]);
+    }
+
+    for (s32 i = 0; i < raster->tiles_x * raster->tiles_y; i++) {
+        array_list_free(&raster->bins[i]);
+    }
+    allocator_free(&std_allocator, raster->bins);
+    array_list_free(&raster->primitives);
+    allocator_free(&std_allocator, raster->pixels);
+
+    *raster = (Raster) {0};
+}
+
+void raster_clear(Raster *raster, u32 color) {
+    u32 *pixels = (u32 *)raster->pixels;
+    for (s64 i = 0; i < (s64)raster->width * raster->height; i++) {
+        pixels[i] = color;
+    }
+    array_list_clear(&raster->primitives);
+}
+
+void raster_triangle(Raster *raster, Raster_Vertex *verticies, Raster_Texture *texture, Raster_Texture *mask, bool distance_field) {
+    Raster_Vertex *v0 = &verticies[0];
+    Raster_Vertex *v1 = &verticies[1];
+    Raster_Vertex *v2 = &verticies[2];
+
+    float area = (v1->position.x - v0->position.x) * (v2->position.y - v0->position.y) - (v1->position.y - v0->position.y) * (v2->position.x - v0->position.x);
+    if (area == 0.0f || isnan(area)) {
+        return;
+    }
+
+    // Making winding positive, so inside is where all edge functions are positive.
+    if (area < 0.0f) {
+        Raster_Vertex *swap = v1;
+        v1 = v2;
+        v2 = swap;
+        area = -area;
+    }
+
+    Raster_Primitive primitive = {
+        .texture        = texture,
+        .mask           = mask,
+        .distance_field = distance_field,
+    };
+
+    Raster_Vertex *edge_from[3] = { v0, v1, v2 };
+    Raster_Vertex *edge_to[3]   = { v1, v2, v0 };
+    for (s32 e = 0; e < 3; e++) {
+        Vec2f from = edge_from[e]->position;
+        Vec2f to = edge_to[e]->position;
+
+        primitive.edge_a[e] = from.y - to.y;
+        primitive.edge_b[e] = to.x - from.x;
+        primitive.edge_c[e] = -(primitive.edge_a[e] * from.x + primitive.edge_b[e] * from.y);
+
+        // Y goes down, so top edge is horizontal one with inside below it, and left edge has inside to the right.
+        primitive.edge_inclusive[e] = primitive.edge_a[e] > 0.0f || (primitive.edge_a[e] == 0.0f && primitive.edge_b[e] > 0.0f);
+    }
+
+    float values[3][6] = {
+        { v0->color.x, v0->color.y, v0->color.z, v0->color.w, v0->uv.x, v0->uv.y },
+        { v1->color.x, v1->color.y, v1->color.z, v1->color.w, v1->uv.x, v1->uv.y },
+        { v2->color.x, v2->color.y, v2->color.z, v2->color.w, v2->uv.x, v2->uv.y },
+    };
+    for (s32 i = 0; i < 6; i++) {
+        float d1 = values[1][i] - values[0][i];
+        float d2 = values[2][i] - values[0][i];
+        primitive.plane_dx[i]   = (d1 * (v2->position.y - v0->position.y) - d2 * (v1->position.y - v0->position.y)) / area;
+        primitive.plane_dy[i]   = (d2 * (v1->position.x - v0->position.x) - d1 * (v2->position.x - v0->position.x)) / area;
+        primitive.plane_base[i] = values[0][i] - primitive.plane_dx[i] * v0->position.x - primitive.plane_dy[i] * v0->position.y;
+    }
+
+    primitive_bounds(raster, &primitive,
+        fminf(fminf(v0->position.x, v1->position.x), v2->position.x),
+        fminf(fminf(v0->position.y, v1->position.y), v2->position.y),
+        fmaxf(fmaxf(v0->position.x, v1->position.x), v2->position.x),
+        fmaxf(fmaxf(v0->position.y, v1->position.y), v2->position.y));
+
+    array_list_append(&raster->primitives, primitive);
+}
+
+void raster_line(Raster *raster, Vec2f p0, Vec2f p1, Vec4f color) {
+    // Clipping to the framebuffer, so lines that go far outside don't step through pixels that aren't there.
+    float t0 = 0.0f;
+    float t1 = 1.0f;
+    float deltas[4]  = { -(p1.x - p0.x), p1.x - p0.x, -(p1.y - p0.y), p1.y - p0.y };
+    float margins[4] = { p0.x, (float)raster->width - p0.x, p0.y, (float)raster->height - p0.y };
+    for (s32 i = 0; i < 4; i++) {
+        if (deltas[i] == 0.0f) {
+            if (margins[i] < 0.0f) {
+                return;
+            }
+            continue;
+        }
+
+        float t = margins[i] / deltas[i];
+        if (deltas[i] < 0.0f) {
+            t0 = fmaxf(t0, t);
+        } else {
+            t1 = fminf(t1, t);
+        }
+    }
+    if (t0 > t1) {
+        return;
+    }
+
+    Vec2f from = vec2f_make(p0.x + (p1.x - p0.x) * t0, p0.y + (p1.y - p0.y) * t0);
+    Vec2f to = vec2f_make(p0.x + (p1.x - p0.x) * t1, p0.y + (p1.y - p0.y) * t1);
+
+    Raster_Primitive primitive = {
+        .line       = true,
+        .line_p0    = from,
+        .line_p1    = to,
+        .plane_base = { color.x, color.y, color.z, color.w },
+    };
+
+    // Line pixels are floors of points on it, so the last pixel is included by bounds.
+    primitive_bounds(raster, &primitive, fminf(from.x, to.x), fminf(from.y, to.y), floorf(fmaxf(from.x, to.x)) + 1.0f, floorf(fmaxf(from.y, to.y)) + 1.0f);
+
+    array_list_append(&raster->primitives, primitive);
+}
+
+void raster_flush(Raster *raster) {
+    u32 count = array_list_length(&raster->primitives);
+    if (count == 0) {
+        return;
+    }
+
+    for (s32 i = 0; i < raster->tiles_x * raster->tiles_y; i++) {
+        array_list_clear(&raster->bins[i]);
+    }
+    for (u32 i = 0; i < count; i++) {
+        primitive_bin(raster, i);
+    }
+
+    atomic_store(&raster->next_tile, 0);
+
+    mutex_lock(&raster->mutex);
+    raster->workers_busy = raster->workers_count;
+    raster->work_generation++;
+    condition_broadcast(&raster->work_started);
+    mutex_unlock(&raster->mutex);
+
+    tiles_run(raster);
+
+    mutex_lock(&raster->mutex);
+    while (raster->workers_busy > 0) {
+        condition_wait(&raster->work_finished, &raster->mutex, RASTER_WORKER_WAIT_MS);
+    }
+    mutex_unlock(&raster->mutex);
+
+    array_list_clear(&raster->primitives);
+}
+
+u32 raster_pixel(Raster *raster, s32 x, s32 y) {
+    u8 *pixel = raster->pixels + ((s64)y * raster->width + x) * 4;
+    return (u32)pixel[0] | (u32)pixel[1] << 8 | (u32)pixel[2] << 16 | (u32)pixel[3] << 24;
+}
+
+bool raster_write_ppm(Raster *raster, char *file_path) {
+    FILE *file = fopen(file_path, "wb");
+    if (file == NULL) {
+        LOG_ERROR("Couldn't open '%s' for writing.", file_path);
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", raster->width, raster->height);
+
+    u8 *row = allocator_alloc(&std_allocator, (u64)raster->width * 3);
+    bool result = true;
+    for (s32 y = 0; y < raster->height && result; y++) {
+        u8 *source = raster->pixels + (s64)y * raster->width * 4;
+        for (s32 x = 0; x < raster->width; x++) {
+            row[x * 3 + 0] = source[x * 4 + 0];
+            row[x * 3 + 1] = source[x * 4 + 1];
+            row[x * 3 + 2] = source[x * 4 + 2];
+        }
+        result = fwrite(row, 1, (u64)raster->width * 3, file) == (u64)raster->width * 3;
+    }
+    allocator_free(&std_allocator, row);
+
+    if (fclose(file) != 0 || !result) {
+        LOG_ERROR("Couldn't write '%s'.", file_path);
+        return false;
+    }
+    return true;
+}
+
+
+
+/**
+ * PNG.
+ * Written without compression, deflate stored blocks only, so it needs just CRC32 and Adler32.
+ */
+
+#define PNG_STORED_BLOCK_SIZE 65535
+
+static u32 png_crc_table[256];
+
+static u32 png_crc(u32 crc, u8 *data, u64 length) {
+    if (png_crc_table[1] == 0) {
+        for (u32 i = 0; i < 256; i++) {
+            u32 value = i;
+            for (s32 k = 0; k < 8; k++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            png_crc_table[i] = value;
+        }
+    }
+
+    crc = ~crc;
+    for (u64 i = 0; i < length; i++) {
+        crc = png_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void png_put_u32(u8 *destination, u32 value) {
+    destination[0] = (u8)(value >> 24);
+    destination[1] = (u8)(value >> 16);
+    destination[2] = (u8)(value >> 8);
+    destination[3] = (u8)value;
+}
+
+static bool png_write_chunk(FILE *file, char *type, u8 *data, u32 length) {
+    u8 header[8];
+    png_put_u32(header, length);
+    memcpy(header + 4, type, 4);
+
+    u8 footer[4];
+    png_put_u32(footer, png_crc(png_crc(0, header + 4, 4), data, length));
+
+    return fwrite(header, 1, 8, file) == 8
+        && fwrite(data, 1, length, file) == length
+        && fwrite(footer, 1, 4, file) == 4;
+}
+
+bool raster_write_png(Raster *raster, char *file_path) {
+    // Scanlines are filter byte 0 followed by the row.
+    u64 row_length = (u64)raster->width * 4 + 1;
+    u64 raw_length = row_length * raster->height;
+    u64 blocks_count = (raw_length + PNG_STORED_BLOCK_SIZE - 1) / PNG_STORED_BLOCK_SIZE;
+    u64 data_length = 2 + raw_length + blocks_count * 5 + 4;
+
+    if (data_length > UINT32_MAX) {
+        LOG_ERROR("Framebuffer is too big to write as PNG '%s'.", file_path);
+        return false;
+    }
+
+    u8 *data = allocator_alloc(&std_allocator, data_length);
+    u8 *write = data;
+
+    // Zlib header, deflate with 32K window, no dictionary.
+    *write++ = 0x78;
+    *write++ = 0x01;
+
+    u32 adler_a = 1;
+    u32 adler_b = 0;
+    u64 raw_offset = 0;
+    for (u64 block = 0; block < blocks_count; block++) {
+        u32 block_length = (u32)mini(raw_length - raw_offset, PNG_STORED_BLOCK_SIZE);
+
+        *write++ = block + 1 == blocks_count ? 1 : 0;
+        *write++ = (u8)block_length;
+        *write++ = (u8)(block_length >> 8);
+        *write++ = (u8)~block_length;
+        *write++ = (u8)(~block_length >> 8);
+
+        for (u32 i = 0; i < block_length; i++, raw_offset++) {
+            u64 y = raw_offset / row_length;
+            u64 x = raw_offset % row_length;
+            u8 value = x == 0 ? 0 : raster->pixels[y * raster->width * 4 + x - 1];
+
+            *write++ = value;
+            adler_a = (adler_a + value) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+    }
+    png_put_u32(write, adler_b << 16 | adler_a);
+
+    u8 header[13];
+    png_put_u32(header, raster->width);
+    png_put_u32(header + 4, raster->height);
+    header[8]  = 8;     // Bit depth.
+    header[9]  = 6;     // RGBA.
+    header[10] = 0;     // Deflate.
+    header[11] = 0;     // Adaptive filtering.
+    header[12] = 0;     // No interlace.
+
+    static u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    FILE *file = fopen(file_path, "wb");
+    if (file == NULL) {
+        LOG_ERROR("Couldn't open '%s' for writing.", file_path);
+        allocator_free(&std_allocator, data);
+        return false;
+    }
+
+    bool result = fwrite(signature, 1, 8, file) == 8
+        && png_write_chunk(file, "IHDR", header, sizeof(header))
+        && png_write_chunk(file, "IDAT", data, (u32)data_length)
+        && png_write_chunk(file, "IEND", NULL, 0);
+
+    allocator_free(&std_allocator, data);
+
+    if (fclose(file) != 0 || !result) {
+        LOG_ERROR("Couldn't write '%s'.", file_path);
+        return false;
+    }
+    return true;
+}
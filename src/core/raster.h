@@ -0,0 +1,138 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+/**
+ * Software rasterizer.
+ * Draws triangles and lines into RGBA8 framebuffer on the CPU, so drawing can be checked and measured without GPU.
+ *
+ * Primitives are recorded by "raster_triangle()" / "raster_line()" and drawn by "raster_flush()":
+ * framebuffer is split into RASTER_TILE_SIZE tiles, primitives are put into bins of tiles they touch,
+ * and tiles are shaded in parallel by worker threads. Every tile draws its primitives in submission order,
+ * so result doesn't depend on the amount of threads, same input gives the same pixels.
+ *
+ * Shading follows "quad.glsl": color comes from vertex color or texture, mask multiplies alpha,
+ * distance field masks are thresholded at 0.5 with smoothstep over the screen space derivative.
+ * Textures are sampled bilinearly with clamp to edge, and blending is GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA.
+ * Pixel centers are at half pixel and edges follow top left fill rule, like in GL.
+ */
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/thread.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define RASTER_TILE_SIZE    64
+#define RASTER_MAX_THREADS  16
+
+typedef struct raster_texture {
+    s32 width;
+    s32 height;
+    u8  channels;       // 1 to 4, missing components are read as GL does, 0 for green and blue and 1 for alpha.
+    u8  *pixels;        // Row 0 is v = 0, same as data uploaded to GL.
+} Raster_Texture;
+
+typedef struct raster_vertex {
+    Vec2f   position;   // Framebuffer pixels, origin at the top left corner.
+    Vec4f   color;      // 0..1.
+    Vec2f   uv;
+} Raster_Vertex;
+
+typedef struct raster_primitive {
+    // Edge functions "a * x + b * y + c", positive inside, and whether edge is top or left one.
+    float   edge_a[3];
+    float   edge_b[3];
+    float   edge_c[3];
+    bool    edge_inclusive[3];
+
+    // Plane "dx * x + dy * y + base" of each interpolated value: color rgba, then uv.
+    float   plane_dx[6];
+    float   plane_dy[6];
+    float   plane_base[6];
+
+    // Pixel bounds, max is exclusive.
+    s32     x0, y0, x1, y1;
+
+    Raster_Texture *texture;    // NULL draws vertex color.
+    Raster_Texture *mask;       // NULL is no mask.
+    bool    distance_field;     // Mask is a distance field with edge at 0.5.
+
+    // Lines don't use edges, color is in "plane_base" with zero slopes.
+    bool    line;
+    Vec2f   line_p0;
+    Vec2f   line_p1;
+} Raster_Primitive;
+
+typedef struct raster {
+    s32     width;
+    s32     height;
+    u8      *pixels;                // RGBA8, row 0 is the top.
+
+    Raster_Primitive *primitives;   // Array list.
+    s32     tiles_x;
+    s32     tiles_y;
+    u32     **bins;                 // Array list of primitive indicies per tile.
+
+    s32     workers_count;
+    Thread  workers[RASTER_MAX_THREADS];
+    Mutex   mutex;
+    Condition work_started;
+    Condition work_finished;
+    u64     work_generation;        // Incremented for every flush, workers wait for it to change.
+    s32     workers_busy;
+    bool    quit;
+    atomic_int next_tile;
+} Raster;
+
+/**
+ * Allocates framebuffer cleared to transparent black, and starts "threads_count - 1" workers, calling thread is the last one.
+ * Threads count is clamped to 1..RASTER_MAX_THREADS.
+ */
+void raster_init(Raster *raster, s32 width, s32 height, s32 threads_count);
+
+/**
+ * Stops workers and frees everything.
+ */
+void raster_free(Raster *raster);
+
+/**
+ * Fills framebuffer with RGBA8 color, drops primitives that weren't flushed.
+ */
+void raster_clear(Raster *raster, u32 color);
+
+/**
+ * Records triangle, winding doesn't matter. Nothing is drawn until "raster_flush()".
+ * @Important: Textures are read during flush, so they should stay alive and unchanged until then.
+ */
+void raster_triangle(Raster *raster, Raster_Vertex *verticies, Raster_Texture *texture, Raster_Texture *mask, bool distance_field);
+
+/**
+ * Records 1 pixel wide line, pixels are stepped along the longer axis.
+ */
+void raster_line(Raster *raster, Vec2f p0, Vec2f p1, Vec4f color);
+
+/**
+ * Draws all recorded primitives, returns after framebuffer is complete.
+ */
+void raster_flush(Raster *raster);
+
+/**
+ * Returns RGBA8 color of the framebuffer pixel.
+ */
+u32 raster_pixel(Raster *raster, s32 x, s32 y);
+
+/**
+ * Writes framebuffer into binary PPM file, alpha is dropped.
+ * Returns false if file couldn't be written.
+ */
+bool raster_write_ppm(Raster *raster, char *file_path);
+
+/**
+ * Writes framebuffer into uncompressed RGBA PNG file.
+ * Returns false if file couldn't be written.
+ */
+bool raster_write_png(Raster *raster, char *file_path);
+
+#endif
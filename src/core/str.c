@@ -1,11 +1,86 @@
 #include "core/str.h"
 #include "core/core.h"
 #include "core/type.h"
+#include "core/num.h"
 
 #include <ctype.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdio.h>
+
+
+
+
+/**
+ * Vectorized scanning.
+ * Every scanning function below first walks the string in full vector chunks, then finishes the remainder with the scalar loop.
+ * Compiling with STR_NO_SIMD forces the scalar loops only, which is what vectorized paths are verified against.
+ * @Important: Whitespace class matches "isspace()" in the "C" locale: ' ', '\t', '\n', '\v', '\f', '\r'.
+ */
+#if !defined(STR_NO_SIMD) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define STR_SIMD 1
+#define STR_VEC_WIDTH 32
+
+typedef __m256i Str_Vec;
+
+#define str_vec_load(ptr)           _mm256_loadu_si256((const __m256i *)(ptr))
+#define str_vec_set(c)              _mm256_set1_epi8(c)
+#define str_vec_eq_mask(a, b)       ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)))
+#define str_vec_sub(a, b)           _mm256_sub_epi8(a, b)
+#define str_vec_min(a, b)           _mm256_min_epu8(a, b)
+#define str_vec_or(a, b)            _mm256_or_si256(a, b)
+#define str_vec_cmpeq(a, b)         _mm256_cmpeq_epi8(a, b)
+#define str_vec_movemask(a)         ((u32)_mm256_movemask_epi8(a))
+#define STR_VEC_FULL_MASK           0xffffffffu
+
+#elif !defined(STR_NO_SIMD) && defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define STR_SIMD 1
+#define STR_VEC_WIDTH 16
+
+typedef __m128i Str_Vec;
+
+#define str_vec_load(ptr)           _mm_loadu_si128((const __m128i *)(ptr))
+#define str_vec_set(c)              _mm_set1_epi8(c)
+#define str_vec_eq_mask(a, b)       ((u32)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)))
+#define str_vec_sub(a, b)           _mm_sub_epi8(a, b)
+#define str_vec_min(a, b)           _mm_min_epu8(a, b)
+#define str_vec_or(a, b)            _mm_or_si128(a, b)
+#define str_vec_cmpeq(a, b)         _mm_cmpeq_epi8(a, b)
+#define str_vec_movemask(a)         ((u32)_mm_movemask_epi8(a))
+#define STR_VEC_FULL_MASK           0xffffu
+
+#else
+
+#define STR_SIMD 0
+
+#endif
+
+
+#if STR_SIMD
+
+/**
+ * Returns bit mask where bit i is set if byte i of the chunk is whitespace.
+ * Bytes '\t'..'\r' are contiguous, so (byte - '\t') <= 4 as unsigned covers them, ' ' is checked separately.
+ */
+static inline u32 str_vec_space_mask(Str_Vec chunk) {
+    Str_Vec shifted = str_vec_sub(chunk, str_vec_set('\t'));
+    Str_Vec control = str_vec_cmpeq(str_vec_min(shifted, str_vec_set(4)), shifted);
+    Str_Vec space   = str_vec_cmpeq(chunk, str_vec_set(' '));
+    return str_vec_movemask(str_vec_or(control, space));
+}
+
+#define str_mask_first(mask)    ((s64)__builtin_ctz(mask))
+#define str_mask_last(mask)     ((s64)(31 - __builtin_clz(mask)))
+#define str_mask_count(mask)    ((s64)__builtin_popcount(mask))
+
+#endif
 
 
 String str_substring(String str, s64 start, s64 end) {
@@ -20,8 +95,36 @@ bool str_equals(String str1, String str2) {
 }
 
 s64 str_find(String str, String search) {
+    if (search.length <= 0) {
+        return 0;
+    }
+
+    if (search.length == 1) {
+        return str_find_char_left(str, search.data[0]);
+    }
+
+    s64 i = 0;
+
+#if STR_SIMD
+    // Filtering candidates by first and last byte of "search", only then comparing the middle.
+    Str_Vec first = str_vec_set(search.data[0]);
+    Str_Vec last  = str_vec_set(search.data[search.length - 1]);
+
+    for (; i + search.length - 1 + STR_VEC_WIDTH <= str.length; i += STR_VEC_WIDTH) {
+        u32 mask = str_vec_eq_mask(str_vec_load(str.data + i), first) & str_vec_eq_mask(str_vec_load(str.data + i + search.length - 1), last);
+
+        while (mask) {
+            s64 candidate = i + str_mask_first(mask);
+            if (!memcmp(str.data + candidate + 1, search.data + 1, search.length - 2)) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
     String substr;
-    for (s64 i = 0; i + search.length <= str.length; i++) {
+    for (; i + search.length <= str.length; i++) {
         if (str.data[i] == search.data[0]) {
             substr = str_substring(str, i, i + search.length);
             if (str_equals(substr, search)) {
@@ -34,7 +137,20 @@ s64 str_find(String str, String search) {
 }
 
 s64 str_find_char_left(String str, char symbol) {
-    for (s64 i = 0; i < str.length; i++) {
+    s64 i = 0;
+
+#if STR_SIMD
+    Str_Vec target = str_vec_set(symbol);
+
+    for (; i + STR_VEC_WIDTH <= str.length; i += STR_VEC_WIDTH) {
+        u32 mask = str_vec_eq_mask(str_vec_load(str.data + i), target);
+        if (mask) {
+            return i + str_mask_first(mask);
+        }
+    }
+#endif
+
+    for (; i < str.length; i++) {
         if (str.data[i] == symbol) {
             return i;
         }
@@ -44,7 +160,20 @@ s64 str_find_char_left(String str, char symbol) {
 }
 
 s64 str_find_char_right(String str, char symbol) {
-    for (s64 i = str.length - 1; i > -1; i--) {
+    s64 i = str.length - 1;
+
+#if STR_SIMD
+    Str_Vec target = str_vec_set(symbol);
+
+    for (; i + 1 - STR_VEC_WIDTH >= 0; i -= STR_VEC_WIDTH) {
+        u32 mask = str_vec_eq_mask(str_vec_load(str.data + i + 1 - STR_VEC_WIDTH), target);
+        if (mask) {
+            return i + 1 - STR_VEC_WIDTH + str_mask_last(mask);
+        }
+    }
+#endif
+
+    for (; i > -1; i--) {
         if (str.data[i] == symbol) {
             return i;
         }
@@ -54,7 +183,18 @@ s64 str_find_char_right(String str, char symbol) {
 }
 
 s64 str_find_non_whitespace_left(String str) {
-    for (s64 i = 0; i < str.length; i++) {
+    s64 i = 0;
+
+#if STR_SIMD
+    for (; i + STR_VEC_WIDTH <= str.length; i += STR_VEC_WIDTH) {
+        u32 mask = ~str_vec_space_mask(str_vec_load(str.data + i)) & STR_VEC_FULL_MASK;
+        if (mask) {
+            return i + str_mask_first(mask);
+        }
+    }
+#endif
+
+    for (; i < str.length; i++) {
         if (!isspace(str.data[i])) {
             return i;
         }
@@ -64,7 +204,18 @@ s64 str_find_non_whitespace_left(String str) {
 }
 
 s64 str_find_non_whitespace_right(String str) {
-    for (s64 i = str.length - 1; i > -1; i--) {
+    s64 i = str.length - 1;
+
+#if STR_SIMD
+    for (; i + 1 - STR_VEC_WIDTH >= 0; i -= STR_VEC_WIDTH) {
+        u32 mask = ~str_vec_space_mask(str_vec_load(str.data + i + 1 - STR_VEC_WIDTH)) & STR_VEC_FULL_MASK;
+        if (mask) {
+            return i + 1 - STR_VEC_WIDTH + str_mask_last(mask);
+        }
+    }
+#endif
+
+    for (; i > -1; i--) {
         if (!isspace(str.data[i])) {
             return i;
         }
@@ -75,7 +226,18 @@ s64 str_find_non_whitespace_right(String str) {
 
 
 s64 str_find_whitespace_left(String str) {
-    for (s64 i = 0; i < str.length; i++) {
+    s64 i = 0;
+
+#if STR_SIMD
+    for (; i + STR_VEC_WIDTH <= str.length; i += STR_VEC_WIDTH) {
+        u32 mask = str_vec_space_mask(str_vec_load(str.data + i));
+        if (mask) {
+            return i + str_mask_first(mask);
+        }
+    }
+#endif
+
+    for (; i < str.length; i++) {
         if (isspace(str.data[i])) {
             return i;
         }
@@ -85,7 +247,18 @@ s64 str_find_whitespace_left(String str) {
 }
 
 s64 str_find_whitespace_right(String str) {
-    for (s64 i = str.length - 1; i > -1; i--) {
+    s64 i = str.length - 1;
+
+#if STR_SIMD
+    for (; i + 1 - STR_VEC_WIDTH >= 0; i -= STR_VEC_WIDTH) {
+        u32 mask = str_vec_space_mask(str_vec_load(str.data + i + 1 - STR_VEC_WIDTH));
+        if (mask) {
+            return i + 1 - STR_VEC_WIDTH + str_mask_last(mask);
+        }
+    }
+#endif
+
+    for (; i > -1; i--) {
         if (isspace(str.data[i])) {
             return i;
         }
@@ -99,30 +272,30 @@ String str_eat_chars(String str, s64 count) {
 }
 
 String str_eat_spaces(String str) {
-    s64 i = 0;
+    s64 i = str_find_non_whitespace_left(str);
 
-    while(i < str.length && isspace(str.data[i])) {
-        i++;
+    if (i == -1) {
+        i = str.length;
     }
 
     return STR(str.length - i, str.data + i);
 }
 
 String str_eat_until_space(String str) {
-    s64 i = 0;
+    s64 i = str_find_whitespace_left(str);
 
-    while(i < str.length && !isspace(str.data[i])) {
-        i++;
+    if (i == -1) {
+        i = str.length;
     }
 
     return STR(str.length - i, str.data + i);
 }
 
 String str_get_until_space(String str) {
-    s64 i = 0;
+    s64 i = str_find_whitespace_left(str);
 
-    while(i < str.length && !isspace(str.data[i])) {
-        i++;
+    if (i == -1) {
+        i = str.length;
     }
 
     return STR(i, str.data);
@@ -207,91 +380,300 @@ bool str_is_float(String str) {
 }
 
 s64 str_parse_int(String str) {
-    s8 sign = 1;
+    return num_parse_s64(str);
+}
+
+float str_parse_float(String str) {
+    return num_parse_f32(str);
+}
+
+s64 str_count_chars(String str, char c) {
+    s64 count = 0;
     s64 i = 0;
 
-    if (str.data[0] == '-') {
-        sign = -1;
-        i = 1;
-    } else if (str.data[0] == '+') {
-        i = 1;
+#if STR_SIMD
+    Str_Vec target = str_vec_set(c);
+
+    for (; i + STR_VEC_WIDTH <= str.length; i += STR_VEC_WIDTH) {
+        count += str_mask_count(str_vec_eq_mask(str_vec_load(str.data + i), target));
     }
+#endif
 
-    int result = 0;
     for (; i < str.length; i++) {
-        result = result * 10 + (str.data[i] - '0');
+        if (str.data[i] == c) {
+            count++;
+        }
     }
 
-    return sign * result;
+    return count;
 }
 
-float str_parse_float(String str) {
-    s8 sign = 1;
-    s64 i = 0;
+u32 str_decode_utf8(String str, s64 *index) {
+    u8 *bytes = (u8 *)str.data + *index;
+    s64 left = str.length - *index;
+    u8 lead = bytes[0];
 
-    if (str.data[0] == '-') {
-        sign = -1;
-        i = 1;
-    } else if (str.data[0] == '+') {
-        i = 1;
+    // ASCII is the common case.
+    if (lead < 0x80) {
+        *index += 1;
+        return lead;
     }
 
-    double result = 0.0;
+    s64 length;
+    u32 codepoint;
+    u32 min;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+        min = 0x80;
+    }
+    else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        min = 0x800;
+    }
+    else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+        min = 0x10000;
+    }
+    else {
+        *index += 1;
+        return STR_REPLACEMENT_CODEPOINT;
+    }
 
-    // Parse integer part
-    while (i < str.length && str.data[i] != '.') {
-        result = result * 10.0 + (str.data[i] - '0');
-        i++;
+    if (length > left) {
+        *index += 1;
+        return STR_REPLACEMENT_CODEPOINT;
     }
 
-    // Parse fractional part
-    if (i < str.length && str.data[i] == '.') {
-        i++;  // skip dot
-        double frac = 0.0;
-        double base = 0.1;
-        while (i < str.length) {
-            frac += (str.data[i] - '0') * base;
-            base *= 0.1;
-            i++;
+    for (s64 i = 1; i < length; i++) {
+        if ((bytes[i] & 0xC0) != 0x80) {
+            *index += 1;
+            return STR_REPLACEMENT_CODEPOINT;
         }
-        result += frac;
+        codepoint = (codepoint << 6) | (bytes[i] & 0x3F);
     }
 
-    return sign * result;
+    // Overlong encodings, surrogates and values past unicode range.
+    if (codepoint < min || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        *index += 1;
+        return STR_REPLACEMENT_CODEPOINT;
+    }
+
+    *index += length;
+    return codepoint;
 }
 
-s64 str_count_chars(String str, char c) {
-    s64 count = 0;
+void *str_copy_to(String str, void *buffer) {
+    return memcpy(buffer, str.data, str.length);
+}
 
-    for (s64 i = 0; i < str.length; i++) {
-        if (str.data[i] == c) {
-            count++;
-        }
+
+
+
+
+/**
+ * Formatting.
+ * Formats made only of "%d", "%i", "%u" (with "hh", "h", "l", "ll", "z" modifiers), "%f", "%s", "%c", "%%", optional width and precision are formatted directly through "core/num.h".
+ * Anything else, including flags, goes through "vsnprintf()", result is identical either way.
+ */
+
+typedef struct str_writer {
+    char *data;
+    s64 capacity;
+    s64 written;
+} Str_Writer;
+
+static void str_writer_put(Str_Writer *writer, const char *data, s64 length) {
+    s64 space = writer->capacity - 1 - writer->written;
+    if (space > 0) {
+        memcpy(writer->data + writer->written, data, length < space ? length : space);
     }
+    writer->written += length;
+}
 
-    return count;
+static void str_writer_pad(Str_Writer *writer, s64 count) {
+    for (s64 i = 0; i < count; i++) {
+        str_writer_put(writer, " ", 1);
+    }
 }
 
-void *str_copy_to(String str, void *buffer) {
-    return memcpy(buffer, str.data, str.length);
+/**
+ * Returns true if every conversion in "format" is handled by the fast path.
+ */
+static bool str_format_is_simple(const char *format) {
+    for (const char *c = format; *c; c++) {
+        if (*c != '%') continue;
+        c++;
+
+        if (*c == '%') continue;
+
+        while (*c >= '0' && *c <= '9') {
+            if (c[-1] == '%' && *c == '0') return false;
+            c++;
+        }
+
+        bool has_precision = false;
+        if (*c == '.') {
+            has_precision = true;
+            c++;
+            if (*c == '*') {
+                c++;
+            } else {
+                while (*c >= '0' && *c <= '9') c++;
+            }
+        }
+
+        bool has_length = false;
+        while (*c == 'h' || *c == 'l' || *c == 'z') {
+            has_length = true;
+            c++;
+        }
+
+        switch (*c) {
+            case 'd': case 'i': case 'u':
+                if (has_precision) return false;
+                break;
+            case 'f': case 's': case 'c':
+                if (has_length) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return true;
 }
 
 String str_format(String buffer, char *format, ...) {
     va_list args;
     va_start(args, format);
 
-    // vsnprintf returns the number of chars that *would* have been written
-    int written = vsnprintf(buffer.data, buffer.length, format, args);
+    if (!str_format_is_simple(format)) {
+        // vsnprintf returns the number of chars that *would* have been written
+        int written = vsnprintf(buffer.data, buffer.length, format, args);
+
+        va_end(args);
+
+        if (written < 0) {
+            return STR(0, NULL);
+        }
+
+        buffer.length = written;
+
+        return buffer;
+    }
+
+    Str_Writer writer = { buffer.data, buffer.length, 0 };
+    char number[NUM_FIXED_MAX_CHARS];
+
+    for (const char *c = format; *c; c++) {
+        if (*c != '%') {
+            const char *literal_end = c;
+            while (literal_end[1] && literal_end[1] != '%') literal_end++;
+            str_writer_put(&writer, c, literal_end - c + 1);
+            c = literal_end;
+            continue;
+        }
+        c++;
+
+        if (*c == '%') {
+            str_writer_put(&writer, "%", 1);
+            continue;
+        }
+
+        s64 width = 0;
+        while (*c >= '0' && *c <= '9') {
+            width = width * 10 + (*c++ - '0');
+        }
+
+        s64 precision = -1;
+        if (*c == '.') {
+            c++;
+            precision = 0;
+            if (*c == '*') {
+                precision = va_arg(args, int);
+                c++;
+            } else {
+                while (*c >= '0' && *c <= '9') {
+                    precision = precision * 10 + (*c++ - '0');
+                }
+            }
+        }
+
+        s32 longs = 0;
+        s32 shorts = 0;
+        bool size = false;
+        while (*c == 'h' || *c == 'l' || *c == 'z') {
+            longs += *c == 'l';
+            shorts += *c == 'h';
+            size |= *c == 'z';
+            c++;
+        }
+
+        const char *data = number;
+        s64 length = 0;
+
+        switch (*c) {
+            case 'd':
+            case 'i': {
+                s64 value = size ? (s64)va_arg(args, s64) : longs >= 2 ? (s64)va_arg(args, long long) : longs == 1 ? (s64)va_arg(args, long) : (s64)va_arg(args, int);
+                // Short values are promoted to int, so they are narrowed back the same way printf does.
+                if (shorts >= 2)        value = (signed char)value;
+                else if (shorts == 1)   value = (short)value;
+                length = num_format_s64(value, number);
+                break;
+            }
+            case 'u': {
+                u64 value = size ? (u64)va_arg(args, u64) : longs >= 2 ? (u64)va_arg(args, unsigned long long) : longs == 1 ? (u64)va_arg(args, unsigned long) : (u64)va_arg(args, unsigned int);
+                if (shorts >= 2)        value = (unsigned char)value;
+                else if (shorts == 1)   value = (unsigned short)value;
+                length = num_format_u64(value, number);
+                break;
+            }
+            case 'f': {
+                double value = va_arg(args, double);
+                if (precision < 0) precision = 6;
+                length = num_format_fixed(value, (s32)precision, number);
+                if (length < 0) {
+                    // Out of the fast path range, formatting just this conversion.
+                    s64 space = writer.capacity - 1 - writer.written;
+                    char *at = space > 0 ? writer.data + writer.written : NULL;
+                    writer.written += snprintf(at, space > 0 ? space + 1 : 0, "%*.*f", (int)width, (int)precision, value);
+                    continue;
+                }
+                break;
+            }
+            case 's': {
+                data = va_arg(args, char *);
+                if (data == NULL) {
+                    // Same as glibc, which prints nothing when precision cuts "(null)".
+                    data = "(null)";
+                    length = precision < 0 || precision >= 6 ? 6 : 0;
+                    break;
+                }
+                length = precision < 0 ? (s64)strlen(data) : (s64)strnlen(data, precision);
+                break;
+            }
+            case 'c': {
+                number[0] = (char)va_arg(args, int);
+                length = 1;
+                break;
+            }
+        }
+
+        str_writer_pad(&writer, width - length);
+        str_writer_put(&writer, data, length);
+    }
 
     va_end(args);
 
-    if (written < 0) {
-        return STR(0, NULL);
+    if (writer.capacity > 0) {
+        writer.data[writer.written < writer.capacity - 1 ? writer.written : writer.capacity - 1] = '\0';
     }
 
-    buffer.length = written;
+    buffer.length = writer.written;
 
     return buffer;
 }
-
-
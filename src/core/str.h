@@ -95,6 +95,14 @@ s64 str_count_chars(String str, char c);
  */
 void *str_copy_to(String str, void *buffer);
 
+#define STR_REPLACEMENT_CODEPOINT 0xFFFD
+
+/**
+ * Decodes UTF-8 codepoint that starts at "*index" and moves "*index" past it.
+ * Invalid, overlong or truncated sequences decode as STR_REPLACEMENT_CODEPOINT and skip one byte, so decoding always moves forward.
+ */
+u32 str_decode_utf8(String str, s64 *index);
+
 String str_format(String buffer, char *format, ...);
 
 
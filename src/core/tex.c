@@ -0,0 +1,446 @@
+#include "core/tex.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/file.h"
+#include "core/log.h"
+#include "core/mathf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "stb/stb_image.h"
+
+
+/**
+ * Mip chain.
+ */
+
+static u32 level_size(Tex_Format format, u32 width, u32 height) {
+    if (format == TEX_FORMAT_BC3) {
+        return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+    }
+    return width * height * 4;
+}
+
+static void premultiply(u8 *pixels, u64 count) {
+    for (u64 i = 0; i < count; i++) {
+        u8 *p = pixels + i * 4;
+        u32 a = p[3];
+        p[0] = (p[0] * a + 127) / 255;
+        p[1] = (p[1] * a + 127) / 255;
+        p[2] = (p[2] * a + 127) / 255;
+    }
+}
+
+static void unpremultiply(u8 *source, u8 *destination, u64 count) {
+    for (u64 i = 0; i < count; i++) {
+        u8 *s = source + i * 4;
+        u8 *d = destination + i * 4;
+        u32 a = s[3];
+        if (a == 0) {
+            memset(d, 0, 4);
+            continue;
+        }
+        d[0] = (u8)mini((s[0] * 255 + a / 2) / a, 255);
+        d[1] = (u8)mini((s[1] * 255 + a / 2) / a, 255);
+        d[2] = (u8)mini((s[2] * 255 + a / 2) / a, 255);
+        d[3] = a;
+    }
+}
+
+/**
+ * Halves premultiplied level with 2x2 box filter, last row or column of odd sizes is repeated.
+ */
+static void downsample(u8 *source, u32 width, u32 height, u8 *destination) {
+    u32 next_width = width > 1 ? width / 2 : 1;
+    u32 next_height = height > 1 ? height / 2 : 1;
+
+    for (u32 y = 0; y < next_height; y++) {
+        u32 y0 = mini(y * 2, height - 1);
+        u32 y1 = mini(y * 2 + 1, height - 1);
+        for (u32 x = 0; x < next_width; x++) {
+            u32 x0 = mini(x * 2, width - 1);
+            u32 x1 = mini(x * 2 + 1, width - 1);
+            for (u32 c = 0; c < 4; c++) {
+                u32 sum = source[(y0 * width + x0) * 4 + c] + source[(y0 * width + x1) * 4 + c]
+                        + source[(y1 * width + x0) * 4 + c] + source[(y1 * width + x1) * 4 + c];
+                destination[(y * next_width + x) * 4 + c] = (sum + 2) / 4;
+            }
+        }
+    }
+}
+
+
+
+
+/**
+ * BC3 encoding.
+ * Endpoints are corners of the block's color bounding box, inset by 1/16 of it, which is cheap and close to what slower encoders pick.
+ */
+
+static u16 pack_565(u32 r, u32 g, u32 b) {
+    return (u16)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static void unpack_565(u16 color, s32 *rgb) {
+    rgb[0] = ((color >> 11) & 31) * 255 / 31;
+    rgb[1] = ((color >> 5) & 63) * 255 / 63;
+    rgb[2] = (color & 31) * 255 / 31;
+}
+
+static void bc3_block(u8 block[16][4], u8 *out) {
+    // Alpha, 8 values between max and min.
+    u8 a_max = 0;
+    u8 a_min = 255;
+    for (u32 i = 0; i < 16; i++) {
+        a_max = block[i][3] > a_max ? block[i][3] : a_max;
+        a_min = block[i][3] < a_min ? block[i][3] : a_min;
+    }
+
+    out[0] = a_max;
+    out[1] = a_min;
+    u64 alpha_bits = 0;
+    if (a_max > a_min) {
+        s32 palette[8] = { a_max, a_min };
+        for (s32 i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * a_max + i * a_min + 3) / 7;
+        }
+
+        for (u32 i = 0; i < 16; i++) {
+            u32 best = 0;
+            s32 best_error = 256;
+            for (u32 p = 0; p < 8; p++) {
+                s32 error = abs(palette[p] - block[i][3]);
+                if (error < best_error) {
+                    best = p;
+                    best_error = error;
+                }
+            }
+            alpha_bits |= (u64)best << (i * 3);
+        }
+    }
+    for (u32 i = 0; i < 6; i++) {
+        out[2 + i] = (u8)(alpha_bits >> (i * 8));
+    }
+
+    // Color, 4 values between endpoints.
+    s32 lo[3] = { 255, 255, 255 };
+    s32 hi[3] = { 0, 0, 0 };
+    for (u32 i = 0; i < 16; i++) {
+        for (u32 c = 0; c < 3; c++) {
+            lo[c] = mini(lo[c], block[i][c]);
+            hi[c] = maxi(hi[c], block[i][c]);
+        }
+    }
+    for (u32 c = 0; c < 3; c++) {
+        s32 inset = (hi[c] - lo[c]) / 16;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    u16 c0 = pack_565(hi[0], hi[1], hi[2]);
+    u16 c1 = pack_565(lo[0], lo[1], lo[2]);
+    u32 color_bits = 0;
+
+    // Block is 4 color one only when first endpoint is bigger, equal endpoints are one color and all indicies stay 0.
+    if (c0 < c1) {
+        u16 swap = c0;
+        c0 = c1;
+        c1 = swap;
+    }
+
+    if (c0 != c1) {
+        s32 palette[4][3];
+        unpack_565(c0, palette[0]);
+        unpack_565(c1, palette[1]);
+        for (u32 c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+        }
+
+        for (u32 i = 0; i < 16; i++) {
+            u32 best = 0;
+            s32 best_error = INT32_MAX;
+            for (u32 p = 0; p < 4; p++) {
+                s32 dr = palette[p][0] - block[i][0];
+                s32 dg = palette[p][1] - block[i][1];
+                s32 db = palette[p][2] - block[i][2];
+                s32 error = dr * dr + dg * dg + db * db;
+                if (error < best_error) {
+                    best = p;
+                    best_error = error;
+                }
+            }
+            color_bits |= best << (i * 2);
+        }
+    }
+
+    memcpy(out + 8, &c0, 2);
+    memcpy(out + 10, &c1, 2);
+    memcpy(out + 12, &color_bits, 4);
+}
+
+/**
+ * Blocks on the right and top edges of sizes that are not multiple of 4 repeat the last pixels.
+ */
+static void bc3_encode(u8 *pixels, u32 width, u32 height, u8 *out) {
+    for (u32 by = 0; by < height; by += 4) {
+        for (u32 bx = 0; bx < width; bx += 4) {
+            u8 block[16][4];
+            for (u32 y = 0; y < 4; y++) {
+                for (u32 x = 0; x < 4; x++) {
+                    u32 px = mini(bx + x, width - 1);
+                    u32 py = mini(by + y, height - 1);
+                    memcpy(block[y * 4 + x], pixels + (py * width + px) * 4, 4);
+                }
+            }
+            bc3_block(block, out);
+            out += 16;
+        }
+    }
+}
+
+
+
+
+bool tex_cook(u8 *pixels, s32 width, s32 height, Tex_Format format, u8 flags, u64 source_hash, char *tex_path) {
+    Tex_Header header = {
+        .magic          = TEX_MAGIC,
+        .version        = TEX_VERSION,
+        .format         = format,
+        .flags          = flags,
+        .width          = width,
+        .height         = height,
+        .source_hash    = source_hash,
+    };
+
+    // Laying levels out after the header.
+    u32 offset = sizeof(Tex_Header);
+    u32 level_width = width;
+    u32 level_height = height;
+    while (header.levels_count < TEX_MAX_LEVELS) {
+        Tex_Level *level = &header.levels[header.levels_count++];
+        level->width = level_width;
+        level->height = level_height;
+        level->offset = offset;
+        level->size = level_size(format, level_width, level_height);
+        offset += level->size;
+
+        if (level_width == 1 && level_height == 1) {
+            break;
+        }
+        level_width = level_width > 1 ? level_width / 2 : 1;
+        level_height = level_height > 1 ? level_height / 2 : 1;
+    }
+
+    u8 *data = allocator_alloc(&std_allocator, offset);
+    memcpy(data, &header, sizeof(Tex_Header));
+
+    // Working level is premultiplied, each level is converted into output format from it.
+    u64 pixels_size = (u64)width * height * 4;
+    u8 *current = allocator_alloc(&std_allocator, pixels_size);
+    u8 *next = allocator_alloc(&std_allocator, pixels_size);
+    u8 *straight = allocator_alloc(&std_allocator, pixels_size);
+    memcpy(current, pixels, pixels_size);
+    premultiply(current, (u64)width * height);
+
+    for (u32 i = 0; i < header.levels_count; i++) {
+        Tex_Level *level = &header.levels[i];
+        u64 count = (u64)level->width * level->height;
+
+        u8 *level_pixels = current;
+        if (!(flags & TEX_COOK_PREMULTIPLIED)) {
+            // First level is taken as it is, so unpremultiplying doesn't lose precision.
+            if (i == 0) {
+                memcpy(straight, pixels, count * 4);
+            } else {
+                unpremultiply(current, straight, count);
+            }
+            level_pixels = straight;
+        }
+
+        if (format == TEX_FORMAT_BC3) {
+            bc3_encode(level_pixels, level->width, level->height, data + level->offset);
+        } else {
+            memcpy(data + level->offset, level_pixels, count * 4);
+        }
+
+        if (i + 1 < header.levels_count) {
+            downsample(current, level->width, level->height, next);
+            u8 *swap = current;
+            current = next;
+            next = swap;
+        }
+    }
+
+    allocator_free(&std_allocator, current);
+    allocator_free(&std_allocator, next);
+    allocator_free(&std_allocator, straight);
+
+    FILE *file = fopen(tex_path, "wb");
+    if (file == NULL) {
+        LOG_ERROR("Couldn't open '%s' for writing.", tex_path);
+        allocator_free(&std_allocator, data);
+        return false;
+    }
+
+    bool result = fwrite(data, 1, offset, file) == offset;
+    allocator_free(&std_allocator, data);
+
+    if (fclose(file) != 0 || !result) {
+        LOG_ERROR("Couldn't write '%s'.", tex_path);
+        return false;
+    }
+    return true;
+}
+
+u64 tex_source_hash(u8 *data, u64 size, Tex_Format format, u8 flags) {
+    // FNV-1a over the source, then options and version, so changing any of them cooks file again.
+    u64 hash = 14695981039346656037ull;
+    for (u64 i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+
+    u8 options[3] = { format, flags, TEX_VERSION };
+    for (u32 i = 0; i < sizeof(options); i++) {
+        hash = (hash ^ options[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool tex_is_current(char *tex_path, u64 source_hash) {
+    FILE *file = fopen(tex_path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    Tex_Header header;
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    (void)fclose(file);
+
+    return read && header.magic == TEX_MAGIC && header.version == TEX_VERSION && header.source_hash == source_hash;
+}
+
+bool tex_cook_file(char *image_path, char *tex_path, Tex_Format format, u8 flags, bool *cooked) {
+    *cooked = false;
+
+    u64 size;
+    u8 *source = read_file_into_buffer(image_path, &size, &std_allocator);
+    if (source == NULL) {
+        LOG_ERROR("Couldn't read image '%s' for cooking.", image_path);
+        return false;
+    }
+
+    u64 hash = tex_source_hash(source, size, format, flags);
+    if (tex_is_current(tex_path, hash)) {
+        allocator_free(&std_allocator, source);
+        return true;
+    }
+
+    s32 width, height, channels;
+    stbi_set_flip_vertically_on_load(true);
+    u8 *pixels = stbi_load_from_memory(source, (s32)size, &width, &height, &channels, 4);
+    allocator_free(&std_allocator, source);
+
+    if (pixels == NULL) {
+        LOG_ERROR("Stbi couldn't decode image '%s' for cooking.", image_path);
+        return false;
+    }
+
+    *cooked = tex_cook(pixels, width, height, format, flags, hash, tex_path);
+    stbi_image_free(pixels);
+    return *cooked;
+}
+
+bool tex_load(char *tex_path, Tex *tex) {
+    *tex = (Tex) {0};
+
+    u64 size;
+    u8 *data = read_file_into_buffer(tex_path, &size, &std_allocator);
+    if (data == NULL) {
+        return false;
+    }
+
+    Tex_Header *header = (Tex_Header *)data;
+    bool valid = size >= sizeof(Tex_Header) && header->magic == TEX_MAGIC && header->version == TEX_VERSION
+              && header->format <= TEX_FORMAT_BC3 && header->levels_count > 0 && header->levels_count <= TEX_MAX_LEVELS;
+
+    for (u32 i = 0; valid && i < header->levels_count; i++) {
+        Tex_Level *level = &header->levels[i];
+        valid = (u64)level->offset + level->size <= size && level->size == level_size(header->format, level->width, level->height);
+    }
+
+    if (!valid) {
+        LOG_ERROR("'%s' is not a valid cooked texture.", tex_path);
+        allocator_free(&std_allocator, data);
+        return false;
+    }
+
+    tex->header = header;
+    tex->data = data;
+    tex->size = size;
+    return true;
+}
+
+void tex_free(Tex *tex) {
+    if (tex->data != NULL) {
+        allocator_free(&std_allocator, tex->data);
+    }
+    *tex = (Tex) {0};
+}
+
+u8 *tex_level_data(Tex *tex, u32 level) {
+    return tex->data + tex->header->levels[level].offset;
+}
+
+bool tex_path_from_image(char *image_path, char *buffer, u64 capacity) {
+    u64 length = strlen(image_path);
+    char *dot = strrchr(image_path, '.');
+    char *slash = strrchr(image_path, '/');
+    if (dot != NULL && (slash == NULL || dot > slash)) {
+        length = dot - image_path;
+    }
+
+    if (length + 1 + strlen(TEX_FILE_FORMAT) + 1 > capacity) {
+        return false;
+    }
+
+    memcpy(buffer, image_path, length);
+    buffer[length] = '.';
+    strcpy(buffer + length + 1, TEX_FILE_FORMAT);
+    return true;
+}
+
+bool tex_cooked_path(char *image_path, char *buffer, u64 capacity) {
+    if (!tex_path_from_image(image_path, buffer, capacity) || strcmp(buffer, image_path) == 0) {
+        return false;
+    }
+
+    // Header is checked first, so images that were never cooked are not read.
+    FILE *file = fopen(buffer, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    Tex_Header header;
+    bool read = fread(&header, sizeof(header), 1, file) == 1;
+    (void)fclose(file);
+
+    if (!read || header.magic != TEX_MAGIC || header.version != TEX_VERSION) {
+        return false;
+    }
+
+    u64 size;
+    u8 *source = read_file_into_buffer(image_path, &size, &std_allocator);
+    if (source == NULL) {
+        return false;
+    }
+
+    u64 hash = tex_source_hash(source, size, header.format, header.flags);
+    allocator_free(&std_allocator, source);
+
+    return hash == header.source_hash;
+}
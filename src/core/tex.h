@@ -0,0 +1,112 @@
+#ifndef TEX_H
+#define TEX_H
+
+/**
+ * Cooked textures.
+ * ".tex" file is image that is ready to be uploaded: header, then every mip level from the biggest one down to 1x1, one after another.
+ * It is loaded with one read, and each level is given to GL as it is, so nothing is decoded at runtime.
+ *
+ * Mip levels are box filtered with premultiplied alpha, so transparent pixels don't bleed their color into edges.
+ * Pixels are stored with straight alpha by default, since renderer blends with GL_SRC_ALPHA, TEX_COOK_PREMULTIPLIED keeps them premultiplied.
+ * TEX_FORMAT_BC3 levels are compressed on the CPU into 4x4 blocks, 1 byte per pixel instead of 4.
+ * Rows go from the bottom up, same as images loaded by "texture_load()".
+ *
+ * Cooking is incremental, header keeps hash of the source file and cook options, and file that has the same hash is not cooked again.
+ * Same hash tells loaders whether ".tex" next to the image is up to date, if it isn't the image is decoded instead.
+ * @Important: Cooking decodes images with stb_image, so program that uses it should define STB_IMAGE_IMPLEMENTATION, game does it in "graphics.c".
+ */
+
+#include "core/core.h"
+#include "core/type.h"
+
+#include <stdbool.h>
+
+#define TEX_MAGIC       0x31584554  // "TEX1".
+#define TEX_VERSION     1
+#define TEX_MAX_LEVELS  16
+#define TEX_FILE_FORMAT "tex"
+
+typedef enum tex_format : u8 {
+    TEX_FORMAT_RGBA8,
+    TEX_FORMAT_BC3,                 // DXT5, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT.
+} Tex_Format;
+
+typedef enum tex_cook_flags : u8 {
+    TEX_COOK_PREMULTIPLIED  = 1 << 0,
+} Tex_Cook_Flags;
+
+typedef struct tex_level {
+    u32 width;
+    u32 height;
+    u32 offset;                     // From the start of the file.
+    u32 size;                       // In bytes.
+} Tex_Level;
+
+typedef struct tex_header {
+    u32 magic;
+    u16 version;
+    u8  format;                     // Tex_Format.
+    u8  flags;                      // Tex_Cook_Flags.
+    u32 width;
+    u32 height;
+    u32 levels_count;
+    u32 reserved;
+    u64 source_hash;                // Hash of source file and cook options.
+    Tex_Level levels[TEX_MAX_LEVELS];
+} Tex_Header;
+
+typedef struct tex {
+    Tex_Header *header;             // Points at the start of "data".
+    u8 *data;                       // Whole file.
+    u64 size;
+} Tex;
+
+/**
+ * Cooks RGBA8 pixels into ".tex" file, rows go from the bottom up.
+ * Returns false if file couldn't be written.
+ */
+bool tex_cook(u8 *pixels, s32 width, s32 height, Tex_Format format, u8 flags, u64 source_hash, char *tex_path);
+
+/**
+ * Cooks image file into ".tex" file, unless it was already cooked from the same source with the same options.
+ * Sets "cooked" to whether file was written.
+ * Returns false if image couldn't be read or cooked file couldn't be written.
+ */
+bool tex_cook_file(char *image_path, char *tex_path, Tex_Format format, u8 flags, bool *cooked);
+
+/**
+ * Returns hash that "tex_cook_file()" keys cooked file by.
+ */
+u64 tex_source_hash(u8 *data, u64 size, Tex_Format format, u8 flags);
+
+/**
+ * Returns true if ".tex" file exists and was cooked from source with this hash.
+ */
+bool tex_is_current(char *tex_path, u64 source_hash);
+
+/**
+ * Reads ".tex" file with one read and checks that header and levels are valid.
+ * Returns false if file couldn't be read or isn't valid.
+ */
+bool tex_load(char *tex_path, Tex *tex);
+
+void tex_free(Tex *tex);
+
+/**
+ * Returns data of the mip level.
+ */
+u8 *tex_level_data(Tex *tex, u32 level);
+
+/**
+ * Writes path with extension replaced by ".tex" into buffer of "capacity" bytes.
+ * Returns false if it doesn't fit.
+ */
+bool tex_path_from_image(char *image_path, char *buffer, u64 capacity);
+
+/**
+ * Writes path of ".tex" file that was cooked from the image as it is now into buffer of "capacity" bytes.
+ * Returns false if there is no such file or it was cooked from older version of the image, then image itself should be loaded.
+ */
+bool tex_cooked_path(char *image_path, char *buffer, u64 capacity);
+
+#endif
@@ -0,0 +1,164 @@
+#include "core/thread.h"
+#include "core/type.h"
+#include "core/core.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+
+#if !defined(_WIN32)
+    #include <sched.h>
+#endif
+
+
+typedef struct thread_start {
+    Thread_Procedure procedure;
+    void *data;
+} Thread_Start;
+
+#if defined(_WIN32)
+
+static DWORD WINAPI thread_entry(LPVOID param) {
+    Thread_Start start = *(Thread_Start *)param;
+    free(param);
+    start.procedure(start.data);
+    return 0;
+}
+
+#else
+
+static void *thread_entry(void *param) {
+    Thread_Start start = *(Thread_Start *)param;
+    free(param);
+    start.procedure(start.data);
+    return NULL;
+}
+
+#endif
+
+bool thread_create(Thread *thread, Thread_Procedure procedure, void *data) {
+    Thread_Start *start = malloc(sizeof(Thread_Start));
+    if (start == NULL) {
+        printf_err("Couldn't allocate thread start parameters.\n");
+        return false;
+    }
+
+    *start = (Thread_Start) { procedure, data };
+
+#if defined(_WIN32)
+    *thread = CreateThread(NULL, 0, thread_entry, start, 0, NULL);
+    if (*thread == NULL) {
+        printf_err("Couldn't create thread, error: %lu.\n", GetLastError());
+        free(start);
+        return false;
+    }
+#else
+    int error = pthread_create(thread, NULL, thread_entry, start);
+    if (error != 0) {
+        printf_err("Couldn't create thread, error: %d.\n", error);
+        free(start);
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void thread_join(Thread thread) {
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+u64 thread_current_id() {
+#if defined(_WIN32)
+    return (u64)GetCurrentThreadId();
+#else
+    return (u64)pthread_self();
+#endif
+}
+
+void thread_sleep_ms(u32 milliseconds) {
+#if defined(_WIN32)
+    Sleep(milliseconds);
+#else
+    struct timespec ts = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR);
+#endif
+}
+
+void thread_yield() {
+#if defined(__SSE2__)
+    __builtin_ia32_pause();
+#elif defined(_WIN32)
+    YieldProcessor();
+#else
+    sched_yield();
+#endif
+}
+
+
+
+
+void mutex_lock(Mutex *mutex) {
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+bool mutex_try_lock(Mutex *mutex) {
+#if defined(_WIN32)
+    return TryAcquireSRWLockExclusive(mutex) != 0;
+#else
+    return pthread_mutex_trylock(mutex) == 0;
+#endif
+}
+
+void mutex_unlock(Mutex *mutex) {
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+
+
+
+bool condition_wait(Condition *condition, Mutex *mutex, u32 timeout_ms) {
+#if defined(_WIN32)
+    return SleepConditionVariableSRW(condition, mutex, timeout_ms, 0) != 0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec  += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    return pthread_cond_timedwait(condition, mutex, &ts) == 0;
+#endif
+}
+
+void condition_signal(Condition *condition) {
+#if defined(_WIN32)
+    WakeConditionVariable(condition);
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+void condition_broadcast(Condition *condition) {
+#if defined(_WIN32)
+    WakeAllConditionVariable(condition);
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
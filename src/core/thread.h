@@ -0,0 +1,99 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+/**
+ * Threads.
+ * Thin layer over Win32 threads on Windows and pthreads everywhere else.
+ */
+
+#include "core/type.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+
+
+
+#if defined(_WIN32)
+
+typedef HANDLE Thread;
+typedef SRWLOCK Mutex;
+typedef CONDITION_VARIABLE Condition;
+
+#define MUTEX_INIT      SRWLOCK_INIT
+#define CONDITION_INIT  CONDITION_VARIABLE_INIT
+
+#else
+
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+
+#define MUTEX_INIT      PTHREAD_MUTEX_INITIALIZER
+#define CONDITION_INIT  PTHREAD_COND_INITIALIZER
+
+#endif
+
+typedef void (*Thread_Procedure)(void *data);
+
+
+
+/**
+ * Starts new thread that runs "procedure(data)".
+ * Returns false if thread couldn't be created.
+ */
+bool thread_create(Thread *thread, Thread_Procedure procedure, void *data);
+
+/**
+ * Blocks until "thread" finishes.
+ */
+void thread_join(Thread thread);
+
+/**
+ * Returns id of the calling thread, same value OS tools show.
+ */
+u64 thread_current_id();
+
+void thread_sleep_ms(u32 milliseconds);
+
+/**
+ * Hints CPU that caller is spinning.
+ */
+void thread_yield();
+
+
+
+/**
+ * Mutex.
+ * Statically initialized with MUTEX_INIT, never needs to be destroyed.
+ */
+void mutex_lock(Mutex *mutex);
+
+/**
+ * Returns true if lock was acquired.
+ */
+bool mutex_try_lock(Mutex *mutex);
+
+void mutex_unlock(Mutex *mutex);
+
+
+
+/**
+ * Condition variable.
+ * Statically initialized with CONDITION_INIT, "mutex" should be locked by the caller when waiting.
+ * Returns false if wait timed out.
+ */
+bool condition_wait(Condition *condition, Mutex *mutex, u32 timeout_ms);
+
+void condition_signal(Condition *condition);
+
+void condition_broadcast(Condition *condition);
+
+
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "core/type.h"
 #include "core/str.h"
+#include "core/num.h"
 
 #include <stdbool.h>
 
@@ -118,6 +119,19 @@ typedef struct any {
     void *data;
 } Any;
 
+/**
+ * Copies formatted number into buffer the same way snprintf would, truncated and NUL-terminated.
+ */
+static void format_any_copy(String buffer, char *number, s64 length) {
+    if (buffer.length <= 0) {
+        return;
+    }
+
+    s64 copied = length < buffer.length - 1 ? length : buffer.length - 1;
+    memcpy(buffer.data, number, copied);
+    buffer.data[copied] = '\0';
+}
+
 /**
  * 'buffer' should be big enough to hold info about 'any'.
  *  Returns a string that corresponds to the formatted 'any'.
@@ -125,45 +139,59 @@ typedef struct any {
 static String format_any(Any any, String buffer) {
     s64 written = 0;
     switch (any.type->type) {
-        case INTEGER:
+        case INTEGER: {
+            char number[NUM_S64_MAX_CHARS];
+            s64 length = 0;
             if (any.type->t_integer.is_signed) {
                 switch(any.type->size) {
                     case 1:
-                        written += snprintf(buffer.data, buffer.length, "%d", *(s8 *)any.data);
+                        length = num_format_s64(*(s8 *)any.data, number);
                         break;
                     case 2:
-                        written += snprintf(buffer.data, buffer.length, "%d", *(s16 *)any.data);
+                        length = num_format_s64(*(s16 *)any.data, number);
                         break;
                     case 4:
-                        written += snprintf(buffer.data, buffer.length, "%d", *(s32 *)any.data);
+                        length = num_format_s64(*(s32 *)any.data, number);
                         break;
                     case 8:
-                        written += snprintf(buffer.data, buffer.length, "%lld", *(s64 *)any.data);
+                        length = num_format_s64(*(s64 *)any.data, number);
                         break;
                 }
             }
             else {
                 switch(any.type->size) {
                     case 1:
-                        written += snprintf(buffer.data, buffer.length, "%u", *(u8 *)any.data);
+                        length = num_format_u64(*(u8 *)any.data, number);
                         break;
                     case 2:
-                        written += snprintf(buffer.data, buffer.length, "%u", *(u16 *)any.data);
+                        length = num_format_u64(*(u16 *)any.data, number);
                         break;
                     case 4:
-                        written += snprintf(buffer.data, buffer.length, "%u", *(u32 *)any.data);
+                        length = num_format_u64(*(u32 *)any.data, number);
                         break;
                     case 8:
-                        written += snprintf(buffer.data, buffer.length, "%llu", *(u64 *)any.data);
+                        length = num_format_u64(*(u64 *)any.data, number);
                         break;
                 }
             }
+            format_any_copy(buffer, number, length);
+            written += length;
             break;
+        }
         case FLOAT:
             switch(any.type->size) {
-                case 4:
-                    written += snprintf(buffer.data, buffer.length, "%f", *(float *)any.data);
+                case 4: {
+                    // Same as "%f", values out of the fast path range are formatted by snprintf.
+                    char number[NUM_FIXED_MAX_CHARS];
+                    s64 length = num_format_fixed(*(float *)any.data, 6, number);
+                    if (length < 0) {
+                        written += snprintf(buffer.data, buffer.length, "%f", *(float *)any.data);
+                        break;
+                    }
+                    format_any_copy(buffer, number, length);
+                    written += length;
                     break;
+                }
             }
             break;
         case BOOL:
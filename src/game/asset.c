@@ -39,9 +39,6 @@ bool asset_view_changes(u32 *count, const Asset_Change **changes) {
 }
 
 int asset_force_changes(char *directory) {
-    array_list_clear(&asset_changes_list);
-    arena_clear(&filenames_arena);
-
     return asset_recursivly_force_changes(CSTR(directory));
 }
 
@@ -368,4 +365,353 @@ int asset_observer_poll_changes() {
 }
 
 
+
+/**
+ * LINUX specific code.
+ * Inotify isn't recursive, so every directory is watched on its own, and directories that appear later are watched as they are reported.
+ * Files are reported when they are closed after writing or moved into place, so half written files are not reloaded,
+ * and path that changed several times since the last poll is reported once, since editors often write file more than once when saving.
+ */
+#elif OS == LINUX
+
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+
+
+#define ASSET_FILENAMES_ARENA_SIZE  (256*KB)   // Holds paths of all files of forced changes too.
+#define ASSET_DIRENTS_BUFFER_SIZE   (8*KB)
+#define ASSET_EVENTS_BUFFER_SIZE    (8*KB)
+#define ASSET_CHANGE_BUCKETS        1024        // Power of two.
+#define ASSET_WATCH_MASK            (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR)
+
+typedef struct linux_dirent64 {
+    u64     d_ino;
+    s64     d_off;
+    u16     d_reclen;
+    u8      d_type;
+    char    d_name[];
+} Linux_Dirent64;
+
+
+static int inotify_fd = -1;
+static String dir_path;
+static char **watch_paths;          // Array list indexed by watch descriptor, directory path or NULL if descriptor isn't used.
+
+// Changes by path, so duplicates are found without going through all of them, rebuilt for every poll.
+static u32 change_buckets[ASSET_CHANGE_BUCKETS];    // Change index + 1, 0 is empty.
+static u32 *change_next;            // Array list, next change index + 1 in the same bucket, 0 is end.
+
+
+
+
+static void asset_changes_index_clear() {
+    memset(change_buckets, 0, sizeof(change_buckets));
+    array_list_clear(&change_next);
+}
+
+/**
+ * Adds change for the file unless it is already there.
+ * Returns 0 if successful.
+ */
+static int asset_change_add(char *path, u32 path_length) {
+    String path_string = STR(path_length, path);
+
+    u32 hash = 2166136261u;
+    for (u32 i = 0; i < path_length; i++) {
+        hash = (hash ^ (u8)path[i]) * 16777619u;
+    }
+    u32 bucket = hash & (ASSET_CHANGE_BUCKETS - 1);
+
+    for (u32 i = change_buckets[bucket]; i != 0; i = change_next[i - 1]) {
+        if (str_equals(asset_changes_list[i - 1].full_path, path_string)) {
+            return 0;
+        }
+    }
+
+    String full_path = {
+        .length = path_length,
+        .data = arena_alloc(&filenames_arena, path_length),
+    };
+
+    if (full_path.data == NULL) {
+        printf_err("Couldn't fit asset change path '%.*s' into the arena.\n", UNPACK(path_string));
+        return -1;
+    }
+    str_copy_to(path_string, full_path.data);
+
+    String file_name = str_substring(full_path, str_find_char_right(full_path, '/') + 1, full_path.length);
+
+    String file_format = str_substring(full_path, str_find_char_right(full_path, '.') + 1, full_path.length);
+
+    array_list_append(&asset_changes_list, ((Asset_Change) {
+                .full_path      = full_path,
+                .file_name      = file_name,
+                .file_format    = file_format,
+                }));
+
+    array_list_append(&change_next, change_buckets[bucket]);
+    change_buckets[bucket] = array_list_length(&asset_changes_list);
+
+    return 0;
+}
+
+/**
+ * Appends '/' and name to the null terminated path.
+ * Returns false if it doesn't fit.
+ */
+static bool asset_path_append(char *path, u32 *path_length, const char *name) {
+    u32 name_length = strlen(name);
+    if (*path_length + 1 + name_length >= PATH_MAX) {
+        printf_err("Asset path '%s/%s' is too long.\n", path, name);
+        return false;
+    }
+
+    path[*path_length] = '/';
+    memcpy(path + *path_length + 1, name, name_length + 1);
+    *path_length += 1 + name_length;
+
+    return true;
+}
+
+/**
+ * Starts watching directory, watching it again replaces its path.
+ * Returns 0 if successful.
+ */
+static int asset_watch_add(char *path, u32 path_length) {
+    int wd = inotify_add_watch(inotify_fd, path, ASSET_WATCH_MASK);
+    if (wd < 0) {
+        printf_err("Couldn't watch directory '%s'. Error: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (array_list_length(&watch_paths) <= (u32)wd) {
+        array_list_append(&watch_paths, NULL);
+    }
+
+    if (watch_paths[wd] != NULL) {
+        allocator_free(&std_allocator, watch_paths[wd]);
+    }
+    watch_paths[wd] = allocator_alloc(&std_allocator, path_length + 1);
+    memcpy(watch_paths[wd], path, path_length + 1);
+
+    return 0;
+}
+
+/**
+ * Walks the directory opened as "directory_fd", which path is in "path" buffer of PATH_MAX size.
+ * Adds changes for every file if "force" is set, and watches every directory if "watch" is set.
+ * @Recursion.
+ * Returns 0 if successful.
+ */
+static int asset_walk(int directory_fd, char *path, u32 path_length, bool force, bool watch) {
+    if (watch && asset_watch_add(path, path_length) != 0) {
+        return -1;
+    }
+
+    u8 buffer[ASSET_DIRENTS_BUFFER_SIZE] __attribute__((aligned(8)));
+
+    while (true) {
+        long read_length = syscall(SYS_getdents64, directory_fd, buffer, sizeof(buffer));
+        if (read_length < 0) {
+            printf_err("Couldn't read directory '%s'. Error: %s\n", path, strerror(errno));
+            return -1;
+        }
+
+        // End of directory.
+        if (read_length == 0) {
+            return 0;
+        }
+
+        for (long offset = 0; offset < read_length;) {
+            Linux_Dirent64 *entry = (Linux_Dirent64 *)(buffer + offset);
+            offset += entry->d_reclen;
+
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+
+            // Some file systems don't fill the type.
+            bool is_directory = entry->d_type == DT_DIR;
+            if (entry->d_type == DT_UNKNOWN) {
+                struct stat file_stat;
+                if (fstatat(directory_fd, entry->d_name, &file_stat, AT_SYMLINK_NOFOLLOW) != 0) {
+                    continue;
+                }
+                is_directory = S_ISDIR(file_stat.st_mode);
+            }
+
+            u32 entry_path_length = path_length;
+            if (!asset_path_append(path, &entry_path_length, entry->d_name)) {
+                return -1;
+            }
+
+            int result = 0;
+            if (is_directory) {
+                int entry_fd = openat(directory_fd, entry->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+                if (entry_fd < 0) {
+                    printf_err("Couldn't open directory '%s'. Error: %s\n", path, strerror(errno));
+                    result = -1;
+                } else {
+                    result = asset_walk(entry_fd, path, entry_path_length, force, watch);
+                    close(entry_fd);
+                }
+            } else if (force) {
+                result = asset_change_add(path, entry_path_length);
+            }
+
+            path[path_length] = '\0';
+            if (result != 0) {
+                return -1;
+            }
+        }
+    }
+}
+
+/**
+ * Opens the directory and walks it, see "asset_walk()".
+ */
+static int asset_walk_path(String directory, bool force, bool watch) {
+    char path[PATH_MAX];
+    if (directory.length >= PATH_MAX) {
+        printf_err("Asset directory path '%.*s' is too long.\n", UNPACK(directory));
+        return -1;
+    }
+    str_copy_to(directory, path);
+    path[directory.length] = '\0';
+
+    int directory_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directory_fd < 0) {
+        printf_err("Couldn't open directory '%s'. Error: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    int result = asset_walk(directory_fd, path, directory.length, force, watch);
+    close(directory_fd);
+
+    return result;
+}
+
+
+
+
+int asset_recursivly_force_changes(String directory) {
+    // Index is kept, so files that already have pending change are not added again.
+    return asset_walk_path(directory, true, false);
+}
+
+int asset_observer_start_watching(char *directory) {
+    // Init arena for filenames retrived from inotify events.
+    filenames_arena = arena_make(ASSET_FILENAMES_ARENA_SIZE);
+
+    watch_paths = array_list_make(char *, 64, &std_allocator);
+    change_next = array_list_make(u32, 64, &std_allocator);
+    dir_path = CSTR(directory);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        printf_err("Failed to init inotify. Error: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (asset_walk_path(dir_path, false, true) != 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+int asset_observer_poll_changes() {
+    array_list_clear(&asset_changes_list);
+    arena_clear(&filenames_arena);
+
+    if (inotify_fd < 0) return 0;
+
+    asset_changes_index_clear();
+
+    // Aligned, so events are read in place.
+    static u8 buffer[ASSET_EVENTS_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    bool overflowed = false;
+
+    while (true) {
+        ssize_t read_length = read(inotify_fd, buffer, sizeof(buffer));
+        if (read_length < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break; // No more events.
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            printf_err("Reading inotify events failed while observing asset changes. Error: %s\n", strerror(errno));
+            return -1;
+        }
+
+        for (ssize_t offset = 0; offset < read_length;) {
+            struct inotify_event *event = (struct inotify_event *)(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflowed = true;
+                continue;
+            }
+
+            if (event->wd < 0 || (u32)event->wd >= array_list_length(&watch_paths) || watch_paths[event->wd] == NULL) {
+                continue;
+            }
+
+            // Directory was removed or moved away, its descriptor can be reused by the next watch.
+            if (event->mask & IN_IGNORED) {
+                allocator_free(&std_allocator, watch_paths[event->wd]);
+                watch_paths[event->wd] = NULL;
+                continue;
+            }
+
+            if (event->len == 0) {
+                continue;
+            }
+
+            char path[PATH_MAX];
+            u32 path_length = strlen(watch_paths[event->wd]);
+            memcpy(path, watch_paths[event->wd], path_length + 1);
+            if (!asset_path_append(path, &path_length, event->name)) {
+                continue;
+            }
+
+            if (event->mask & IN_ISDIR) {
+                // Files could be written into new directory before it was watched, so all of them are reported.
+                if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && asset_walk_path(STR(path_length, path), true, true) != 0) {
+                    return -1;
+                }
+                continue;
+            }
+
+            if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && asset_change_add(path, path_length) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    // Events were lost, so every file is reported, and directories that could have been missed are watched.
+    if (overflowed) {
+        printf_err("Asset events queue overflowed, forcing changes of '%.*s'.\n", UNPACK(dir_path));
+
+        array_list_clear(&asset_changes_list);
+        arena_clear(&filenames_arena);
+        asset_changes_index_clear();
+
+        return asset_walk_path(dir_path, true, true);
+    }
+
+    return 0;
+}
+
+
 #endif
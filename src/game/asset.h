@@ -16,6 +16,7 @@ typedef struct asset_change {
  * Forcefully generate asset changes for every file in the directory specified.
  * Can be used to track all existing assets during app initialization stage.
  * Or can be used to hot reload assets in the specific folders.
+ * Changes are appended after the ones that are pending, so they stay in the list.
  * Return 0 is successful
  */
 int asset_force_changes(char *directory);
@@ -0,0 +1,545 @@
+#include "game/atlas.h"
+#include "game/graphics.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/mathf.h"
+#include "core/log.h"
+#include "core/tex.h"
+
+#include <GL/glew.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stb/stb_image.h"
+
+
+/**
+ * Skyline packer.
+ */
+
+void skyline_init(Skyline *skyline, s32 width, s32 height) {
+    skyline->width = width;
+    skyline->height = height;
+    skyline->nodes_count = 1;
+    skyline->nodes[0] = (Skyline_Node) { 0, 0, width };
+}
+
+/**
+ * Returns y at which rect placed at the start of node fits, or -1.
+ */
+static s32 skyline_fit(Skyline *skyline, s32 index, s32 width, s32 height) {
+    if (skyline->nodes[index].x + width > skyline->width) {
+        return -1;
+    }
+
+    // Rect lies on the highest of nodes it spans, nodes always cover whole width, so it doesn't go past the last node.
+    s32 y = 0;
+    s32 width_left = width;
+    for (s32 i = index; width_left > 0; i++) {
+        y = maxi(y, skyline->nodes[i].y);
+        if (y + height > skyline->height) {
+            return -1;
+        }
+        width_left -= skyline->nodes[i].width;
+    }
+
+    return y;
+}
+
+bool skyline_pack(Skyline *skyline, s32 width, s32 height, s32 *x, s32 *y) {
+    if (width <= 0 || height <= 0 || skyline->nodes_count >= SKYLINE_MAX_NODES) {
+        return false;
+    }
+
+    // Lowest place, narrowest node on ties, so wide gaps stay for wide rects.
+    s32 best_index = -1;
+    s32 best_y = INT_MAX;
+    s32 best_width = INT_MAX;
+    for (s32 i = 0; i < skyline->nodes_count; i++) {
+        s32 fit_y = skyline_fit(skyline, i, width, height);
+        if (fit_y == -1) {
+            continue;
+        }
+
+        if (fit_y < best_y || (fit_y == best_y && skyline->nodes[i].width < best_width)) {
+            best_index = i;
+            best_y = fit_y;
+            best_width = skyline->nodes[i].width;
+        }
+    }
+
+    if (best_index == -1) {
+        return false;
+    }
+
+    *x = skyline->nodes[best_index].x;
+    *y = best_y;
+
+    // Inserting node for the top of the rect.
+    Skyline_Node *nodes = skyline->nodes;
+    memmove(nodes + best_index + 1, nodes + best_index, (skyline->nodes_count - best_index) * sizeof(Skyline_Node));
+    nodes[best_index] = (Skyline_Node) { *x, best_y + height, width };
+    skyline->nodes_count++;
+
+    // Shrinking or removing nodes that are under it now.
+    for (s32 i = best_index + 1; i < skyline->nodes_count; ) {
+        s32 previous_end = nodes[i - 1].x + nodes[i - 1].width;
+        if (nodes[i].x >= previous_end) {
+            break;
+        }
+
+        s32 shrink = previous_end - nodes[i].x;
+        nodes[i].x += shrink;
+        nodes[i].width -= shrink;
+
+        if (nodes[i].width > 0) {
+            break;
+        }
+
+        memmove(nodes + i, nodes + i + 1, (skyline->nodes_count - i - 1) * sizeof(Skyline_Node));
+        skyline->nodes_count--;
+    }
+
+    // Merging neighbours of the same height.
+    for (s32 i = 0; i + 1 < skyline->nodes_count; ) {
+        if (nodes[i].y != nodes[i + 1].y) {
+            i++;
+            continue;
+        }
+
+        nodes[i].width += nodes[i + 1].width;
+        memmove(nodes + i + 1, nodes + i + 2, (skyline->nodes_count - i - 2) * sizeof(Skyline_Node));
+        skyline->nodes_count--;
+    }
+
+    return true;
+}
+
+
+
+
+
+/**
+ * Texture atlas.
+ */
+
+#define ATLAS_MAX_PATH_LENGTH 256
+#define ATLAS_PAGE_PENDING    -2    // Image is being loaded asynchronously, handle shows placeholder.
+
+typedef struct atlas_page {
+    u32 id;
+    Skyline skyline;
+} Atlas_Page;
+
+typedef struct atlas_entry {
+    char path[ATLAS_MAX_PATH_LENGTH];
+    String name;            // Points into "path".
+    Texture texture;        // Handle that is returned to the user.
+    s32 page;               // -1 if image has its own texture, ATLAS_PAGE_PENDING if it isn't loaded yet.
+
+    // Copy of the newest pixels while atlas is repacked, NULL if image isn't decoded yet.
+    u8 *repack_pixels;
+    s32 repack_width;
+    s32 repack_height;
+    bool repack_waiting;    // Decode of the image for repack is queued.
+} Atlas_Entry;
+
+static Atlas_Page atlas_pages[ATLAS_MAX_PAGES];
+static s32 atlas_pages_count = 0;
+
+static Atlas_Entry atlas_entries[ATLAS_MAX_TEXTURES];
+static s32 atlas_entries_count = 0;
+
+static bool atlas_repacking = false;
+static s32 atlas_repack_waiting = 0;    // Images repack waits to be decoded.
+
+
+void atlas_init() {
+    atlas_pages_count = 0;
+    atlas_entries_count = 0;
+}
+
+void atlas_free() {
+    for (s32 i = 0; i < atlas_pages_count; i++) {
+        glDeleteTextures(1, &atlas_pages[i].id);
+        texture_changed(atlas_pages[i].id);
+    }
+
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        if (atlas_entries[i].page == -1) {
+            texture_unload(&atlas_entries[i].texture);
+        }
+        free(atlas_entries[i].repack_pixels);
+    }
+
+    atlas_pages_count = 0;
+    atlas_entries_count = 0;
+    atlas_repacking = false;
+    atlas_repack_waiting = 0;
+}
+
+static void atlas_texture_parameters() {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+static Atlas_Page *atlas_page_make() {
+    Atlas_Page *page = &atlas_pages[atlas_pages_count++];
+
+    glGenTextures(1, &page->id);
+    glBindTexture(GL_TEXTURE_2D, page->id);
+    atlas_texture_parameters();
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    skyline_init(&page->skyline, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+
+    LOG_INFO("Atlas page %d created, %dx%d.", atlas_pages_count - 1, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+    return page;
+}
+
+/**
+ * Uploads RGBA image with its border pixels repeated into the padding around it, "x" and "y" is the corner of the padding.
+ */
+static void atlas_upload(u32 page_id, s32 x, s32 y, u8 *data, s32 width, s32 height) {
+    s32 padded_width = width + ATLAS_PADDING * 2;
+    s32 padded_height = height + ATLAS_PADDING * 2;
+    u8 *padded = malloc(padded_width * padded_height * 4);
+
+    for (s32 row = 0; row < padded_height; row++) {
+        s32 source_row = clampi(row - ATLAS_PADDING, 0, height - 1);
+        for (s32 column = 0; column < padded_width; column++) {
+            s32 source_column = clampi(column - ATLAS_PADDING, 0, width - 1);
+            memcpy(padded + (row * padded_width + column) * 4, data + (source_row * width + source_column) * 4, 4);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, page_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height, GL_RGBA, GL_UNSIGNED_BYTE, padded);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture_changed(page_id);
+
+    free(padded);
+}
+
+/**
+ * Places image on the first page it fits on, making new page if needed, or gives it its own texture.
+ */
+static void atlas_place(Atlas_Entry *entry, u8 *data, s32 width, s32 height) {
+    s32 padded_width = width + ATLAS_PADDING * 2;
+    s32 padded_height = height + ATLAS_PADDING * 2;
+
+    s32 x, y;
+    s32 page = -1;
+    for (s32 i = 0; i < atlas_pages_count; i++) {
+        if (skyline_pack(&atlas_pages[i].skyline, padded_width, padded_height, &x, &y)) {
+            page = i;
+            break;
+        }
+    }
+
+    if (page == -1 && atlas_pages_count < ATLAS_MAX_PAGES && padded_width <= ATLAS_PAGE_SIZE && padded_height <= ATLAS_PAGE_SIZE) {
+        Atlas_Page *new_page = atlas_page_make();
+        if (skyline_pack(&new_page->skyline, padded_width, padded_height, &x, &y)) {
+            page = atlas_pages_count - 1;
+        }
+    }
+
+    entry->page = page;
+    entry->texture.width = width;
+    entry->texture.height = height;
+
+    if (page == -1) {
+        LOG_WARNING("Image '%s' doesn't fit into the atlas, it gets its own texture.", entry->path);
+
+        glGenTextures(1, &entry->texture.id);
+        glBindTexture(GL_TEXTURE_2D, entry->texture.id);
+        atlas_texture_parameters();
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        entry->texture.region = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT };
+        return;
+    }
+
+    atlas_upload(atlas_pages[page].id, x, y, data, width, height);
+
+    entry->texture.id = atlas_pages[page].id;
+    entry->texture.region = (UV_Region) {
+        .uv0 = vec2f_make((float)(x + ATLAS_PADDING) / ATLAS_PAGE_SIZE, (float)(y + ATLAS_PADDING) / ATLAS_PAGE_SIZE),
+        .uv1 = vec2f_make((float)(x + ATLAS_PADDING + width) / ATLAS_PAGE_SIZE, (float)(y + ATLAS_PADDING + height) / ATLAS_PAGE_SIZE),
+    };
+}
+
+static Atlas_Entry *atlas_find(String path) {
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        if (str_equals(CSTR(atlas_entries[i].path), path)) {
+            return &atlas_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Keeps copy of the pixels for the repack in progress, replacing older ones.
+ */
+static void atlas_repack_store(Atlas_Entry *entry, u8 *data, s32 width, s32 height) {
+    free(entry->repack_pixels);
+    entry->repack_pixels = malloc((u64)width * height * 4);
+    memcpy(entry->repack_pixels, data, (u64)width * height * 4);
+    entry->repack_width = width;
+    entry->repack_height = height;
+}
+
+/**
+ * Puts pixels of the image into its entry, new images are placed, reloaded ones are uploaded over their old place.
+ */
+static void atlas_entry_set_pixels(Atlas_Entry *entry, u8 *data, s32 width, s32 height) {
+    // Image is shown right away where it is possible, and placed again when repack finishes.
+    if (atlas_repacking) {
+        atlas_repack_store(entry, data, width, height);
+    }
+
+    if (entry->page == ATLAS_PAGE_PENDING) {
+        atlas_place(entry, data, width, height);
+        return;
+    }
+
+    if (width == entry->texture.width && height == entry->texture.height) {
+        if (entry->page == -1) {
+            glBindTexture(GL_TEXTURE_2D, entry->texture.id);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            texture_changed(entry->texture.id);
+        } else {
+            s32 x = (s32)(entry->texture.region.uv0.x * ATLAS_PAGE_SIZE + 0.5f) - ATLAS_PADDING;
+            s32 y = (s32)(entry->texture.region.uv0.y * ATLAS_PAGE_SIZE + 0.5f) - ATLAS_PADDING;
+            atlas_upload(entry->texture.id, x, y, data, width, height);
+        }
+    } else if (!atlas_repacking) {
+        // Size changed, so old place can't be reused, and skyline can't free it.
+        atlas_repack();
+    }
+}
+
+/**
+ * Adds entry for the image, returns NULL if there is no room.
+ */
+static Atlas_Entry *atlas_entry_add(char *texture_path) {
+    if (atlas_entries_count >= ATLAS_MAX_TEXTURES || strlen(texture_path) >= ATLAS_MAX_PATH_LENGTH) {
+        LOG_ERROR("Couldn't add image '%s' to the atlas, too many textures or path is too long.", texture_path);
+        return NULL;
+    }
+
+    Atlas_Entry *entry = &atlas_entries[atlas_entries_count++];
+    strcpy(entry->path, texture_path);
+
+    String path = CSTR(entry->path);
+    s64 name_start = str_find_char_right(path, '/') + 1;
+    s64 name_end = str_find_char_right(path, '.');
+    entry->name = str_substring(path, name_start, name_end > name_start ? name_end : path.length);
+
+    entry->page = ATLAS_PAGE_PENDING;
+    entry->texture = *texture_placeholder();
+    return entry;
+}
+
+/**
+ * Returns RGBA pixels of the image, from the biggest level of up to date ".tex" next to it if there is one, otherwise decoded by stbi.
+ * Returns NULL if image couldn't be loaded, pixels are freed by "atlas_image_free()".
+ */
+static u8 *atlas_image_load(char *texture_path, s32 *width, s32 *height, Tex *tex) {
+    *tex = (Tex) {0};
+
+    // Atlas pages are RGBA8 with straight alpha, so compressed or premultiplied ".tex" can't be used.
+    char cooked_path[TEXTURE_LOAD_MAX_PATH];
+    if (tex_cooked_path(texture_path, cooked_path, sizeof(cooked_path)) && tex_load(cooked_path, tex)) {
+        if (tex->header->format == TEX_FORMAT_RGBA8 && (tex->header->flags & TEX_COOK_PREMULTIPLIED) == 0) {
+            *width = tex->header->width;
+            *height = tex->header->height;
+            return tex_level_data(tex, 0);
+        }
+        tex_free(tex);
+    }
+
+    s32 channels;
+    return stbi_load(texture_path, width, height, &channels, 4);
+}
+
+static void atlas_image_free(u8 *pixels, Tex *tex) {
+    if (tex->data != NULL) {
+        tex_free(tex);
+    } else {
+        stbi_image_free(pixels);
+    }
+}
+
+Texture *atlas_texture_load(char *texture_path) {
+    Atlas_Entry *entry = atlas_find(CSTR(texture_path));
+
+    s32 width, height;
+    Tex tex;
+    u8 *data = atlas_image_load(texture_path, &width, &height, &tex);
+    if (data == NULL) {
+        LOG_ERROR("Stbi couldn't load image '%s'.", texture_path);
+        return entry != NULL ? &entry->texture : NULL;
+    }
+
+    if (entry == NULL) {
+        entry = atlas_entry_add(texture_path);
+        if (entry == NULL) {
+            atlas_image_free(data, &tex);
+            return NULL;
+        }
+    }
+
+    atlas_entry_set_pixels(entry, data, width, height);
+
+    atlas_image_free(data, &tex);
+    return &entry->texture;
+}
+
+static void atlas_texture_decoded(Texture *texture, char *path, u8 *pixels, s32 width, s32 height) {
+    (void)texture;
+
+    // Entry is looked up again, since atlas could have been freed while image was decoded.
+    Atlas_Entry *entry = atlas_find(CSTR(path));
+    if (entry != NULL && pixels != NULL) {
+        atlas_entry_set_pixels(entry, pixels, width, height);
+    }
+}
+
+Texture *atlas_texture_load_async(char *texture_path) {
+    Atlas_Entry *entry = atlas_find(CSTR(texture_path));
+    if (entry == NULL) {
+        entry = atlas_entry_add(texture_path);
+        if (entry == NULL) {
+            return NULL;
+        }
+    }
+
+    if (!texture_decode_async(entry->path, &entry->texture, atlas_texture_decoded)) {
+        return atlas_texture_load(texture_path);
+    }
+
+    return &entry->texture;
+}
+
+Texture *atlas_texture_get(String name) {
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        if (str_equals(atlas_entries[i].name, name)) {
+            return &atlas_entries[i].texture;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Places all images from pixels decoded for repack.
+ */
+static void atlas_repack_finish() {
+    // Standalone textures are made again, since images that didn't fit before may fit now.
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        if (atlas_entries[i].page == -1) {
+            texture_unload(&atlas_entries[i].texture);
+        }
+    }
+
+    for (s32 i = 0; i < atlas_pages_count; i++) {
+        skyline_init(&atlas_pages[i].skyline, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+    }
+
+    // Tallest first packs skyline tighter.
+    s32 order[ATLAS_MAX_TEXTURES];
+    s32 heights[ATLAS_MAX_TEXTURES];
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        heights[i] = atlas_entries[i].repack_pixels != NULL ? atlas_entries[i].repack_height : 0;
+
+        // Insertion sort, stable.
+        s32 j = i;
+        while (j > 0 && heights[order[j - 1]] < heights[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        Atlas_Entry *entry = &atlas_entries[order[i]];
+
+        if (entry->repack_pixels == NULL) {
+            // Images added during repack are placed when their own load finishes.
+            if (entry->page == ATLAS_PAGE_PENDING) {
+                continue;
+            }
+
+            // Keeping the handle valid, it just shows nothing until image loads again.
+            LOG_ERROR("Couldn't load image '%s' while repacking atlas.", entry->path);
+            u8 empty[4] = {0};
+            atlas_place(entry, empty, 1, 1);
+            continue;
+        }
+
+        atlas_place(entry, entry->repack_pixels, entry->repack_width, entry->repack_height);
+        free(entry->repack_pixels);
+        entry->repack_pixels = NULL;
+    }
+
+    atlas_repacking = false;
+    LOG_INFO("Atlas repacked, %d textures on %d pages.", atlas_entries_count, atlas_pages_count);
+}
+
+static void atlas_repack_decoded(Texture *texture, char *path, u8 *pixels, s32 width, s32 height) {
+    (void)texture;
+
+    // Decodes queued before atlas was freed are ignored.
+    Atlas_Entry *entry = atlas_find(CSTR(path));
+    if (entry == NULL || !entry->repack_waiting) {
+        return;
+    }
+
+    if (pixels != NULL) {
+        atlas_repack_store(entry, pixels, width, height);
+    }
+
+    entry->repack_waiting = false;
+    atlas_repack_waiting--;
+    if (atlas_repack_waiting == 0) {
+        atlas_repack_finish();
+    }
+}
+
+void atlas_repack() {
+    if (atlas_repacking) {
+        return;
+    }
+    atlas_repacking = true;
+
+    // Old pages stay as they are until all images are decoded, so nothing disappears meanwhile.
+    for (s32 i = 0; i < atlas_entries_count; i++) {
+        Atlas_Entry *entry = &atlas_entries[i];
+
+        if (texture_decode_async(entry->path, &entry->texture, atlas_repack_decoded)) {
+            entry->repack_waiting = true;
+            atlas_repack_waiting++;
+            continue;
+        }
+
+        s32 width, height;
+        Tex tex;
+        u8 *data = atlas_image_load(entry->path, &width, &height, &tex);
+        if (data != NULL) {
+            atlas_repack_store(entry, data, width, height);
+            atlas_image_free(data, &tex);
+        }
+    }
+
+    if (atlas_repack_waiting == 0) {
+        atlas_repack_finish();
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include "game/graphics.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+
+/**
+ * Skyline packer.
+ * Packs rects into fixed size area, keeping only the top edge of already packed rects, each new rect goes where it ends up lowest.
+ * Rects can't be removed one by one, only whole packer can be cleared.
+ */
+
+#define SKYLINE_MAX_NODES 512
+
+typedef struct skyline_node {
+    s32 x;
+    s32 y;
+    s32 width;
+} Skyline_Node;
+
+typedef struct skyline {
+    s32 width;
+    s32 height;
+    s32 nodes_count;
+    Skyline_Node nodes[SKYLINE_MAX_NODES];
+} Skyline;
+
+/**
+ * Resets packer to empty area of specified size.
+ */
+void skyline_init(Skyline *skyline, s32 width, s32 height);
+
+/**
+ * Finds place for the rect and reserves it, writes bottom left corner into "x" and "y".
+ * Returns false if rect doesn't fit.
+ */
+bool skyline_pack(Skyline *skyline, s32 width, s32 height, s32 *x, s32 *y);
+
+
+
+
+/**
+ * Texture atlas.
+ * Images are packed into few big RGBA pages, each loaded image is "Texture" which id is its page and region is its UV rect on the page.
+ * So sprites that are on the same page take one texture slot and can be drawn in one batch.
+ *
+ * Returned textures are stable handles, when image is reloaded or atlas is repacked, handle is updated in place.
+ * @Important: Draw functions take texture UVs as relative to the texture region, but mask UVs are not remapped, so masks shouldn't be atlas textures.
+ */
+
+#define ATLAS_PAGE_SIZE         2048
+#define ATLAS_MAX_PAGES         4
+#define ATLAS_MAX_TEXTURES      256
+#define ATLAS_PADDING           1       // Border pixels are repeated into padding, so linear filtering doesn't bleed neighbours in.
+
+/**
+ * Should be called one time after "graphics_init()".
+ */
+void atlas_init();
+
+/**
+ * Frees pages, standalone textures and handles.
+ */
+void atlas_free();
+
+/**
+ * Loads image into the atlas and returns its handle, if image with the same path is already loaded, reloads it into the same handle.
+ * If reloaded image has different size all pages are repacked.
+ * Images that don't fit on page get their own texture.
+ * Returns NULL if image couldn't be loaded or there are too many textures.
+ */
+Texture *atlas_texture_load(char *texture_path);
+
+/**
+ * Same as "atlas_texture_load()", but image is decoded on the texture load worker and placed by "texture_loads_update()".
+ * New image's handle shows placeholder until then, reloaded one keeps showing old image.
+ * Returns NULL if there are too many textures.
+ */
+Texture *atlas_texture_load_async(char *texture_path);
+
+/**
+ * Returns handle of loaded image by file name without format, or NULL.
+ */
+Texture *atlas_texture_get(String name);
+
+/**
+ * Packs all images again from scratch, tallest first, reading them from disk.
+ * Images are decoded on the texture load worker and packed by "texture_loads_update()" once the last one is decoded, handles keep old images until then.
+ * Does nothing if repack is already in progress, images loaded meanwhile are packed with the newest pixels.
+ */
+void atlas_repack();
+
+#endif
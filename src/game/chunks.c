@@ -0,0 +1,160 @@
+#include "game/chunks.h"
+
+#include "game/graphics.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/structs.h"
+#include "core/profile.h"
+
+#include <math.h>
+#include <string.h>
+
+
+static s32 chunk_coordinate(Static_Chunks *chunks, float value) {
+    // Clamping, so far away values don't overflow.
+    return (s32)fmaxf(fminf(floorf(value / chunks->chunk_size), 1.0e9f), -1.0e9f);
+}
+
+static u32 chunk_bucket(s32 x, s32 y) {
+    return ((u32)x * 73856093u ^ (u32)y * 19349663u) & (STATIC_CHUNKS_BUCKETS - 1);
+}
+
+/**
+ * Returns index of the chunk that holds the point, chunk is made if there is none.
+ */
+static u32 chunk_find_or_make(Static_Chunks *chunks, Vec2f point) {
+    s32 x = chunk_coordinate(chunks, point.x);
+    s32 y = chunk_coordinate(chunks, point.y);
+    u32 bucket = chunk_bucket(x, y);
+
+    for (u32 i = chunks->buckets[bucket]; i != 0; i = chunks->chunks[i - 1].next) {
+        if (chunks->chunks[i - 1].x == x && chunks->chunks[i - 1].y == y) {
+            return i - 1;
+        }
+    }
+
+    Static_Chunk chunk = {
+        .x      = x,
+        .y      = y,
+        .next   = chunks->buckets[bucket],
+        .items  = array_list_make(u32, 16, &std_allocator),
+    };
+    array_list_append(&chunks->chunks, chunk);
+
+    chunks->buckets[bucket] = array_list_length(&chunks->chunks);
+    return chunks->buckets[bucket] - 1;
+}
+
+static void chunk_remove_item(Static_Chunk *chunk, u32 item) {
+    for (u32 i = 0; i < array_list_length(&chunk->items); i++) {
+        if (chunk->items[i] == item) {
+            array_list_unordered_remove(&chunk->items, i);
+            break;
+        }
+    }
+    chunk->dirty = true;
+}
+
+static void chunk_rebuild(Static_Chunks *chunks, Static_Chunk *chunk) {
+    if (chunk->buffer.vao == 0) {
+        static_buffer_init(&chunk->buffer, chunks->drawer->program);
+    }
+
+    draw_begin(chunks->drawer);
+    for (u32 i = 0; i < array_list_length(&chunk->items); i++) {
+        chunks->build(chunk->items[i], chunks->data);
+    }
+    draw_end_static(&chunk->buffer);
+}
+
+
+
+void static_chunks_init(Static_Chunks *chunks, float chunk_size, Quad_Drawer *drawer, Static_Chunk_Build_Procedure build, void *data) {
+    memset(chunks->buckets, 0, sizeof(chunks->buckets));
+    chunks->chunk_size      = chunk_size;
+    chunks->drawer          = drawer;
+    chunks->build           = build;
+    chunks->data            = data;
+    chunks->chunks          = array_list_make(Static_Chunk, 16, &std_allocator);
+    chunks->item_chunks     = array_list_make(u32, 64, &std_allocator);
+    chunks->item_bounds     = array_list_make(AABB, 64, &std_allocator);
+    chunks->chunks_drawn    = 0;
+    chunks->chunks_rebuilt  = 0;
+}
+
+void static_chunks_free(Static_Chunks *chunks) {
+    for (u32 i = 0; i < array_list_length(&chunks->chunks); i++) {
+        if (chunks->chunks[i].buffer.vao != 0) {
+            static_buffer_free(&chunks->chunks[i].buffer);
+        }
+        array_list_free(&chunks->chunks[i].items);
+    }
+
+    array_list_free(&chunks->chunks);
+    array_list_free(&chunks->item_chunks);
+    array_list_free(&chunks->item_bounds);
+}
+
+void static_chunks_set(Static_Chunks *chunks, u32 item, AABB bounds) {
+    while (array_list_length(&chunks->item_chunks) <= item) {
+        array_list_append(&chunks->item_chunks, 0);
+        array_list_append(&chunks->item_bounds, bounds);
+    }
+    chunks->item_bounds[item] = bounds;
+
+    u32 chunk = chunk_find_or_make(chunks, aabb_center(bounds));
+    u32 previous = chunks->item_chunks[item];
+
+    if (previous != chunk + 1) {
+        if (previous != 0) {
+            chunk_remove_item(&chunks->chunks[previous - 1], item);
+        }
+        array_list_append(&chunks->chunks[chunk].items, item);
+        chunks->item_chunks[item] = chunk + 1;
+    }
+
+    chunks->chunks[chunk].dirty = true;
+}
+
+void static_chunks_changed(Static_Chunks *chunks, u32 item) {
+    if (item < array_list_length(&chunks->item_chunks) && chunks->item_chunks[item] != 0) {
+        chunks->chunks[chunks->item_chunks[item] - 1].dirty = true;
+    }
+}
+
+@Profile;
+void static_chunks_draw(Static_Chunks *chunks, AABB view) {
+    chunks->chunks_drawn = 0;
+    chunks->chunks_rebuilt = 0;
+
+    for (u32 i = 0; i < array_list_length(&chunks->chunks); i++) {
+        Static_Chunk *chunk = &chunks->chunks[i];
+        u32 items_count = array_list_length(&chunk->items);
+
+        // Bounds are needed for culling before chunk is rebuilt, and they are cheap next to the rebuild.
+        if (chunk->dirty && items_count > 0) {
+            chunk->bounds = chunks->item_bounds[chunk->items[0]];
+            for (u32 j = 1; j < items_count; j++) {
+                AABB *bounds = &chunks->item_bounds[chunk->items[j]];
+                chunk->bounds.p0 = vec2f_make(fminf(chunk->bounds.p0.x, bounds->p0.x), fminf(chunk->bounds.p0.y, bounds->p0.y));
+                chunk->bounds.p1 = vec2f_make(fmaxf(chunk->bounds.p1.x, bounds->p1.x), fmaxf(chunk->bounds.p1.y, bounds->p1.y));
+            }
+        }
+
+        // Empty chunk keeps its old verticies until it is rebuilt, but it is never drawn.
+        if (items_count == 0 || !aabb_touches_aabb(&chunk->bounds, &view)) {
+            continue;
+        }
+
+        if (chunk->dirty) {
+            chunk_rebuild(chunks, chunk);
+            chunk->dirty = false;
+            chunks->chunks_rebuilt++;
+        }
+
+        render_submit_static(&chunk->buffer);
+        chunks->chunks_drawn++;
+    }
+}
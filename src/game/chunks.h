@@ -0,0 +1,75 @@
+#ifndef CHUNKS_H
+#define CHUNKS_H
+
+#include "game/graphics.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+
+/**
+ * Static chunks.
+ * Geometry that barely changes, like level quads, is split into square chunks of the world, and each chunk keeps its quads in a static buffer of its own.
+ * Item belongs to the chunk its bounds center is in, bounds of the chunk grow to hold its items, so they can stick out of the chunk square.
+ *
+ * Setting or changing item only marks its chunk, and the one it left, as dirty. Dirty chunks are rebuilt by "static_chunks_draw()" when they are visible,
+ * by calling build procedure for each of their items between "draw_begin()" and "draw_end_static()".
+ * So editing one item rebuilds one chunk, and chunks that didn't change upload nothing.
+ *
+ * Items are numbered by the user, so they can be indicies of the array they come from.
+ */
+
+#define STATIC_CHUNKS_BUCKETS   256     // Power of two.
+
+/**
+ * Should draw item with quad drawing calls into the default vertex buffer.
+ */
+typedef void (*Static_Chunk_Build_Procedure)(u32 item, void *data);
+
+typedef struct static_chunk {
+    s32     x;
+    s32     y;
+    u32     next;                   // Next chunk index + 1 in the same bucket, 0 is end.
+    u32     *items;                 // Array list.
+    AABB    bounds;                 // Of all items, recalculated when chunk is dirty.
+    bool    dirty;
+    Static_Buffer buffer;           // Made by the first rebuild.
+} Static_Chunk;
+
+typedef struct static_chunks {
+    float       chunk_size;
+    Quad_Drawer *drawer;
+    Static_Chunk_Build_Procedure build;
+    void        *data;              // Passed to build procedure.
+
+    u32         buckets[STATIC_CHUNKS_BUCKETS];     // First chunk index + 1, 0 is empty.
+    Static_Chunk *chunks;           // Array list, chunks are never removed, empty ones are skipped.
+    u32         *item_chunks;       // Array list, indexed by item, chunk index + 1, 0 if item wasn't set.
+    AABB        *item_bounds;       // Array list, indexed by item.
+
+    // Of the last draw.
+    u32         chunks_drawn;
+    u32         chunks_rebuilt;
+} Static_Chunks;
+
+void static_chunks_init(Static_Chunks *chunks, float chunk_size, Quad_Drawer *drawer, Static_Chunk_Build_Procedure build, void *data);
+
+void static_chunks_free(Static_Chunks *chunks);
+
+/**
+ * Adds item or moves it to new bounds, marks its chunk as dirty.
+ */
+void static_chunks_set(Static_Chunks *chunks, u32 item, AABB bounds);
+
+/**
+ * Marks chunk of the item as dirty, for changes that don't move it, like color.
+ */
+void static_chunks_changed(Static_Chunks *chunks, u32 item);
+
+/**
+ * Rebuilds dirty chunks that touch the view and submits them with projection drawer's shader has now.
+ * @Important: Rebuilding uses default vertex buffer and "draw_begin()", so it shouldn't be called between "draw_begin()" and "draw_end()".
+ */
+void static_chunks_draw(Static_Chunks *chunks, AABB view);
+
+#endif
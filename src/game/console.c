@@ -7,6 +7,7 @@
 #include "game/graphics.h"
 #include "game/command.h"
 #include "game/vars.h"
+#include "game/scrollback.h"
 
 #include "core/structs.h"
 #include "core/arena.h"
@@ -40,10 +41,9 @@ static Console console;
 
 
 
-static const s64 HISTORY_BUFFER_SIZE = 8192;
-static const s64 HISTORY_MAX_MESSAGES = 256;
+static const s64 USER_INPUT_HISTORY_BUFFER_SIZE = 8192;
+static const u64 HISTORY_SCROLLBACK_SIZE = 4 * 1024 * 1024; // Oldest history text is dropped after this many bytes.
 
-#define HISTORY_MAX_BUFFERS   2
 #define INPUT_BUFFER_SIZE     100
 
 typedef enum history_message_type : u8 {
@@ -58,18 +58,12 @@ static const Vec4f HISTORY_MESSAGE_COLORS[] = {
     ((Vec4f) { 0.8f, 0.4f, 0.4f, 1.0f }),
 };
 
-typedef struct history_message {
-    History_Message_Type type;
-    String str;
-} History_Message;
-
-static History_Message *history;
-static s64 history_index;
+static Scrollback history;
 static float history_font_top_pad;
 static float history_block_width;
 
-static s64 display_line_offset; // It is amount of line that should be skipped before rendering first (most bottom line) in the console.
-                                // So in case of scrolling console up this value would correspond to the amount of lines scrolled up.
+static s64 display_line_offset; // It is amount of rows that should be skipped before rendering first (most bottom row) in the console.
+                                // So in case of scrolling console up this value would correspond to the amount of rows scrolled up.
 
 
 
@@ -108,11 +102,6 @@ static float c_x1;
 
 
 
-static char *history_active_buffer;
-static s64 history_active_buffer_index;
-static s64 history_buffer_write_index;
-static char *history_buffers[HISTORY_MAX_BUFFERS];
-
 static char *user_input_history_buffer;
 
 
@@ -206,49 +195,14 @@ void history_return_peeked_message() {
  * Console printing.
  */
 void console_add(char *buffer, s64 length, History_Message_Type type) {
-    // Copy actual string data.
-    if (history_buffer_write_index + length > HISTORY_BUFFER_SIZE) {
-        if (length > HISTORY_BUFFER_SIZE) {
-            printf_err("Message written to the console buffer is too long, not enough memory space to store it.\n");
-            return;
-        }
-
-        // Swapping buffers.
-        // @Important: Right now it doesn't clear swapped buffer and doesn't track any pointers that migth have been left in the buffer, but it is assumed that buffers are simply big, so that by the time it tracks back to the used buffer all string pointers that pointed to the that memory would be gone.
-        history_active_buffer_index = (history_active_buffer_index + 1) % HISTORY_MAX_BUFFERS;
-        history_buffer_write_index = 0;
-    }
-
-    char *ptr = history_buffers[history_active_buffer_index] + history_buffer_write_index;
-    history_buffer_write_index += length;
-    memcpy(ptr, buffer, length);
-
     // Saving user input into user input history.
     if (type == MESSAGE_USER) {
         array_list_append(&user_input_history, ((User_Input_Handle){ .length = length, .index = array_list_length(&user_input_history_buffer) }));
         array_list_append_multiple(&user_input_history_buffer, buffer, length);
     }
 
-
-    // Following code will determine to either create a new String if previous was ended with '\n' or append to previous string if not. It is done to properly display messages if previous one wasn't ended with '\n'.
-    bool concat_with_last_message = false;
-    History_Message *last_message = NULL;
-    u32 history_length = looped_array_length(&history);
-    if (history_length > 0) {
-        last_message = history + _looped_array_map_index((void *)history, history_length - 1);
-        concat_with_last_message = last_message->str.data[last_message->str.length - 1] != '\n';
-    }
-
-
-    if (concat_with_last_message) {
-        last_message->str.length += length;
-    } else {
-        History_Message msg = (History_Message){
-                    .type = type,
-                    .str = STR(length, ptr),
-                    };
-        looped_array_append(&history, msg);
-    }
+    // Message that doesn't end with '\n' is continued by the next one, scrollback keeps last line open for that.
+    scrollback_append(&history, buffer, length, type);
 }
 
 void cprintf_va(History_Message_Type type, char *format, va_list args) {
@@ -316,28 +270,23 @@ void console_init(State *state) {
     // ------ Internal vars.
 
     // Get resources.
-    drawer = &state->quad_drawer;
+    drawer = &state->sprite_drawer;
 
     // Load needed font... Hard coded...
-    u8* font_data = read_file_into_buffer("res/font/Consolas-Regular.ttf", NULL, &std_allocator);
-
-    font_input = font_bake(font_data, 18.0f);
-    font_output = font_bake(font_data, 16.0f);
-
-    free(font_data);
+    font_input = font_load("res/font/Consolas-Regular.ttf", 18.0f);
+    font_output = font_load("res/font/Consolas-Regular.ttf", 16.0f);
 
     // @Important: For metrics we assume that fonts are monospaced!
     // Set input metrics.
     input_font_top_pad = font_input.line_height * 0.4f;
     input_height = font_input.line_height + input_font_top_pad;
-    input_block_width = font_input.chars[(s32)' ' - font_input.first_char_code].xadvance;
+    input_block_width = font_glyph(&font_input, ' ').xadvance;
 
     // Set history height.
     history_font_top_pad = font_output.line_height * 0.2f;
-    history_block_width = font_output.chars[(s32)' ' - font_input.first_char_code].xadvance;
+    history_block_width = font_glyph(&font_output, ' ').xadvance;
 
     // Important not styling, logic vars.
-    history = looped_array_make(History_Message, HISTORY_MAX_MESSAGES, &std_allocator);
     display_line_offset = 0;
 
 
@@ -361,15 +310,10 @@ void console_init(State *state) {
     console_state = CLOSED;
 
 
-    // Initing all history buffers. The idea is to swap buffer once it has been filled for the next one.
-    history_active_buffer_index = 0;
-    history_active_buffer = allocator_alloc(&std_allocator, HISTORY_BUFFER_SIZE * HISTORY_MAX_BUFFERS);
-    for (s64 i = 0; i < HISTORY_MAX_BUFFERS; i++) {
-        history_buffers[i] = history_active_buffer + i * HISTORY_BUFFER_SIZE;
-    }
-    history_buffer_write_index = 0;
+    // History text is stored in chunks that are allocated when needed, oldest text is dropped once max size is reached.
+    scrollback_init(&history, HISTORY_SCROLLBACK_SIZE);
 
-    user_input_history_buffer = array_list_make(char, HISTORY_BUFFER_SIZE, &std_allocator);
+    user_input_history_buffer = array_list_make(char, USER_INPUT_HISTORY_BUFFER_SIZE, &std_allocator);
 }
 
 void console_update(Window_Info *window, Events_Info *events, Time_Info *t) {
@@ -540,8 +484,10 @@ void console_update(Window_Info *window, Events_Info *events, Time_Info *t) {
 
 }
 
+@Profile;
 void console_draw(Window_Info *window) {
     projection = screen_calculate_projection(window->width, window->height);
+    render_layer_set(RENDER_LAYER_CONSOLE);
     shader_update_projection(drawer->program, &projection);
     
 
@@ -553,38 +499,23 @@ void console_draw(Window_Info *window) {
     // Input.
     draw_rect(vec2f_make(c_x0, c_y0), vec2f_make(c_x1, c_y0 + input_height), .color = vec4f_make(0.18f, 0.18f, 0.35f, 0.98f));
     
-    // Draw text of the history.
-    Vec2f history_draw_origin = vec2f_make(c_x0 + console.text_pad, c_y0 + input_height);
-    s64 lines_drawen = 0;
-    History_Message *msg;
-    s64 msg_line_count;
-
-    u32 history_length = looped_array_length(&history);
-    for (s64 i = 1; i <= history_length; i++) {
-        msg = history + _looped_array_map_index((void *)history, history_length - i); // Calling to internal function cause it is just faster to get pointer this way.
-        msg_line_count = str_count_chars(msg->str, '\n'); // Later when wrapping of text will be made in the console, the counting of lines will change.
-
-        lines_drawen += msg_line_count;
-        if (lines_drawen <= display_line_offset) {
-            continue;
-        }
+    // Draw text of the history, going up from the bottom row and touching only rows that can be seen.
+    scrollback_set_wrap(&history, (s32)((c_x1 - c_x0 - 2.0f * (float)console.text_pad) / history_block_width));
 
-        // Cutting off lines that are in the same message but are supposed to be offseted.
-        String msg_str = msg->str;
-        s64 msg_cut_lines = msg_line_count - mini(msg_line_count, lines_drawen - display_line_offset);
-        for (s64 j = -1; j < msg_cut_lines; j++) { // @Important: -1 is here because this for loop is given extra turn to remove the very last '\n' at the end of every message.
-            msg_str = str_substring(msg_str, 0, str_find_char_right(msg_str, '\n'));
-        }
+    s64 rows_count = (s64)scrollback_rows_count(&history);
+    display_line_offset = mini(display_line_offset, rows_count);
 
+    s64 visible_rows = (s64)((console_max_height(window) - input_height) / (float)font_output.line_height) + 1;
+    Vec2f history_draw_origin = vec2f_make(c_x0 + console.text_pad, c_y0 + input_height);
 
-        history_draw_origin.y += (msg_line_count - msg_cut_lines) * font_output.line_height; 
-        // history_draw_origin.y += history_font_top_pad;
+    for (s64 i = 0; i < visible_rows && display_line_offset + i < rows_count; i++) {
+        u8 type;
+        String row = scrollback_row_from_bottom(&history, (u64)(display_line_offset + i), &type);
 
-        draw_text(msg_str, history_draw_origin, &font_output, .color = HISTORY_MESSAGE_COLORS[msg->type]);
+        history_draw_origin.y += (float)font_output.line_height;
+        draw_text(row, history_draw_origin, &font_output, .color = HISTORY_MESSAGE_COLORS[type]);
     }
     
-    display_line_offset = mini(display_line_offset, lines_drawen);
-    
     // Draw input cursor.
     if (input_cursor_visible) {
         Vec4f color = vec4f_lerp(vec4f_make(0.58f, 0.58f, 0.85f, 0.90f), VEC4F_YELLOW, input_cursor_activity);
@@ -613,7 +544,7 @@ void console_draw(Window_Info *window) {
 
 
 void console_free() {
-    allocator_free(&std_allocator, history_buffers[0]);
+    scrollback_free(&history);
 }
 
 
@@ -632,7 +563,7 @@ s64 add(s32 a, s32 b) {
 }
 
 void clear() {
-    looped_array_clear(&history);
+    scrollback_clear(&history);
 }
 
 
@@ -4,45 +4,99 @@
 #include "core/core.h"
 #include "core/type.h"
 #include "core/mathf.h"
+#include "core/log.h"
+#include "core/structs.h"
+#include "core/str.h"
+
+#include <stdint.h>
+#include <string.h>
 
 
 static const float DOT_SCALE = 6.0f;
 static const float CROSS_SCALE = 8.0f;
 
 
-void draw_quad_opt(Vec2f p0, Vec2f p2, Vec2f p3, Vec2f p1, Draw_Quad_Opt_Args opt) {
-    float texture_slot = -1.0f; // @Important: -1.0f slot signifies shader to use color, not texture.
-    float mask_slot = -1.0f;
+/**
+ * Writes packed quad in the same corner order as the old float layout: p0, p2, p3, p1.
+ */
+static void draw_quad_packed(Vec2f p0, Vec2f p2, Vec2f p3, Vec2f p1, Vec4f color, Texture *texture, Vec2f uv0, Vec2f uv1, Texture *mask, Vertex_Buffer *buffer) {
+    u8 texture_slot = VERTEX_SLOT_NONE; // @Important: VERTEX_SLOT_NONE slot signifies shader to use color, not texture.
+    u8 mask_slot = vertex_pack_mask_slot(mask);
 
-    if (opt.texture != NULL)
-        texture_slot = add_texture_to_slots(opt.texture);              
+    if (texture != NULL) {
+        texture_slot = vertex_pack_slot(add_texture_to_slots(texture));              
+        uv0 = texture_uv(texture, uv0);
+        uv1 = texture_uv(texture, uv1);
+    }
 
-    if (opt.mask != NULL)
-        mask_slot = add_texture_to_slots(opt.mask);              
+    u32 packed_color = vertex_pack_color(color);
+    u16 u0 = vertex_pack_unorm16(uv0.x);
+    u16 v0 = vertex_pack_unorm16(uv0.y);
+    u16 u1 = vertex_pack_unorm16(uv1.x);
+    u16 v1 = vertex_pack_unorm16(uv1.y);
     
-    float quad_data[44] = {
-        p0.x, p0.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv0.x, opt.uv0.y, texture_slot, mask_slot,
-        p2.x, p2.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv1.x, opt.uv0.y, texture_slot, mask_slot,
-        p3.x, p3.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv0.x, opt.uv1.y, texture_slot, mask_slot,
-        p1.x, p1.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv1.x, opt.uv1.y, texture_slot, mask_slot,
+    Quad_Vertex quad_data[VERTICIES_PER_QUAD] = {
+        { p0, packed_color, { u0, v0 }, texture_slot, mask_slot, 0 },
+        { p2, packed_color, { u1, v0 }, texture_slot, mask_slot, 0 },
+        { p3, packed_color, { u0, v1 }, texture_slot, mask_slot, 0 },
+        { p1, packed_color, { u1, v1 }, texture_slot, mask_slot, 0 },
     };
     
-    if (opt.buffer == NULL)
-        draw_quad_data(quad_data, 1);
+    if (buffer == NULL)
+        draw_quad_data((float *)quad_data, 1);
     else
-        vertex_buffer_append_data(opt.buffer, quad_data, VERTICIES_PER_QUAD * 11);
+        vertex_buffer_append_data(buffer, (float *)quad_data, VERTICIES_PER_QUAD * QUAD_VERTEX_STRIDE);
 }
 
-void draw_rect_opt(Vec2f p0, Vec2f p1, Draw_Rect_Opt_Args opt) {
-    float texture_slot = -1.0f; // @Important: -1.0f slot signifies shader to use color, not texture.
-    float mask_slot = -1.0f;
+void draw_quad_opt(Vec2f p0, Vec2f p2, Vec2f p3, Vec2f p1, Draw_Quad_Opt_Args opt) {
+    if (opt.buffer == NULL && draw_is_instanced()) {
+        LOG_ERROR("Arbitrary quad can't be drawn with instanced shader, use drawer with per vertex shader.");
+        return;
+    }
 
-    if (opt.texture != NULL)
-        texture_slot = add_texture_to_slots(opt.texture);              
+    draw_quad_packed(p0, p2, p3, p1, opt.color, opt.texture, opt.uv0, opt.uv1, opt.mask, opt.buffer);
+}
+
+/**
+ * Writes one instance for the whole rect, corners are expanded by the shader.
+ */
+static void draw_rect_instanced(Vec2f p0, Vec2f p1, Draw_Rect_Opt_Args opt) {
+    u8 texture_slot = VERTEX_SLOT_NONE; // @Important: VERTEX_SLOT_NONE slot signifies shader to use color, not texture.
+    u8 mask_slot = vertex_pack_mask_slot(opt.mask);
+
+    if (opt.texture != NULL) {
+        texture_slot = vertex_pack_slot(add_texture_to_slots(opt.texture));              
+        opt.uv0 = texture_uv(opt.texture, opt.uv0);
+        opt.uv1 = texture_uv(opt.texture, opt.uv1);
+    }
+
+    // Diagonal split on sides along and across offset angle direction, so p0 and p1 stay opposite corners.
+    Vec2f diagonal = vec2f_difference(p1, p0);
+    Vec2f half_size = vec2f_multi_constant(diagonal, 0.5f);
+    if (opt.offset_angle != 0.0f) {
+        Vec2f k = vec2f_make(cosf(opt.offset_angle), sinf(opt.offset_angle));
+        half_size = vec2f_make(vec2f_dot(k, diagonal) * 0.5f, (k.x * diagonal.y - k.y * diagonal.x) * 0.5f);
+    }
+
+    Sprite_Instance instance = {
+        .center     = vec2f_sum(p0, vec2f_multi_constant(diagonal, 0.5f)),
+        .half_size  = half_size,
+        .rotation   = opt.offset_angle,
+        .color      = vertex_pack_color(opt.color),
+        .uv         = { vertex_pack_unorm16(opt.uv0.x), vertex_pack_unorm16(opt.uv0.y), vertex_pack_unorm16(opt.uv1.x), vertex_pack_unorm16(opt.uv1.y) },
+        .texture    = texture_slot,
+        .mask       = mask_slot,
+    };
+
+    draw_quad_data((float *)&instance, 1);
+}
+
+void draw_rect_opt(Vec2f p0, Vec2f p1, Draw_Rect_Opt_Args opt) {
+    if (opt.buffer == NULL && draw_is_instanced()) {
+        draw_rect_instanced(p0, p1, opt);
+        return;
+    }
 
-    if (opt.mask != NULL)
-        mask_slot = add_texture_to_slots(opt.mask);              
-    
     // What the in the world is offset angle? Probably has to do with rotation...
     // Past me always had stupid shit to come up with.
     // @Todo: Replace this with transformation matrix...
@@ -52,110 +106,318 @@ void draw_rect_opt(Vec2f p0, Vec2f p1, Draw_Rect_Opt_Args opt) {
     Vec2f p2 = vec2f_sum(p0, k);
     Vec2f p3 = vec2f_difference(p1, k);
     
-    float quad_data[44] = {
-        p0.x, p0.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv0.x, opt.uv0.y, texture_slot, mask_slot,
-        p2.x, p2.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv1.x, opt.uv0.y, texture_slot, mask_slot,
-        p3.x, p3.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv0.x, opt.uv1.y, texture_slot, mask_slot,
-        p1.x, p1.y, 0.0f, opt.color.x, opt.color.y, opt.color.z, opt.color.w, opt.uv1.x, opt.uv1.y, texture_slot, mask_slot,
-    };
-    
-    if (opt.buffer == NULL)
-        draw_quad_data(quad_data, 1);
-    else
-        vertex_buffer_append_data(opt.buffer, quad_data, VERTICIES_PER_QUAD * 11);
+    draw_quad_packed(p0, p2, p3, p1, opt.color, opt.texture, opt.uv0, opt.uv1, opt.mask, opt.buffer);
 }
 
-void draw_text_opt(String text, Vec2f current_point, Font_Baked *font, Draw_Text_Opt_Args opt) {
-    // Scale and adjust current_point.
-    current_point = vec2f_multi_constant(current_point, (float)opt.unit_scale);
-    float origin_x = current_point.x;
-    current_point.y += (float)font->baseline;
+#define PARTICLES_DRAW_BATCH 1024
 
-    // Text rendering variables.
-    s32 font_char_index;
-    u16 width, height;
-    stbtt_bakedchar *c;
+void draw_particles(Particles *particles, Texture *texture) {
+    // Instanced "ui_quad.glsl" takes instances of other layout, so stride is checked too.
+    if (!draw_is_instanced() || draw_vertex_stride() != SPRITE_INSTANCE_STRIDE) {
+        LOG_ERROR("Particles can only be drawn with instanced sprite shader.");
+        return;
+    }
 
+    // Same for every particle, so it is packed once.
+    Sprite_Instance base = {
+        .uv         = { 0, 0, UINT16_MAX, UINT16_MAX },
+        .texture    = VERTEX_SLOT_NONE,
+        .mask       = VERTEX_SLOT_NONE,
+    };
+    if (texture != NULL) {
+        Vec2f uv0 = texture_uv(texture, VEC2F_ORIGIN);
+        Vec2f uv1 = texture_uv(texture, VEC2F_UNIT);
+        base.texture = vertex_pack_slot(add_texture_to_slots(texture));
+        base.uv[0] = vertex_pack_unorm16(uv0.x);
+        base.uv[1] = vertex_pack_unorm16(uv0.y);
+        base.uv[2] = vertex_pack_unorm16(uv1.x);
+        base.uv[3] = vertex_pack_unorm16(uv1.y);
+    }
+
+    Sprite_Instance batch[PARTICLES_DRAW_BATCH];
+    for (u32 start = 0; start < particles->count; start += PARTICLES_DRAW_BATCH) {
+        u32 count = mini(particles->count - start, PARTICLES_DRAW_BATCH);
+
+        for (u32 j = 0; j < count; j++) {
+            u32 i = start + j;
+            float half_size = particles->size[i] * 0.5f;
+
+            batch[j] = base;
+            batch[j].center     = vec2f_make(particles->position_x[i], particles->position_y[i]);
+            batch[j].half_size  = vec2f_make(half_size, half_size);
+            batch[j].color      = vertex_pack_color(vec4f_make(particles->color_r[i], particles->color_g[i], particles->color_b[i], particles->color_a[i]));
+        }
+
+        draw_quad_data((float *)batch, count);
+    }
+}
+
+/**
+ * Text layout cache.
+ */
+
+#define TEXT_LAYOUT_BUCKETS 1024
+
+typedef struct text_layout_entry {
+    bool        used;
+    u64         hash;
+    Font_Baked *font;
+    float       font_size;
+    float       wrap_width;
+    char *      text;                   // Array list, copy of the text, so hash collisions are not confused.
+    Text_Layout_Glyph *glyphs;          // Array list.
+    Text_Layout layout;
+    u32         generation;             // Glyph cache generation layout was made at.
+    bool        complete;               // False if some glyphs couldn't be cached, then layout is done again next time.
+    u64         last_used;
+    s32         next;                   // Next entry index + 1 in the same bucket, 0 is end.
+} Text_Layout_Entry;
+
+static Text_Layout_Entry text_layout_entries[TEXT_LAYOUT_CACHE_SIZE];
+static s32 text_layout_buckets[TEXT_LAYOUT_BUCKETS]; // Entry index + 1, 0 is empty.
+static u64 text_layout_frame = 1;
+
+static u64 text_layout_hash(String text, Font_Baked *font, float wrap_width) {
+    // FNV-1a over the text, then mixing in the rest of the key.
+    u64 hash = 0xCBF29CE484222325ull;
     for (s64 i = 0; i < text.length; i++) {
-        // @Incomplete: Handle special characters / symbols.
-        if (text.data[i] == '\n') {
-            current_point.x = origin_x;
-            current_point.y -= (float)font->line_height;
+        hash = (hash ^ (u8)text.data[i]) * 0x100000001B3ull;
+    }
+    hash ^= (u64)(uintptr_t)font * 0x9E3779B97F4A7C15ull;
+    hash ^= (u64)(font->size * 64.0f) << 40;
+    hash ^= (u64)(wrap_width * 64.0f) << 20;
+    return hash;
+}
+
+static void text_layout_unlink(s32 index) {
+    Text_Layout_Entry *entry = &text_layout_entries[index];
+    s32 *link = &text_layout_buckets[entry->hash & (TEXT_LAYOUT_BUCKETS - 1)];
+    while (*link != 0) {
+        if (*link == index + 1) {
+            *link = entry->next;
+            break;
+        }
+        link = &text_layout_entries[*link - 1].next;
+    }
+    entry->used = false;
+    entry->next = 0;
+}
+
+/**
+ * Lays out text into the entry, moving pen along baseline, and moving words that cross wrap width to the next line.
+ */
+static void text_layout_build(Text_Layout_Entry *entry, String text, Font_Baked *font, float wrap_width) {
+    array_list_clear(&entry->glyphs);
+
+    entry->generation   = font_cache_generation(font);
+    entry->complete     = true;
+    entry->layout       = (Text_Layout) {0};
+
+    if (text.length == 0) {
+        return;
+    }
+
+    Vec2f pen = vec2f_make(0.0f, (float)font->baseline);
+    float width = 0.0f;
+    u32 lines = 1;
+
+    // Last place on current line where it can be broken, it is right after a space.
+    s32 break_glyph = -1;
+    float break_x = 0.0f;
+    float break_line_width = 0.0f;
+
+    s64 i = 0;
+    while (i < text.length) {
+        u32 codepoint = str_decode_utf8(text, &i);
+
+        if (codepoint == '\n') {
+            width = fmaxf(width, pen.x);
+            pen.x = 0.0f;
+            pen.y -= (float)font->line_height;
+            lines++;
+            break_glyph = -1;
             continue;
         }
 
-        // Character drawing.
-        font_char_index = (s32)text.data[i] - font->first_char_code;
-        if (font_char_index < font->chars_count) {
-            c = &font->chars[font_char_index];
-            width  = font->chars[font_char_index].x1 - font->chars[font_char_index].x0;
-            height = font->chars[font_char_index].y1 - font->chars[font_char_index].y0;
-
-            // Behold! The most unreadable piece of inlined shit...
-            // But it gets the job done...
-            draw_rect(
-                    vec2f_divide_constant(vec2f_make(current_point.x + c->xoff, current_point.y - c->yoff - height), (float)opt.unit_scale), 
-                    vec2f_divide_constant(vec2f_make(current_point.x + c->xoff + width, current_point.y - c->yoff), (float)opt.unit_scale), 
-                    .color = opt.color, 
-                    .uv0 = vec2f_make(c->x0 / (float)font->bitmap.width, c->y1 / (float)font->bitmap.height), 
-                    .uv1 = vec2f_make(c->x1 / (float)font->bitmap.width, c->y0 / (float)font->bitmap.height), 
-                    .mask = &font->bitmap, 
-                    .buffer = opt.buffer);
-
-            current_point.x += font->chars[font_char_index].xadvance;
+        Glyph glyph = font_glyph(font, codepoint);
+        if (glyph.missing) {
+            entry->complete = false;
+        }
+
+        if (wrap_width > 0.0f && pen.x > 0.0f && pen.x + glyph.xadvance > wrap_width) {
+            if (codepoint == ' ') {
+                // Space at the end of the line is dropped.
+                width = fmaxf(width, pen.x);
+                pen.x = 0.0f;
+                pen.y -= (float)font->line_height;
+                lines++;
+                break_glyph = -1;
+                continue;
+            }
+
+            u32 count = array_list_length(&entry->glyphs);
+            if (break_glyph != -1) {
+                // Moving last word to the next line.
+                width = fmaxf(width, break_line_width);
+                for (u32 g = (u32)break_glyph; g < count; g++) {
+                    entry->glyphs[g].offset.x -= break_x;
+                    entry->glyphs[g].offset.y -= (float)font->line_height;
+                }
+                pen.x -= break_x;
+            }
+            else {
+                width = fmaxf(width, pen.x);
+                pen.x = 0.0f;
+            }
+            pen.y -= (float)font->line_height;
+            lines++;
+            break_glyph = -1;
+        }
+
+        if (codepoint == ' ') {
+            break_line_width = pen.x;
+            break_x = pen.x + glyph.xadvance;
+            break_glyph = (s32)array_list_length(&entry->glyphs);
+        }
+
+        if (glyph.texture != NULL) {
+            Text_Layout_Glyph layout_glyph = {
+                .offset = vec2f_sum(pen, glyph.offset),
+                .size   = glyph.size,
+                .uv     = glyph.uv,
+            };
+            array_list_append(&entry->glyphs, layout_glyph);
+
+            entry->layout.mask = glyph.texture;
+            entry->layout.pages |= 1u << glyph.page;
         }
+
+        pen.x += glyph.xadvance;
     }
-}
 
-Vec2f text_size(String text, Font_Baked *font) {
-    // Result.
-    Vec2f result = VEC2F_ORIGIN;
+    // Text that ends with new line doesn't have one more line after it.
+    if (text.data[text.length - 1] == '\n') {
+        lines--;
+    }
 
-    // Scale and adjust current_point.
-    Vec2f current_point = VEC2F_ORIGIN;
-    float origin_x = current_point.x;
-    current_point.y += (float)font->baseline;
+    width = fmaxf(width, pen.x);
 
-    // Text rendering variables.
-    s32 font_char_index;
+    entry->layout.size = vec2f_make(width, (float)(lines * font->line_height));
+    entry->layout.glyphs_count = array_list_length(&entry->glyphs);
+    entry->layout.glyphs = entry->glyphs;
+}
 
-    for (s64 i = 0; i < text.length; i++) {
-        // Handle special characters / symbols.
-        if (text.data[i] == '\n') {
-            result.y += (float)font->line_height;
-            if (result.x < current_point.x)
-                result.x = current_point.x;
+Text_Layout *text_layout(String text, Font_Baked *font, float wrap_width) {
+    u64 hash = text_layout_hash(text, font, wrap_width);
+    s32 *bucket = &text_layout_buckets[hash & (TEXT_LAYOUT_BUCKETS - 1)];
+
+    // Looking up.
+    Text_Layout_Entry *entry = NULL;
+    for (s32 link = *bucket; link != 0; link = text_layout_entries[link - 1].next) {
+        Text_Layout_Entry *candidate = &text_layout_entries[link - 1];
+        if (candidate->hash == hash 
+                && candidate->font == font 
+                && candidate->font_size == font->size 
+                && candidate->wrap_width == wrap_width 
+                && array_list_length(&candidate->text) == text.length 
+                && memcmp(candidate->text, text.data, text.length) == 0) {
+            entry = candidate;
+            break;
+        }
+    }
 
-            current_point.x = origin_x;
-            current_point.y -= (float)font->line_height;
-            continue;
+    if (entry != NULL) {
+        if (!entry->complete || entry->generation != font_cache_generation(font)) {
+            text_layout_build(entry, text, font, wrap_width);
+        }
+    }
+    else {
+        // Taking free entry, or least recently used one.
+        s32 index = 0;
+        for (s32 i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+            if (!text_layout_entries[i].used) {
+                index = i;
+                break;
+            }
+            if (text_layout_entries[i].last_used < text_layout_entries[index].last_used) {
+                index = i;
+            }
         }
 
-        // Character iterating.
-        font_char_index = (s32)text.data[i] - font->first_char_code;
-        if (font_char_index < font->chars_count) {
+        entry = &text_layout_entries[index];
+        if (entry->used) {
+            text_layout_unlink(index);
+        }
 
-            current_point.x += font->chars[font_char_index].xadvance;
+        if (entry->text == NULL) {
+            entry->text     = array_list_make(char, (u32)text.length + 1, &std_allocator);
+            entry->glyphs   = array_list_make(Text_Layout_Glyph, (u32)text.length + 1, &std_allocator);
         }
+
+        array_list_clear(&entry->text);
+        (void)array_list_append_multiple(&entry->text, text.data, (u32)text.length);
+
+        entry->used         = true;
+        entry->hash         = hash;
+        entry->font         = font;
+        entry->font_size    = font->size;
+        entry->wrap_width   = wrap_width;
+        entry->next         = *bucket;
+        *bucket = index + 1;
+
+        text_layout_build(entry, text, font, wrap_width);
     }
-    
-    // Since last line dimensions is not handled in the loop, it can be done here.
-    if (text.data[text.length - 1] != '\n') 
-        result.y += (float)font->line_height;
 
-    if (result.x < current_point.x)
-        result.x = current_point.x;
+    entry->last_used = text_layout_frame;
+    font_cache_touch(font, entry->layout.pages);
 
-    return result;
+    return &entry->layout;
+}
+
+void text_layout_frame_end() {
+    text_layout_frame++;
+
+    for (s32 i = 0; i < TEXT_LAYOUT_CACHE_SIZE; i++) {
+        Text_Layout_Entry *entry = &text_layout_entries[i];
+        if (entry->used && text_layout_frame - entry->last_used > TEXT_LAYOUT_MAX_AGE) {
+            text_layout_unlink(i);
+            array_list_free(&entry->text);
+            array_list_free(&entry->glyphs);
+        }
+    }
+}
+
+
+
+void draw_text_opt(String text, Vec2f position, Font_Baked *font, Draw_Text_Opt_Args opt) {
+    Text_Layout *layout = text_layout(text, font, opt.wrap_width);
+
+    // Layout is in font pixels, position is in units.
+    float unit = 1.0f / (float)opt.unit_scale;
+
+    for (u32 i = 0; i < layout->glyphs_count; i++) {
+        Text_Layout_Glyph *glyph = &layout->glyphs[i];
+        Vec2f p0 = vec2f_sum(position, vec2f_multi_constant(glyph->offset, unit));
+        Vec2f p1 = vec2f_sum(p0, vec2f_multi_constant(glyph->size, unit));
+
+        draw_rect(p0, p1, 
+                .color = opt.color, 
+                .uv0 = glyph->uv.uv0, 
+                .uv1 = glyph->uv.uv1, 
+                .mask = layout->mask, 
+                .buffer = opt.buffer);
+    }
+}
+
+Vec2f text_size(String text, Font_Baked *font) {
+    return text_layout(text, font, 0.0f)->size;
 }
 
 float text_size_y(String text, Font_Baked *font) {
     // Result.
     float result = 0;
 
-    // Text rendering variables.
-    s32 font_char_index;
-
+    // Newline byte is never part of multibyte UTF-8 sequence, so bytes can be checked directly.
     for (s64 i = 0; i < text.length; i++) {
         // Handle special characters / symbols.
         if (text.data[i] == '\n') {
@@ -378,66 +640,27 @@ void draw_area_function(float x0, float x1, Function y, u32 rect_count, Vec4f co
 }
 
 void draw_area_polar(float t0, float t1, Function r, u32 rect_count, Vec4f color, Vertex_Buffer *buffer) {
-    float quad_data[rect_count * VERTICIES_PER_QUAD * 11];
+    Quad_Vertex quad_data[rect_count * VERTICIES_PER_QUAD];
+    u32 packed_color = vertex_pack_color(color);
 
     float step = (t1 - t0) / (float)rect_count;
-    float radius;
     for (u32 i = 0; i < rect_count; i++) {
-        quad_data[0  + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[1  + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[2  + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[3  + i * VERTICIES_PER_QUAD * 11] = color.x;
-        quad_data[4  + i * VERTICIES_PER_QUAD * 11] = color.y;
-        quad_data[5  + i * VERTICIES_PER_QUAD * 11] = color.z;
-        quad_data[6  + i * VERTICIES_PER_QUAD * 11] = color.w;
-        quad_data[7  + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[8  + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[9  + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-        quad_data[10 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-                     
-        quad_data[11 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[12 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[13 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[14 + i * VERTICIES_PER_QUAD * 11] = color.x;
-        quad_data[15 + i * VERTICIES_PER_QUAD * 11] = color.y;
-        quad_data[16 + i * VERTICIES_PER_QUAD * 11] = color.z;
-        quad_data[17 + i * VERTICIES_PER_QUAD * 11] = color.w;
-        quad_data[18 + i * VERTICIES_PER_QUAD * 11] = 1.0f;
-        quad_data[19 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[20 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-        quad_data[21 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-                     
-        radius = r(t0 + step * (float)i);
-        quad_data[22 + i * VERTICIES_PER_QUAD * 11] = radius * cosf(t0 + step * (float)i);
-        quad_data[23 + i * VERTICIES_PER_QUAD * 11] = radius * sinf(t0 + step * (float)i);
-        quad_data[24 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[25 + i * VERTICIES_PER_QUAD * 11] = color.x;
-        quad_data[26 + i * VERTICIES_PER_QUAD * 11] = color.y;
-        quad_data[27 + i * VERTICIES_PER_QUAD * 11] = color.z;
-        quad_data[28 + i * VERTICIES_PER_QUAD * 11] = color.w;
-        quad_data[29 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[30 + i * VERTICIES_PER_QUAD * 11] = 1.0f;
-        quad_data[31 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-        quad_data[32 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-                     
-        radius = r(t0 + step * (float)(i + 1));
-        quad_data[33 + i * VERTICIES_PER_QUAD * 11] = radius * cosf(t0 + step * (float)(i + 1));
-        quad_data[34 + i * VERTICIES_PER_QUAD * 11] = radius * sinf(t0 + step * (float)(i + 1));
-        quad_data[35 + i * VERTICIES_PER_QUAD * 11] = 0.0f;
-        quad_data[36 + i * VERTICIES_PER_QUAD * 11] = color.x;
-        quad_data[37 + i * VERTICIES_PER_QUAD * 11] = color.y;
-        quad_data[38 + i * VERTICIES_PER_QUAD * 11] = color.z;
-        quad_data[39 + i * VERTICIES_PER_QUAD * 11] = color.w;
-        quad_data[40 + i * VERTICIES_PER_QUAD * 11] = 1.0f;
-        quad_data[41 + i * VERTICIES_PER_QUAD * 11] = 1.0f;
-        quad_data[42 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
-        quad_data[43 + i * VERTICIES_PER_QUAD * 11] = -1.0f;
+        float a0 = t0 + step * (float)i;
+        float a1 = t0 + step * (float)(i + 1);
+        Vec2f p0 = vec2f_multi_constant(vec2f_make(cosf(a0), sinf(a0)), r(a0));
+        Vec2f p1 = vec2f_multi_constant(vec2f_make(cosf(a1), sinf(a1)), r(a1));
+
+        Quad_Vertex *quad = quad_data + i * VERTICIES_PER_QUAD;
+        quad[0] = (Quad_Vertex) { VEC2F_ORIGIN, packed_color, { 0, 0 },           VERTEX_SLOT_NONE, VERTEX_SLOT_NONE, 0 };
+        quad[1] = (Quad_Vertex) { VEC2F_ORIGIN, packed_color, { 0xFFFF, 0 },      VERTEX_SLOT_NONE, VERTEX_SLOT_NONE, 0 };
+        quad[2] = (Quad_Vertex) { p0,           packed_color, { 0, 0xFFFF },      VERTEX_SLOT_NONE, VERTEX_SLOT_NONE, 0 };
+        quad[3] = (Quad_Vertex) { p1,           packed_color, { 0xFFFF, 0xFFFF }, VERTEX_SLOT_NONE, VERTEX_SLOT_NONE, 0 };
     }
     
     if (buffer == NULL)
-        draw_quad_data(quad_data, rect_count);
+        draw_quad_data((float *)quad_data, rect_count);
     else
-        vertex_buffer_append_data(buffer, quad_data, rect_count * VERTICIES_PER_QUAD * 11);
+        vertex_buffer_append_data(buffer, (float *)quad_data, rect_count * VERTICIES_PER_QUAD * QUAD_VERTEX_STRIDE);
 
 }
 
@@ -455,7 +678,7 @@ void draw_viewport(u32 x, u32 y, u32 width, u32 height, Vec4f color, Camera *cam
     Vec2f p1 = vec2f_make((float)width / 2 / (float)camera->unit_scale, (float)height / 2 / (float)camera->unit_scale);
     Vec2f p0 = vec2f_negate(p1);
     
-    draw_rect(p0, p1, .color = color, .uv0 = p0, .uv1 = p1, .buffer = buffer);
+    draw_rect(p0, p1, .color = color, .buffer = buffer);
 
 }
 
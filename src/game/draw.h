@@ -2,6 +2,7 @@
 #define DRAW_H
 
 #include "game/graphics.h"
+#include "game/particles.h"
 
 #include "core/core.h"
 #include "core/type.h"
@@ -23,6 +24,7 @@ typedef struct draw_quad_args_opt {
 
 /**
  * Draws p0 being bottom left corner, p1 being top right corner.
+ * @Important: Quad is written as 4 verticies, so drawer shouldn't be instanced.
  */
 void draw_quad_opt(Vec2f p0, Vec2f p2, Vec2f p3, Vec2f p1, Draw_Quad_Opt_Args opt);
 
@@ -47,23 +49,70 @@ typedef struct draw_rect_args_opt {
 
 /**
  * Draws rectangular quad, p0 being bottom left corner, p1 being top right corner.
+ * If active drawer is instanced, writes one instance instead of 4 verticies, unless it is written into "buffer".
  */
 void draw_rect_opt(Vec2f p0, Vec2f p1, Draw_Rect_Opt_Args opt);
 
+/**
+ * Draws every particle as square sprite instance of its size, textured if "texture" isn't NULL.
+ * Instances are packed in batches straight from particle arrays, so active drawer should be instanced sprite drawer.
+ */
+void draw_particles(Particles *particles, Texture *texture);
+
+
+
+
+
+/**
+ * Text layout cache.
+ * Laid out text is kept by its contents, font and wrap width, so static labels are measured and laid out once, and then only copied into quads each frame.
+ * Layouts that weren't used for TEXT_LAYOUT_MAX_AGE frames are freed, and if cache is full least recently used layout is replaced.
+ * Layout is done again when glyph cache page it points into was cleared.
+ */
 
+#define TEXT_LAYOUT_CACHE_SIZE  512
+#define TEXT_LAYOUT_MAX_AGE     120
+
+typedef struct text_layout_glyph {
+    Vec2f       offset;     // From top left origin of the text to bottom left corner of the glyph quad.
+    Vec2f       size;
+    UV_Region   uv;
+} Text_Layout_Glyph;
+
+typedef struct text_layout {
+    Vec2f               size;           // Width of the longest line and height of all lines.
+    Texture *           mask;           // Glyph cache texture, all glyphs of one font are on the same one.
+    u32                 pages;          // Glyph cache pages glyphs are on, one bit per page.
+    u32                 glyphs_count;
+    Text_Layout_Glyph * glyphs;
+} Text_Layout;
+
+/**
+ * Returns layout of the text from the cache, laying it out if needed.
+ * If "wrap_width" is bigger than 0, lines are broken at spaces, or anywhere if word doesn't fit on its own, so they are not wider than it.
+ * @Important: Returned pointer is valid until next call, and pages it points into are kept in glyph cache while this frame is drawn.
+ */
+Text_Layout *text_layout(String text, Font_Baked *font, float wrap_width);
+
+/**
+ * Ages cached layouts and frees ones that weren't used for TEXT_LAYOUT_MAX_AGE frames, should be called once per frame.
+ */
+void text_layout_frame_end();
 
 
 
 typedef struct draw_text_args_opt {
     Vec4f           color;
     u32             unit_scale;
+    float           wrap_width;
     Vertex_Buffer * buffer;
 } Draw_Text_Opt_Args;
 
-#define draw_text(text, position, font, ...)  draw_text_opt(text, position, font, (Draw_Text_Opt_Args) { .color = VEC4F_WHITE, .unit_scale = 1, .buffer = NULL, __VA_ARGS__})
+#define draw_text(text, position, font, ...)  draw_text_opt(text, position, font, (Draw_Text_Opt_Args) { .color = VEC4F_WHITE, .unit_scale = 1, .wrap_width = 0.0f, .buffer = NULL, __VA_ARGS__})
 
 /**
  * Draws text as series of quads, position being the top left origin of the text.
+ * Layout comes from the text layout cache, "wrap_width" is in pixels same as font.
  */
 void draw_text_opt(String text, Vec2f position, Font_Baked *font, Draw_Text_Opt_Args opt);
 
@@ -6,6 +6,8 @@
 #include "game/game.h"
 #include "game/graphics.h"
 #include "game/console.h"
+#include "game/spatial.h"
+#include "game/chunks.h"
 
 #include "core/mathf.h"
 #include "core/structs.h"
@@ -89,6 +91,19 @@ static Editor_Params editor_params;
 
 static Editor_Quad *quads_list;
 
+// Quads are culled against camera view using spatial grid, which is filled again when quads are added or moved.
+#define EDITOR_GRID_CELL_SIZE       4.0f
+#define EDITOR_CULL_MARGIN_PIXELS   8.0f    // Dots and crosses stick out of the quad by this many pixels.
+
+static Spatial_Grid quads_grid;
+static bool quads_grid_dirty;
+static u32 *visible_quads;
+
+// Quads themselves are drawn from static chunks, which are rebuilt only when quads in them are added or moved.
+#define EDITOR_CHUNK_SIZE           16.0f
+
+static Static_Chunks quads_chunks;
+
 
 
 
@@ -193,6 +208,11 @@ static Time_Info   *time_ptr;
 static Shader      **shader_table_ptr;
 
 
+static void editor_chunk_build(u32 item, void *data) {
+    (void)data;
+    draw_quad(quads_list[item].quad.verts[0], quads_list[item].quad.verts[1], quads_list[item].quad.verts[2], quads_list[item].quad.verts[3], .color = quads_list[item].color);
+}
+
 void editor_init(State *state) {
     // Tweak vars default values.
     editor_params.selection_radius              = 0.1f;
@@ -237,17 +257,19 @@ void editor_init(State *state) {
     quads_list = array_list_make(Editor_Quad, 8, &std_allocator);
     editor_selected = array_list_make(Editor_Selected, 8, &std_allocator);
 
+    spatial_grid_init(&quads_grid, EDITOR_GRID_CELL_SIZE);
+    quads_grid_dirty = true;
+    visible_quads = array_list_make(u32, 64, &std_allocator);
+
+    static_chunks_init(&quads_chunks, EDITOR_CHUNK_SIZE, quad_drawer_ptr, editor_chunk_build, NULL);
+
     
     // @Copypasta: From console.c ... 
     // Get resources.
 
     // Load needed font... Hard coded...
-    u8* font_data = read_file_into_buffer("res/font/Consolas-Regular.ttf", NULL, &std_allocator);
-
-    font_small  = font_bake(font_data, 14.0f);
-    font_medium = font_bake(font_data, 20.0f);
-
-    free(font_data);
+    font_small  = font_load("res/font/Consolas-Regular.ttf", 14.0f);
+    font_medium = font_load("res/font/Consolas-Regular.ttf", 20.0f);
     
 
     // Copying main camera for editor.
@@ -398,10 +420,15 @@ editor_left_mouse_select_end:
                             editor_selected[i].quad->quad.verts[j].y += selection_move_offset.y;
                         }
                     }
+                    static_chunks_set(&quads_chunks, editor_selected[i].quad - quads_list, quad_enclose_in_aabb(&editor_selected[i].quad->quad));
                     break;
             }
         }
 
+        if (array_list_length(&editor_selected) > 0) {
+            quads_grid_dirty = true;
+        }
+
         // If there were no elements selected, select all elements in the region.
         if (array_list_length(&editor_selected) == 0) {
             AABB selection_region = (AABB) {
@@ -461,12 +488,14 @@ void editor_draw() {
     
     
     // Draw grid, with grid shader.
+    render_layer_set(RENDER_LAYER_WORLD_BACKGROUND);
     shader_update_projection(grid_drawer_ptr->program, &projection);
 
     draw_begin(grid_drawer_ptr);
 
-    Vec2f editor_camera_p0 = vec2f_make(editor_camera.center.x - window_ptr->width * 0.5f / editor_camera.unit_scale, editor_camera.center.y - window_ptr->height * 0.5f / editor_camera.unit_scale);
-    Vec2f editor_camera_p1 = vec2f_make(editor_camera.center.x + window_ptr->width * 0.5f / editor_camera.unit_scale, editor_camera.center.y + window_ptr->height * 0.5f / editor_camera.unit_scale);
+    AABB view = camera_view_aabb(&editor_camera, window_ptr->width, window_ptr->height);
+    Vec2f editor_camera_p0 = view.p0;
+    Vec2f editor_camera_p1 = view.p1;
 
     float grid_quad[36] = {
         -1.0f, -1.0f, editor_camera.unit_scale, 0.2f, 0.2f, 0.2f, 1.0f, editor_camera_p0.x, editor_camera_p0.y,
@@ -481,15 +510,34 @@ void editor_draw() {
 
 
 
-    // Drawing quads.
+    // Culling quads, grid is filled again only after quads changed.
+    if (quads_grid_dirty) {
+        spatial_grid_clear(&quads_grid);
+        for (u32 i = 0; i < array_list_length(&quads_list); i++) {
+            (void)spatial_grid_insert(&quads_grid, quad_enclose_in_aabb(&quads_list[i].quad));
+        }
+        quads_grid_dirty = false;
+    }
+
+    float cull_margin = EDITOR_CULL_MARGIN_PIXELS / (float)editor_camera.unit_scale;
+    AABB cull_region = aabb_make(vec2f_make(view.p0.x - cull_margin, view.p0.y - cull_margin), vec2f_make(view.p1.x + cull_margin, view.p1.y + cull_margin));
+
+    array_list_clear(&visible_quads);
+    spatial_grid_query(&quads_grid, cull_region, &visible_quads);
+
+
+
+    // Drawing quads, visible chunks are submitted before dots, so dots are drawn on top.
+    render_layer_set(RENDER_LAYER_WORLD);
     shader_update_projection(quad_drawer_ptr->program, &projection);
 
-    draw_begin(quad_drawer_ptr);
+    static_chunks_draw(&quads_chunks, view);
 
-    // Draw editor quads.
-    for (u32 i = 0; i < array_list_length(&quads_list); i++) {
-        draw_quad(quads_list[i].quad.verts[0], quads_list[i].quad.verts[1], quads_list[i].quad.verts[2], quads_list[i].quad.verts[3], .color = quads_list[i].color);
+    draw_begin(quad_drawer_ptr);
 
+    // Draw dots of visible editor quads, their size depends on camera, so they aren't static.
+    for (u32 v = 0; v < array_list_length(&visible_quads); v++) {
+        u32 i = visible_quads[v];
         for (u32 j = 0; j < VERTICIES_PER_QUAD; j++) {
             if (quads_list[i].flags & (1 << j)) {
                 draw_dot(quads_list[i].quad.verts[j], VEC4F_RED, &editor_camera, NULL);
@@ -516,30 +564,37 @@ void editor_draw() {
 
     line_draw_begin(line_drawer_ptr);
 
-    // Draw editor quads outlines.
-    for (u32 i = 0; i < array_list_length(&quads_list); i++) {
-        if (quads_list[i].flags & EDITOR_QUAD_BITMASK_ANY_POINT_SELECTED) {
-            // Original selected.
-            draw_cross(quad_center(&quads_list[i].quad), VEC4F_YELLOW, &editor_camera, NULL);
-            draw_quad_outline(quads_list[i].quad.verts[0], quads_list[i].quad.verts[1], quads_list[i].quad.verts[2], quads_list[i].quad.verts[3], VEC4F_YELLOW, NULL);
+    // Draw visible editor quads outlines, selected ones are drawn after, since their preview can be visible even if they aren't.
+    for (u32 v = 0; v < array_list_length(&visible_quads); v++) {
+        u32 i = visible_quads[v];
+        if (!(quads_list[i].flags & EDITOR_QUAD_BITMASK_ANY_POINT_SELECTED)) {
+            draw_quad_outline(quads_list[i].quad.verts[0], quads_list[i].quad.verts[1], quads_list[i].quad.verts[2], quads_list[i].quad.verts[3], VEC4F_WHITE, NULL);
+            draw_cross(quad_center(&quads_list[i].quad), VEC4F_WHITE, &editor_camera, NULL);
+        }
+    }
 
+    for (u32 i = 0; i < array_list_length(&editor_selected); i++) {
+        if (editor_selected[i].type != EDITOR_QUAD) {
+            continue;
+        }
+        Editor_Quad *quad = editor_selected[i].quad;
 
-            // Preview of where selected quad.
-            Quad preview_quad;
-            for (u32 j = 0; j < VERTICIES_PER_QUAD; j++) {
-                if (quads_list[i].flags & (1 << j)) {
-                    preview_quad.verts[j] = vec2f_sum(quads_list[i].quad.verts[j], selection_move_offset);
-                } else {
-                    preview_quad.verts[j] = quads_list[i].quad.verts[j];
-                }
-            }
-            draw_cross(quad_center(&preview_quad), VEC4F_RED, &editor_camera, NULL);
-            draw_quad_outline(preview_quad.verts[0], preview_quad.verts[1], preview_quad.verts[2], preview_quad.verts[3], VEC4F_RED, NULL);
+        // Original selected.
+        draw_cross(quad_center(&quad->quad), VEC4F_YELLOW, &editor_camera, NULL);
+        draw_quad_outline(quad->quad.verts[0], quad->quad.verts[1], quad->quad.verts[2], quad->quad.verts[3], VEC4F_YELLOW, NULL);
 
-        } else {
-            draw_quad_outline(quads_list[i].quad.verts[0], quads_list[i].quad.verts[1], quads_list[i].quad.verts[2], quads_list[i].quad.verts[3], VEC4F_WHITE, NULL);
-            draw_cross(quad_center(&quads_list[i].quad), VEC4F_WHITE, &editor_camera, NULL);
+
+        // Preview of where selected quad.
+        Quad preview_quad;
+        for (u32 j = 0; j < VERTICIES_PER_QUAD; j++) {
+            if (quad->flags & (1 << j)) {
+                preview_quad.verts[j] = vec2f_sum(quad->quad.verts[j], selection_move_offset);
+            } else {
+                preview_quad.verts[j] = quad->quad.verts[j];
+            }
         }
+        draw_cross(quad_center(&preview_quad), VEC4F_RED, &editor_camera, NULL);
+        draw_quad_outline(preview_quad.verts[0], preview_quad.verts[1], preview_quad.verts[2], preview_quad.verts[3], VEC4F_RED, NULL);
     }
 
     line_draw_end();
@@ -552,6 +607,7 @@ void editor_draw() {
 
 
     projection = screen_calculate_projection(window_ptr->width, window_ptr->height);
+    render_layer_set(RENDER_LAYER_UI);
     shader_update_projection(ui_quad_drawer_ptr->program, &projection);
 
     draw_begin(ui_quad_drawer_ptr);
@@ -563,12 +619,14 @@ void editor_draw() {
                 str_format(info_buffer, 
                     "Window size: %dx%d\n"
                     "Vert count: %u\n"
+                    "Visible quads: %u\n"
+                    "Static chunks drawn: %u, rebuilt: %u\n"
                     "World mouse position: (%2.2f, %2.2f)\n"
                     "World mouse snapped position: (%2.2f, %2.2f)\n"
                     "World mouse snapped click origin: (%2.2f, %2.2f)\n"
                     "Selected count: %u\n"
                     "Camera unit scale: %d\n"
-                    , window_ptr->width, window_ptr->height, array_list_length(&quads_list) * 4, world_mouse_position.x, world_mouse_position.y, world_mouse_snapped_position.x, world_mouse_snapped_position.y, world_mouse_snapped_click_origin.x, world_mouse_snapped_click_origin.y, array_list_length(&editor_selected), editor_camera.unit_scale)
+                    , window_ptr->width, window_ptr->height, array_list_length(&quads_list) * 4, array_list_length(&visible_quads), quads_chunks.chunks_drawn, quads_chunks.chunks_rebuilt, world_mouse_position.x, world_mouse_position.y, world_mouse_snapped_position.x, world_mouse_snapped_position.y, world_mouse_snapped_click_origin.x, world_mouse_snapped_click_origin.y, array_list_length(&editor_selected), editor_camera.unit_scale)
             );
     );
 
@@ -593,4 +651,9 @@ void editor_add_quad() {
                 .quad = ((Quad) {{ { -1.0f, -1.0f }, { 1.0f, -1.0f, }, { -1.0f, 1.0f }, { 1.0f, 1.0f } }}),
                 .color = { randf() * 0.6f + 0.2f, randf() * 0.6f + 0.2f, randf() * 0.6f + 0.2f, 1.0f },
                 }));
+
+    u32 item = array_list_length(&quads_list) - 1;
+    static_chunks_set(&quads_chunks, item, quad_enclose_in_aabb(&quads_list[item].quad));
+
+    quads_grid_dirty = true;
 }
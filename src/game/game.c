@@ -7,6 +7,8 @@
 #include "core/mathf.h"
 #include "core/typeinfo.h"
 #include "core/log.h"
+#include "core/profile.h"
+#include "core/tex.h"
 
 #include "game/graphics.h"
 #include "game/input.h"
@@ -18,6 +20,8 @@
 #include "game/vars.h"
 #include "game/imui.h"
 #include "game/asset.h"
+#include "game/overlay.h"
+#include "game/atlas.h"
 
 #include <SDL2/SDL_keycode.h>
 #include <SDL2/SDL_keyboard.h>
@@ -50,6 +54,13 @@ static State *state;
 #define BIND_HOLD(keybind)      (!SDL_IsTextInputActive() && hold(keybind))
 #define BIND_UNPRESSED(keybind) (!SDL_IsTextInputActive() && unpressed(keybind))
 
+// Uncomment to draw and swap frames on the main thread, which is easier to debug, "render_thread_toggle()" does the same at runtime.
+// #define RENDER_SINGLE_THREADED
+
+// Frame capture, next frame is drawn by software backend when set by "render_capture()".
+#define RENDER_CAPTURE_PATH "frame_capture.png"
+static bool render_capture_pending = false;
+
 
 
 
@@ -63,6 +74,7 @@ static State *state;
 
 static const String SHADER_FILE_FORMAT  = STR_BUFFER("glsl");
 static const String FONT_FILE_FORMAT    = STR_BUFFER("ttf");
+static const String TEXTURE_FILE_FORMAT = STR_BUFFER("png");
 
 
 
@@ -132,6 +144,8 @@ void game_init(State *global_state) {
     // Initing graphics.
     graphics_init();
 
+    atlas_init();
+
 
 
     // Keyboard input init.
@@ -184,6 +198,22 @@ void game_init(State *global_state) {
 
             continue;
         }
+
+        // Textures are packed into atlas, and are looked up by name with "atlas_texture_get()", they show placeholder until they are loaded.
+        if (str_equals(changes[i].file_format, TEXTURE_FILE_FORMAT)) {
+            LOG_INFO("Detected Texture Asset: '%.*s'.", UNPACK(changes[i].full_path));
+            char _buffer[changes[i].full_path.length + 1]; 
+            str_copy_to(changes[i].full_path, _buffer);
+            _buffer[changes[i].full_path.length]     = '\0';
+
+            (void)atlas_texture_load_async(_buffer);
+
+            asset_remove_change(i);
+            i--;
+            changes_count--;
+
+            continue;
+        }
     }
 
 
@@ -191,6 +221,8 @@ void game_init(State *global_state) {
     // Drawers init.
     drawer_init(&state->quad_drawer, hash_table_get(&state->shader_table, UNPACK_LITERAL("quad")));
 
+    drawer_init(&state->sprite_drawer, hash_table_get(&state->shader_table, UNPACK_LITERAL("sprite")));
+
     drawer_init(&state->grid_drawer, hash_table_get(&state->shader_table, UNPACK_LITERAL("grid")));
 
     drawer_init(&state->ui_quad_drawer, hash_table_get(&state->shader_table, UNPACK_LITERAL("ui_quad")));
@@ -215,6 +247,9 @@ void game_init(State *global_state) {
     // Init editor.
     editor_init(state);
 
+    // Init performance overlay.
+    overlay_init(state);
+
     
 
 
@@ -253,7 +288,12 @@ void game_init(State *global_state) {
 
 
     // Setting clear color.
-    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    render_clear_color_set(vec4f_make(0.2f, 0.2f, 0.2f, 1.0f));
+
+    // Starting render thread, frames are drawn on the main thread if it fails.
+#ifndef RENDER_SINGLE_THREADED
+    (void)render_thread_start(&state->window);
+#endif
 
     // Logging hello world to the console.
     console_log("Hello world!\n");
@@ -269,6 +309,9 @@ void process_asset_changes() {
     const Asset_Change *changes;
 
     if (asset_view_changes(&count, &changes)) {
+        // Reloaded assets replace GL objects that frame in flight may still draw with.
+        render_thread_wait();
+
         for (u32 i = 0; i < count; i++) {
             // Vars files.
             if (str_equals(changes[i].file_format, VARS_FILE_FORMAT)) {
@@ -303,6 +346,15 @@ void process_asset_changes() {
 
                 hash_table_put(&state->shader_table, shader, UNPACK(shader_name));
             }
+            // Texture files, reloaded into the same atlas handle, old image is shown until new one is decoded.
+            else if (str_equals(changes[i].file_format, TEXTURE_FILE_FORMAT)) {
+                console_log("Texture detected Asset Change: '%.*s'\n", UNPACK(changes[i].full_path));
+                char _buffer[changes[i].full_path.length + 1]; 
+                str_copy_to(changes[i].full_path, _buffer);
+                _buffer[changes[i].full_path.length]     = '\0';
+
+                (void)atlas_texture_load_async(_buffer);
+            }
         }
     }
 }
@@ -313,21 +365,41 @@ void process_asset_changes() {
  * Drawing part is only responsible for putting pixels accrodingly with calculated data in "Updating" part.
  */
 void game_update() {
+    PROFILE_ZONE("game_update");
+
     // Polling any asset changes.
-    if (asset_observer_poll_changes() != 0) {
-        LOG_ERROR("Couldn't poll asset changes.");
-        exit(1);
+    {
+        PROFILE_ZONE("asset_poll");
+
+        if (asset_observer_poll_changes() != 0) {
+            LOG_ERROR("Couldn't poll asset changes.");
+            exit(1);
+        }
+
+        process_asset_changes();
     }
 
-    process_asset_changes();
+    // Uploading textures that were decoded since last frame.
+    {
+        PROFILE_ZONE("texture_loads");
+
+        texture_loads_update();
+
+        Texture_Load_Completion completion;
+        while (texture_load_completed(&completion)) {
+            if (completion.failed) {
+                console_error("Couldn't load texture '%s'.\n", completion.path);
+            }
+        }
+    }
 
     
     // Handling events
-    event_handle(&state->events, &state->window, &state->t);
+    {
+        PROFILE_ZONE("events");
+        event_handle(&state->events, &state->window, &state->t);
+    }
 
-    // Clearin screen.
-    glClear(GL_COLOR_BUFFER_BIT);
-    
 
 
 
@@ -351,6 +423,8 @@ void game_update() {
 
             // Updating editor, if console is not active.
             if (!console_active()) {
+                PROFILE_ZONE("editor_update");
+
                 if (editor_update()) {
                     TODO("Editor exitting.");
                     // Editor is exitted.
@@ -361,7 +435,10 @@ void game_update() {
             }
 
             // Editor drawing.
-            editor_draw();
+            {
+                PROFILE_ZONE("editor_draw");
+                editor_draw();
+            }
 
             break;
         case GAME_STATE_LEVEL:
@@ -373,19 +450,41 @@ void game_update() {
 
 
     // Console update.
-    console_update(&state->window, &state->events, &state->t);
+    {
+        PROFILE_ZONE("console_update");
+        console_update(&state->window, &state->events, &state->t);
+    }
 
     // Console drawing.
     console_draw(&state->window);
+
+    // Performance overlay drawing.
+    {
+        PROFILE_ZONE("overlay_draw");
+        overlay_draw();
+    }
    
 
 
-    // Checking for gl error.
-    check_gl_error();
+    // Handing everything that was submitted this frame off to be drawn and swapped.
+    if (render_capture_pending) {
+        render_backend_set(RENDER_BACKEND_SOFTWARE, state->window.width, state->window.height);
+    }
 
+    render_present(&state->window);
 
-    // Swap buffers to display the rendered image.
-    SDL_GL_SwapWindow(state->window.ptr);
+    if (render_capture_pending) {
+        render_capture_pending = false;
+        if (render_software_save(RENDER_CAPTURE_PATH)) {
+            console_log("Captured frame into '%s'.\n", RENDER_CAPTURE_PATH);
+        } else {
+            console_error("Couldn't capture frame.\n");
+        }
+        render_backend_set(RENDER_BACKEND_GL, 0, 0);
+    }
+
+    // Aging cached text layouts.
+    text_layout_frame_end();
 
 
     // Post updating input.
@@ -393,11 +492,18 @@ void game_update() {
 }
 
 void game_free() {
+    render_thread_stop();
+
     console_free();
+    overlay_free();
 
     shader_unload(hash_table_get(&state->shader_table, UNPACK_LITERAL("quad")));
+    shader_unload(hash_table_get(&state->shader_table, UNPACK_LITERAL("sprite")));
     shader_unload(hash_table_get(&state->shader_table, UNPACK_LITERAL("ui_quad")));
     drawer_free(&state->quad_drawer);
+    drawer_free(&state->sprite_drawer);
+
+    atlas_free();
 }
 
 void quit() {
@@ -408,16 +514,88 @@ void game_set_state(Game_State game_state) {
     state->game_state = game_state;
 }
 
+void profile_dump() {
+    if (profile_dump_chrome_trace("profile_trace.json")) {
+        console_log("Dumped %lld frames into 'profile_trace.json'.\n", profile_frame_count());
+    } else {
+        console_error("Couldn't dump profile trace.\n");
+    }
+}
 
+void render_capture() {
+    render_capture_pending = true;
+}
 
+void render_thread_toggle() {
+    if (render_thread_running()) {
+        render_thread_stop();
+        console_log("Drawing on the main thread.\n");
+    } else if (render_thread_start(&state->window)) {
+        console_log("Drawing on the render thread.\n");
+    } else {
+        console_error("Couldn't start render thread.\n");
+    }
+}
 
+void render_stats() {
+    Graphics_Stats stats = graphics_stats_last_frame();
+    console_log("Draw calls: %u (%u saved), verticies: %u, triangles: %u.\n", stats.draw_calls, stats.draw_calls_saved, stats.verticies, stats.triangles);
+    console_log("Buffer uploads: %u, %.1f KB.\n", stats.buffer_uploads, (float)stats.bytes_uploaded / 1024.0f);
+    console_log("State changes: %u (%u saved), program binds: %u, texture binds: %u, uniform updates: %u.\n", stats.state_changes, stats.state_changes_saved, stats.program_binds, stats.texture_binds, stats.uniform_updates);
+}
 
+void render_trace() {
+    if (graphics_trace_frame("render_trace.txt")) {
+        console_log("Tracing next frame into 'render_trace.txt'.\n");
+    } else {
+        console_error("Couldn't trace frame.\n");
+    }
+}
 
+void texture_cook() {
+    u32 pending_count;
+    const Asset_Change *changes;
+    if (!asset_view_changes(&pending_count, &changes)) {
+        pending_count = 0;
+    }
 
+    bool found = asset_force_changes("res") == 0;
 
+    u32 count;
+    if (!asset_view_changes(&count, &changes)) {
+        count = 0;
+    }
 
+    s32 cooked_count = 0;
+    s32 failed_count = 0;
+    for (u32 i = 0; found && i < count; i++) {
+        if (!str_equals(changes[i].file_format, TEXTURE_FILE_FORMAT)) {
+            continue;
+        }
 
+        char image_path[changes[i].full_path.length + 1];
+        str_copy_to(changes[i].full_path, image_path);
+        image_path[changes[i].full_path.length] = '\0';
+
+        char tex_path[TEXTURE_LOAD_MAX_PATH];
+        bool cooked = false;
+        if (!tex_path_from_image(image_path, tex_path, sizeof(tex_path)) || !tex_cook_file(image_path, tex_path, TEX_FORMAT_RGBA8, 0, &cooked)) {
+            console_error("Couldn't cook '%s'.\n", image_path);
+            failed_count++;
+        } else if (cooked) {
+            cooked_count++;
+        }
+    }
 
+    // Forced changes are only used to find textures, they shouldn't be reloaded, pending ones before them are kept.
+    while (count > pending_count) {
+        asset_remove_change(--count);
+    }
 
+    if (!found) {
+        console_error("Couldn't find textures to cook.\n");
+        return;
+    }
 
-
+    console_log("Cooked %d textures, %d failed, rest are up to date.\n", cooked_count, failed_count);
+}
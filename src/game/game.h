@@ -36,6 +36,7 @@ typedef struct state {
     Font_Baked *font;
 
     Quad_Drawer quad_drawer;
+    Quad_Drawer sprite_drawer;
     Quad_Drawer grid_drawer;
     Quad_Drawer ui_quad_drawer;
     Line_Drawer line_drawer;
@@ -73,4 +74,46 @@ void quit();
 @RegisterCommand;
 void game_set_state(Game_State game_state);
 
+/**
+ * Writes last profiled frames into "profile_trace.json", open it in "about:tracing" or Perfetto.
+ */
+@Introspect;
+@RegisterCommand;
+void profile_dump();
+
+/**
+ * Draws next frame with software backend and writes it into "frame_capture.png", to compare frames without depending on GPU.
+ */
+@Introspect;
+@RegisterCommand;
+void render_capture();
+
+/**
+ * Stops render thread if it runs, so frames are drawn and swapped on the main thread, or starts it again.
+ */
+@Introspect;
+@RegisterCommand;
+void render_thread_toggle();
+
+/**
+ * Prints GL calls, verticies and uploads of the last drawn frame.
+ */
+@Introspect;
+@RegisterCommand;
+void render_stats();
+
+/**
+ * Writes every counted GL call of the next frame into "render_trace.txt".
+ */
+@Introspect;
+@RegisterCommand;
+void render_trace();
+
+/**
+ * Cooks textures inside "res" into mipmapped ".tex" files next to them, only textures that changed since the last cook are cooked again.
+ */
+@Introspect;
+@RegisterCommand;
+void texture_cook();
+
 #endif
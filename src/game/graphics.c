@@ -1,4 +1,5 @@
 #include "game/graphics.h"
+#include "game/atlas.h"
 
 #include "core/core.h"
 #include "core/type.h"
@@ -7,11 +8,20 @@
 #include "core/structs.h"
 #include "core/mathf.h"
 #include "core/log.h"
+#include "core/profile.h"
+#include "core/thread.h"
+#include "core/raster.h"
+#include "core/tex.h"
 
 
 #include "SDL2/SDL_video.h"
 #include <GL/glew.h>
 
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
@@ -114,11 +124,325 @@ Vertex_Buffer verticies;
 u32 *quad_indicies;
 u32 texture_ids[32];
 
-void graphics_init() {
+// Stats.
+static _Thread_local Graphics_Stats stats_current;     // Of the calling context, main context's stats are handed to the frame they were made for.
+static Graphics_Stats stats_last_frame;
+static Mutex stats_mutex = MUTEX_INIT;  // Last frame is closed by the thread that draws and read by the main one.
+static _Thread_local FILE *stats_trace = NULL;          // Counted calls are written into it while it is set.
+
+
+
+
+
+/**
+ * GL call shims.
+ * Count calls, verticies and bytes into the stats of the calling context, and write calls into the trace when there is one.
+ */
+
+static void gl_trace(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void gl_trace(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stats_trace, format, args);
+    va_end(args);
+}
+
+static u32 gl_triangles_count(u32 mode, u32 count) {
+    switch (mode) {
+        case GL_TRIANGLES:          return count / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN:       return count > 2 ? count - 2 : 0;
+    }
+    return 0;
+}
+
+static void gl_buffer_data(u32 target, s64 size, const void *data, u32 usage) {
+    glBufferData(target, size, data, usage);
+
+    stats_current.buffer_uploads++;
+    stats_current.bytes_uploaded += data != NULL ? size : 0;
+    if (stats_trace != NULL) gl_trace("glBufferData(0x%X, %lld, %s, 0x%X)\n", target, (long long)size, data != NULL ? "data" : "NULL", usage);
+}
+
+static void gl_buffer_sub_data(u32 target, s64 offset, s64 size, const void *data) {
+    glBufferSubData(target, offset, size, data);
+
+    stats_current.buffer_uploads++;
+    stats_current.bytes_uploaded += size;
+    if (stats_trace != NULL) gl_trace("glBufferSubData(0x%X, %lld, %lld)\n", target, (long long)offset, (long long)size);
+}
+
+static void gl_draw_elements(u32 mode, s32 count, u32 type, const void *indicies) {
+    glDrawElements(mode, count, type, indicies);
+
+    stats_current.draw_calls++;
+    stats_current.verticies += count;
+    stats_current.triangles += gl_triangles_count(mode, count);
+    if (stats_trace != NULL) gl_trace("glDrawElements(0x%X, %d, 0x%X, %p)\n", mode, count, type, indicies);
+}
+
+static void gl_draw_elements_base_vertex(u32 mode, s32 count, u32 type, const void *indicies, s32 base_vertex) {
+    glDrawElementsBaseVertex(mode, count, type, (void *)indicies, base_vertex);
+
+    stats_current.draw_calls++;
+    stats_current.verticies += count;
+    stats_current.triangles += gl_triangles_count(mode, count);
+    if (stats_trace != NULL) gl_trace("glDrawElementsBaseVertex(0x%X, %d, 0x%X, %p, %d)\n", mode, count, type, indicies, base_vertex);
+}
+
+static void gl_draw_arrays(u32 mode, s32 first, s32 count) {
+    glDrawArrays(mode, first, count);
+
+    stats_current.draw_calls++;
+    stats_current.verticies += count;
+    stats_current.triangles += gl_triangles_count(mode, count);
+    if (stats_trace != NULL) gl_trace("glDrawArrays(0x%X, %d, %d)\n", mode, first, count);
+}
+
+static void gl_draw_arrays_instanced_base_instance(u32 mode, s32 first, s32 count, s32 instances_count, u32 base_instance) {
+    glDrawArraysInstancedBaseInstance(mode, first, count, instances_count, base_instance);
+
+    stats_current.draw_calls++;
+    stats_current.verticies += count * instances_count;
+    stats_current.triangles += gl_triangles_count(mode, count) * instances_count;
+    if (stats_trace != NULL) gl_trace("glDrawArraysInstancedBaseInstance(0x%X, %d, %d, %d, %u)\n", mode, first, count, instances_count, base_instance);
+}
+
+static void gl_bind_texture(u32 target, u32 texture) {
+    glBindTexture(target, texture);
+
+    stats_current.texture_binds++;
+    if (stats_trace != NULL) gl_trace("glBindTexture(0x%X, %u)\n", target, texture);
+}
+
+static void gl_use_program(u32 program) {
+    glUseProgram(program);
+
+    stats_current.program_binds++;
+    if (stats_trace != NULL) gl_trace("glUseProgram(%u)\n", program);
+}
+
+static void gl_uniform_matrix4fv(s32 location, s32 count, u8 transpose, const float *value) {
+    glUniformMatrix4fv(location, count, transpose, value);
+
+    stats_current.uniform_updates++;
+    if (stats_trace != NULL) gl_trace("glUniformMatrix4fv(%d, %d, %u)\n", location, count, transpose);
+}
+
+static void gl_uniform1iv(s32 location, s32 count, const s32 *value) {
+    glUniform1iv(location, count, value);
+
+    stats_current.uniform_updates++;
+    if (stats_trace != NULL) gl_trace("glUniform1iv(%d, %d)\n", location, count);
+}
+
+
+
+
+
+/**
+ * Vertex stream.
+ * One big VBO used as a ring by all drawers, verticies of each draw are written after previous ones, and draws use base vertex offsets into it.
+ * So GL never has to wait for or copy the data that previous draw is still reading, which happens when every batch overwrites offset 0.
+ *
+ * Ring is split into regions, when writing moves to the next region, fence is placed after draws that read the region that is left.
+ * Before writing into region again its fence is waited on, which only stalls if GPU is whole ring behind.
+ */
+
+typedef enum vertex_stream_mode : u8 {
+    VERTEX_STREAM_PERSISTENT,       // GL 4.4 or ARB_buffer_storage, buffer is mapped once and stays mapped.
+    VERTEX_STREAM_UNSYNCHRONIZED,   // Each write maps its range unsynchronized, fences guard reuse.
+    VERTEX_STREAM_ORPHAN,           // Fallback, writes with glBufferSubData and orphans whole buffer with glBufferData on wrap.
+} Vertex_Stream_Mode;
+
+static const char *vertex_stream_mode_names[] = { "persistent", "unsynchronized", "orphan" };
+
+// Uncomment or define when compiling to test specific path, modes that are not supported still fall back, test.exe is built with orphan mode.
+// #define VERTEX_STREAM_FORCE_MODE VERTEX_STREAM_ORPHAN
+
+#define VERTEX_STREAM_SIZE      (4 * 1024 * 1024)
+#define VERTEX_STREAM_REGIONS   4
+#define VERTEX_STREAM_REGION    (VERTEX_STREAM_SIZE / VERTEX_STREAM_REGIONS)
+
+// Biggest single write, leaves room for aligning write to the vertex size inside of the region.
+#define VERTEX_STREAM_MAX_WRITE (VERTEX_STREAM_REGION / 2)
+
+typedef struct vertex_stream {
+    u32 vbo;
+    Vertex_Stream_Mode mode;
+    u8 *mapped;             // Only for VERTEX_STREAM_PERSISTENT.
+    u64 head;               // Byte offset where next write can start.
+    u32 region;             // Region that "head" is in.
+    GLsync fences[VERTEX_STREAM_REGIONS];
+} Vertex_Stream;
+
+static Vertex_Stream vertex_stream;
+
+
+static void vertex_stream_init() {
+    vertex_stream = (Vertex_Stream) {0};
+
+    Vertex_Stream_Mode mode = (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) ? VERTEX_STREAM_PERSISTENT : VERTEX_STREAM_UNSYNCHRONIZED;
+#ifdef VERTEX_STREAM_FORCE_MODE
+    mode = maxi(mode, VERTEX_STREAM_FORCE_MODE);
+#endif
+
+    glGenBuffers(1, &vertex_stream.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.vbo);
+
+    if (mode == VERTEX_STREAM_PERSISTENT) {
+        u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, VERTEX_STREAM_SIZE, NULL, flags);
+        vertex_stream.mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, VERTEX_STREAM_SIZE, flags);
+
+        if (vertex_stream.mapped == NULL) {
+            // Storage is immutable, so buffer needs to be recreated for other modes.
+            LOG_WARNING("Couldn't persistently map vertex stream, falling back to unsynchronized mapping.");
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(1, &vertex_stream.vbo);
+            glGenBuffers(1, &vertex_stream.vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.vbo);
+            mode = VERTEX_STREAM_UNSYNCHRONIZED;
+        }
+    }
+
+    if (mode != VERTEX_STREAM_PERSISTENT) {
+        gl_buffer_data(GL_ARRAY_BUFFER, VERTEX_STREAM_SIZE, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    vertex_stream.mode = mode;
+    LOG_INFO("Vertex stream: %d KB ring, '%s' mode.", VERTEX_STREAM_SIZE / 1024, vertex_stream_mode_names[mode]);
+}
+
+/**
+ * Waits until GPU is done with commands issued before fence was placed, and deletes it.
+ */
+static void vertex_stream_wait(GLsync *fence) {
+    if (*fence == NULL) {
+        return;
+    }
+
+    while (true) {
+        GLenum result = glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED) {
+            break;
+        }
+        if (result == GL_WAIT_FAILED) {
+            LOG_ERROR("Waiting on vertex stream fence failed.");
+            break;
+        }
+    }
+
+    glDeleteSync(*fence);
+    *fence = NULL;
+}
+
+/**
+ * Finds where the next write of "size" bytes goes, returns its region and sets its byte offset.
+ */
+static u32 vertex_stream_place(u64 size, u64 alignment, u64 *offset) {
+    *offset = (vertex_stream.head + alignment - 1) / alignment * alignment;
+    u32 region = *offset / VERTEX_STREAM_REGION;
+
+    // Writes don't cross regions, so each region can be fenced separately.
+    if (region >= VERTEX_STREAM_REGIONS || *offset + size > (u64)(region + 1) * VERTEX_STREAM_REGION) {
+        region = region + 1 < VERTEX_STREAM_REGIONS ? region + 1 : 0;
+        *offset = ((u64)region * VERTEX_STREAM_REGION + alignment - 1) / alignment * alignment;
+    }
+
+    return region;
+}
+
+/**
+ * Returns true if the next write of "size" bytes goes into another region, then it fences the current region or orphans the buffer,
+ * so draws that read what was written before should be issued first.
+ */
+static bool vertex_stream_switches_region(u64 size, u64 alignment) {
+    u64 offset;
+    return vertex_stream_place(size, alignment, &offset) != vertex_stream.region;
+}
+
+/**
+ * Writes data into the vertex stream, "GL_ARRAY_BUFFER" should be bound to the stream buffer.
+ * Offset is aligned to "alignment", which is the vertex size in bytes, so it can be converted to base vertex.
+ * Returns byte offset where data was written.
+ * @Important: Size should not exceed VERTEX_STREAM_MAX_WRITE.
+ * @Important: Draws of data written before should be issued before the write that switches region, see "vertex_stream_switches_region()".
+ */
+static u64 vertex_stream_write(void *data, u64 size, u64 alignment) {
+    u64 offset;
+    u32 region = vertex_stream_place(size, alignment, &offset);
+
+    if (region != vertex_stream.region) {
+        if (vertex_stream.mode == VERTEX_STREAM_ORPHAN) {
+            if (region == 0) {
+                // Old storage stays alive until draws that read it are done, writes go to the new one.
+                gl_buffer_data(GL_ARRAY_BUFFER, VERTEX_STREAM_SIZE, NULL, GL_STREAM_DRAW);
+            }
+        } else {
+            vertex_stream.fences[vertex_stream.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            vertex_stream_wait(&vertex_stream.fences[region]);
+        }
+        vertex_stream.region = region;
+    }
+
+    switch (vertex_stream.mode) {
+        case VERTEX_STREAM_PERSISTENT:
+            memcpy(vertex_stream.mapped + offset, data, size);
+            stats_current.bytes_uploaded += size;
+            break;
+
+        case VERTEX_STREAM_UNSYNCHRONIZED: {
+            void *ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if (ptr != NULL) {
+                memcpy(ptr, data, size);
+                (void)glUnmapBuffer(GL_ARRAY_BUFFER);
+                stats_current.bytes_uploaded += size;
+                break;
+            }
+
+            LOG_WARNING("Couldn't map vertex stream range, falling back to buffer orphaning.");
+            vertex_stream.mode = VERTEX_STREAM_ORPHAN;
+            for (u32 i = 0; i < VERTEX_STREAM_REGIONS; i++) {
+                vertex_stream_wait(&vertex_stream.fences[i]);
+            }
+            gl_buffer_sub_data(GL_ARRAY_BUFFER, offset, size, data);
+            break;
+        }
+
+        case VERTEX_STREAM_ORPHAN:
+            gl_buffer_sub_data(GL_ARRAY_BUFFER, offset, size, data);
+            break;
+    }
+
+    vertex_stream.head = offset + size;
+    return offset;
+}
+
+
+/**
+ * State that belongs to the context and not to shared objects, so each context that draws sets it.
+ */
+static void graphics_context_setup() {
     // Enable Blending (Rendering with alpha channels in mind).
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     // glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void graphics_init_headless() {
+    if (verticies != NULL) {
+        return;
+    }
+
+    verticies = vertex_buffer_make(); // @Leak
+}
+
+void graphics_init() {
+    graphics_context_setup();
 
     // Make stbi flip images vertically when loading.
     stbi_set_flip_vertically_on_load(true);
@@ -128,7 +452,9 @@ void graphics_init() {
     FILE *table = fopen("structs_trace.csv", "ab");
     diagnostic_attach("verticies", table);
 
-    verticies = vertex_buffer_make(); // @Leak
+    graphics_init_headless();
+
+    vertex_stream_init(); // @Leak
                                       //
     quad_indicies = array_list_make(u32, MAX_QUADS_PER_BATCH * 6, &std_allocator); // @Leak
     
@@ -140,7 +466,87 @@ void graphics_init() {
     }
 }
 
+static bool texture_path_is_cooked(char *texture_path) {
+    char *format = strrchr(texture_path, '.');
+    return format != NULL && strcmp(format + 1, TEX_FILE_FORMAT) == 0;
+}
+
+/**
+ * Sets up bound texture to sample mip levels of cooked texture.
+ * Returns false if format of the cooked texture isn't supported by GL.
+ */
+static bool texture_cooked_setup(Tex *tex) {
+    if (tex->header->format == TEX_FORMAT_BC3 && !GLEW_EXT_texture_compression_s3tc) {
+        return false;
+    }
+
+    s32 min_filter = texture_min_filter == GL_NEAREST ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture_wrap_s);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture_wrap_t);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_max_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, tex->header->levels_count - 1);
+    return true;
+}
+
+/**
+ * Uploads mip level of cooked texture into bound texture as it is stored.
+ */
+static void texture_cooked_level_upload(Tex *tex, u32 level) {
+    Tex_Level *info = &tex->header->levels[level];
+
+    if (tex->header->format == TEX_FORMAT_BC3) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, info->width, info->height, 0, info->size, tex_level_data(tex, level));
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, info->width, info->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, tex_level_data(tex, level));
+    }
+}
+
+/**
+ * Loads ".tex" file cooked by "tex_cook_file()" with all its mip levels.
+ */
+static Texture texture_load_cooked(char *texture_path) {
+    Texture texture = {
+        .region = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT },
+    };
+
+    Tex tex;
+    if (!tex_load(texture_path, &tex)) {
+        LOG_ERROR("Couldn't load cooked texture '%s'.", texture_path);
+        return texture;
+    }
+
+    glGenTextures(1, &texture.id);
+    gl_bind_texture(GL_TEXTURE_2D, texture.id);
+
+    if (texture_cooked_setup(&tex)) {
+        for (u32 i = 0; i < tex.header->levels_count; i++) {
+            texture_cooked_level_upload(&tex, i);
+        }
+        texture.width = tex.header->width;
+        texture.height = tex.header->height;
+    } else {
+        LOG_ERROR("Cooked texture '%s' is BC3 compressed, but GL doesn't support S3TC, it should be cooked without compression.", texture_path);
+    }
+
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+    tex_free(&tex);
+
+    return texture;
+}
+
 Texture texture_load(char *texture_path) {
+    if (texture_path_is_cooked(texture_path)) {
+        return texture_load_cooked(texture_path);
+    }
+
+    char cooked_path[TEXTURE_LOAD_MAX_PATH];
+    if (tex_cooked_path(texture_path, cooked_path, sizeof(cooked_path))) {
+        return texture_load_cooked(cooked_path);
+    }
+
     // Process image into texture.
     Texture texture;
     s32 nrChannels;
@@ -153,22 +559,27 @@ Texture texture_load(char *texture_path) {
 
     // Loading a single image into texture example:
     glGenTextures(1, &texture.id);
-    glBindTexture(GL_TEXTURE_2D, texture.id);
+    gl_bind_texture(GL_TEXTURE_2D, texture.id);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture_wrap_s);	
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture_wrap_t);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture_min_filter);  
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_max_filter);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture.width, texture.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gl_bind_texture(GL_TEXTURE_2D, 0);
 
     stbi_image_free(data);
 
+    texture.region = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT };
+    texture.distance_field = false;
+
     return texture;
 }
 
 void texture_unload(Texture *texture) {
+    render_thread_wait();
     glDeleteTextures(1, &texture->id);
+    texture_changed(texture->id);
 
     texture->id = 0;
     texture->width = 0;
@@ -184,451 +595,2531 @@ UV_Region uv_slice(u32 rows, u32 cols, u32 index) {
 }
 
 
-const char *shader_uniform_pr_matrix_name = "pr_matrix";
-const char *shader_uniform_ml_matrix_name = "ml_matrix";
-const char *shader_uniform_samplers_name = "u_textures";
+
 
 /**
- * @Temporary: Later, setting uniforms either will be done more automatically, or simplified to be done by user manually. 
- * But right now it is not neccassary to care about too much, since only one shader is used anyway.
+ * Async texture loading.
+ * Jobs are kept in a ring, worker decodes them in order and main thread uploads them in the same order,
+ * so "submitted", "decoded" and "uploaded" counters are all the state threads share.
  */
-void shader_init_uniforms(Shader *program) {
-    // Get uniform's locations based on unifrom's name.
-    s32 quad_shader_pr_matrix_loc = glGetUniformLocation(program->id, shader_uniform_pr_matrix_name);
-    if (quad_shader_pr_matrix_loc == -1) {
-        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_pr_matrix_name, program->id);
-    }
 
-    s32 quad_shader_ml_matrix_loc = glGetUniformLocation(program->id, shader_uniform_ml_matrix_name);
-    if (quad_shader_ml_matrix_loc == -1) {
-        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_ml_matrix_name, program->id);
-    }
+#define TEXTURE_LOAD_WAIT_MS 100
+
+typedef struct texture_load_job {
+    char path[TEXTURE_LOAD_MAX_PATH];
+    Texture *texture;                       // Handle that is updated when job is done.
+    Texture_Decoded_Procedure procedure;    // NULL uploads pixels into texture of its own.
+
+    // Set by worker.
+    u8 *pixels;                             // RGBA, NULL if image couldn't be decoded or it is cooked.
+    Tex tex;                                // Cooked texture, data is NULL if image isn't cooked or couldn't be loaded.
+    s32 width;
+    s32 height;
+
+    // Set by main thread while uploading.
+    u32 id;
+    s32 rows_uploaded;
+    u32 levels_uploaded;                    // Cooked textures are uploaded by whole mip levels.
+} Texture_Load_Job;
+
+typedef struct texture_loads {
+    Texture_Load_Job jobs[TEXTURE_LOAD_QUEUE_SIZE];
+    u32 submitted;
+    u32 decoded;
+    u32 uploaded;
+
+    Thread worker;
+    bool worker_started;
+    Mutex mutex;
+    Condition job_submitted;
+
+    u32 pbo;                                // 0 if pixel buffers are not supported, rows are uploaded from memory then.
+
+    Texture_Load_Completion *completions;   // Array list.
+    u32 completions_read;
+} Texture_Loads;
+
+static Texture_Loads texture_loads = {
+    .mutex          = MUTEX_INIT,
+    .job_submitted  = CONDITION_INIT,
+};
+
+typedef struct texture_async {
+    char path[TEXTURE_LOAD_MAX_PATH];
+    Texture texture;
+} Texture_Async;
 
-    s32 quad_shader_samplers_loc = glGetUniformLocation(program->id, shader_uniform_samplers_name);
-    if (quad_shader_samplers_loc == -1) {
-        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_samplers_name, program->id);
+static Texture_Async texture_async[TEXTURE_LOAD_MAX_TEXTURES];
+static s32 texture_async_count = 0;
+
+static Texture placeholder_texture;
+
+
+static void texture_load_worker(void *data) {
+    (void)data;
+
+    mutex_lock(&texture_loads.mutex);
+    while (true) {
+        while (texture_loads.decoded == texture_loads.submitted) {
+            condition_wait(&texture_loads.job_submitted, &texture_loads.mutex, TEXTURE_LOAD_WAIT_MS);
+        }
+
+        // Slot isn't touched by main thread until it is decoded.
+        Texture_Load_Job *job = &texture_loads.jobs[texture_loads.decoded % TEXTURE_LOAD_QUEUE_SIZE];
+        mutex_unlock(&texture_loads.mutex);
+
+        if (texture_path_is_cooked(job->path)) {
+            (void)tex_load(job->path, &job->tex);
+        } else {
+            // Image that has up to date ".tex" next to it is loaded from there, so it isn't decoded and gets its mip levels.
+            // Unless ".tex" can't be used as it is, procedures take straight alpha RGBA8 and GL may not have S3TC, then image is decoded after all.
+            char cooked_path[TEXTURE_LOAD_MAX_PATH];
+            if (tex_cooked_path(job->path, cooked_path, sizeof(cooked_path)) && tex_load(cooked_path, &job->tex)) {
+                bool compressed = job->tex.header->format == TEX_FORMAT_BC3;
+                bool premultiplied = job->tex.header->flags & TEX_COOK_PREMULTIPLIED;
+                if (((compressed || premultiplied) && job->procedure != NULL) || (compressed && !GLEW_EXT_texture_compression_s3tc)) {
+                    tex_free(&job->tex);
+                }
+            }
+
+            if (job->tex.data == NULL) {
+                s32 channels;
+                job->pixels = stbi_load(job->path, &job->width, &job->height, &channels, 4);
+            }
+        }
+
+        if (job->tex.data != NULL) {
+            job->width = job->tex.header->width;
+            job->height = job->tex.header->height;
+        }
+
+        mutex_lock(&texture_loads.mutex);
+        texture_loads.decoded++;
     }
-    
-    // Set uniforms.
-    glUseProgram(program->id);
-    glUniformMatrix4fv(quad_shader_pr_matrix_loc, 1, GL_TRUE, shader_uniform_pr_matrix.array);
-    glUniformMatrix4fv(quad_shader_ml_matrix_loc, 1, GL_TRUE, shader_uniform_ml_matrix.array);
-    glUniform1iv(quad_shader_samplers_loc, 32, shader_uniform_samplers);
-    glUseProgram(0);
+    mutex_unlock(&texture_loads.mutex);
 }
 
-bool check_program(u32 id, char *shader_path) {
-    s32 is_linked = 0;
-    glGetProgramiv(id, GL_LINK_STATUS, &is_linked); 
-    if (is_linked == GL_FALSE) {
-        LOG_ERROR("Program of %s, failed to link.", shader_path);
-       
-        s32 info_log_length;
-        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &info_log_length);
-        char *buffer = malloc(info_log_length);
-        
-        s32 buffer_size;
-        glGetProgramInfoLog(id, info_log_length, &buffer_size, buffer);
-        (void)fprintf(stderr, "%s\n", buffer);
-        
-        free(buffer);
+Texture *texture_placeholder() {
+    if (placeholder_texture.id != 0) {
+        return &placeholder_texture;
+    }
 
-        return false;
-    } 
-    return true;
+    u8 pixel[4] = { 128, 128, 128, 255 };
+
+    glGenTextures(1, &placeholder_texture.id);
+    gl_bind_texture(GL_TEXTURE_2D, placeholder_texture.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+
+    placeholder_texture.width = 1;
+    placeholder_texture.height = 1;
+    placeholder_texture.region = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT };
+    placeholder_texture.distance_field = false;
+
+    return &placeholder_texture;
 }
 
-bool check_shader(u32 id, char *shader_path) {
-    s32 is_compiled = 0;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &is_compiled); 
-    if (is_compiled == GL_FALSE) {
-        LOG_ERROR("Shader of %s, failed to compile.", shader_path);
-        
-        s32 info_log_length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &info_log_length);
-        char *buffer = malloc(info_log_length);
-        
-        s32 buffer_size;
-        glGetShaderInfoLog(id, info_log_length, &buffer_size, buffer);
-        (void)fprintf(stderr, "%s\n", buffer);
-        
-        free(buffer);
+bool texture_decode_async(char *texture_path, Texture *texture, Texture_Decoded_Procedure procedure) {
+    if (strlen(texture_path) >= TEXTURE_LOAD_MAX_PATH) {
+        LOG_ERROR("Couldn't load image '%s' asynchronously, path is too long.", texture_path);
+        return false;
+    }
+
+    if (!texture_loads.worker_started) {
+        if (!thread_create(&texture_loads.worker, texture_load_worker, NULL)) { // @Leak
+            LOG_ERROR("Texture load worker could not be created, images are loaded synchronously.");
+            return false;
+        }
+        texture_loads.worker_started = true;
+        texture_loads.completions = array_list_make(Texture_Load_Completion, 16, &std_allocator); // @Leak
+
+        if (GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object) {
+            glGenBuffers(1, &texture_loads.pbo); // @Leak
+        }
+    }
 
+    // Only main thread submits, so slot can be filled before worker sees it.
+    if (texture_loads.submitted - texture_loads.uploaded >= TEXTURE_LOAD_QUEUE_SIZE) {
+        LOG_WARNING("Texture load queue is full, image '%s' is loaded synchronously.", texture_path);
         return false;
-    } 
+    }
+
+    Texture_Load_Job *job = &texture_loads.jobs[texture_loads.submitted % TEXTURE_LOAD_QUEUE_SIZE];
+    *job = (Texture_Load_Job) {
+        .texture    = texture,
+        .procedure  = procedure,
+    };
+    strcpy(job->path, texture_path);
+
+    mutex_lock(&texture_loads.mutex);
+    texture_loads.submitted++;
+    condition_signal(&texture_loads.job_submitted);
+    mutex_unlock(&texture_loads.mutex);
+
     return true;
 }
 
-s32 components_of(GLenum type) {
-    switch (type) {
-        case GL_FLOAT: return 1;
-        case GL_FLOAT_VEC2: return 2;
-        case GL_FLOAT_VEC3: return 3;
-        case GL_FLOAT_VEC4: return 4;
-        case GL_FLOAT_MAT4: return 16;
-        default: return 0;
+Texture *texture_load_async(char *texture_path) {
+    Texture_Async *entry = NULL;
+    for (s32 i = 0; i < texture_async_count; i++) {
+        if (strcmp(texture_async[i].path, texture_path) == 0) {
+            entry = &texture_async[i];
+            break;
+        }
     }
-}
 
-Shader shader_load(char *shader_path) {
-    Shader shader;
+    // New handles show placeholder, reloaded ones keep showing old image until new one is uploaded.
+    if (entry == NULL) {
+        if (texture_async_count >= TEXTURE_LOAD_MAX_TEXTURES || strlen(texture_path) >= TEXTURE_LOAD_MAX_PATH) {
+            LOG_ERROR("Couldn't load image '%s' asynchronously, too many textures or path is too long.", texture_path);
+            return NULL;
+        }
 
-    /**
-     * @Important: To avoid error while compiling glsl file we need to ensure that "#version ...\n" line comes before anything else in the final shader string. 
-     * That said, we can't just have "#define ...\n" come before version tag. 
+        entry = &texture_async[texture_async_count++];
+        strcpy(entry->path, texture_path);
+        entry->texture = *texture_placeholder();
+    }
+
+    if (!texture_decode_async(texture_path, &entry->texture, NULL)) {
+        Texture loaded = texture_load(texture_path);
+        if (entry->texture.id != placeholder_texture.id) {
+            texture_unload(&entry->texture);
+        }
+        entry->texture = loaded;
+    }
+
+    return &entry->texture;
+}
+
+/**
+ * Uploads rows of the image starting at "rows_uploaded", through pixel buffer if there is one.
+ */
+static void texture_upload_rows(Texture_Load_Job *job, s32 rows) {
+    u64 row_size = (u64)job->width * 4;
+    u8 *source = job->pixels + job->rows_uploaded * row_size;
+
+    gl_bind_texture(GL_TEXTURE_2D, job->id);
+
+    if (texture_loads.pbo != 0) {
+        // Orphaning, so rows that GL still copies from the previous storage are not waited on.
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, texture_loads.pbo);
+        gl_buffer_data(GL_PIXEL_UNPACK_BUFFER, rows * row_size, NULL, GL_STREAM_DRAW);
+
+        void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, rows * row_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped != NULL) {
+            memcpy(mapped, source, rows * row_size);
+            (void)glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job->rows_uploaded, job->width, rows, GL_RGBA, GL_UNSIGNED_BYTE, (void *)0);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            gl_bind_texture(GL_TEXTURE_2D, 0);
+            return;
+        }
+
+        LOG_WARNING("Couldn't map texture upload buffer, uploading from memory.");
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &texture_loads.pbo);
+        texture_loads.pbo = 0;
+    }
+
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job->rows_uploaded, job->width, rows, GL_RGBA, GL_UNSIGNED_BYTE, source);
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+}
+
+/**
+ * Uploads as many mip levels of cooked texture as budget allows, returns true when all levels are uploaded.
+ * Levels are already in a single buffer, so they are given to GL from memory, without pixel buffer.
+ */
+static bool texture_upload_cooked_job(Texture_Load_Job *job, u64 *budget) {
+    if (job->id == 0) {
+        glGenTextures(1, &job->id);
+    }
+
+    gl_bind_texture(GL_TEXTURE_2D, job->id);
+    if (job->levels_uploaded == 0) {
+        (void)texture_cooked_setup(&job->tex);
+    }
+
+    // At least one level per frame, so levels bigger than budget still finish.
+    while (job->levels_uploaded < job->tex.header->levels_count) {
+        u64 size = job->tex.header->levels[job->levels_uploaded].size;
+        if (size > *budget && *budget < TEXTURE_UPLOAD_BUDGET) {
+            break;
+        }
+
+        texture_cooked_level_upload(&job->tex, job->levels_uploaded++);
+        *budget -= mini(size, *budget);
+    }
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+
+    return job->levels_uploaded == job->tex.header->levels_count;
+}
+
+/**
+ * Uploads as many rows of the job as budget allows, returns true when image is fully uploaded.
+ */
+static bool texture_upload_job(Texture_Load_Job *job, u64 *budget) {
+    if (job->tex.data != NULL) {
+        return texture_upload_cooked_job(job, budget);
+    }
+
+    if (job->id == 0) {
+        glGenTextures(1, &job->id);
+        gl_bind_texture(GL_TEXTURE_2D, job->id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture_wrap_s);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture_wrap_t);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture_min_filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_max_filter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, job->width, job->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        gl_bind_texture(GL_TEXTURE_2D, 0);
+    }
+
+    // At least one row per frame, so rows wider than budget still finish.
+    u64 row_size = (u64)job->width * 4;
+    s32 rows = mini(job->height - job->rows_uploaded, maxi(*budget / row_size, *budget == TEXTURE_UPLOAD_BUDGET));
+    if (rows == 0) {
+        return false;
+    }
+
+    texture_upload_rows(job, rows);
+    job->rows_uploaded += rows;
+    *budget -= mini(rows * row_size, *budget);
+
+    return job->rows_uploaded == job->height;
+}
+
+static void texture_load_job_free(Texture_Load_Job *job) {
+    if (job->pixels != NULL) {
+        stbi_image_free(job->pixels);
+        job->pixels = NULL;
+    }
+    tex_free(&job->tex);
+}
+
+static void texture_load_complete(Texture_Load_Job *job, bool failed) {
+    Texture_Load_Completion completion = {
+        .texture    = job->texture,
+        .failed     = failed,
+    };
+    strcpy(completion.path, job->path);
+    array_list_append(&texture_loads.completions, completion);
+}
+
+@Profile;
+void texture_loads_update() {
+    if (!texture_loads.worker_started) {
+        return;
+    }
+
+    mutex_lock(&texture_loads.mutex);
+    u32 decoded = texture_loads.decoded;
+    mutex_unlock(&texture_loads.mutex);
+
+    u64 budget = TEXTURE_UPLOAD_BUDGET;
+    while (texture_loads.uploaded != decoded && budget > 0) {
+        Texture_Load_Job *job = &texture_loads.jobs[texture_loads.uploaded % TEXTURE_LOAD_QUEUE_SIZE];
+
+        bool unsupported = job->tex.data != NULL && job->tex.header->format == TEX_FORMAT_BC3
+                        && (job->procedure != NULL || !GLEW_EXT_texture_compression_s3tc);
+
+        if ((job->pixels == NULL && job->tex.data == NULL) || unsupported) {
+            if (unsupported) {
+                LOG_ERROR("Cooked texture '%s' is BC3 compressed, which GL or atlas doesn't support, it should be cooked without compression.", job->path);
+            } else {
+                LOG_ERROR("Couldn't load image '%s'.", job->path);
+            }
+            if (job->procedure != NULL) {
+                job->procedure(job->texture, job->path, NULL, 0, 0);
+            }
+            texture_load_job_free(job);
+            texture_load_complete(job, true);
+            texture_loads.uploaded++;
+            continue;
+        }
+
+        if (job->procedure != NULL) {
+            // Procedure takes pixels of the biggest level of cooked texture.
+            u8 *pixels = job->pixels != NULL ? job->pixels : tex_level_data(&job->tex, 0);
+
+            // Procedure uploads whole image at once, so it waits for the next frame unless it is the first upload of this one.
+            u64 size = (u64)job->width * job->height * 4;
+            if (size > budget && budget < TEXTURE_UPLOAD_BUDGET) {
+                break;
+            }
+
+            job->procedure(job->texture, job->path, pixels, job->width, job->height);
+            budget -= mini(size, budget);
+        } else {
+            if (!texture_upload_job(job, &budget)) {
+                break;
+            }
+
+            // Commands of the frame in flight hold the old id, "texture_unload()" waits for them.
+            if (job->texture->id != placeholder_texture.id) {
+                texture_unload(job->texture);
+            }
+
+            job->texture->id = job->id;
+            job->texture->width = job->width;
+            job->texture->height = job->height;
+            job->texture->region = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT };
+        }
+
+        texture_load_job_free(job);
+        texture_load_complete(job, false);
+        texture_loads.uploaded++;
+    }
+}
+
+bool texture_load_completed(Texture_Load_Completion *completion) {
+    if (texture_loads.completions == NULL || texture_loads.completions_read == array_list_length(&texture_loads.completions)) {
+        return false;
+    }
+
+    *completion = texture_loads.completions[texture_loads.completions_read++];
+
+    if (texture_loads.completions_read == array_list_length(&texture_loads.completions)) {
+        array_list_clear(&texture_loads.completions);
+        texture_loads.completions_read = 0;
+    }
+    return true;
+}
+
+u32 texture_loads_pending() {
+    return texture_loads.submitted - texture_loads.uploaded;
+}
+
+
+
+
+/**
+ * Glyph cache.
+ */
+
+#define GLYPH_PAGE_HEIGHT (GLYPH_CACHE_SIZE / GLYPH_CACHE_PAGES)
+#define GLYPH_PADDING 1     // Empty border around each glyph, so linear filtering doesn't bleed neighbours in.
+
+typedef struct font_face {
+    char            path[256];
+    u8              *data;
+    stbtt_fontinfo  info;
+} Font_Face;
+
+typedef struct glyph_entry {
+    u64     key;            // 0 is empty entry.
+    s32     page;           // -1 if glyph has no pixels.
+    s16     x;              // Top left pixel of the glyph on cache texture, rows go from top of the glyph down.
+    s16     y;
+    s16     width;
+    s16     height;
+    s16     x_offset;       // From pen position to top left of the glyph, y goes down, same as stbtt.
+    s16     y_offset;
+    float   xadvance;       // At the size glyph was rasterized.
+} Glyph_Entry;
+
+typedef struct glyph_page {
+    Skyline skyline;
+    u64     last_used;      // Frame page was last drawn from.
+    u32     glyphs_count;
+} Glyph_Page;
+
+typedef struct glyph_cache {
+    Texture     texture;
+    Glyph_Page  pages[GLYPH_CACHE_PAGES];
+    Glyph_Entry entries[GLYPH_CACHE_CAPACITY];  // Open addressing table, power of two capacity.
+    u32         entries_count;
+    u32         generation;                     // Incremented when page is cleared.
+} Glyph_Cache;
+
+static Font_Face font_faces[FONT_MAX_FACES];
+static s32 font_faces_count;
+
+static Glyph_Cache *glyph_caches[2]; // Coverage and distance field caches, made when first glyph of the kind is needed. @Leak
+static u64 glyph_cache_frame = 1;
+static u64 glyph_cache_warned_frame;
+
+static Glyph_Cache *glyph_cache_get(bool distance_field) {
+    Glyph_Cache **cache = &glyph_caches[distance_field ? 1 : 0];
+    if (*cache != NULL) {
+        return *cache;
+    }
+
+    *cache = calloc(1, sizeof(Glyph_Cache));
+
+    for (s32 i = 0; i < GLYPH_CACHE_PAGES; i++) {
+        skyline_init(&(*cache)->pages[i].skyline, GLYPH_CACHE_SIZE, GLYPH_PAGE_HEIGHT);
+    }
+
+    Texture *texture = &(*cache)->texture;
+    texture->width          = GLYPH_CACHE_SIZE;
+    texture->height         = GLYPH_CACHE_SIZE;
+    texture->region         = (UV_Region) { VEC2F_ORIGIN, VEC2F_UNIT };
+    texture->distance_field = distance_field;
+
+    u8 *pixels = calloc(GLYPH_CACHE_SIZE * GLYPH_CACHE_SIZE, sizeof(u8));
+
+    glGenTextures(1, &texture->id);
+    gl_bind_texture(GL_TEXTURE_2D, texture->id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture_wrap_s);	
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture_wrap_t);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture_min_filter);  
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_max_filter);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, GLYPH_CACHE_SIZE, GLYPH_CACHE_SIZE, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+
+    free(pixels);
+
+    return *cache;
+}
+
+static u64 glyph_key(Font_Baked *font, u32 codepoint) {
+    // Distance field glyphs are the same for every size, so size part of the key is 0 for them.
+    u64 size = font->distance_field ? 0 : (u64)(font->size * 4.0f) & 0xFFFFFF;
+    return ((u64)(font->face + 1) << 56) | (size << 32) | codepoint;
+}
+
+static Glyph_Entry *glyph_cache_slot(Glyph_Cache *cache, u64 key) {
+    u32 index = (u32)((key * 0x9E3779B97F4A7C15ull) >> 40) & (GLYPH_CACHE_CAPACITY - 1);
+    while (cache->entries[index].key != 0 && cache->entries[index].key != key) {
+        index = (index + 1) & (GLYPH_CACHE_CAPACITY - 1);
+    }
+    return &cache->entries[index];
+}
+
+/**
+ * Clears page and removes its glyphs from the table, glyphs without pixels are removed too since they are cheap to get again.
+ * Table is rebuilt, since open addressing table can't just remove entries.
+ */
+static void glyph_cache_evict(Glyph_Cache *cache, s32 page) {
+    static Glyph_Entry kept[GLYPH_CACHE_CAPACITY];
+    u32 kept_count = 0;
+
+    for (u32 i = 0; i < GLYPH_CACHE_CAPACITY; i++) {
+        Glyph_Entry *entry = &cache->entries[i];
+        if (entry->key != 0 && entry->page != page && entry->page != -1) {
+            kept[kept_count] = *entry;
+            kept_count++;
+        }
+    }
+
+    memset(cache->entries, 0, sizeof(cache->entries));
+    for (u32 i = 0; i < kept_count; i++) {
+        *glyph_cache_slot(cache, kept[i].key) = kept[i];
+    }
+    cache->entries_count = kept_count;
+
+    skyline_init(&cache->pages[page].skyline, GLYPH_CACHE_SIZE, GLYPH_PAGE_HEIGHT);
+    cache->pages[page].glyphs_count = 0;
+    cache->generation++;
+}
+
+/**
+ * Returns least recently used page that wasn't used by this or previous frame, or -1.
+ * Previous frame can still be drawn by render thread while this one is built, so its pages are kept too.
+ * If "non_empty" is true pages without glyphs are skipped, since clearing them doesn't free table entries.
+ */
+static s32 glyph_cache_lru_page(Glyph_Cache *cache, bool non_empty) {
+    s32 result = -1;
+    for (s32 i = 0; i < GLYPH_CACHE_PAGES; i++) {
+        if (cache->pages[i].last_used + 1 >= glyph_cache_frame || (non_empty && cache->pages[i].glyphs_count == 0)) {
+            continue;
+        }
+        if (result == -1 || cache->pages[i].last_used < cache->pages[result].last_used) {
+            result = i;
+        }
+    }
+    return result;
+}
+
+/**
+ * Finds place for the glyph on one of the pages, clearing least recently used page if glyph doesn't fit anywhere.
+ * Returns page index or -1.
+ */
+static s32 glyph_cache_pack(Glyph_Cache *cache, s32 width, s32 height, s32 *x, s32 *y) {
+    for (s32 i = 0; i < GLYPH_CACHE_PAGES; i++) {
+        if (skyline_pack(&cache->pages[i].skyline, width, height, x, y)) {
+            return i;
+        }
+    }
+
+    s32 page = glyph_cache_lru_page(cache, false);
+    if (page == -1) {
+        return -1;
+    }
+
+    glyph_cache_evict(cache, page);
+    if (skyline_pack(&cache->pages[page].skyline, width, height, x, y)) {
+        return page;
+    }
+
+    return -1;
+}
+
+/**
+ * Rasterizes glyph into the cache and fills the entry, entry page is -1 if glyph has no pixels.
+ * Returns false if glyph couldn't be packed, then it shouldn't be kept in the table so it is tried again next time.
+ */
+static bool glyph_cache_rasterize(Glyph_Cache *cache, Font_Baked *font, u32 codepoint, Glyph_Entry *entry) {
+    stbtt_fontinfo *info = &font_faces[font->face].info;
+
+    float scale = font->distance_field ? stbtt_ScaleForPixelHeight(info, GLYPH_DISTANCE_FIELD_SIZE) : font->scale;
+
+    s32 advance, left_side_bearing;
+    stbtt_GetCodepointHMetrics(info, (s32)codepoint, &advance, &left_side_bearing);
+    entry->xadvance = (float)advance * scale;
+    entry->page = -1;
+
+    // Rasterizing into buffer with empty border.
+    s32 width, height, x_offset, y_offset;
+    u8 *pixels = NULL;
+    u8 *sdf = NULL;
+    if (font->distance_field) {
+        sdf = stbtt_GetCodepointSDF(info, scale, (s32)codepoint, GLYPH_DISTANCE_FIELD_PADDING, 128, 128.0f / (float)GLYPH_DISTANCE_FIELD_PADDING, &width, &height, &x_offset, &y_offset);
+        if (sdf == NULL) {
+            return true;
+        }
+    }
+    else {
+        s32 x0, y0, x1, y1;
+        stbtt_GetCodepointBitmapBox(info, (s32)codepoint, scale, scale, &x0, &y0, &x1, &y1);
+        width = x1 - x0;
+        height = y1 - y0;
+        x_offset = x0;
+        y_offset = y0;
+        if (width <= 0 || height <= 0) {
+            return true;
+        }
+    }
+
+    s32 padded_width = width + GLYPH_PADDING * 2;
+    s32 padded_height = height + GLYPH_PADDING * 2;
+    pixels = calloc(padded_width * padded_height, sizeof(u8));
+    u8 *inner = pixels + GLYPH_PADDING * padded_width + GLYPH_PADDING;
+
+    if (font->distance_field) {
+        for (s32 row = 0; row < height; row++) {
+            memcpy(inner + row * padded_width, sdf + row * width, width);
+        }
+        stbtt_FreeSDF(sdf, NULL);
+    }
+    else {
+        stbtt_MakeCodepointBitmap(info, inner, width, height, padded_width, scale, scale, (s32)codepoint);
+    }
+
+    s32 x, y;
+    s32 page = glyph_cache_pack(cache, padded_width, padded_height, &x, &y);
+    if (page == -1) {
+        if (glyph_cache_warned_frame != glyph_cache_frame) {
+            LOG_WARNING("Glyph cache is full, glyph %u of size %.1f is not drawn.", codepoint, font->size);
+            glyph_cache_warned_frame = glyph_cache_frame;
+        }
+        free(pixels);
+        return false;
+    }
+
+    y += page * GLYPH_PAGE_HEIGHT;
+
+    gl_bind_texture(GL_TEXTURE_2D, cache->texture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, padded_width, padded_height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl_bind_texture(GL_TEXTURE_2D, 0);
+    texture_changed(cache->texture.id);
+
+    free(pixels);
+
+    cache->pages[page].glyphs_count++;
+
+    entry->page     = page;
+    entry->x        = (s16)(x + GLYPH_PADDING);
+    entry->y        = (s16)(y + GLYPH_PADDING);
+    entry->width    = (s16)width;
+    entry->height   = (s16)height;
+    entry->x_offset = (s16)x_offset;
+    entry->y_offset = (s16)y_offset;
+
+    return true;
+}
+
+Glyph font_glyph(Font_Baked *font, u32 codepoint) {
+    if (font->face < 0) {
+        return (Glyph) {0};
+    }
+
+    Glyph_Cache *cache = glyph_cache_get(font->distance_field);
+    u64 key = glyph_key(font, codepoint);
+
+    // Distance field glyphs are rasterized at one size and scaled.
+    float scale = font->distance_field ? font->size / GLYPH_DISTANCE_FIELD_SIZE : 1.0f;
+
+    Glyph_Entry *entry = glyph_cache_slot(cache, key);
+    if (entry->key == 0) {
+        // Keeping table at most 3/4 full, so probing stays short.
+        if (cache->entries_count >= GLYPH_CACHE_CAPACITY / 4 * 3) {
+            s32 page = glyph_cache_lru_page(cache, true);
+            if (page == -1) {
+                return (Glyph) { .missing = true };
+            }
+            glyph_cache_evict(cache, page);
+        }
+
+        Glyph_Entry rasterized = { .key = key };
+        if (!glyph_cache_rasterize(cache, font, codepoint, &rasterized)) {
+            return (Glyph) { .xadvance = rasterized.xadvance * scale, .missing = true };
+        }
+
+        // Rasterizing could have evicted a page, so the slot is looked up again.
+        entry = glyph_cache_slot(cache, key);
+        *entry = rasterized;
+        cache->entries_count++;
+    }
+
+    Glyph result = {
+        .xadvance = entry->xadvance * scale,
+    };
+
+    if (entry->page == -1) {
+        return result;
+    }
+
+    cache->pages[entry->page].last_used = glyph_cache_frame;
+
+    float inverse_size = 1.0f / (float)GLYPH_CACHE_SIZE;
+    result.texture = &cache->texture;
+    result.page = (u8)entry->page;
+    result.uv = (UV_Region) {
+        .uv0 = vec2f_make((float)entry->x * inverse_size, (float)(entry->y + entry->height) * inverse_size),
+        .uv1 = vec2f_make((float)(entry->x + entry->width) * inverse_size, (float)entry->y * inverse_size),
+    };
+    result.offset = vec2f_make((float)entry->x_offset * scale, (float)(-entry->y_offset - entry->height) * scale);
+    result.size = vec2f_make((float)entry->width * scale, (float)entry->height * scale);
+
+    return result;
+}
+
+Texture *font_cache_pin(Font_Baked *font) {
+    if (font->face < 0) {
+        return NULL;
+    }
+
+    Glyph_Cache *cache = glyph_cache_get(font->distance_field);
+    for (s32 i = 0; i < GLYPH_CACHE_PAGES; i++) {
+        cache->pages[i].last_used = glyph_cache_frame;
+    }
+    return &cache->texture;
+}
+
+void font_cache_touch(Font_Baked *font, u32 pages) {
+    if (font->face < 0) {
+        return;
+    }
+
+    Glyph_Cache *cache = glyph_cache_get(font->distance_field);
+    for (s32 i = 0; i < GLYPH_CACHE_PAGES; i++) {
+        if (pages & (1u << i)) {
+            cache->pages[i].last_used = glyph_cache_frame;
+        }
+    }
+}
+
+u32 font_cache_generation(Font_Baked *font) {
+    if (font->face < 0) {
+        return 0;
+    }
+
+    return glyph_cache_get(font->distance_field)->generation;
+}
+
+
+const char *shader_uniform_pr_matrix_name = "pr_matrix";
+const char *shader_uniform_ml_matrix_name = "ml_matrix";
+const char *shader_uniform_samplers_name = "u_textures";
+
+/**
+ * @Temporary: Later, setting uniforms either will be done more automatically, or simplified to be done by user manually. 
+ * But right now it is not neccassary to care about too much, since only one shader is used anyway.
+ */
+/**
+ * Projection uniforms.
+ * Remembers last projection uploaded to each program, so same projection is not uploaded again every draw.
+ */
+
+#define PROJECTION_CACHE_SIZE 16
+
+typedef struct projection_cache_entry {
+    u32 program;
+    Matrix4f projection;
+} Projection_Cache_Entry;
+
+static Projection_Cache_Entry projection_cache[PROJECTION_CACHE_SIZE];
+
+static Projection_Cache_Entry *projection_cache_find(u32 program) {
+    for (u32 i = 0; i < PROJECTION_CACHE_SIZE; i++) {
+        if (projection_cache[i].program == program) {
+            return projection_cache + i;
+        }
+    }
+    return NULL;
+}
+
+static void projection_cache_set(u32 program, Matrix4f *projection) {
+    Projection_Cache_Entry *entry = projection_cache_find(program);
+    if (entry == NULL) {
+        entry = projection_cache_find(0);
+    }
+    if (entry == NULL) {
+        // Cache is full, evicted entry will just be uploaded again.
+        entry = projection_cache + program % PROJECTION_CACHE_SIZE;
+    }
+
+    entry->program = program;
+    entry->projection = *projection;
+}
+
+static bool projection_uploaded(u32 program, Matrix4f *projection) {
+    Projection_Cache_Entry *entry = projection_cache_find(program);
+    return entry != NULL && memcmp(&entry->projection, projection, sizeof(Matrix4f)) == 0;
+}
+
+/**
+ * Uploads projection to the program, program should be in use.
+ * Returns true if uniform was actually uploaded.
+ */
+static bool projection_upload(Shader *shader, Matrix4f *projection) {
+    if (projection_uploaded(shader->id, projection)) {
+        return false;
+    }
+
+    s32 location = glGetUniformLocation(shader->id, shader_uniform_pr_matrix_name);
+    if (location == -1) {
+        LOG_ERROR("Couldn't get location of %s uniform, in shader, when updating projection.", shader_uniform_pr_matrix_name);
+    }
+
+    gl_uniform_matrix4fv(location, 1, GL_TRUE, projection->array);
+    projection_cache_set(shader->id, projection);
+    return true;
+}
+
+
+
+
+
+void shader_init_uniforms(Shader *program) {
+    // Get uniform's locations based on unifrom's name.
+    s32 quad_shader_pr_matrix_loc = glGetUniformLocation(program->id, shader_uniform_pr_matrix_name);
+    if (quad_shader_pr_matrix_loc == -1) {
+        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_pr_matrix_name, program->id);
+    }
+
+    s32 quad_shader_ml_matrix_loc = glGetUniformLocation(program->id, shader_uniform_ml_matrix_name);
+    if (quad_shader_ml_matrix_loc == -1) {
+        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_ml_matrix_name, program->id);
+    }
+
+    s32 quad_shader_samplers_loc = glGetUniformLocation(program->id, shader_uniform_samplers_name);
+    if (quad_shader_samplers_loc == -1) {
+        LOG_WARNING("Couldn't get location of %s uniform, in shader with id: %d.", shader_uniform_samplers_name, program->id);
+    }
+    
+    // Set uniforms.
+    gl_use_program(program->id);
+    gl_uniform_matrix4fv(quad_shader_pr_matrix_loc, 1, GL_TRUE, shader_uniform_pr_matrix.array);
+    gl_uniform_matrix4fv(quad_shader_ml_matrix_loc, 1, GL_TRUE, shader_uniform_ml_matrix.array);
+    gl_uniform1iv(quad_shader_samplers_loc, 32, shader_uniform_samplers);
+    gl_use_program(0);
+
+    program->projection = shader_uniform_pr_matrix;
+    projection_cache_set(program->id, &shader_uniform_pr_matrix);
+}
+
+bool check_program(u32 id, char *shader_path) {
+    s32 is_linked = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &is_linked); 
+    if (is_linked == GL_FALSE) {
+        LOG_ERROR("Program of %s, failed to link.", shader_path);
+       
+        s32 info_log_length;
+        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &info_log_length);
+        char *buffer = malloc(info_log_length);
+        
+        s32 buffer_size;
+        glGetProgramInfoLog(id, info_log_length, &buffer_size, buffer);
+        (void)fprintf(stderr, "%s\n", buffer);
+        
+        free(buffer);
+
+        return false;
+    } 
+    return true;
+}
+
+bool check_shader(u32 id, char *shader_path) {
+    s32 is_compiled = 0;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &is_compiled); 
+    if (is_compiled == GL_FALSE) {
+        LOG_ERROR("Shader of %s, failed to compile.", shader_path);
+        
+        s32 info_log_length;
+        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &info_log_length);
+        char *buffer = malloc(info_log_length);
+        
+        s32 buffer_size;
+        glGetShaderInfoLog(id, info_log_length, &buffer_size, buffer);
+        (void)fprintf(stderr, "%s\n", buffer);
+        
+        free(buffer);
+
+        return false;
+    } 
+    return true;
+}
+
+s32 components_of(GLenum type) {
+    switch (type) {
+        case GL_FLOAT: return 1;
+        case GL_FLOAT_VEC2: return 2;
+        case GL_FLOAT_VEC3: return 3;
+        case GL_FLOAT_VEC4: return 4;
+        case GL_FLOAT_MAT4: return 16;
+        default: return 0;
+    }
+}
+
+typedef struct attribute_packing {
+    char *name;
+    GLenum component_type;
+    bool normalized;
+    u32 component_size;
+} Attribute_Packing;
+
+static const Attribute_Packing attribute_packings[] = {
+    { "unorm8",     GL_UNSIGNED_BYTE,   true,   1 },
+    { "unorm16",    GL_UNSIGNED_SHORT,  true,   2 },
+    { "u8",         GL_UNSIGNED_BYTE,   false,  1 },
+    { "u16",        GL_UNSIGNED_SHORT,  false,  2 },
+};
+
+static String attribute_packed_note = CSTR("@Packed:");
+static String shader_instanced_note = CSTR("@Instanced.");
+
+/**
+ * Finds line that declares vertex input with attribute name in the shader source and returns packing from it's "@Packed" note.
+ * Returns NULL if attribute isn't packed.
+ */
+static const Attribute_Packing *attribute_find_packing(String shader_source, char *attribute_name, char *shader_path) {
+    char _buffer[MAX_ATTRIBUTE_NAME_LENGTH + 2];
+    s32 length = snprintf(_buffer, sizeof(_buffer), " %s;", attribute_name);
+    String declaration = STR(length, _buffer);
+
+    String rest = shader_source;
+    s64 index;
+    while ((index = str_find(rest, declaration)) != -1) {
+        s64 line_start = str_find_char_right(str_substring(rest, 0, index), '\n') + 1;
+        s64 line_end = str_find_char_left(str_substring(rest, index, rest.length), '\n');
+        line_end = line_end == -1 ? rest.length : index + line_end;
+
+        String line = str_substring(rest, line_start, line_end);
+        rest = str_substring(rest, line_end, rest.length);
+
+        // Fragment outputs and varyings can have the same name.
+        String trimmed = str_eat_spaces(line);
+        if (str_find(line, CSTR(" in ")) == -1 && str_find(trimmed, CSTR("in ")) != 0) {
+            continue;
+        }
+
+        s64 note = str_find(line, attribute_packed_note);
+        if (note == -1) {
+            return NULL;
+        }
+
+        String kind = str_eat_spaces(str_substring(line, note + attribute_packed_note.length, line.length));
+        s64 kind_end = 0;
+        while (kind_end < kind.length && ((kind.data[kind_end] >= 'a' && kind.data[kind_end] <= 'z') || (kind.data[kind_end] >= '0' && kind.data[kind_end] <= '9'))) {
+            kind_end++;
+        }
+        kind = str_substring(kind, 0, kind_end);
+
+        for (u32 i = 0; i < sizeof(attribute_packings) / sizeof(attribute_packings[0]); i++) {
+            if (str_equals(kind, CSTR(attribute_packings[i].name))) {
+                return &attribute_packings[i];
+            }
+        }
+
+        LOG_WARNING("Shader of %s, has unknown packing '%.*s' of attribute '%s', it is read as float.", shader_path, UNPACK(kind), attribute_name);
+        return NULL;
+    }
+
+    return NULL;
+}
+
+Shader shader_load(char *shader_path) {
+    Shader shader;
+
+    /**
+     * @Important: To avoid error while compiling glsl file we need to ensure that "#version ...\n" line comes before anything else in the final shader string. 
+     * That said, we can't just have "#define ...\n" come before version tag. 
      * Therefore we split original shader source on it's shader version part that consists of single "#version ...\n" line, and rest of the shader code that comes after.
      * And finally we insert "define ...\n" part in between these two substrings.
      */
 
-    // Getting full shader file.
-    String shader_source = read_file_into_str(shader_path, &std_allocator);
+    // Getting full shader file.
+    String shader_source = read_file_into_str(shader_path, &std_allocator);
+    
+    // Splitting on two substrings, "shader_version" and "shader_code".
+    s64 start_of_version_tag = str_find(shader_source, shader_version_tag);
+    s64 end_of_version_tag   = str_find_char_left(
+            str_substring(shader_source, start_of_version_tag, shader_source.length), '\n');
+
+    String shader_version    = str_substring(shader_source, start_of_version_tag, end_of_version_tag + 1);
+    String shader_code       = str_substring(shader_source, end_of_version_tag + 1, shader_source.length);
+    
+    // Passing all parts in the respective shader sources, where defines inserted between version and code parts.
+    const char *vertex_shader_source[3] = { shader_version.data, vertex_shader_defines.data, shader_code.data };
+    const char *fragment_shader_source[3] = { shader_version.data, fragment_shader_defines.data, shader_code.data };
+    
+    /**
+     * Specifying lengths, because we don't pass null terminated strings.
+     * @Important: Since defines length depends on whether we are loading vertex or fragment shader, we set it's length values separately when loading each.
+     */
+    shader_strings_lengths[0] = shader_version.length;
+    shader_strings_lengths[2] = shader_code.length;
+    
+
+    shader_strings_lengths[1] = vertex_shader_defines.length;
+    u32 vertex_shader;
+    vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertex_shader, 3, vertex_shader_source, shader_strings_lengths);
+    glCompileShader(vertex_shader);
+    
+    // Check results for errors.
+    if (!check_shader(vertex_shader, shader_path)) {
+        allocator_free(&std_allocator, shader_source.data);
+        return (Shader) {0};
+    }
+
+    shader_strings_lengths[1] = fragment_shader_defines.length;
+    u32 fragment_shader;
+    fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragment_shader, 3, fragment_shader_source, shader_strings_lengths);
+    glCompileShader(fragment_shader);
+    
+    // Check results for errors.
+    if (!check_shader(fragment_shader, shader_path)) {
+        allocator_free(&std_allocator, shader_source.data);
+        return (Shader) {0};
+    }
+    
+
+
+    shader.id = glCreateProgram();
+
+    glAttachShader(shader.id, vertex_shader);
+    glAttachShader(shader.id, fragment_shader);
+    glLinkProgram(shader.id);
+    
+    // Check results for errors.
+    if (!check_program(shader.id, shader_path)) {
+        allocator_free(&std_allocator, shader_source.data);
+        return (Shader) {0};
+    }
+
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+    
+
+    // Cache all attributes in shader based on shader location as index.
+    shader.attributes_count = 0;
+    shader.vertex_stride = 0;
+    glGetProgramiv(shader.id, GL_ACTIVE_ATTRIBUTES, &shader.attributes_count);
+
+    if (shader.attributes_count > MAX_ATTRIBUTES_PER_SHADER) {
+        LOG_ERROR("Shader of %s, exceeded maximum attributes per shader limit on loading.", shader_path);
+        allocator_free(&std_allocator, shader_source.data);
+        return (Shader) {0};
+    }
+    
+    Attribute attribute;
+    u32 component_sizes[MAX_ATTRIBUTES_PER_SHADER];
+    for (s32 i = 0; i < shader.attributes_count; i++) {
+        glGetActiveAttrib(shader.id, i, MAX_ATTRIBUTE_NAME_LENGTH, NULL, &attribute.length, &attribute.type, attribute.name);
+        attribute.components = components_of(attribute.type);
+
+        const Attribute_Packing *packing = attribute_find_packing(shader_source, attribute.name, shader_path);
+        attribute.component_type = packing != NULL ? packing->component_type : ATTRIBUTE_COMPONENT_TYPE;
+        attribute.normalized = packing != NULL ? packing->normalized : false;
+
+        s32 location = glGetAttribLocation(shader.id, attribute.name);
+        shader.attributes[location] = attribute;
+        component_sizes[location] = packing != NULL ? packing->component_size : ATTRIBUTE_COMPONENT_SIZE;
+    }
+
+    shader.instanced = str_find(shader_source, shader_instanced_note) != -1;
+
+    allocator_free(&std_allocator, shader_source.data);
+
+    // Offsets go in location order, since that is the order verticies are written in.
+    u32 offset = 0;
+    for (s32 i = 0; i < shader.attributes_count; i++) {
+        offset = (offset + component_sizes[i] - 1) / component_sizes[i] * component_sizes[i];
+        shader.attributes[i].offset = offset;
+        offset += shader.attributes[i].components * component_sizes[i];
+    }
+    shader.vertex_stride = (offset + ATTRIBUTE_COMPONENT_SIZE - 1) / ATTRIBUTE_COMPONENT_SIZE;
+
     
-    // Splitting on two substrings, "shader_version" and "shader_code".
-    s64 start_of_version_tag = str_find(shader_source, shader_version_tag);
-    s64 end_of_version_tag   = str_find_char_left(
-            str_substring(shader_source, start_of_version_tag, shader_source.length), '\n');
 
-    String shader_version    = str_substring(shader_source, start_of_version_tag, end_of_version_tag + 1);
-    String shader_code       = str_substring(shader_source, end_of_version_tag + 1, shader_source.length);
+    return shader;
+}
+
+void shader_unload(Shader *shader) {
+    render_thread_wait();
+    gl_use_program(0);
+    glDeleteProgram(shader->id);
+
+    // Id can be given to the next program, which will start with its own uniforms.
+    Projection_Cache_Entry *entry = projection_cache_find(shader->id);
+    if (entry != NULL) {
+        entry->program = 0;
+    }
     
-    // Passing all parts in the respective shader sources, where defines inserted between version and code parts.
-    const char *vertex_shader_source[3] = { shader_version.data, vertex_shader_defines.data, shader_code.data };
-    const char *fragment_shader_source[3] = { shader_version.data, fragment_shader_defines.data, shader_code.data };
+    shader->id = 0;
+    shader->vertex_stride = 0;
+}
+
+
+Camera camera_make(Vec2f center, s32 unit_scale) {
+    return (Camera) {
+        .center = center,
+        .unit_scale = unit_scale,
+    };
+}
+
+Matrix4f camera_calculate_projection(Camera *camera, float window_width, float window_height) {
+    float camera_width_offset = (window_width / (float) camera->unit_scale) / 2;
+    float camera_height_offset = (window_height / (float) camera->unit_scale) / 2;
+    return matrix4f_orthographic(camera->center.x - camera_width_offset, camera->center.x + camera_width_offset, camera->center.y - camera_height_offset, camera->center.y + camera_height_offset, -1.0f, 1.0f);
+}
+
+Vec2f screen_to_camera(Vec2f screen_position, Camera *camera, float window_width, float window_height) {
+    return vec2f_sum(vec2f_divide_constant(vec2f_difference(screen_position, vec2f_make(window_width / 2.0f, window_height / 2.0f)), camera->unit_scale), camera->center);
+}
+
+AABB camera_view_aabb(Camera *camera, float window_width, float window_height) {
+    Vec2f half = vec2f_make(window_width * 0.5f / (float)camera->unit_scale, window_height * 0.5f / (float)camera->unit_scale);
+    return aabb_make(vec2f_difference(camera->center, half), vec2f_sum(camera->center, half));
+}
+
+
+void shader_update_projection(Shader *shader, Matrix4f *projection) {
+    shader->projection = *projection;
+}
+
+
+
+u8 texture_ids_filled_length = 0;
+
+Vec2f texture_uv(Texture *texture, Vec2f uv) {
+    return vec2f_make(
+            texture->region.uv0.x + (texture->region.uv1.x - texture->region.uv0.x) * uv.x,
+            texture->region.uv0.y + (texture->region.uv1.y - texture->region.uv0.y) * uv.y);
+}
+
+// List the calling thread records into, NULL draws into the default vertex buffer.
+static _Thread_local Draw_List *thread_draw_list = NULL;
+
+float add_texture_to_slots(Texture *texture) {
+    // Threads that record draw lists have slots of their own.
+    u32 *slots = texture_ids;
+    u8 *slots_count = &texture_ids_filled_length;
+    if (thread_draw_list != NULL) {
+        slots = thread_draw_list->textures;
+        slots_count = &thread_draw_list->textures_count;
+    }
+
+    // Consecutive quads mostly use the same texture, especially with atlas, so last slot is checked first.
+    static _Thread_local u8 last_slot = 0;
+    if (last_slot < *slots_count && slots[last_slot] == texture->id) {
+        return last_slot;
+    }
+
+    for (u8 i = 0; i < *slots_count; i++) {
+        if (slots[i] == texture->id) {
+            last_slot = i;
+            return i;
+        }
+    }
+    if (*slots_count < 32) {
+        slots[*slots_count] = texture->id;
+        (*slots_count)++;
+        last_slot = *slots_count - 1;
+        return last_slot;
+    }
+    LOG_ERROR("Overflow of 32 texture slots limit, can't add texture id: %d, to current draw call texture slots.", texture->id);
+    return -1.0f;
+}
+
+u32 vertex_pack_color(Vec4f color) {
+    u32 r = (u32)(clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 g = (u32)(clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 b = (u32)(clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+    u32 a = (u32)(clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+    // Bytes in memory go r, g, b, a, same as the attribute components.
+    return r | g << 8 | b << 16 | a << 24;
+}
+
+u16 vertex_pack_unorm16(float value) {
+    return (u16)(clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+u8 vertex_pack_slot(float slot) {
+    return slot < 0.0f ? VERTEX_SLOT_NONE : (u8)slot;
+}
+
+u8 vertex_pack_mask_slot(Texture *mask) {
+    if (mask == NULL) {
+        return VERTEX_SLOT_NONE;
+    }
+
+    u8 slot = vertex_pack_slot(add_texture_to_slots(mask));
+    if (slot != VERTEX_SLOT_NONE && mask->distance_field) {
+        slot |= VERTEX_SLOT_DISTANCE_FIELD;
+    }
+    return slot;
+}
+
+
+
+
+/**
+ * Points attributes of bound VAO at the bound vertex stream, as the shader declares them.
+ */
+static void quad_attributes_setup(Shader *shader) {
+    for (s32 i = 0; i < shader->attributes_count; i++) {
+        Attribute *attribute = &shader->attributes[i];
+        glVertexAttribPointer(i, attribute->components, attribute->component_type, attribute->normalized ? GL_TRUE : GL_FALSE, shader->vertex_stride * ATTRIBUTE_COMPONENT_SIZE, (void*)(u64)attribute->offset);
+        glEnableVertexAttribArray(i);
+
+        if (shader->instanced) {
+            glVertexAttribDivisor(i, 1);
+        }
+    }
+}
+
+/**
+ * Line verticies are position xyz and color rgba floats.
+ */
+static void line_attributes_setup(Shader *shader) {
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, shader->vertex_stride * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, shader->vertex_stride * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+}
+
+// Defined with the render thread, which has VAOs of its own for each drawer.
+static void render_thread_release_vao(u32 vao);
+
+// @Incomplete: Finish attributes pointers setting for different types of shaders and strides.
+void drawer_init(Quad_Drawer *drawer, Shader *shader) {
+    drawer->program = shader;
+
+    // Setting Vertex Objects for render using OpenGL. Also seeting up Element Buffer Object for indices to load, instanced quads are triangle strips that don't need it.
+    glGenVertexArrays(1, &drawer->vao);
+    drawer->ebo = 0;
+    drawer->vbo = vertex_stream.vbo;
+
+    // 1. Bind Vertex Array Object. [VAO]
+    glBindVertexArray(drawer->vao);
     
-    /**
-     * Specifying lengths, because we don't pass null terminated strings.
-     * @Important: Since defines length depends on whether we are loading vertex or fragment shader, we set it's length values separately when loading each.
-     */
-    shader_strings_lengths[0] = shader_version.length;
-    shader_strings_lengths[2] = shader_code.length;
+    // 2. Bind vertex stream, verticies are written into it when drawing. [VBO].
+    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
+
+    // 3. Copy indicies array in a buffer for OpenGL to use. [EBO].
+    if (!shader->instanced) {
+        glGenBuffers(1, &drawer->ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawer->ebo);
+        gl_buffer_data(GL_ELEMENT_ARRAY_BUFFER, array_list_length(&quad_indicies) * sizeof(float), quad_indicies, GL_STATIC_DRAW);
+    }
+    
+    // 3. Set vertex attributes pointers. [VAO, VBO, EBO]. @Old.
+    // glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)0);
+    // glEnableVertexAttribArray(0);
+
+    // glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(3 * sizeof(float)));
+    // glEnableVertexAttribArray(1);
+    // 
+    // glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(7 * sizeof(float)));
+    // glEnableVertexAttribArray(2);
+    // 
+    // glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(9 * sizeof(float)));
+    // glEnableVertexAttribArray(3);
+    // 
+    // glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(10 * sizeof(float)));
+    // glEnableVertexAttribArray(4);
+
+    // 3. Set vertex attributes pointers. [VAO, VBO, EBO].
+    quad_attributes_setup(shader);
+
+    
+
+
+    // 4. Unbind EBO, VBO and VAO.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void drawer_free(Quad_Drawer *drawer) {
+    render_thread_release_vao(drawer->vao);
+    glDeleteVertexArrays(1, &drawer->vao); 
+    if (drawer->ebo != 0) {
+        glDeleteBuffers(1, &drawer->ebo); 
+    }
+
+    drawer->program = NULL;
+    drawer->vao = 0;
+    drawer->vbo = 0;
+    drawer->ebo = 0;
+}
+
+
+void line_drawer_init(Line_Drawer *drawer, Shader *shader) {
+    drawer->program = shader;
+
+    // Setting Vertex Objects for render using OpenGL. Also seeting up Element Buffer Object for indices to load.
+    glGenVertexArrays(1, &drawer->vao);
+    drawer->vbo = vertex_stream.vbo;
+
+    // 1. Bind Vertex Array Object. [VAO]
+    glBindVertexArray(drawer->vao);
+    
+    // 2. Bind vertex stream, verticies are written into it when drawing. [VBO].
+    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
+
+    // 3. Set vertex attributes pointers. [VAO, VBO].
+    line_attributes_setup(drawer->program);
+
+    // 4. Unbind EBO, VBO and VAO.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void line_drawer_free(Line_Drawer *drawer) {
+    render_thread_release_vao(drawer->vao);
+    glDeleteVertexArrays(1, &drawer->vao); 
+
+    drawer->program = NULL;
+    drawer->vao = 0;
+    drawer->vbo = 0;
+}
+
+
+
+Vertex_Buffer vertex_buffer_make() {
+    return array_list_make(float, MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD * 11, &std_allocator);
+}
+
+void vertex_buffer_free(Vertex_Buffer *buffer) {
+    array_list_free(buffer);
+}
+
+void vertex_buffer_append_data(Vertex_Buffer *buffer, float *vertex_data, u32 length) {
+    (void)array_list_append_multiple(buffer, vertex_data, length);
+}
+
+/**
+ * Draw calls for verticies that are already written to the stream, VAO and EBO should be bound.
+ * Return count of draw calls issued.
+ */
+static u32 stream_draw_quads(s32 base_vertex, u32 verticies_count) {
+    u32 batch = MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD;
+    u32 draw_calls = 0;
+    for (u32 drawn = 0; drawn < verticies_count; drawn += batch) {
+        gl_draw_elements_base_vertex(GL_TRIANGLES, mini(verticies_count - drawn, batch) / VERTICIES_PER_QUAD * INDICIES_PER_QUAD, GL_UNSIGNED_INT, 0, base_vertex + drawn);
+        draw_calls++;
+    }
+    return draw_calls;
+}
+
+static u32 stream_draw_lines(s32 first_vertex, u32 verticies_count) {
+    gl_draw_arrays(GL_LINES, first_vertex, verticies_count);
+    return 1;
+}
+
+/**
+ * Instances don't need indicies, so any count is drawn with one call.
+ */
+static u32 stream_draw_instances(u32 base_instance, u32 instances_count) {
+    gl_draw_arrays_instanced_base_instance(GL_TRIANGLE_STRIP, 0, VERTICIES_PER_QUAD, instances_count, base_instance);
+    return 1;
+}
+
+typedef enum render_primitive : u8 {
+    RENDER_PRIMITIVE_QUADS,
+    RENDER_PRIMITIVE_INSTANCES,
+    RENDER_PRIMITIVE_LINES,
+} Render_Primitive;
+
+static u32 stream_draw(Render_Primitive primitive, s32 first, u32 count) {
+    switch (primitive) {
+        case RENDER_PRIMITIVE_QUADS:        return stream_draw_quads(first, count);
+        case RENDER_PRIMITIVE_INSTANCES:    return stream_draw_instances(first, count);
+        case RENDER_PRIMITIVE_LINES:        return stream_draw_lines(first, count);
+    }
+    return 0;
+}
+
+/**
+ * Count of verticies or instances that are written to the stream together, so they can be drawn at once.
+ */
+static u32 stream_primitive_stride(Render_Primitive primitive) {
+    switch (primitive) {
+        case RENDER_PRIMITIVE_QUADS:        return MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD;
+        case RENDER_PRIMITIVE_INSTANCES:    return 1;
+        case RENDER_PRIMITIVE_LINES:        return VERTICIES_PER_LINE;
+    }
+    return 1;
+}
+
+/**
+ * Biggest part of the buffer in floats that is written to the stream at once, it always holds whole primitives.
+ */
+static u32 stream_write_stride(u32 primitive_stride) {
+    return maxi(VERTEX_STREAM_MAX_WRITE / (primitive_stride * sizeof(float)), 1) * primitive_stride;
+}
+
+@Profile;
+void vertex_buffer_draw_quads(Vertex_Buffer *buffer, Quad_Drawer *drawer) {
+    u32 length = array_list_length(buffer);
+
+    // Bind buffers, program, textures.
+    gl_use_program(drawer->program->id);
+    bool projection_changed = projection_upload(drawer->program, &drawer->program->projection);
+
+    for (u8 i = 0; i < texture_ids_filled_length; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        gl_bind_texture(GL_TEXTURE_2D, texture_ids[i]);
+    }
+
+    glBindVertexArray(drawer->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawer->ebo);
+
+    // Writing as many whole batches into the stream at once as fit, then drawing each batch from its base vertex or instance.
+    Render_Primitive primitive = drawer->program->instanced ? RENDER_PRIMITIVE_INSTANCES : RENDER_PRIMITIVE_QUADS;
+    u32 stride = drawer->program->vertex_stride;
+    u32 write_stride = stream_write_stride(stream_primitive_stride(primitive) * stride);
+    for (u32 written = 0; written < length; written += write_stride) {
+        u32 write_length = mini(length - written, write_stride);
+        u64 offset = vertex_stream_write(*buffer + written, write_length * sizeof(float), stride * sizeof(float));
+
+        stream_draw(primitive, offset / (stride * sizeof(float)), write_length / stride);
+    }
+
+    stats_current.state_changes += 2 + projection_changed + texture_ids_filled_length;
+
+    // Unbinding of buffers after use.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
     
+    glActiveTexture(GL_TEXTURE0);
+    texture_ids_filled_length = 0;
 
-    shader_strings_lengths[1] = vertex_shader_defines.length;
-    u32 vertex_shader;
-    vertex_shader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex_shader, 3, vertex_shader_source, shader_strings_lengths);
-    glCompileShader(vertex_shader);
-    
-    // Check results for errors.
-    if (!check_shader(vertex_shader, shader_path)) {
-        allocator_free(&std_allocator, shader_source.data);
-        return (Shader) {0};
+    gl_use_program(0);
+}
+
+void vertex_buffer_draw_lines(Vertex_Buffer *buffer, Line_Drawer *drawer) {
+    u32 length = array_list_length(buffer);
+
+    // Bind buffers, program, textures.
+    gl_use_program(drawer->program->id);
+    bool projection_changed = projection_upload(drawer->program, &drawer->program->projection);
+
+    glBindVertexArray(drawer->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
+
+    // Lines don't need indicies, so everything written at once is drawn with one call.
+    u32 stride = drawer->program->vertex_stride;
+    u32 write_stride = stream_write_stride(VERTICIES_PER_LINE * stride);
+    for (u32 written = 0; written < length; written += write_stride) {
+        u32 write_length = mini(length - written, write_stride);
+        u64 offset = vertex_stream_write(*buffer + written, write_length * sizeof(float), stride * sizeof(float));
+
+        stream_draw(RENDER_PRIMITIVE_LINES, offset / (stride * sizeof(float)), write_length / stride);
     }
 
-    shader_strings_lengths[1] = fragment_shader_defines.length;
-    u32 fragment_shader;
-    fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment_shader, 3, fragment_shader_source, shader_strings_lengths);
-    glCompileShader(fragment_shader);
+    stats_current.state_changes += 2 + projection_changed;
+
+
+    // Unbinding of buffers after use.
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
     
-    // Check results for errors.
-    if (!check_shader(fragment_shader, shader_path)) {
-        allocator_free(&std_allocator, shader_source.data);
-        return (Shader) {0};
+    gl_use_program(0);
+}
+
+void vertex_buffer_clear(Vertex_Buffer *buffer) {
+    array_list_clear(buffer);
+}
+
+/**
+ * Adds stats of main context's calls to the frame drawn by another context.
+ */
+static void graphics_stats_add(Graphics_Stats *stats, Graphics_Stats *other) {
+    stats->draw_calls           += other->draw_calls;
+    stats->verticies            += other->verticies;
+    stats->triangles            += other->triangles;
+    stats->state_changes        += other->state_changes;
+    stats->state_changes_saved  += other->state_changes_saved;
+    stats->draw_calls_saved     += other->draw_calls_saved;
+    stats->buffer_uploads       += other->buffer_uploads;
+    stats->program_binds        += other->program_binds;
+    stats->texture_binds        += other->texture_binds;
+    stats->uniform_updates      += other->uniform_updates;
+    stats->bytes_uploaded       += other->bytes_uploaded;
+}
+
+void graphics_stats_frame_end() {
+    if (stats_trace != NULL) {
+        gl_trace("# Frame: %u draw calls, %u verticies, %u triangles, %u buffer uploads, %llu bytes, %u program binds, %u texture binds, %u uniform updates.\n",
+                stats_current.draw_calls, stats_current.verticies, stats_current.triangles, stats_current.buffer_uploads, (unsigned long long)stats_current.bytes_uploaded,
+                stats_current.program_binds, stats_current.texture_binds, stats_current.uniform_updates);
+        fclose(stats_trace);
+        stats_trace = NULL;
     }
-    
 
+    mutex_lock(&stats_mutex);
+    stats_last_frame = stats_current;
+    mutex_unlock(&stats_mutex);
+    stats_current = (Graphics_Stats) {0};
+}
 
-    shader.id = glCreateProgram();
+Graphics_Stats graphics_stats_last_frame() {
+    mutex_lock(&stats_mutex);
+    Graphics_Stats stats = stats_last_frame;
+    mutex_unlock(&stats_mutex);
+    return stats;
+}
 
-    glAttachShader(shader.id, vertex_shader);
-    glAttachShader(shader.id, fragment_shader);
-    glLinkProgram(shader.id);
-    
-    // Check results for errors.
-    if (!check_program(shader.id, shader_path)) {
-        allocator_free(&std_allocator, shader_source.data);
-        return (Shader) {0};
+bool graphics_trace_frame(const char *file_path) {
+    if (stats_trace != NULL) {
+        return true;
     }
 
-    glDeleteShader(vertex_shader);
-    glDeleteShader(fragment_shader);
-    
+    stats_trace = fopen(file_path, "w");
+    if (stats_trace == NULL) {
+        LOG_ERROR("Couldn't open '%s' for the frame trace.", file_path);
+        return false;
+    }
 
-    allocator_free(&std_allocator, shader_source.data);
-    
+    gl_trace("# Main context.\n");
+    return true;
+}
 
-    // Cache all attributes in shader based on shader location as index.
-    shader.attributes_count = 0;
-    shader.vertex_stride = 0;
-    glGetProgramiv(shader.id, GL_ACTIVE_ATTRIBUTES, &shader.attributes_count);
 
-    if (shader.attributes_count > MAX_ATTRIBUTES_PER_SHADER) {
-        LOG_ERROR("Shader of %s, exceeded maximum attributes per shader limit on loading.", shader_path);
-        return (Shader) {0};
+
+
+
+typedef struct render_command {
+    u64 key;
+    Render_Primitive primitive;
+    Shader *program;
+    u32 vao;
+    u32 ebo;                        // Only for not instanced quads.
+    Matrix4f projection;
+    u32 verticies_offset;           // In floats, into verticies of the same queue.
+    u32 verticies_length;           // In floats.
+    Static_Buffer *static_buffer;   // NULL if verticies are in the queue, otherwise they are drawn from the buffer, offset is 0.
+    u8 textures_count;
+    u32 textures[32];
+} Render_Command;
+
+typedef struct render_sort_item {
+    u64 key;
+    u32 command;
+} Render_Sort_Item;
+
+// Queue that is filled by submits, and queue that is drawn, they are swapped when frame is presented.
+static Render_Command *queue_commands;
+static float *queue_verticies;
+static Render_Command *flush_commands;
+static float *flush_verticies;
+static Render_Sort_Item *queue_sort_items;
+static Render_Sort_Item *queue_sort_temp;
+
+static Render_Layer queue_layer = RENDER_LAYER_WORLD;
+static u16 queue_depth = 0;
+static bool queue_layer_sorted_by_state[256]; // Indexed by layer.
+
+void render_layer_set(Render_Layer layer) {
+    queue_layer = layer;
+}
+
+void render_layer_sort_by_state(Render_Layer layer, bool enabled) {
+    queue_layer_sorted_by_state[layer] = enabled;
+}
+
+static u16 render_textures_hash(u32 *textures, u8 count) {
+    u32 hash = 2166136261u;
+    for (u8 i = 0; i < count; i++) {
+        hash = (hash ^ textures[i]) * 16777619u;
     }
-    
-    Attribute attribute;
-    for (s32 i = 0; i < shader.attributes_count; i++) {
-        glGetActiveAttrib(shader.id, i, MAX_ATTRIBUTE_NAME_LENGTH, NULL, &attribute.length, &attribute.type, attribute.name);
-        attribute.components = components_of(attribute.type);
-        shader.vertex_stride += attribute.components;
-        shader.attributes[glGetAttribLocation(shader.id, attribute.name)] = attribute;
+    return (u16)(hash ^ (hash >> 16));
+}
+
+/**
+ * Key of the command submitted to current layer, also advances depth.
+ */
+static u64 render_command_key(Render_Primitive primitive, Shader *program, u32 *textures, u8 textures_count) {
+    u64 shader = ((u32)primitive << 6) | (program->id & 0x3F);
+    u64 state = shader << 16 | render_textures_hash(textures, textures_count);
+
+    u64 key = (u64)queue_layer << 56;
+    if (queue_layer_sorted_by_state[queue_layer]) {
+        key |= state << 32 | (u64)queue_depth << 16;
+    } else {
+        key |= (u64)queue_depth << 40 | state << 16;
     }
 
-    
+    if (queue_depth < UINT16_MAX) {
+        queue_depth++;
+    }
+
+    return key;
+}
+
+static void render_queue_init() {
+    if (queue_commands != NULL) {
+        return;
+    }
+
+    queue_commands      = array_list_make(Render_Command, 64, &std_allocator); // @Leak
+    queue_verticies     = array_list_make(float, MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD * 11, &std_allocator); // @Leak
+    flush_commands      = array_list_make(Render_Command, 64, &std_allocator); // @Leak
+    flush_verticies     = array_list_make(float, MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD * 11, &std_allocator); // @Leak
+    queue_sort_items    = array_list_make(Render_Sort_Item, 64, &std_allocator); // @Leak
+    queue_sort_temp     = array_list_make(Render_Sort_Item, 64, &std_allocator); // @Leak
+}
+
+static void render_submit(Vertex_Buffer *buffer, Shader *program, u32 vao, u32 ebo, Render_Primitive primitive) {
+    render_queue_init();
+
+    u32 length = array_list_length(buffer);
+    if (length == 0) {
+        texture_ids_filled_length = 0;
+        return;
+    }
+
+    Render_Command command = {
+        .primitive          = primitive,
+        .program            = program,
+        .vao                = vao,
+        .ebo                = ebo,
+        .projection         = program->projection,
+        .verticies_offset   = array_list_append_multiple(&queue_verticies, *buffer, length),
+        .verticies_length   = length,
+        .textures_count     = texture_ids_filled_length,
+    };
+    memcpy(command.textures, texture_ids, texture_ids_filled_length * sizeof(u32));
+    texture_ids_filled_length = 0;
+
+    command.key = render_command_key(primitive, program, command.textures, command.textures_count);
+
+    array_list_append(&queue_commands, command);
+}
+
+void render_submit_quads(Vertex_Buffer *buffer, Quad_Drawer *drawer) {
+    render_submit(buffer, drawer->program, drawer->vao, drawer->ebo, drawer->program->instanced ? RENDER_PRIMITIVE_INSTANCES : RENDER_PRIMITIVE_QUADS);
+}
+
+void render_submit_lines(Vertex_Buffer *buffer, Line_Drawer *drawer) {
+    render_submit(buffer, drawer->program, drawer->vao, 0, RENDER_PRIMITIVE_LINES);
+}
+
+
+
+
+/**
+ * Static buffers.
+ */
+
+void static_buffer_init(Static_Buffer *buffer, Shader *shader) {
+    *buffer = (Static_Buffer) {
+        .program    = shader,
+        .verticies  = vertex_buffer_make(),
+    };
+
+    glGenVertexArrays(1, &buffer->vao);
+    glGenBuffers(1, &buffer->vbo);
+
+    glBindVertexArray(buffer->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+
+    // Index buffer is made with its storage when quads are uploaded.
+    if (!shader->instanced) {
+        glGenBuffers(1, &buffer->ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->ebo);
+    }
+
+    quad_attributes_setup(shader);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void static_buffer_free(Static_Buffer *buffer) {
+    render_thread_wait();
+    render_thread_release_vao(buffer->vao);
+    glDeleteVertexArrays(1, &buffer->vao);
+    glDeleteBuffers(1, &buffer->vbo);
+    if (buffer->ebo != 0) {
+        glDeleteBuffers(1, &buffer->ebo);
+    }
+    vertex_buffer_free(&buffer->verticies);
+
+    *buffer = (Static_Buffer) {0};
+}
+
+/**
+ * Replaces contents of the buffer, storage only grows, so rebuilding buffer of about the same size doesn't reallocate it.
+ */
+static void static_buffer_upload(Static_Buffer *buffer, float *data, u32 length, u32 *textures, u8 textures_count) {
+    // Frame in flight can still draw old contents.
+    render_thread_wait();
+
+    vertex_buffer_clear(&buffer->verticies);
+    vertex_buffer_append_data(&buffer->verticies, data, length);
+    memcpy(buffer->textures, textures, textures_count * sizeof(u32));
+    buffer->textures_count = textures_count;
+
+    u32 size = length * sizeof(float);
+    if (size == 0) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer->vbo);
+    if (size > buffer->vbo_capacity) {
+        buffer->vbo_capacity = maxi(size, buffer->vbo_capacity * 2);
+        gl_buffer_data(GL_ARRAY_BUFFER, buffer->vbo_capacity, NULL, GL_STATIC_DRAW);
+    }
+    gl_buffer_sub_data(GL_ARRAY_BUFFER, 0, size, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Same indicies as the shared ones, but for all quads of the buffer, so it is drawn with one call.
+    u32 quads = length / buffer->program->vertex_stride / VERTICIES_PER_QUAD;
+    if (buffer->ebo != 0 && quads > buffer->ebo_capacity) {
+        buffer->ebo_capacity = maxi(quads, buffer->ebo_capacity * 2);
+
+        u32 *indicies = allocator_alloc(&std_allocator, buffer->ebo_capacity * INDICIES_PER_QUAD * sizeof(u32));
+        for (u32 i = 0; i < buffer->ebo_capacity * INDICIES_PER_QUAD; i++) {
+            indicies[i] = i - (i / 3) * 2 + (i / 6) * 2;
+        }
+
+        // Element buffer binding is part of VAO state.
+        glBindVertexArray(buffer->vao);
+        gl_buffer_data(GL_ELEMENT_ARRAY_BUFFER, buffer->ebo_capacity * INDICIES_PER_QUAD * sizeof(u32), indicies, GL_STATIC_DRAW);
+        glBindVertexArray(0);
+
+        allocator_free(&std_allocator, indicies);
+    }
+}
+
+void render_submit_static(Static_Buffer *buffer) {
+    render_queue_init();
+
+    u32 length = array_list_length(&buffer->verticies);
+    if (length == 0) {
+        return;
+    }
+
+    Render_Primitive primitive = buffer->program->instanced ? RENDER_PRIMITIVE_INSTANCES : RENDER_PRIMITIVE_QUADS;
+    Render_Command command = {
+        .primitive          = primitive,
+        .program            = buffer->program,
+        .vao                = buffer->vao,
+        .ebo                = buffer->ebo,
+        .projection         = buffer->program->projection,
+        .verticies_length   = length,
+        .static_buffer      = buffer,
+        .textures_count     = buffer->textures_count,
+    };
+    memcpy(command.textures, buffer->textures, buffer->textures_count * sizeof(u32));
+
+    command.key = render_command_key(primitive, buffer->program, command.textures, command.textures_count);
+
+    array_list_append(&queue_commands, command);
+}
+
+/**
+ * Draws whole static buffer of the command, its VAO should be bound.
+ */
+static u32 static_buffer_draw(Render_Command *command) {
+    u32 count = command->verticies_length / command->program->vertex_stride;
+    if (command->primitive == RENDER_PRIMITIVE_INSTANCES) {
+        return stream_draw_instances(0, count);
+    }
+
+    gl_draw_elements(GL_TRIANGLES, count / VERTICIES_PER_QUAD * INDICIES_PER_QUAD, GL_UNSIGNED_INT, 0);
+    return 1;
+}
+
+/**
+ * Least significant digit radix sort, byte at a time, bytes that are the same in all keys are skipped.
+ * It is stable, so commands with equal keys stay in submission order.
+ * Returns whichever of two arrays holds the result.
+ */
+static Render_Sort_Item *render_radix_sort(Render_Sort_Item *items, Render_Sort_Item *temp, u32 count) {
+    for (u32 shift = 0; shift < 64; shift += 8) {
+        u32 offsets[256] = {0};
+        for (u32 i = 0; i < count; i++) {
+            offsets[(items[i].key >> shift) & 0xFF]++;
+        }
+
+        if (offsets[(items[0].key >> shift) & 0xFF] == count) {
+            continue;
+        }
+
+        u32 sum = 0;
+        for (u32 i = 0; i < 256; i++) {
+            u32 bucket = offsets[i];
+            offsets[i] = sum;
+            sum += bucket;
+        }
+
+        for (u32 i = 0; i < count; i++) {
+            temp[offsets[(items[i].key >> shift) & 0xFF]++] = items[i];
+        }
+
+        Render_Sort_Item *swap = items;
+        items = temp;
+        temp = swap;
+    }
+
+    return items;
+}
+
+/**
+ * Software backend.
+ * Draws sorted commands with the CPU rasterizer, textures are read back from GL when they are first used or after they changed.
+ */
+
+typedef struct software_texture {
+    u32 id;
+    bool stale;
+    Raster_Texture texture;
+} Software_Texture;
+
+static Render_Backend render_backend = RENDER_BACKEND_GL;
+static Raster software_raster;
+static Software_Texture *software_textures; // Array list. @Leak
+
+static Software_Texture *software_texture_find(u32 id) {
+    for (u32 i = 0; i < array_list_length(&software_textures); i++) {
+        if (software_textures[i].id == id) {
+            return &software_textures[i];
+        }
+    }
+    return NULL;
+}
+
+static Raster_Texture *software_texture(u32 id) {
+    Software_Texture *entry = software_texture_find(id);
+    if (entry == NULL) {
+        Software_Texture new_entry = { .id = id, .stale = true };
+        array_list_append(&software_textures, new_entry);
+        entry = &software_textures[array_list_length(&software_textures) - 1];
+    }
+
+    if (entry->stale) {
+        s32 width, height, format;
+        gl_bind_texture(GL_TEXTURE_2D, id);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+        u8 channels = (format == GL_RED || format == GL_R8) ? 1 : 4;
+        u64 size = (u64)width * height * channels;
+        u64 old_size = (u64)entry->texture.width * entry->texture.height * entry->texture.channels;
+        if (entry->texture.pixels == NULL) {
+            entry->texture.pixels = allocator_alloc(&std_allocator, maxi(size, 1));
+        } else if (size != old_size) {
+            entry->texture.pixels = allocator_re_alloc(&std_allocator, entry->texture.pixels, maxi(size, 1));
+        }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glGetTexImage(GL_TEXTURE_2D, 0, channels == 1 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, entry->texture.pixels);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        gl_bind_texture(GL_TEXTURE_2D, 0);
+
+        entry->texture.width = width;
+        entry->texture.height = height;
+        entry->texture.channels = channels;
+        entry->stale = false;
+    }
+
+    return &entry->texture;
+}
+
+static Raster_Texture *software_slot(Render_Command *command, u8 slot) {
+    slot &= ~VERTEX_SLOT_DISTANCE_FIELD;
+    if (slot >= command->textures_count) {
+        return NULL;
+    }
+    return software_texture(command->textures[slot]);
+}
+
+static Vec2f software_position(Render_Command *command, Vec2f position) {
+    Vec4f clip = matrix4f_mul_vec4f(command->projection, vec4f_make(position.x, position.y, 0.0f, 1.0f));
+    return vec2f_make((clip.x / clip.w + 1.0f) * 0.5f * software_raster.width, (1.0f - clip.y / clip.w) * 0.5f * software_raster.height);
+}
+
+static Vec4f software_color(u32 color) {
+    return vec4f_make((color & 0xFF) / 255.0f, (color >> 8 & 0xFF) / 255.0f, (color >> 16 & 0xFF) / 255.0f, (color >> 24) / 255.0f);
+}
+
+/**
+ * Draws quad as two triangles, corners are in the same order as quad indicies: 0, 1, 2 and 1, 2, 3.
+ */
+static void software_quad(Raster_Vertex *corners, Render_Command *command, u8 texture, u8 mask) {
+    Raster_Texture *texture_pixels = texture == VERTEX_SLOT_NONE ? NULL : software_slot(command, texture);
+    Raster_Texture *mask_pixels = mask == VERTEX_SLOT_NONE ? NULL : software_slot(command, mask);
+    bool distance_field = mask != VERTEX_SLOT_NONE && (mask & VERTEX_SLOT_DISTANCE_FIELD);
+
+    raster_triangle(&software_raster, corners, texture_pixels, mask_pixels, distance_field);
+    raster_triangle(&software_raster, corners + 1, texture_pixels, mask_pixels, distance_field);
+}
+
+/**
+ * Instanced corners, same as in "sprite.glsl" and "ui_quad.glsl": bottom left, bottom right, top left, top right.
+ */
+static const Vec2f software_corners[VERTICIES_PER_QUAD] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 1.0f } };
+
+static void software_draw(Render_Command *command) {
+    float *data = command->static_buffer != NULL ? command->static_buffer->verticies : flush_verticies + command->verticies_offset;
+    u32 stride = command->program->vertex_stride;
+    u32 count = command->verticies_length / stride;
+
+    switch (command->primitive) {
+        case RENDER_PRIMITIVE_QUADS: {
+            for (u32 i = 0; i + VERTICIES_PER_QUAD <= count; i += VERTICIES_PER_QUAD) {
+                Quad_Vertex *quad = (Quad_Vertex *)(data + i * stride);
+                Raster_Vertex corners[VERTICIES_PER_QUAD];
+                for (s32 c = 0; c < VERTICIES_PER_QUAD; c++) {
+                    corners[c] = (Raster_Vertex) {
+                        .position   = software_position(command, quad[c].position),
+                        .color      = software_color(quad[c].color),
+                        .uv         = vec2f_make(quad[c].uv[0] / 65535.0f, quad[c].uv[1] / 65535.0f),
+                    };
+                }
+                software_quad(corners, command, quad[0].texture, quad[0].mask);
+            }
+        } break;
+
+        case RENDER_PRIMITIVE_INSTANCES: {
+            for (u32 i = 0; i < count; i++) {
+                Raster_Vertex corners[VERTICIES_PER_QUAD];
+
+                if (stride == SPRITE_INSTANCE_STRIDE) {
+                    Sprite_Instance *sprite = (Sprite_Instance *)(data + i * stride);
+                    float c = cosf(sprite->rotation);
+                    float s = sinf(sprite->rotation);
+                    for (s32 k = 0; k < VERTICIES_PER_QUAD; k++) {
+                        Vec2f corner = software_corners[k];
+                        Vec2f local = vec2f_make((corner.x * 2.0f - 1.0f) * sprite->half_size.x, (corner.y * 2.0f - 1.0f) * sprite->half_size.y);
+                        corners[k] = (Raster_Vertex) {
+                            .position   = software_position(command, vec2f_make(sprite->center.x + local.x * c - local.y * s, sprite->center.y + local.x * s + local.y * c)),
+                            .color      = software_color(sprite->color),
+                            .uv         = vec2f_make(lerp(sprite->uv[0], sprite->uv[2], corner.x) / 65535.0f, lerp(sprite->uv[1], sprite->uv[3], corner.y) / 65535.0f),
+                        };
+                    }
+                    software_quad(corners, command, sprite->texture, sprite->mask);
+                }
+                else {
+                    UI_Quad_Instance *ui_quad = (UI_Quad_Instance *)(data + i * stride);
+                    for (s32 k = 0; k < VERTICIES_PER_QUAD; k++) {
+                        Vec2f corner = software_corners[k];
+                        corners[k] = (Raster_Vertex) {
+                            .position   = software_position(command, vec2f_make(ui_quad->position.x + corner.x * ui_quad->size.x, ui_quad->position.y + corner.y * ui_quad->size.y)),
+                            .color      = software_color(ui_quad->color),
+                            .uv         = vec2f_make(lerp(ui_quad->uv[0], ui_quad->uv[2], corner.x) / 65535.0f, lerp(ui_quad->uv[1], ui_quad->uv[3], corner.y) / 65535.0f),
+                        };
+                    }
+                    software_quad(corners, command, VERTEX_SLOT_NONE, ui_quad->mask);
+                }
+            }
+        } break;
+
+        case RENDER_PRIMITIVE_LINES: {
+            // Line verticies are position xyz and color rgba floats.
+            for (u32 i = 0; i + VERTICIES_PER_LINE <= count; i += VERTICIES_PER_LINE) {
+                float *p0 = data + i * stride;
+                float *p1 = p0 + stride;
+                raster_line(&software_raster, software_position(command, vec2f_make(p0[0], p0[1])), software_position(command, vec2f_make(p1[0], p1[1])), vec4f_make(p0[3], p0[4], p0[5], p0[6]));
+            }
+        } break;
+    }
+}
+
+static void software_flush(Render_Sort_Item *sorted, u32 count, Vec4f clear_color) {
+    raster_clear(&software_raster, vertex_pack_color(clear_color));
+
+    u32 verticies_count = 0;
+    for (u32 i = 0; i < count; i++) {
+        Render_Command *command = flush_commands + sorted[i].command;
+        software_draw(command);
+        verticies_count += command->verticies_length / command->program->vertex_stride * (command->primitive == RENDER_PRIMITIVE_INSTANCES ? VERTICIES_PER_QUAD : 1);
+    }
+
+    raster_flush(&software_raster);
+
+    stats_current.verticies += verticies_count;
+}
+
+void render_backend_set(Render_Backend backend, s32 width, s32 height) {
+    render_thread_wait();
+
+    if (software_raster.pixels != NULL && (backend != RENDER_BACKEND_SOFTWARE || software_raster.width != width || software_raster.height != height)) {
+        raster_free(&software_raster);
+    }
+
+    if (backend == RENDER_BACKEND_SOFTWARE && software_raster.pixels == NULL) {
+        raster_init(&software_raster, width, height, SDL_GetCPUCount());
+        if (software_textures == NULL) {
+            software_textures = array_list_make(Software_Texture, 16, &std_allocator);
+        }
+    }
+
+    render_backend = backend;
+}
+
+Render_Backend render_backend_get() {
+    return render_backend;
+}
+
+void texture_changed(u32 id) {
+    if (software_textures == NULL) {
+        return;
+    }
+
+    Software_Texture *entry = software_texture_find(id);
+    if (entry != NULL) {
+        entry->stale = true;
+    }
+}
+
+bool render_software_save(char *file_path) {
+    render_thread_wait();
+
+    if (software_raster.pixels == NULL) {
+        LOG_ERROR("Software backend wasn't used, there is no frame to save into '%s'.", file_path);
+        return false;
+    }
+
+    u64 length = strlen(file_path);
+    if (length >= 4 && strcmp(file_path + length - 4, ".png") == 0) {
+        return raster_write_png(&software_raster, file_path);
+    }
+    return raster_write_ppm(&software_raster, file_path);
+}
+
+
+
+
+/**
+ * Render thread.
+ * Draws and swaps frames with a context of its own that shares objects with the main one, so textures, shaders and buffers made on the main thread are drawn as they are.
+ * Main thread fills one queue while render thread draws the other, "render_present()" waits for the previous frame before swapping them, so at most two frames are in flight.
+ *
+ * Everything a frame needs is handed off with it: commands hold copies of verticies, texture ids and projections, frame holds window size and clear color.
+ * Main context places a fence after uploads of the frame, and render context waits on it on the GPU before drawing, so uploaded pixels are visible to it.
+ * VAOs are not shared between contexts, so render thread makes its own copy of each drawer's VAO the first time it is drawn.
+ */
+
+typedef struct render_frame {
+    Window_Info window;
+    Vec4f clear_color;
+    GLsync fence;               // NULL when frame is drawn by the main thread.
+    Graphics_Stats stats;       // Of main context's calls made for this frame.
+    FILE *trace;                // Main context's trace, drawing of the frame is written after it.
+} Render_Frame;
+
+typedef struct render_vao {
+    u32 source;                 // Drawer's VAO in the main context.
+    u32 program;
+    u32 vao;                    // Copy in the render context.
+} Render_Vao;
+
+#define RENDER_THREAD_WAIT_MS 100
+
+typedef struct render_thread {
+    Thread thread;
+    SDL_GLContext context;
+    Window_Info window;
+    bool running;
+    bool quit;
+    bool frame_pending;         // Frame was handed off and isn't swapped yet.
+    Render_Frame frame;
+
+    Mutex mutex;
+    Condition frame_started;
+    Condition frame_finished;
+
+    Render_Vao *vaos;           // Array list, used by render thread while it draws.
+    u32 *vaos_released;         // Array list, drawer VAOs deleted by the main thread, their copies are deleted before the next frame.
+} Render_Thread;
+
+static Render_Thread render_thread = {
+    .mutex          = MUTEX_INIT,
+    .frame_started  = CONDITION_INIT,
+    .frame_finished = CONDITION_INIT,
+};
+
+static _Thread_local bool render_thread_current = false;
+
+static Vec4f render_clear_color = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+/**
+ * Returns VAO to draw the command with in the context of the calling thread.
+ */
+static u32 render_thread_vao(Render_Command *command) {
+    if (!render_thread_current) {
+        return command->vao;
+    }
 
-    return shader;
-}
+    for (u32 i = 0; i < array_list_length(&render_thread.vaos); i++) {
+        Render_Vao *entry = &render_thread.vaos[i];
+        if (entry->source == command->vao && entry->program == command->program->id) {
+            return entry->vao;
+        }
+    }
 
-void shader_unload(Shader *shader) {
-    glUseProgram(0);
-    glDeleteProgram(shader->id);
-    
-    shader->id = 0;
-    shader->vertex_stride = 0;
-}
+    Render_Vao entry = { .source = command->vao, .program = command->program->id };
+    glGenVertexArrays(1, &entry.vao);
+    glBindVertexArray(entry.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, command->static_buffer != NULL ? command->static_buffer->vbo : vertex_stream.vbo);
 
+    if (command->primitive == RENDER_PRIMITIVE_LINES) {
+        line_attributes_setup(command->program);
+    } else {
+        quad_attributes_setup(command->program);
+    }
 
-Camera camera_make(Vec2f center, s32 unit_scale) {
-    return (Camera) {
-        .center = center,
-        .unit_scale = unit_scale,
-    };
-}
+    // Element buffer binding is part of VAO state, command binds it again anyway after binding VAO.
+    if (command->primitive == RENDER_PRIMITIVE_QUADS) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, command->ebo);
+    }
 
-Matrix4f camera_calculate_projection(Camera *camera, float window_width, float window_height) {
-    float camera_width_offset = (window_width / (float) camera->unit_scale) / 2;
-    float camera_height_offset = (window_height / (float) camera->unit_scale) / 2;
-    return matrix4f_orthographic(camera->center.x - camera_width_offset, camera->center.x + camera_width_offset, camera->center.y - camera_height_offset, camera->center.y + camera_height_offset, -1.0f, 1.0f);
-}
+    // Stream is expected to stay bound while queue is drawn.
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.vbo);
 
-Vec2f screen_to_camera(Vec2f screen_position, Camera *camera, float window_width, float window_height) {
-    return vec2f_sum(vec2f_divide_constant(vec2f_difference(screen_position, vec2f_make(window_width / 2.0f, window_height / 2.0f)), camera->unit_scale), camera->center);
+    array_list_append(&render_thread.vaos, entry);
+    return entry.vao;
 }
 
-
 /**
- * @Todo: When shader loading will be more deterministic, optimize glGetUniformLocation use.
+ * Deletes copies of VAOs that were released, on the render thread.
  */
-void shader_update_projection(Shader *shader, Matrix4f *projection) {
-    s32 quad_shader_pr_matrix_loc = glGetUniformLocation(shader->id, shader_uniform_pr_matrix_name);
-    if (quad_shader_pr_matrix_loc == -1) {
-        LOG_ERROR("Couldn't get location of %s uniform, in shader, when updating projection.", shader_uniform_pr_matrix_name);
+static void render_thread_delete_vaos(bool all) {
+    for (u32 i = 0; i < array_list_length(&render_thread.vaos); i++) {
+        bool released = all;
+        for (u32 j = 0; j < array_list_length(&render_thread.vaos_released) && !released; j++) {
+            released = render_thread.vaos[i].source == render_thread.vaos_released[j];
+        }
+
+        if (released) {
+            glDeleteVertexArrays(1, &render_thread.vaos[i].vao);
+            array_list_unordered_remove(&render_thread.vaos, i);
+            i--;
+        }
     }
 
-    // Set uniforms.
-    glUseProgram(shader->id);
-    glUniformMatrix4fv(quad_shader_pr_matrix_loc, 1, GL_TRUE, projection->array);
-    glUseProgram(0);
+    array_list_clear(&render_thread.vaos_released);
 }
 
+static void render_thread_release_vao(u32 vao) {
+    if (!render_thread.running) {
+        return;
+    }
 
+    render_thread_wait();
+    array_list_append(&render_thread.vaos_released, vao);
+}
 
-u8 texture_ids_filled_length = 0;
 
-float add_texture_to_slots(Texture *texture) {
-    for (u8 i = 0; i < texture_ids_filled_length; i++) {
-        if (texture_ids[i] == texture->id)
-            return i;
-    }
-    if (texture_ids_filled_length < 32) {
-        texture_ids[texture_ids_filled_length] = texture->id;
-        texture_ids_filled_length++;
-        return texture_ids_filled_length - 1;
+/**
+ * Sorts and draws commands of the flush queue, with the context that is current on the calling thread.
+ */
+@Profile;
+static void render_queue_draw(Vec4f clear_color) {
+    u32 count = array_list_length(&flush_commands);
+
+    // Sorting.
+    array_list_clear(&queue_sort_items);
+    array_list_clear(&queue_sort_temp);
+    for (u32 i = 0; i < count; i++) {
+        Render_Sort_Item item = { flush_commands[i].key, i };
+        array_list_append(&queue_sort_items, item);
+        array_list_append(&queue_sort_temp, item);
     }
-    LOG_ERROR("Overflow of 32 texture slots limit, can't add texture id: %d, to current draw call texture slots.", texture->id);
-    return -1.0f;
-}
-
+    Render_Sort_Item *sorted = render_radix_sort(queue_sort_items, queue_sort_temp, count);
 
+    if (render_backend == RENDER_BACKEND_SOFTWARE) {
+        software_flush(sorted, count, clear_color);
+        return;
+    }
 
+    if (count == 0) {
+        return;
+    }
 
-// @Incomplete: Finish attributes pointers setting for different types of shaders and strides.
-void drawer_init(Quad_Drawer *drawer, Shader *shader) {
-    drawer->program = shader;
+    // State that is currently bound, textures are unknown at the start, since anything could have bound them since last flush.
+    u32 program = 0;
+    u32 vao = 0;
+    u32 textures[32];
+    memset(textures, 0xFF, sizeof(textures));
+
+    // Draw that is accumulated from commands with the same state, which verticies are contiguous in the stream.
+    Render_Primitive pending_primitive = RENDER_PRIMITIVE_QUADS;
+    s32 pending_first = 0;
+    u32 pending_count = 0;
+
+    u32 draw_calls = 0;
+    u32 draw_calls_naive = 0;
+    u32 state_changes = 0;
+    u32 state_changes_naive = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.vbo);
+
+    for (u32 i = 0; i < count; i++) {
+        Render_Command *command = flush_commands + sorted[i].command;
+        Shader *shader = command->program;
+
+        bool program_changed    = shader->id != program;
+        bool vao_changed        = command->vao != vao;
+        bool projection_changed = !projection_uploaded(shader->id, &command->projection);
+        bool textures_changed   = memcmp(textures, command->textures, command->textures_count * sizeof(u32)) != 0;
+
+        if (program_changed || vao_changed || projection_changed || textures_changed) {
+            if (pending_count > 0) {
+                draw_calls += stream_draw(pending_primitive, pending_first, pending_count);
+                pending_count = 0;
+            }
+
+            if (program_changed) {
+                gl_use_program(shader->id);
+                program = shader->id;
+                state_changes++;
+            }
+
+            if (vao_changed) {
+                glBindVertexArray(render_thread_vao(command));
+                if (command->primitive == RENDER_PRIMITIVE_QUADS) {
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, command->ebo);
+                }
+                vao = command->vao;
+                state_changes++;
+            }
+
+            state_changes += projection_upload(shader, &command->projection);
+
+            for (u8 t = 0; t < command->textures_count; t++) {
+                if (textures[t] != command->textures[t]) {
+                    glActiveTexture(GL_TEXTURE0 + t);
+                    gl_bind_texture(GL_TEXTURE_2D, command->textures[t]);
+                    textures[t] = command->textures[t];
+                    state_changes++;
+                }
+            }
+        }
 
-    // Setting Vertex Objects for render using OpenGL. Also seeting up Element Buffer Object for indices to load.
-    glGenVertexArrays(1, &drawer->vao);
-    glGenBuffers(1, &drawer->vbo);
-    glGenBuffers(1, &drawer->ebo);
+        u32 stride = shader->vertex_stride;
 
-    // 1. Bind Vertex Array Object. [VAO]
-    glBindVertexArray(drawer->vao);
-    
-    // 2. Copy verticies array in a buffer for OpenGL to use. [VBO].
-    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
-    glBufferData(GL_ARRAY_BUFFER, drawer->program->vertex_stride * VERTICIES_PER_QUAD * MAX_QUADS_PER_BATCH * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        // Static verticies are already on the GPU, buffer is drawn as it is.
+        if (command->static_buffer != NULL) {
+            if (pending_count > 0) {
+                draw_calls += stream_draw(pending_primitive, pending_first, pending_count);
+                pending_count = 0;
+            }
 
-    // 3. Copy indicies array in a buffer for OpenGL to use. [EBO].
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawer->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, array_list_length(&quad_indicies) * sizeof(float), quad_indicies, GL_STATIC_DRAW);
-    
-    // 3. Set vertex attributes pointers. [VAO, VBO, EBO]. @Old.
-    // glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)0);
-    // glEnableVertexAttribArray(0);
+            draw_calls += static_buffer_draw(command);
+            draw_calls_naive += 1;
+            state_changes_naive += 3 + 32;
+            continue;
+        }
 
-    // glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(3 * sizeof(float)));
-    // glEnableVertexAttribArray(1);
-    // 
-    // glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(7 * sizeof(float)));
-    // glEnableVertexAttribArray(2);
-    // 
-    // glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(9 * sizeof(float)));
-    // glEnableVertexAttribArray(3);
-    // 
-    // glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(10 * sizeof(float)));
-    // glEnableVertexAttribArray(4);
+        // Writing verticies, and extending pending draw if they are right after previous ones.
+        u32 write_stride = stream_write_stride(stream_primitive_stride(command->primitive) * stride);
+        for (u32 written = 0; written < command->verticies_length; written += write_stride) {
+            u32 write_length = mini(command->verticies_length - written, write_stride);
+
+            // Pending draw reads the region that is about to be fenced or orphaned.
+            if (pending_count > 0 && vertex_stream_switches_region(write_length * sizeof(float), stride * sizeof(float))) {
+                draw_calls += stream_draw(pending_primitive, pending_first, pending_count);
+                pending_count = 0;
+            }
+
+            u64 offset = vertex_stream_write(flush_verticies + command->verticies_offset + written, write_length * sizeof(float), stride * sizeof(float));
+            s32 first = offset / (stride * sizeof(float));
+
+            if (pending_count > 0 && pending_primitive == command->primitive && pending_first + (s32)pending_count == first) {
+                pending_count += write_length / stride;
+            } else {
+                if (pending_count > 0) {
+                    draw_calls += stream_draw(pending_primitive, pending_first, pending_count);
+                }
+                pending_primitive = command->primitive;
+                pending_first = first;
+                pending_count = write_length / stride;
+            }
+
+            // What drawing this command on its own would take.
+            draw_calls_naive += command->primitive == RENDER_PRIMITIVE_QUADS ? (write_length / stride + MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD - 1) / (MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD) : 1;
+        }
 
-    // 3. Set vertex attributes pointers. [VAO, VBO, EBO].
-    u64 offset = 0;
-    for (s32 i = 0; i < shader->attributes_count; i++) {
-        glVertexAttribPointer(i, shader->attributes[i].components, ATTRIBUTE_COMPONENT_TYPE, GL_FALSE, drawer->program->vertex_stride * ATTRIBUTE_COMPONENT_SIZE, (void*)(offset * ATTRIBUTE_COMPONENT_SIZE));
-        glEnableVertexAttribArray(i);
-        offset += shader->attributes[i].components; 
+        state_changes_naive += 3 + (command->primitive == RENDER_PRIMITIVE_LINES ? 0 : 32);
     }
 
-    
+    if (pending_count > 0) {
+        draw_calls += stream_draw(pending_primitive, pending_first, pending_count);
+    }
 
 
-    // 4. Unbind EBO, VBO and VAO.
+    // Unbinding after use.
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+    gl_use_program(0);
+
+    // Draw calls and verticies are counted by the shims.
+    stats_current.state_changes         += state_changes;
+    stats_current.state_changes_saved   += state_changes_naive > state_changes ? state_changes_naive - state_changes : 0;
+    stats_current.draw_calls_saved      += draw_calls_naive > draw_calls ? draw_calls_naive - draw_calls : 0;
 }
 
-void drawer_free(Quad_Drawer *drawer) {
-    glDeleteVertexArrays(1, &drawer->vao); 
-    glDeleteBuffers(1, &drawer->vbo); 
-    glDeleteBuffers(1, &drawer->ebo); 
 
-    drawer->program = NULL;
-    drawer->vao = 0;
-    drawer->vbo = 0;
-    drawer->ebo = 0;
-}
+/**
+ * Draws the flush queue and swaps it into the window, with the context that is current on the calling thread.
+ */
+static void render_frame_execute(Render_Frame *frame) {
+    if (frame->fence != NULL) {
+        glWaitSync(frame->fence, 0, GL_TIMEOUT_IGNORED);
+        glDeleteSync(frame->fence);
+    }
 
+    if (render_thread_current) {
+        render_thread_delete_vaos(false);
+    }
 
-void line_drawer_init(Line_Drawer *drawer, Shader *shader) {
-    drawer->program = shader;
+    graphics_stats_add(&stats_current, &frame->stats);
+    if (frame->trace != NULL) {
+        stats_trace = frame->trace;
+        gl_trace("# Drawing.\n");
+    }
 
-    // Setting Vertex Objects for render using OpenGL. Also seeting up Element Buffer Object for indices to load.
-    glGenVertexArrays(1, &drawer->vao);
-    glGenBuffers(1, &drawer->vbo);
+    // Software backend can draw without window, and then there is no GL context either, GL backend has nothing to draw into, so frame is dropped.
+    if (frame->window.ptr == NULL) {
+        if (render_backend == RENDER_BACKEND_SOFTWARE) {
+            render_queue_draw(frame->clear_color);
+        }
+        graphics_stats_frame_end();
+        return;
+    }
 
-    // 1. Bind Vertex Array Object. [VAO]
-    glBindVertexArray(drawer->vao);
-    
-    // 2. Copy verticies array in a buffer for OpenGL to use. [VBO].
-    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
-    // printf("max: %d\n", drawer->program->vertex_stride * VERTICIES_PER_QUAD * MAX_QUADS_PER_BATCH);
-    glBufferData(GL_ARRAY_BUFFER, drawer->program->vertex_stride * VERTICIES_PER_LINE * MAX_LINES_PER_BATCH * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+    glViewport(0, 0, frame->window.width, frame->window.height);
+    glClearColor(frame->clear_color.x, frame->clear_color.y, frame->clear_color.z, frame->clear_color.w);
+    glClear(GL_COLOR_BUFFER_BIT);
 
-    // 3. Set vertex attributes pointers. [VAO, VBO].
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    render_queue_draw(frame->clear_color);
 
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, drawer->program->vertex_stride * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Checking for gl error.
+    check_gl_error();
 
-    // 4. Unbind EBO, VBO and VAO.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // Swap buffers to display the rendered image.
+    {
+        PROFILE_ZONE("swap");
+        SDL_GL_SwapWindow(frame->window.ptr);
+    }
+
+    // Closing frame's draw calls stats.
+    graphics_stats_frame_end();
 }
 
-void line_drawer_free(Line_Drawer *drawer) {
-    glDeleteVertexArrays(1, &drawer->vao); 
-    glDeleteBuffers(1, &drawer->vbo); 
+static void render_thread_procedure(void *data) {
+    (void)data;
 
-    drawer->program = NULL;
-    drawer->vao = 0;
-    drawer->vbo = 0;
-}
+    if (SDL_GL_MakeCurrent(render_thread.window.ptr, render_thread.context) < 0) {
+        LOG_ERROR("Couldn't make render context current on render thread! SDL_Error: %s.", SDL_GetError());
+    }
 
+    render_thread_current = true;
+    graphics_context_setup();
 
+    mutex_lock(&render_thread.mutex);
+    while (true) {
+        while (!render_thread.quit && !render_thread.frame_pending) {
+            condition_wait(&render_thread.frame_started, &render_thread.mutex, RENDER_THREAD_WAIT_MS);
+        }
+        // Frame that was handed off before quitting is still drawn.
+        if (!render_thread.frame_pending) {
+            break;
+        }
+        mutex_unlock(&render_thread.mutex);
 
-Vertex_Buffer vertex_buffer_make() {
-    return array_list_make(float, MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD * 11, &std_allocator);
-}
+        render_frame_execute(&render_thread.frame);
 
-void vertex_buffer_free(Vertex_Buffer *buffer) {
-    array_list_free(buffer);
-}
+        mutex_lock(&render_thread.mutex);
+        render_thread.frame_pending = false;
+        condition_broadcast(&render_thread.frame_finished);
+    }
+    mutex_unlock(&render_thread.mutex);
 
-void vertex_buffer_append_data(Vertex_Buffer *buffer, float *vertex_data, u32 length) {
-    (void)array_list_append_multiple(buffer, vertex_data, length);
+    // Copies of VAOs live in this context, so they are deleted with it.
+    render_thread_delete_vaos(true);
+    (void)SDL_GL_MakeCurrent(render_thread.window.ptr, NULL);
 }
 
-void vertex_buffer_draw_quads(Vertex_Buffer *buffer, Quad_Drawer *drawer) {
-    u32 length = array_list_length(buffer);
+bool render_thread_start(Window_Info *window) {
+    if (render_thread.running) {
+        return true;
+    }
 
-    // Bind buffers, program, textures.
-    glUseProgram(drawer->program->id);
+    // Creating context makes it current, main thread keeps its own one.
+    SDL_GLContext main_context = SDL_GL_GetCurrentContext();
+    (void)SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    render_thread.context = SDL_GL_CreateContext(window->ptr);
+    (void)SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 0);
 
-    for (u8 i = 0; i < 32; i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, texture_ids[i]);
+    if (render_thread.context == NULL) {
+        LOG_ERROR("Render context could not be created, drawing on the main thread! SDL_Error: %s.", SDL_GetError());
+        return false;
     }
 
-    glBindVertexArray(drawer->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawer->ebo);
+    (void)SDL_GL_MakeCurrent(window->ptr, main_context);
 
-    u32 batch_stride = MAX_QUADS_PER_BATCH * VERTICIES_PER_QUAD * drawer->program->vertex_stride;
-    // Spliting all data on equal batches, and processing each batch in each draw call.
-    u32 batches = length / batch_stride;
-    for (u32 i = 0; i < batches; i++) {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, batch_stride * sizeof(float), *buffer + (i * batch_stride));
-        glDrawElements(GL_TRIANGLES, array_list_length(&quad_indicies), GL_UNSIGNED_INT, 0);
+    if (render_thread.vaos == NULL) {
+        render_thread.vaos          = array_list_make(Render_Vao, 8, &std_allocator); // @Leak
+        render_thread.vaos_released = array_list_make(u32, 8, &std_allocator); // @Leak
     }
-    
-    // Data that didn't group into full batch, rendered in last draw call.
-    u32 float_attributes_left = (length - batch_stride * batches);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, float_attributes_left * sizeof(float), *buffer + (batches * batch_stride));
-    glDrawElements(GL_TRIANGLES, float_attributes_left / drawer->program->vertex_stride / VERTICIES_PER_QUAD * INDICIES_PER_QUAD, GL_UNSIGNED_INT, 0);
 
-    // Unbinding of buffers after use.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    
-    // Unbind texture ids.
-    for (u8 i = 0; i < 32; i++) {
-        glActiveTexture(GL_TEXTURE0 + i);
-        glBindTexture(GL_TEXTURE_2D, 0);
+    render_thread.window        = *window;
+    render_thread.quit          = false;
+    render_thread.frame_pending = false;
+
+    if (!thread_create(&render_thread.thread, render_thread_procedure, NULL)) {
+        LOG_ERROR("Render thread could not be created, drawing on the main thread.");
+        SDL_GL_DeleteContext(render_thread.context);
+        render_thread.context = NULL;
+        return false;
     }
-    texture_ids_filled_length = 0;
 
-    glUseProgram(0);
+    render_thread.running = true;
+    LOG_INFO("Render thread started.");
+    return true;
 }
 
-void vertex_buffer_draw_lines(Vertex_Buffer *buffer, Line_Drawer *drawer) {
-    u32 length = array_list_length(buffer);
+void render_thread_stop() {
+    if (!render_thread.running) {
+        return;
+    }
 
-    // Bind buffers, program, textures.
-    glUseProgram(drawer->program->id);
+    mutex_lock(&render_thread.mutex);
+    render_thread.quit = true;
+    condition_signal(&render_thread.frame_started);
+    mutex_unlock(&render_thread.mutex);
 
-    glBindVertexArray(drawer->vao);
-    glBindBuffer(GL_ARRAY_BUFFER, drawer->vbo);
+    thread_join(render_thread.thread);
+
+    SDL_GL_DeleteContext(render_thread.context);
+    render_thread.context = NULL;
+    render_thread.running = false;
+    render_thread.frame_pending = false;
+    LOG_INFO("Render thread stopped, drawing on the main thread.");
+}
 
+bool render_thread_running() {
+    return render_thread.running;
+}
 
-    u32 batch_stride = MAX_LINES_PER_BATCH * VERTICIES_PER_LINE * drawer->program->vertex_stride;
-    // Spliting all data on equal batches, and processing each batch in each draw call.
-    u32 batches = length / batch_stride;
-    for (u32 i = 0; i < batches; i++) {
-        glBufferSubData(GL_ARRAY_BUFFER, 0, batch_stride * sizeof(float), *buffer + (i * batch_stride));
-        glDrawArrays(GL_LINES, 0, MAX_LINES_PER_BATCH * VERTICIES_PER_LINE);
+void render_thread_wait() {
+    if (!render_thread.running || render_thread_current) {
+        return;
     }
-    
-    // Data that didn't group into full batch, rendered in last draw call.
-    u32 float_attributes_left = (length - batch_stride * batches);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, float_attributes_left * sizeof(float), *buffer + (batches * batch_stride));
-    glDrawArrays(GL_LINES, 0, float_attributes_left / drawer->program->vertex_stride);
 
+    PROFILE_ZONE("render_wait");
 
-    // Unbinding of buffers after use.
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-    
-    glUseProgram(0);
+    mutex_lock(&render_thread.mutex);
+    while (render_thread.frame_pending) {
+        condition_wait(&render_thread.frame_finished, &render_thread.mutex, RENDER_THREAD_WAIT_MS);
+    }
+    mutex_unlock(&render_thread.mutex);
 }
 
-void vertex_buffer_clear(Vertex_Buffer *buffer) {
-    array_list_clear(buffer);
+void render_clear_color_set(Vec4f color) {
+    render_clear_color = color;
+}
+
+@Profile;
+void render_present(Window_Info *window) {
+    render_queue_init();
+
+    // Previous frame is done with the flush queue, so it can take this frame's commands.
+    render_thread_wait();
+
+    Render_Command *commands = flush_commands;
+    float *verticies_data = flush_verticies;
+    flush_commands = queue_commands;
+    flush_verticies = queue_verticies;
+    queue_commands = commands;
+    queue_verticies = verticies_data;
+
+    array_list_clear(&queue_commands);
+    array_list_clear(&queue_verticies);
+    queue_layer = RENDER_LAYER_WORLD;
+    queue_depth = 0;
+
+    Render_Frame frame = {
+        .window         = *window,
+        .clear_color    = render_clear_color,
+        .stats          = stats_current,
+        .trace          = stats_trace,
+    };
+    stats_current = (Graphics_Stats) {0};
+    stats_trace = NULL;
+
+    // Glyph cache pages used before this point can be cleared again once frames that use them are drawn.
+    glyph_cache_frame++;
+
+    if (!render_thread.running) {
+        render_frame_execute(&frame);
+        return;
+    }
+
+    // Uploads of this frame are flushed, so render context doesn't wait on commands that main context never sends.
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    mutex_lock(&render_thread.mutex);
+    render_thread.frame = frame;
+    render_thread.frame_pending = true;
+    condition_signal(&render_thread.frame_started);
+    mutex_unlock(&render_thread.mutex);
+
+    // Software backend reads textures back while drawing, so frame is finished before main thread can change them.
+    if (render_backend == RENDER_BACKEND_SOFTWARE) {
+        render_thread_wait();
+    }
 }
 
 
+
 Quad_Drawer *active_drawer = NULL;
 
 void draw_begin(Quad_Drawer* drawer) {
@@ -636,7 +3127,16 @@ void draw_begin(Quad_Drawer* drawer) {
 }
 
 void draw_end() {
-    vertex_buffer_draw_quads(&verticies, active_drawer);
+    render_submit_quads(&verticies, active_drawer);
+
+    // Clean up.
+    active_drawer = NULL;
+    array_list_clear(&verticies);
+}
+
+void draw_end_static(Static_Buffer *buffer) {
+    static_buffer_upload(buffer, verticies, array_list_length(&verticies), texture_ids, texture_ids_filled_length);
+    texture_ids_filled_length = 0;
 
     // Clean up.
     active_drawer = NULL;
@@ -644,7 +3144,113 @@ void draw_end() {
 }
 
 void draw_quad_data(float *quad_data, u32 count) {
-    vertex_buffer_append_data(&verticies, quad_data, count * VERTICIES_PER_QUAD * active_drawer->program->vertex_stride);
+    u32 verticies_per_quad = active_drawer->program->instanced ? 1 : VERTICIES_PER_QUAD;
+    Vertex_Buffer *buffer = thread_draw_list != NULL ? &thread_draw_list->verticies : &verticies;
+    vertex_buffer_append_data(buffer, quad_data, count * verticies_per_quad * active_drawer->program->vertex_stride);
+}
+
+bool draw_is_instanced() {
+    return active_drawer != NULL && active_drawer->program->instanced;
+}
+
+u32 draw_vertex_stride() {
+    return active_drawer != NULL ? active_drawer->program->vertex_stride : 0;
+}
+
+
+
+Draw_List draw_list_make() {
+    return (Draw_List) {
+        .verticies = vertex_buffer_make(),
+    };
+}
+
+void draw_list_free(Draw_List *list) {
+    vertex_buffer_free(&list->verticies);
+    list->textures_count = 0;
+}
+
+void draw_list_begin(Draw_List *list) {
+    vertex_buffer_clear(&list->verticies);
+    list->textures_count = 0;
+    thread_draw_list = list;
+}
+
+void draw_list_end() {
+    thread_draw_list = NULL;
+}
+
+/**
+ * Byte offsets of texture and mask slots in vertex or instance of the drawer's shader, -1 if it has no such slot.
+ */
+static void drawer_slot_offsets(Quad_Drawer *drawer, s32 *texture_offset, s32 *mask_offset) {
+    if (!drawer->program->instanced) {
+        *texture_offset = offsetof(Quad_Vertex, texture);
+        *mask_offset    = offsetof(Quad_Vertex, mask);
+    } else if (drawer->program->vertex_stride == SPRITE_INSTANCE_STRIDE) {
+        *texture_offset = offsetof(Sprite_Instance, texture);
+        *mask_offset    = offsetof(Sprite_Instance, mask);
+    } else {
+        *texture_offset = -1;
+        *mask_offset    = offsetof(UI_Quad_Instance, mask);
+    }
+}
+
+static u8 slot_remap(u8 slot, u8 *remap) {
+    if (slot == VERTEX_SLOT_NONE) {
+        return slot;
+    }
+
+    u8 result = remap[slot & ~VERTEX_SLOT_DISTANCE_FIELD];
+    if (result == VERTEX_SLOT_NONE) {
+        return result;
+    }
+    return result | (slot & VERTEX_SLOT_DISTANCE_FIELD);
+}
+
+void draw_lists_merge(Draw_List *lists, u32 count) {
+    u32 stride = active_drawer->program->vertex_stride;
+    s32 texture_offset, mask_offset;
+    drawer_slot_offsets(active_drawer, &texture_offset, &mask_offset);
+
+    for (u32 i = 0; i < count; i++) {
+        Draw_List *list = &lists[i];
+        u32 length = array_list_length(&list->verticies);
+        if (length == 0) {
+            continue;
+        }
+
+        u8 remap[32];
+        bool identity = true;
+        for (u8 t = 0; t < list->textures_count; t++) {
+            Texture texture = { .id = list->textures[t] };
+            remap[t] = vertex_pack_slot(add_texture_to_slots(&texture));
+            identity = identity && remap[t] == t;
+        }
+
+        u32 offset = array_list_append_multiple(&verticies, list->verticies, length);
+        if (identity) {
+            continue;
+        }
+
+        // Slots are bytes inside of verticies, so they are rewritten in place after copying.
+        for (u32 v = offset; v < offset + length; v += stride) {
+            u8 *vertex = (u8 *)(verticies + v);
+            if (texture_offset >= 0) {
+                vertex[texture_offset] = slot_remap(vertex[texture_offset], remap);
+            }
+            vertex[mask_offset] = slot_remap(vertex[mask_offset], remap);
+        }
+    }
+}
+
+void draw_end_cached(Draw_List *cache) {
+    vertex_buffer_clear(&cache->verticies);
+    vertex_buffer_append_data(&cache->verticies, verticies, array_list_length(&verticies));
+    memcpy(cache->textures, texture_ids, texture_ids_filled_length * sizeof(u32));
+    cache->textures_count = texture_ids_filled_length;
+
+    draw_end();
 }
 
 
@@ -659,7 +3265,7 @@ void line_draw_begin(Line_Drawer* drawer) {
 }
 
 void line_draw_end() {
-    vertex_buffer_draw_lines(&verticies, active_line_drawer);
+    render_submit_lines(&verticies, active_line_drawer);
 
     // Clean up.
     active_line_drawer = NULL;
@@ -722,58 +3328,74 @@ void print_indicies() {
 
 
 
-Font_Baked font_bake(u8 *font_data, float font_size) {
+/**
+ * Returns index of loaded font file, reading it if it isn't loaded yet, or -1.
+ */
+static s32 font_face_load(char *font_path) {
+    for (s32 i = 0; i < font_faces_count; i++) {
+        if (strcmp(font_faces[i].path, font_path) == 0) {
+            return i;
+        }
+    }
 
-    Font_Baked result;
-    
-    // Init font info.
-    stbtt_fontinfo info;
-    (void)stbtt_InitFont(&info, font_data, 0);
+    if (font_faces_count >= FONT_MAX_FACES) {
+        LOG_ERROR("Can't load font '%s', max number of fonts is %d.", font_path, FONT_MAX_FACES);
+        return -1;
+    }
 
-    // Initing needed variables. @Temporary: Maybe move some of this variables into font struct directly and calculate when baking bitmap.
-    s32 ascent, descent, line_gap;
-    stbtt_GetFontVMetrics(&info, &ascent, &descent, &line_gap);
-
-    float scale = stbtt_ScaleForPixelHeight(&info, font_size);
-    result.line_height = (s32)((float)(ascent - descent + line_gap) * scale);
-    result.baseline = (s32)((float)ascent * -scale);
-    result.line_gap = (s32)((float)line_gap * scale);
-
-    // Create a bitmap.
-    result.bitmap.width    = 512;
-    result.bitmap.height   = 512;
-    u8 *bitmap = calloc(result.bitmap.width * result.bitmap.height, sizeof(u8));
-
-    // Bake the font into the bitmap.
-    result.first_char_code  = 32; // ASCII value of the first character to bake.
-    result.chars_count      = 96;  // Number of characters to bake.
-                         
-    result.chars = malloc(result.chars_count * sizeof(stbtt_bakedchar));
-    (void)stbtt_BakeFontBitmap(font_data, 0, font_size, bitmap, result.bitmap.width, result.bitmap.height, result.first_char_code, result.chars_count, result.chars);
-
-    // Create an OpenGL texture.
-    glGenTextures(1, &result.bitmap.id);
-    
-    glBindTexture(GL_TEXTURE_2D, result.bitmap.id);
+    u8 *data = read_file_into_buffer(font_path, NULL, &std_allocator); // @Leak: Faces stay loaded, glyphs can be rasterized at any time.
+    if (data == NULL) {
+        LOG_ERROR("Couldn't read font '%s'.", font_path);
+        return -1;
+    }
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture_wrap_s);	
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture_wrap_t);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture_min_filter);  
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture_max_filter);
+    Font_Face *face = &font_faces[font_faces_count];
+    if (!stbtt_InitFont(&face->info, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+        LOG_ERROR("Couldn't parse font '%s'.", font_path);
+        allocator_free(&std_allocator, data);
+        return -1;
+    }
+
+    (void)snprintf(face->path, sizeof(face->path), "%s", font_path);
+    face->data = data;
+
+    font_faces_count++;
+    return font_faces_count - 1;
+}
+
+static Font_Baked font_make(char *font_path, float font_size, bool distance_field) {
+    Font_Baked result = {
+        .face           = font_face_load(font_path),
+        .size           = font_size,
+        .distance_field = distance_field,
+    };
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, result.bitmap.width, result.bitmap.height, 0, GL_RED, GL_UNSIGNED_BYTE, bitmap);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (result.face == -1) {
+        return result;
+    }
+
+    stbtt_fontinfo *info = &font_faces[result.face].info;
+
+    s32 ascent, descent, line_gap;
+    stbtt_GetFontVMetrics(info, &ascent, &descent, &line_gap);
 
-    free(bitmap);
+    result.scale = stbtt_ScaleForPixelHeight(info, font_size);
+    result.line_height = (s32)((float)(ascent - descent + line_gap) * result.scale);
+    result.baseline = (s32)((float)ascent * -result.scale);
+    result.line_gap = (s32)((float)line_gap * result.scale);
 
     return result;
 }
 
+Font_Baked font_load(char *font_path, float font_size) {
+    return font_make(font_path, font_size, false);
+}
+
+Font_Baked font_load_distance_field(char *font_path, float font_size) {
+    return font_make(font_path, font_size, true);
+}
+
 void font_free(Font_Baked *font) {
-    free(font->chars);
-    font->line_height = 0;
-    font->baseline = 0;
-    font->first_char_code = 0;
-    font->chars_count = 0;
-    texture_unload(&font->bitmap);
+    // Glyphs stay in the cache until they are evicted, and face is shared with other sizes.
+    *font = (Font_Baked) { .face = -1 };
 }
@@ -18,8 +18,6 @@
 #include <SDL2/SDL_mixer.h>
 #include <SDL2/SDL_timer.h>
 
-#include "stb/stb_truetype.h"
-
 
 /**
  * Simple glGetError() wrapper that outputs OpenGL error code if it detects error at a time of calling.
@@ -52,27 +50,37 @@ int init_sdl_audio();
 
 
 /**
- * An initialization function for general purpose rendering, makes arraylists for indicies and verticies, configures GL Blending, and gets stbi to flip image vertically on load.
+ * An initialization function for general purpose rendering, makes arraylists for indicies and verticies, creates vertex stream, configures GL Blending, and gets stbi to flip image vertically on load.
  * Needs to be called before other graphics functions are called.
  */
 void graphics_init();
 
+/**
+ * Makes only what drawing needs on the CPU side, so render queue can be filled and drawn by software backend without window and GL context.
+ * "graphics_init()" does it too, it is for tests and tools that never make a window.
+ */
+void graphics_init_headless();
 
-typedef struct texture {
-    u32 id;             // OpenGL texture id.
-    s32 width;          // Pixel width of texture.
-    s32 height;         // Pixel height of texture.
-} Texture;
 
 typedef struct uv_region {
     Vec2f uv0;
     Vec2f uv1;
 } UV_Region;
 
+typedef struct texture {
+    u32 id;             // OpenGL texture id.
+    s32 width;          // Pixel width of texture.
+    s32 height;         // Pixel height of texture.
+    UV_Region region;   // Part of the GL texture that this texture is, whole texture unless it is in the atlas.
+    bool distance_field;// Single channel signed distance field with edge at 0.5, only makes sense for masks.
+} Texture;
+
 #define UV_DEFAULT          ((UV_Region)({ .uv0 = VEC2F_ORIGIN, .uv1 = VEC2F_UNIT }))
 
 /**
  * Loads texture from image file and returns struct that contains it's OpenGL id with other texture parameters.
+ * Files with ".tex" extension are cooked textures from "core/tex.h", they are uploaded with all their mip levels as they are, without decoding.
+ * Other images are loaded from ".tex" file next to them instead, if it was cooked from the image as it is now.
  */
 Texture texture_load(char *texture_path);
 
@@ -81,6 +89,69 @@ Texture texture_load(char *texture_path);
  */
 void texture_unload(Texture *texture);
 
+
+
+
+/**
+ * Async texture loading.
+ * "texture_load_async()" returns handle right away, which shows placeholder until image is loaded, so loading doesn't stall the frame.
+ * Images are decoded on a worker thread, and "texture_loads_update()" uploads decoded ones on the main thread, at most TEXTURE_UPLOAD_BUDGET bytes a frame,
+ * in strips of rows through pixel buffer, so big images are spread over few frames and GL copies them without stalling.
+ * When image is uploaded handle is updated in place, and completion is put into a queue that is read with "texture_load_completed()".
+ *
+ * @Important: Handles are stable, loading the same path again reloads it into the same handle, old image is shown until new one is uploaded.
+ */
+
+#define TEXTURE_LOAD_MAX_PATH       256
+#define TEXTURE_LOAD_MAX_TEXTURES   256                 // Handles made by "texture_load_async()".
+#define TEXTURE_LOAD_QUEUE_SIZE     256                 // Images that can be decoded or wait for upload at once, images past it are loaded synchronously.
+#define TEXTURE_UPLOAD_BUDGET       (4 * 1024 * 1024)   // Bytes uploaded per frame.
+
+typedef struct texture_load_completion {
+    char path[TEXTURE_LOAD_MAX_PATH];
+    Texture *texture;
+    bool failed;        // Image couldn't be decoded, handle keeps what it showed before.
+} Texture_Load_Completion;
+
+/**
+ * Called on the main thread with decoded RGBA pixels instead of uploading them into handle's own texture, pixels are freed after the call.
+ * Pixels are NULL if image couldn't be decoded.
+ */
+typedef void (*Texture_Decoded_Procedure)(Texture *texture, char *path, u8 *pixels, s32 width, s32 height);
+
+/**
+ * Returns handle of the image, which shows placeholder until image is uploaded.
+ * Returns NULL if there are too many handles.
+ */
+Texture *texture_load_async(char *texture_path);
+
+/**
+ * Decodes image on the worker thread, then "procedure" is called with its pixels by "texture_loads_update()", and completion of "texture" is queued.
+ * Whole image counts against upload budget of the frame procedure is called in.
+ * Returns false if image can't be queued, caller should load it synchronously then.
+ */
+bool texture_decode_async(char *texture_path, Texture *texture, Texture_Decoded_Procedure procedure);
+
+/**
+ * Uploads decoded images within the frame budget, should be called once per frame on the main thread, before drawing.
+ */
+void texture_loads_update();
+
+/**
+ * Takes next completed load from the queue, returns false if there is none.
+ */
+bool texture_load_completed(Texture_Load_Completion *completion);
+
+/**
+ * Returns count of images that are not uploaded yet.
+ */
+u32 texture_loads_pending();
+
+/**
+ * Returns 1x1 grey texture that handles show until their image is loaded.
+ */
+Texture *texture_placeholder();
+
 /**
  * Returns uv region that corresponds to the slice index of the texture that is sliced on grid of specified rows and cols.
  *
@@ -102,6 +173,11 @@ void texture_unload(Texture *texture);
  */
 UV_Region uv_slice(u32 rows, u32 cols, u32 index);
 
+/**
+ * Maps UV that is relative to the texture into UV on the GL texture, using texture region.
+ */
+Vec2f texture_uv(Texture *texture, Vec2f uv);
+
 /**
  * Simply adds texture to a 32 limited array of textures being used, if its already in array returns its index, if its not, appends added texture id to the end and return it's index, if it overflows 32 textures limits, its prints error and returns -1.0f.
  */
@@ -119,17 +195,32 @@ typedef struct attribute {
     GLenum type;
     s32 length;
     s32 components;
+    GLenum component_type;  // Type of components in the vertex data, ATTRIBUTE_COMPONENT_TYPE unless attribute is packed.
+    bool normalized;        // If true integer components are converted to 0..1 floats.
+    u32 offset;             // Offset in bytes from the start of the vertex.
 } Attribute;
 
 typedef struct shader {
     u32 id;             // OpenGL program id.
-    u32 vertex_stride;  // Stride length in bytes needed to be allocated per vertex for shader to run correctly for each vertex.
+    u32 vertex_stride;  // Stride length in ATTRIBUTE_COMPONENT_SIZE units needed to be allocated per vertex for shader to run correctly for each vertex.
     s32 attributes_count;
     Attribute attributes[MAX_ATTRIBUTES_PER_SHADER];
+    bool instanced;     // Attributes are per quad instance, corners are expanded by vertex shader.
+    Matrix4f projection; // Projection that draws with this shader use, set by "shader_update_projection()", uploaded to GL only when drawing.
 } Shader;
 
 /**
  * Loads shader from .glsl file and returns struct that contains it's OpenGL id.
+ *
+ * By default vertex attributes are read as floats, to pack attribute into smaller type add note at the end of it's line in the glsl file:
+ *
+ *      layout(location = 1) in vec4 color; // @Packed: unorm8.
+ *
+ * Where type is one of: "unorm8", "unorm16" (normalized to 0..1 floats), "u8", "u16" (converted to floats as is).
+ * Attributes are laid out in location order, each aligned to it's component size, and vertex is padded to ATTRIBUTE_COMPONENT_SIZE.
+ *
+ * Shader that has "// @Instanced." note reads its attributes once per quad, instead of once per vertex,
+ * and is drawn as 4 vertex triangle strip per instance, so vertex shader should compute corners from "gl_VertexID".
  */
 Shader shader_load(char *shader_path);
 
@@ -144,8 +235,8 @@ void shader_init_uniforms(Shader *shader);
 
 typedef struct quad_drawer {
     u32     vao;         // OpenGL id of Vertex Array Object.
-    u32     vbo;         // OpenGL id of Vertex Buffer Object.
-    u32     ebo;         // OpenGL id of Element Buffer Object.
+    u32     vbo;         // OpenGL id of Vertex Buffer Object, it is the shared vertex stream buffer, not owned by the drawer.
+    u32     ebo;         // OpenGL id of Element Buffer Object, 0 for instanced shaders.
     Shader  *program;    // Pointer to shader that will be used to draw.
 } Quad_Drawer;
 
@@ -153,8 +244,70 @@ typedef struct quad_drawer {
 #define VERTICIES_PER_QUAD      4
 #define INDICIES_PER_QUAD       6
 
+
+/**
+ * Packed verticies of "quad.glsl" shader and instances of "sprite.glsl" and "ui_quad.glsl" shaders, should match their "@Packed" attributes.
+ * @Important: UVs are unorm16, so they should stay in 0..1 range.
+ */
+
+#define VERTEX_SLOT_NONE        255     // Texture or mask slot that tells shader to not sample anything.
+#define VERTEX_SLOT_DISTANCE_FIELD 0x80 // Set on mask slot when mask is distance field, shader thresholds it instead of using it as coverage.
+
+typedef struct quad_vertex {
+    Vec2f   position;
+    u32     color;      // RGBA8.
+    u16     uv[2];
+    u8      texture;
+    u8      mask;
+    u16     padding;
+} Quad_Vertex;
+
+typedef struct sprite_instance {
+    Vec2f   center;
+    Vec2f   half_size;
+    float   rotation;   // Radians, counter clockwise around the center.
+    u32     color;      // RGBA8.
+    u16     uv[4];      // u0, v0 at the bottom left corner, u1, v1 at the top right.
+    u8      texture;
+    u8      mask;
+    u16     padding;
+} Sprite_Instance;
+
+typedef struct ui_quad_instance {
+    Vec2f   position;   // Bottom left corner.
+    Vec2f   size;
+    u32     color;      // RGBA8.
+    u16     uv[4];
+    u8      mask;
+    u8      padding[3];
+} UI_Quad_Instance;
+
+#define QUAD_VERTEX_STRIDE      (sizeof(Quad_Vertex) / ATTRIBUTE_COMPONENT_SIZE)
+#define SPRITE_INSTANCE_STRIDE  (sizeof(Sprite_Instance) / ATTRIBUTE_COMPONENT_SIZE)
+
+/**
+ * Packs 0..1 color into RGBA8.
+ */
+u32 vertex_pack_color(Vec4f color);
+
+/**
+ * Packs 0..1 value into unorm16.
+ */
+u16 vertex_pack_unorm16(float value);
+
+/**
+ * Converts slot returned by "add_texture_to_slots()" into packed slot, -1.0f becomes VERTEX_SLOT_NONE.
+ */
+u8 vertex_pack_slot(float slot);
+
+/**
+ * Adds mask to texture slots and returns packed mask slot with VERTEX_SLOT_DISTANCE_FIELD set if needed, NULL mask becomes VERTEX_SLOT_NONE.
+ */
+u8 vertex_pack_mask_slot(Texture *mask);
+
 /**
  * Creates GL buffers based on shader vertex stride for quad drawer.
+ * @Important: Vertex attributes are pointed at the shared vertex stream, so "graphics_init()" should be called before.
  */
 void drawer_init(Quad_Drawer *drawer, Shader *shader);
 
@@ -168,15 +321,15 @@ void drawer_free(Quad_Drawer *drawer);
 
 typedef struct line_drawer {
     u32     vao;         // OpenGL id of Vertex Array Object.
-    u32     vbo;         // OpenGL id of Vertex Buffer Object.
+    u32     vbo;         // OpenGL id of Vertex Buffer Object, it is the shared vertex stream buffer, not owned by the drawer.
     Shader  *program;    // Pointer to shader that will be used to draw.
 } Line_Drawer;
 
-#define MAX_LINES_PER_BATCH     1024
 #define VERTICIES_PER_LINE      2
 
 /**
  * Creates GL buffers based on shader vertex stride for line drawer.
+ * @Important: Vertex attributes are pointed at the shared vertex stream, so "graphics_init()" should be called before.
  */
 void line_drawer_init(Line_Drawer *drawer, Shader *shader);
 
@@ -208,14 +361,14 @@ void vertex_buffer_free(Vertex_Buffer *buffer);
 void vertex_buffer_append_data(Vertex_Buffer *buffer, float *vertex_data, u32 length);
 
 /**
- * Draws quad data to the screen that is stored in the buffer.
- * For example: "draw_end()" uses this function to draw verticies that are stored inside default vertex buffer.
+ * Draws quad data to the screen that is stored in the buffer right away, bypassing render queue.
+ * Data is copied into the vertex stream once and drawn in batches of MAX_QUADS_PER_BATCH quads, each batch using base vertex offset into the stream.
  */
 void vertex_buffer_draw_quads(Vertex_Buffer *buffer, Quad_Drawer *drawer);
 
 /**
- * Draws line data to the screen that is stored in the buffer.
- * For example: "line_draw_end()" uses this function to draw verticies that are stored inside default vertex buffer.
+ * Draws line data to the screen that is stored in the buffer right away, bypassing render queue.
+ * Data is copied into the vertex stream and drawn with one draw call per stream chunk.
  */
 void vertex_buffer_draw_lines(Vertex_Buffer *buffer, Line_Drawer *drawer);
 
@@ -227,6 +380,219 @@ void vertex_buffer_clear(Vertex_Buffer *buffer);
 
 
 
+/**
+ * Graphics stats.
+ * GL calls that cost the frame go through counting shims in "graphics.c", so calls made by both main and render context are counted,
+ * and main context's calls are added to the frame they were made for.
+ * Software backend makes no GL calls, so it only counts verticies.
+ */
+
+typedef struct graphics_stats {
+    u32 draw_calls;             // Count of glDraw* calls issued.
+    u32 verticies;              // Count of verticies submitted by those calls, indexed draws count indicies.
+    u32 triangles;
+    u32 state_changes;          // Count of program, vertex array, texture and projection changes issued.
+    u32 state_changes_saved;    // State changes that drawing each render command on its own would issue on top of that.
+    u32 draw_calls_saved;       // Same for draw calls, saved by merging commands that are contiguous in the vertex stream.
+    u32 buffer_uploads;         // Count of glBufferData and glBufferSubData calls.
+    u32 program_binds;
+    u32 texture_binds;
+    u32 uniform_updates;
+    u64 bytes_uploaded;         // Bytes written to buffers, with GL calls or into mapped memory.
+} Graphics_Stats;
+
+/**
+ * Closes stats of the current frame, "render_present()" calls it after the frame is swapped.
+ */
+void graphics_stats_frame_end();
+
+/**
+ * Returns stats of the last finished frame.
+ */
+Graphics_Stats graphics_stats_last_frame();
+
+/**
+ * Writes every counted GL call of the rest of this frame into the file, main context's uploads and then drawing of the frame,
+ * file is closed after the frame is swapped. Should be called by the main thread.
+ * Returns false if file couldn't be opened.
+ */
+bool graphics_trace_frame(const char *file_path);
+
+
+
+
+
+
+
+/**
+ * Render queue.
+ *
+ * Draws are not issued right away, instead each "draw_end()" / "line_draw_end()" submits a command with a copy of its verticies, texture slots and projection.
+ * At the end of the frame "render_present()" sorts commands by their key and draws them, skipping state changes that are already in place,
+ * and merging draws of commands with the same state.
+ *
+ * Key, from the most significant bits:
+ *      layer       8 bits, what is drawn on top of what.
+ *      depth       16 bits, submission order inside of the layer.
+ *      shader      8 bits, primitive kind and program.
+ *      textures    16 bits, hash of used texture slots.
+ *
+ * Everything is alpha blended, so by default commands of the same layer are drawn in the order they were submitted, and state is only a tie-breaker.
+ * Layer which draws don't overlap can be sorted by state instead with "render_layer_sort_by_state()", then shader and textures go before depth,
+ * quads, then instanced quads, then lines of the same layer.
+ */
+
+typedef enum render_layer : u8 {
+    RENDER_LAYER_WORLD_BACKGROUND,
+    RENDER_LAYER_WORLD,
+    RENDER_LAYER_UI,
+    RENDER_LAYER_CONSOLE,
+    RENDER_LAYER_OVERLAY,
+} Render_Layer;
+
+/**
+ * Sets layer for commands submitted after this call, resets to RENDER_LAYER_WORLD after each "render_present()".
+ */
+void render_layer_set(Render_Layer layer);
+
+/**
+ * Lets commands of the layer be reordered by shader and textures, so more of them are merged into one draw.
+ * @Important: Only for layers which draws don't overlap, overlapping blended draws would be drawn in the wrong order.
+ */
+void render_layer_sort_by_state(Render_Layer layer, bool enabled);
+
+/**
+ * Submits quads from the buffer, with textures currently in slots, and clears texture slots.
+ * Buffer can be reused right after the call, data is copied.
+ */
+void render_submit_quads(Vertex_Buffer *buffer, Quad_Drawer *drawer);
+
+/**
+ * Submits lines from the buffer, buffer can be reused right after the call, data is copied.
+ */
+void render_submit_lines(Vertex_Buffer *buffer, Line_Drawer *drawer);
+
+/**
+ * Ends the frame: submitted commands are sorted and drawn over "render_clear_color_set()" color, and swapped into the window.
+ * When render thread runs, frame is handed off to it as soon as it is done with the previous one, and commands of the next frame can be submitted right away.
+ * Otherwise frame is drawn and swapped before returning.
+ */
+void render_present(Window_Info *window);
+
+/**
+ * Sets color frames are cleared to, it is taken by each frame when it is presented.
+ */
+void render_clear_color_set(Vec4f color);
+
+
+
+
+/**
+ * Static buffers.
+ * Quads that don't change every frame can be kept in a buffer of their own on the GPU, instead of being copied into the vertex stream each frame.
+ * They are uploaded once with "draw_end_static()", and "render_submit_static()" puts a command that draws the buffer as it is into the render queue,
+ * sorted with the rest of the commands, so nothing is uploaded while buffer doesn't change.
+ *
+ * Buffer keeps a copy of its verticies on the CPU, which software backend draws from, and texture slots that were filled when it was uploaded.
+ * @Important: Uploading and freeing wait for the frame in flight, since it can still draw the buffer, so they shouldn't be done every frame.
+ */
+
+typedef struct static_buffer {
+    u32     vao;
+    u32     vbo;
+    u32     ebo;                // Indicies of all quads, 0 for instanced shaders.
+    Shader  *program;
+    u32     vbo_capacity;       // In bytes.
+    u32     ebo_capacity;       // In quads.
+    Vertex_Buffer verticies;    // Copy of the uploaded data.
+    u32     textures[32];       // Texture ids of slots at the time of upload.
+    u8      textures_count;
+} Static_Buffer;
+
+/**
+ * Creates GL objects for quads drawn with shader, storage is allocated by the first upload.
+ */
+void static_buffer_init(Static_Buffer *buffer, Shader *shader);
+
+void static_buffer_free(Static_Buffer *buffer);
+
+/**
+ * Submits command that draws buffer with projection its shader has now, commands of empty buffers are skipped.
+ */
+void render_submit_static(Static_Buffer *buffer);
+
+
+
+
+/**
+ * Render thread.
+ * Draws and swaps presented frames with a context of its own that shares objects with the main context, while the main thread builds the next frame.
+ * Main thread keeps making textures, shaders and drawers, they are handed off with the frame that uses them.
+ *
+ * @Important: Only the render queue is drawn by render thread, "vertex_buffer_draw_quads()" and "vertex_buffer_draw_lines()" should not be used while it runs.
+ * @Important: Swapping from thread other than the one that made the window doesn't work on macOS.
+ */
+
+/**
+ * Makes render context for the window and starts render thread, main context stays current on the calling thread.
+ * Returns false if context or thread couldn't be made, frames are drawn on the main thread then.
+ */
+bool render_thread_start(Window_Info *window);
+
+/**
+ * Finishes frame in flight and stops render thread, frames are drawn on the main thread after it.
+ */
+void render_thread_stop();
+
+bool render_thread_running();
+
+/**
+ * Blocks until frame in flight is drawn, does nothing if render thread doesn't run.
+ * Called before GL objects the frame can use are changed or deleted, "texture_unload()", "shader_unload()" and drawer frees do it themselves.
+ */
+void render_thread_wait();
+
+
+
+
+/**
+ * Render backends.
+ *
+ * GL backend draws render queue on the GPU. Software backend draws it on the CPU with "core/raster.h" into a framebuffer of its own,
+ * which can be saved to compare frames pixel by pixel, GL is only used to read textures back, nothing is drawn into the window.
+ * Commands are shaded by primitive: quads as "quad.glsl", instances as "sprite.glsl" or "ui_quad.glsl" by their stride, lines as "line.glsl".
+ * Without window, that is "render_present()" of window with NULL ptr, software backend needs no GL context at all, as long as nothing is textured,
+ * and GL backend drops the frame without drawing it.
+ *
+ * @Important: Rounded corners and borders of "ui_quad.glsl" rects aren't drawn by software backend, they are plain rects.
+ * @Important: Only the render queue is drawn by software backend, "vertex_buffer_draw_quads()" and "vertex_buffer_draw_lines()" still draw with GL.
+ */
+
+typedef enum render_backend : u8 {
+    RENDER_BACKEND_GL,
+    RENDER_BACKEND_SOFTWARE,
+} Render_Backend;
+
+/**
+ * Sets backend that "render_present()" draws with, software framebuffer is made with given size, and freed when switching back to GL.
+ */
+void render_backend_set(Render_Backend backend, s32 width, s32 height);
+
+Render_Backend render_backend_get();
+
+/**
+ * Writes last frame drawn by software backend as PNG if path ends with ".png", otherwise as PPM.
+ * Returns false if there is no frame or it couldn't be written.
+ */
+bool render_software_save(char *file_path);
+
+/**
+ * Should be called after pixels of GL texture were changed or it was deleted, so software backend reads it again.
+ */
+void texture_changed(u32 id);
+
+
+
 
 
 
@@ -236,16 +602,86 @@ void vertex_buffer_clear(Vertex_Buffer *buffer);
 void draw_begin(Quad_Drawer *drawer);
 
 /**
- * Wraps around "draw_buffer()" using active drawer as a parameter, and internally inited vertices arraylist as a buffer parameter.
+ * Wraps around "render_submit_quads()" using active drawer as a parameter, and internally inited vertices arraylist as a buffer parameter.
  * @Important: Essentially all general drawing should happen between draw_begin() and draw_end() calls.
  */
 void draw_end();
 
 /**
- * Simply places specified data directly into the default vertex buffer.
+ * Same as "draw_end()", but drawn data replaces contents of static buffer, with textures currently in slots, instead of being submitted.
+ * @Important: Buffer should be made for the shader of the drawer passed to "draw_begin()".
+ */
+void draw_end_static(Static_Buffer *buffer);
+
+/**
+ * Simply places specified data of "count" quads directly into the default vertex buffer.
+ * That is 4 verticies per quad, or one instance per quad if active drawer's shader is instanced.
  */
 void draw_quad_data(float *quad_data, u32 count);
 
+/**
+ * Returns true if drawer passed to "draw_begin()" takes one instance per quad.
+ */
+bool draw_is_instanced();
+
+/**
+ * Returns vertex stride of drawer's shader passed to "draw_begin()" in ATTRIBUTE_COMPONENT_SIZE units, or 0 if there is none.
+ */
+u32 draw_vertex_stride();
+
+
+
+
+/**
+ * Draw lists.
+ * Quads can be recorded on several threads at once, each thread into a list of its own, then lists are merged into the default vertex buffer.
+ *
+ *      draw_begin(&drawer);
+ *
+ *      // On each job thread, drawing calls with NULL buffer go into the list, texture slots are the list's own.
+ *      draw_list_begin(&lists[job]);
+ *      draw_quad(...);
+ *      draw_list_end();
+ *
+ *      // After all jobs are done, lists are merged in array order, so result doesn't depend on which job finished first.
+ *      draw_lists_merge(lists, jobs_count);
+ *      draw_end();
+ *
+ * Merging rewrites texture and mask slots of the verticies from list slots into the shared ones, and everything is submitted with one "draw_end()".
+ * @Important: Only quad drawing and texture slots are per thread, text drawing uses glyph and layout caches that aren't thread safe.
+ * @Important: Active drawer is shared, it should be set with "draw_begin()" before jobs start and not changed until they are done.
+ */
+
+typedef struct draw_list {
+    Vertex_Buffer verticies;
+    u32 textures[32];       // Texture ids of the list's slots.
+    u8 textures_count;
+} Draw_List;
+
+Draw_List draw_list_make();
+
+void draw_list_free(Draw_List *list);
+
+/**
+ * Clears the list and makes calling thread record into it, until "draw_list_end()".
+ */
+void draw_list_begin(Draw_List *list);
+
+void draw_list_end();
+
+/**
+ * Appends verticies of all lists in array order into the default vertex buffer, with their texture slots mapped into the shared slots.
+ * Quads which textures don't fit into 32 shared slots are drawn without them, and error is logged.
+ */
+void draw_lists_merge(Draw_List *lists, u32 count);
+
+/**
+ * Same as "draw_end()", but also copies drawn quads with textures of their slots into "cache",
+ * so the same quads could be drawn again later by merging the cache with "draw_lists_merge()" without rebuilding them.
+ * Slots are resolved when cache is merged, so it doesn't matter what else is in the slots by then.
+ */
+void draw_end_cached(Draw_List *cache);
+
 
 
 
@@ -261,7 +697,7 @@ void draw_quad_data(float *quad_data, u32 count);
 void line_draw_begin(Line_Drawer *drawer);
 
 /**
- * Wraps around "line_draw_buffer()" using active line drawer as a parameter, and internally inited vertices arraylist as a buffer parameter.
+ * Wraps around "render_submit_lines()" using active line drawer as a parameter, and internally inited vertices arraylist as a buffer parameter.
  * @Important: Essentially all general line drawing should happen between line_draw_begin() and line_draw_end() calls. But it cannot happen inside "draw_begin()" and "draw_end()" since both lines and quads use same default vertex buffer.
  */
 void line_draw_end();
@@ -307,24 +743,89 @@ Matrix4f camera_calculate_projection(Camera *camera, float window_width, float w
  */
 Vec2f screen_to_camera(Vec2f screen_pos, Camera *camera, float window_width, float window_height);
 
+/**
+ * Returns part of the world that camera sees, can be used to cull what is outside of it.
+ */
+AABB camera_view_aabb(Camera *camera, float window_width, float window_height);
+
 
 /**
- * Sets shader uniform projection matrix to the specified 4x4 matrix.
+ * Sets shader projection matrix to the specified 4x4 matrix, draws submitted after this call use it.
+ * Uniform itself is uploaded when drawing, and only if it differs from the one GL already has.
  */
 void shader_update_projection(Shader *shader, Matrix4f *projection);
 
 
+/**
+ * Glyph cache.
+ * Glyphs are rasterized when they are first drawn, keyed by font file, size and codepoint, into shared single channel textures.
+ * Each texture is split into horizontal pages, when glyph doesn't fit, least recently used page is cleared and its glyphs are rasterized again when needed.
+ * Page that was used by this or previous frame is never cleared, since verticies that point into it may not be drawn yet.
+ *
+ * Distance field glyphs are rasterized once at GLYPH_DISTANCE_FIELD_SIZE and scaled, so all sizes of the font share them.
+ * @Important: Verticies that are kept between frames (like overlay cache) should call "font_cache_pin()" or "font_cache_touch()" when they are drawn again, so glyphs they point at aren't evicted.
+ */
+
+#define GLYPH_CACHE_SIZE            1024
+#define GLYPH_CACHE_PAGES           4       // Pages are GLYPH_CACHE_SIZE wide and GLYPH_CACHE_SIZE / GLYPH_CACHE_PAGES tall.
+#define GLYPH_CACHE_CAPACITY        4096    // Max glyphs in one cache, page is cleared when there are more.
+#define GLYPH_DISTANCE_FIELD_SIZE   48.0f
+#define GLYPH_DISTANCE_FIELD_PADDING 4
+
+typedef struct glyph {
+    Texture *texture;   // Cache texture glyph is on, NULL if glyph has nothing to draw, like space.
+    UV_Region uv;
+    Vec2f offset;       // From pen position on the baseline to bottom left corner of the glyph quad.
+    Vec2f size;
+    float xadvance;
+    u8 page;            // Cache page glyph is on, for "font_cache_touch()".
+    bool missing;       // Glyph has pixels but couldn't be cached right now, texture is NULL.
+} Glyph;
+
 typedef struct font_baked {
-    stbtt_bakedchar *chars;
-    s32             chars_count;                // Number of chars baked.
-    s32             first_char_code;            // ASCII value of the first character baked.
+    s32             face;                       // Index of loaded font file, -1 if font failed to load.
+    float           size;                       // Pixel height.
+    float           scale;                      // Font units to pixels.
+    bool            distance_field;
     s32             baseline;
     s32             line_height;
     s32             line_gap;
-    Texture         bitmap;
 } Font_Baked;
 
-Font_Baked font_bake(u8 *font_data, float font_size);
+#define FONT_MAX_FACES 8
+
+/**
+ * Makes font of specified pixel height, glyphs are rasterized on first draw.
+ * Font file is read only the first time, every size of the same file shares it, and it stays loaded since glyphs can be rasterized at any time.
+ */
+Font_Baked font_load(char *font_path, float font_size);
+
+/**
+ * Same as "font_load()" but glyphs are distance fields, which stay sharp when font is scaled.
+ */
+Font_Baked font_load_distance_field(char *font_path, float font_size);
+
+/**
+ * Returns glyph of the codepoint, rasterizing it if it isn't in the cache.
+ * If glyph couldn't be cached its texture is NULL, but xadvance is still valid.
+ */
+Glyph font_glyph(Font_Baked *font, u32 codepoint);
+
+/**
+ * Returns cache texture glyphs of the font are on and marks all its pages as used by this frame.
+ * Returns NULL if font failed to load.
+ */
+Texture *font_cache_pin(Font_Baked *font);
+
+/**
+ * Marks pages of font's cache as used by this frame, one bit per "Glyph.page".
+ */
+void font_cache_touch(Font_Baked *font, u32 pages);
+
+/**
+ * Returns number of times any page of font's cache was cleared, glyphs taken when it was different may point at other glyphs now.
+ */
+u32 font_cache_generation(Font_Baked *font);
 
 void font_free(Font_Baked *font);
 
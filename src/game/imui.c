@@ -163,17 +163,15 @@ void ui_frame_end(float width, float height) {
 
 
 void ui_draw_rect(Vec2f position, Vec2f size, Vec4f color) {
-    Vec2f p0 = position;
-    Vec2f p1 = vec2f_sum(position, size);
-
-    float quad_data[48] = {
-        p0.x, p0.y, 0.0f, color.x, color.y, color.z, color.w, 0.0f, 0.0f, size.x, size.y, -1.0f,
-        p1.x, p0.y, 0.0f, color.x, color.y, color.z, color.w, 1.0f, 0.0f, size.x, size.y, -1.0f,
-        p0.x, p1.y, 0.0f, color.x, color.y, color.z, color.w, 0.0f, 1.0f, size.x, size.y, -1.0f,
-        p1.x, p1.y, 0.0f, color.x, color.y, color.z, color.w, 1.0f, 1.0f, size.x, size.y, -1.0f,
+    UI_Quad_Instance instance = {
+        .position   = position,
+        .size       = size,
+        .color      = vertex_pack_color(color),
+        .uv         = { 0, 0, 0xFFFF, 0xFFFF },
+        .mask       = VERTEX_SLOT_NONE,
     };
     
-    draw_quad_data(quad_data, 1);
+    draw_quad_data((float *)&instance, 1);
 }
 
 
@@ -191,57 +189,36 @@ bool ui_is_hover(Vec2f size) {
 }
 
 void ui_draw_text(String text, Vec2f position, Vec4f color) {
-    // Scale and adjust current_point.
-    Vec2f current_point = position;
-    Font_Baked *font = ui->font;
-    float origin_x = current_point.x;
-    current_point.y += (float)font->baseline;
-
-    // Text rendering variables.
-    s32 font_char_index;
-    u16 width, height;
-    stbtt_bakedchar *c;
-
-    for (u64 i = 0; i < text.length; i++) {
-        if (text.data[i] == '\n') {
-            current_point.x = origin_x;
-            current_point.y -= (float)font->line_height;
-            continue;
-        }
-
-        // Character drawing.
-        font_char_index = (s32)text.data[i] - font->first_char_code;
-        if (font_char_index < font->chars_count) {
-            c = &font->chars[font_char_index];
-            width  = font->chars[font_char_index].x1 - font->chars[font_char_index].x0;
-            height = font->chars[font_char_index].y1 - font->chars[font_char_index].y0;
-
-
-            Vec2f p0 = vec2f_make(current_point.x + c->xoff, current_point.y - c->yoff - height);
-            Vec2f p1 = vec2f_make(current_point.x + c->xoff + width, current_point.y - c->yoff);
-
-            Vec2f uv0 = vec2f_make(c->x0 / (float)font->bitmap.width, c->y1 / (float)font->bitmap.height);
-            Vec2f uv1 = vec2f_make(c->x1 / (float)font->bitmap.width, c->y0 / (float)font->bitmap.height);
-
-            float mask_slot = add_texture_to_slots(&font->bitmap);              
-
-            float quad_data[48] = {
-                p0.x, p0.y, 0.0f, color.x, color.y, color.z, color.w, uv0.x, uv0.y, 1.0f, 1.0f, mask_slot,
-                p1.x, p0.y, 0.0f, color.x, color.y, color.z, color.w, uv1.x, uv0.y, 1.0f, 1.0f, mask_slot,
-                p0.x, p1.y, 0.0f, color.x, color.y, color.z, color.w, uv0.x, uv1.y, 1.0f, 1.0f, mask_slot,
-                p1.x, p1.y, 0.0f, color.x, color.y, color.z, color.w, uv1.x, uv1.y, 1.0f, 1.0f, mask_slot,
-            };
-
-            draw_quad_data(quad_data, 1);
-
-
-            current_point.x += font->chars[font_char_index].xadvance;
-        }
+    Text_Layout *layout = text_layout(text, ui->font, 0.0f);
+    if (layout->glyphs_count == 0) {
+        return;
+    }
 
+    u32 packed_color = vertex_pack_color(color);
+    u8 mask_slot = vertex_pack_mask_slot(layout->mask);
+
+    for (u32 i = 0; i < layout->glyphs_count; i++) {
+        Text_Layout_Glyph *glyph = &layout->glyphs[i];
+
+        UI_Quad_Instance instance = {
+            .position   = vec2f_sum(position, glyph->offset),
+            .size       = glyph->size,
+            .color      = packed_color,
+            .uv         = { 
+                vertex_pack_unorm16(glyph->uv.uv0.x), 
+                vertex_pack_unorm16(glyph->uv.uv0.y), 
+                vertex_pack_unorm16(glyph->uv.uv1.x), 
+                vertex_pack_unorm16(glyph->uv.uv1.y), 
+            },
+            .mask       = mask_slot,
+        };
+
+        draw_quad_data((float *)&instance, 1);
     }
 }
 
 void ui_draw_text_centered(String text, Vec2f position, Vec2f size, Vec4f color) {
+    // Measuring lays text out into the cache, so drawing it right after doesn't do it again.
     Vec2f t_size = text_size(text, ui->font);
 
     // Following ui_draw_text centered calculations are for the system where y axis points up, and x axis to the right.
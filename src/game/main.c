@@ -2,6 +2,7 @@
 #include "core/type.h"
 #include "core/structs.h"
 #include "core/log.h"
+#include "core/profile.h"
 
 #include "game/game.h"
 #include "game/graphics.h"
@@ -58,6 +59,9 @@ int main(int argc, char **argv) {
 
         // Updating game.
         game_update();
+
+        // Collecting profiled zones of the frame.
+        profile_frame_end();
     }
 
     // Free's all allocated memory before exitting.
@@ -0,0 +1,344 @@
+#include "game/overlay.h"
+
+#include "game/game.h"
+#include "game/draw.h"
+#include "game/graphics.h"
+#include "game/imui.h"
+#include "game/console.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/mathf.h"
+#include "core/file.h"
+#include "core/profile.h"
+
+#include <string.h>
+
+
+#define OVERLAY_FRAME_COUNT             128
+#define OVERLAY_UPDATE_INTERVAL_NS      250000000ull    // Text and geometry are rebuilt 4 times a second.
+#define OVERLAY_MAX_ZONES               16
+
+#define OVERLAY_WIDTH                   320.0f
+#define OVERLAY_MARGIN                  8.0f
+#define OVERLAY_PAD                     6.0f
+#define OVERLAY_GRAPH_HEIGHT            64.0f
+#define OVERLAY_ZONE_LABEL_CHARS        24
+#define OVERLAY_FRAME_BUDGET_MS         (1000.0f / 60.0f)
+
+static const Vec4f OVERLAY_BG_COLOR         = { 0.06f, 0.07f, 0.10f, 0.85f };
+static const Vec4f OVERLAY_GRAPH_BG_COLOR   = { 0.12f, 0.12f, 0.16f, 1.00f };
+static const Vec4f OVERLAY_GRAPH_COLOR      = { 0.40f, 0.90f, 0.50f, 1.00f };
+static const Vec4f OVERLAY_BUDGET_COLOR     = { 0.90f, 0.35f, 0.30f, 1.00f };
+static const Vec4f OVERLAY_ZONE_COLORS[]    = {
+    { 0.30f, 0.55f, 0.90f, 1.0f },
+    { 0.45f, 0.75f, 0.95f, 1.0f },
+    { 0.60f, 0.85f, 0.70f, 1.0f },
+    { 0.85f, 0.80f, 0.45f, 1.0f },
+};
+
+
+typedef struct overlay_zone {
+    const char *name;
+    u16 depth;
+    u64 total_ns;
+} Overlay_Zone;
+
+
+static bool overlay_shown = false;
+
+static Font_Baked font;
+
+// Frame times, recorded every frame, even when overlay is hidden.
+static float frame_times_ms[OVERLAY_FRAME_COUNT];
+static s64 frame_times_written = 0;
+static u64 last_frame_ns = 0;
+
+// Update state.
+static u64 last_update_ns = 0;
+static s64 frames_since_update = 0;
+static s32 last_window_width = 0;
+static s32 last_window_height = 0;
+static Allocator_Stats last_allocator_stats;
+
+// Cached geometry, drawn as is between updates, quads keep textures of their slots.
+static Draw_List quads_cache;
+static Vertex_Buffer lines_cache;
+static u32 quads_cache_pages;       // Glyph cache pages text in "quads_cache" is on.
+
+// Text buffers.
+static char info_data[512];
+static char row_data[64];
+
+// Graph mapping used by "overlay_graph_y()" while graph is built.
+static Vec2f graph_origin;
+static Vec2f graph_size;
+static float graph_step;
+static float graph_max_ms;
+static s64 graph_sample_count;
+
+// Pointers to global state.
+static UI_State    *ui_ptr;
+static Quad_Drawer *ui_quad_drawer_ptr;
+static Line_Drawer *line_drawer_ptr;
+static Window_Info *window_ptr;
+
+
+void overlay_init(State *state) {
+    ui_ptr             = &state->ui_state;
+    ui_quad_drawer_ptr = &state->ui_quad_drawer;
+    line_drawer_ptr    = &state->line_drawer;
+    window_ptr         = &state->window;
+
+    // @Copypasta: From editor.c ...
+    font = font_load("res/font/Consolas-Regular.ttf", 14.0f);
+
+    quads_cache = draw_list_make();
+    lines_cache = vertex_buffer_make();
+
+    last_frame_ns = get_time_ns();
+    last_allocator_stats = std_allocator_stats();
+}
+
+void overlay_free() {
+    draw_list_free(&quads_cache);
+    vertex_buffer_free(&lines_cache);
+    font_free(&font);
+}
+
+void overlay_toggle() {
+    overlay_shown = !overlay_shown;
+
+    // Forcing rebuild on the next draw.
+    last_update_ns = 0;
+}
+
+
+
+
+
+/**
+ * Returns frame time sample, "index" 0 is the oldest of "graph_sample_count" samples.
+ */
+static float overlay_frame_time(s64 index) {
+    return frame_times_ms[(frame_times_written - graph_sample_count + index) % OVERLAY_FRAME_COUNT];
+}
+
+/**
+ * Maps x on the graph to the height of the frame time sample under it, plotted with "draw_function()".
+ */
+static float overlay_graph_y(float x) {
+    s64 index = (s64)((x - graph_origin.x) / graph_step + 0.5f);
+    index = clampi(index, 0, graph_sample_count - 1);
+
+    float t = overlay_frame_time(index) / graph_max_ms;
+    return graph_origin.y + fminf(t, 1.0f) * graph_size.y;
+}
+
+/**
+ * Sums zone durations of the last "frames" profiled frames, merging zones by name and depth.
+ * Returns count of zones written, sorted from the most expensive one.
+ */
+static s64 overlay_collect_zones(Overlay_Zone *zones, s64 frames) {
+    s64 count = 0;
+
+    for (s64 age = 0; age < frames; age++) {
+        Profile_Frame *frame = profile_frame_get(age);
+        if (frame == NULL) {
+            break;
+        }
+
+        for (s64 i = 0; i < frame->event_count; i++) {
+            Profile_Event *event = frame->events + i;
+
+            s64 j = 0;
+            for (; j < count; j++) {
+                if (zones[j].depth == event->depth && (zones[j].name == event->name || strcmp(zones[j].name, event->name) == 0)) {
+                    break;
+                }
+            }
+
+            if (j == count) {
+                if (count >= OVERLAY_MAX_ZONES) {
+                    continue;
+                }
+                zones[count++] = (Overlay_Zone) { event->name, event->depth, 0 };
+            }
+
+            zones[j].total_ns += event->end_ns - event->start_ns;
+        }
+    }
+
+    // Insertion sort, there are only a few zones.
+    for (s64 i = 1; i < count; i++) {
+        Overlay_Zone zone = zones[i];
+        s64 j = i - 1;
+        for (; j >= 0 && zones[j].total_ns < zone.total_ns; j--) {
+            zones[j + 1] = zones[j];
+        }
+        zones[j + 1] = zone;
+    }
+
+    return count;
+}
+
+/**
+ * Rebuilds text and geometry of the overlay, and draws it, quads and lines are kept in caches.
+ */
+/**
+ * Draws line of text into the cache and keeps glyph cache pages it is on, ui lays text out the same way, so layout comes from the cache.
+ */
+static void overlay_text(String text) {
+    ui_text(text);
+    quads_cache_pages |= text_layout(text, &font, 0.0f)->pages;
+}
+
+static void overlay_rebuild(u64 now) {
+    // Frame time stats.
+    graph_sample_count = mini(frame_times_written, OVERLAY_FRAME_COUNT);
+
+    float frame_avg_ms = 0.0f;
+    float frame_max_ms = 0.0f;
+    for (s64 i = 0; i < graph_sample_count; i++) {
+        float ms = overlay_frame_time(i);
+        frame_avg_ms += ms;
+        frame_max_ms = fmaxf(frame_max_ms, ms);
+    }
+    if (graph_sample_count > 0) {
+        frame_avg_ms /= (float)graph_sample_count;
+    }
+
+    // Allocator rates since the last update.
+    Allocator_Stats alloc_stats = std_allocator_stats();
+    float seconds = last_update_ns == 0 ? 0.0f : (float)(now - last_update_ns) / 1e9f;
+    float allocs_per_second = 0.0f;
+    float kb_per_second = 0.0f;
+    if (seconds > 0.0f) {
+        allocs_per_second = (float)(alloc_stats.allocations + alloc_stats.reallocations - last_allocator_stats.allocations - last_allocator_stats.reallocations) / seconds;
+        kb_per_second = (float)(alloc_stats.bytes_requested - last_allocator_stats.bytes_requested) / 1024.0f / seconds;
+    }
+    last_allocator_stats = alloc_stats;
+
+    Graphics_Stats graphics_stats = graphics_stats_last_frame();
+
+    String info = str_format((String) { sizeof(info_data), info_data },
+            "Frame: %5.2f ms avg, %5.2f ms max, %d fps\n"
+            "Draw calls: %u (%u saved), verticies: %u, %.1f KB\n"
+            "State changes: %u (%u saved)\n"
+            "Triangles: %u, buffer uploads: %u\n"
+            "Binds: %u programs, %u textures, uniforms: %u\n"
+            "Allocations live: %lld\n"
+            "Allocations: %.0f/s, %.1f KB/s\n"
+            , frame_avg_ms, frame_max_ms, frame_avg_ms > 0.0f ? (s32)(1000.0f / frame_avg_ms + 0.5f) : 0, graphics_stats.draw_calls, graphics_stats.draw_calls_saved, graphics_stats.verticies, (float)graphics_stats.bytes_uploaded / 1024.0f, graphics_stats.state_changes, graphics_stats.state_changes_saved, graphics_stats.triangles, graphics_stats.buffer_uploads, graphics_stats.program_binds, graphics_stats.texture_binds, graphics_stats.uniform_updates, (long long)(alloc_stats.allocations - alloc_stats.frees), allocs_per_second, kb_per_second);
+
+    // Zones, averaged over the frames since the last update.
+    Overlay_Zone zones[OVERLAY_MAX_ZONES];
+    s64 zone_frames = mini(maxi(frames_since_update, 1), profile_frame_count());
+    s64 zone_count = overlay_collect_zones(zones, zone_frames);
+
+#ifdef PROFILE_ENABLED
+    String no_zones_text = CSTR("No profiled zones.");
+#else
+    String no_zones_text = CSTR("Profiler is compiled out.");
+#endif
+
+    // Layout.
+    float row_height = (float)font.line_height;
+    float content_width = OVERLAY_WIDTH - OVERLAY_PAD * 2.0f;
+    float height = text_size_y(info, &font) + OVERLAY_GRAPH_HEIGHT + row_height * (float)maxi(zone_count, 1) + OVERLAY_PAD * 2.0f;
+
+    Vec2f position = vec2f_make((float)window_ptr->width - OVERLAY_WIDTH - OVERLAY_MARGIN, (float)window_ptr->height - height - OVERLAY_MARGIN);
+
+
+    vertex_buffer_clear(&lines_cache);
+    quads_cache_pages = 0;
+
+    ui_set_font(&font);
+    draw_begin(ui_quad_drawer_ptr);
+
+    ui_draw_rect(position, vec2f_make(OVERLAY_WIDTH, height), OVERLAY_BG_COLOR);
+
+    UI_WINDOW(position.x + OVERLAY_PAD, position.y + OVERLAY_PAD, content_width, height - OVERLAY_PAD * 2.0f,
+        overlay_text(info);
+
+        // Frame time graph.
+        graph_size = vec2f_make(content_width, OVERLAY_GRAPH_HEIGHT);
+        ui_cursor_advance(graph_size);
+        ui_set_element_size(graph_size);
+        graph_origin = ui_ptr->cursor;
+
+        ui_draw_rect(graph_origin, graph_size, OVERLAY_GRAPH_BG_COLOR);
+
+        graph_max_ms = fmaxf(OVERLAY_FRAME_BUDGET_MS * 2.0f, frame_max_ms);
+        if (graph_sample_count > 1) {
+            graph_step = graph_size.x / (float)(graph_sample_count - 1);
+            draw_function(graph_origin.x, graph_origin.x + graph_size.x, overlay_graph_y, (u32)(graph_sample_count - 1), OVERLAY_GRAPH_COLOR, &lines_cache);
+        }
+
+        float budget_y = graph_origin.y + OVERLAY_FRAME_BUDGET_MS / graph_max_ms * graph_size.y;
+        draw_line(vec2f_make(graph_origin.x, budget_y), vec2f_make(graph_origin.x + graph_size.x, budget_y), OVERLAY_BUDGET_COLOR, &lines_cache);
+
+        // Zone bars, scaled relative to the average frame.
+        if (zone_count == 0) {
+            overlay_text(no_zones_text);
+        }
+
+        for (s64 i = 0; i < zone_count; i++) {
+            float ms = (float)zones[i].total_ns / 1e6f / (float)zone_frames;
+
+            String row = str_format((String) { sizeof(row_data), row_data }, "%-*.*s%6.2f ms", OVERLAY_ZONE_LABEL_CHARS - 10, OVERLAY_ZONE_LABEL_CHARS - 10, zones[i].name, ms);
+            Vec2f row_size = text_size(row, &font);
+            overlay_text(row);
+
+            float bar_x = row_size.x + OVERLAY_PAD + (float)zones[i].depth * 4.0f;
+            float bar_max_width = content_width - bar_x;
+            float bar_width = frame_avg_ms > 0.0f ? fminf(ms / frame_avg_ms, 1.0f) * bar_max_width : 0.0f;
+
+            ui_draw_rect(vec2f_make(ui_ptr->cursor.x + bar_x, ui_ptr->cursor.y + 2.0f), vec2f_make(fmaxf(bar_width, 1.0f), row_height - 4.0f), OVERLAY_ZONE_COLORS[zones[i].depth % (sizeof(OVERLAY_ZONE_COLORS) / sizeof(OVERLAY_ZONE_COLORS[0]))]);
+        }
+    );
+
+    draw_end_cached(&quads_cache);
+
+    render_submit_lines(&lines_cache, line_drawer_ptr);
+
+
+    last_update_ns = now;
+    frames_since_update = 0;
+    last_window_width = window_ptr->width;
+    last_window_height = window_ptr->height;
+}
+
+void overlay_draw() {
+    u64 now = get_time_ns();
+
+    frame_times_ms[frame_times_written % OVERLAY_FRAME_COUNT] = (float)(now - last_frame_ns) / 1e6f;
+    frame_times_written++;
+    frames_since_update++;
+    last_frame_ns = now;
+
+    if (!overlay_shown) {
+        return;
+    }
+
+
+    Matrix4f projection = screen_calculate_projection(window_ptr->width, window_ptr->height);
+    render_layer_set(RENDER_LAYER_OVERLAY);
+    shader_update_projection(ui_quad_drawer_ptr->program, &projection);
+    shader_update_projection(line_drawer_ptr->program, &projection);
+
+    bool window_resized = window_ptr->width != last_window_width || window_ptr->height != last_window_height;
+
+    if (last_update_ns == 0 || now - last_update_ns >= OVERLAY_UPDATE_INTERVAL_NS || window_resized) {
+        overlay_rebuild(now);
+        return;
+    }
+
+    // Drawing cached geometry, glyphs it uses should stay in the cache.
+    font_cache_touch(&font, quads_cache_pages);
+    draw_begin(ui_quad_drawer_ptr);
+    draw_lists_merge(&quads_cache, 1);
+    draw_end();
+    render_submit_lines(&lines_cache, line_drawer_ptr);
+}
@@ -0,0 +1,36 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include "game/game.h"
+
+/**
+ * Performance overlay.
+ * Shows frame time graph, profiler zones of the last frames, draw calls and allocator stats.
+ *
+ * @Important: To not distort what it measures, overlay rebuilds its text and geometry only a few times a second, between updates it redraws cached verticies.
+ */
+
+/**
+ * Should be called one time, inits overlay.
+ */
+void overlay_init(State *state);
+
+/**
+ * Records frame time and draws overlay if it is shown, should be called every frame after everything else is drawn.
+ */
+void overlay_draw();
+
+/**
+ * Frees memory allocated for the overlay.
+ */
+void overlay_free();
+
+
+/**
+ * Shows or hides performance overlay.
+ */
+@Introspect;
+@RegisterCommand;
+void overlay_toggle();
+
+#endif
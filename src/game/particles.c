@@ -0,0 +1,311 @@
+#include "game/particles.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/thread.h"
+#include "core/profile.h"
+#include "core/log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+#define PARTICLES_WORKER_WAIT_MS    100
+#define PARTICLES_ALIGNMENT         64
+
+typedef float Particle_Lane __attribute__((vector_size(PARTICLES_LANES * sizeof(float))));
+
+// Every field array, so allocation and removal don't have to list them again.
+static const u64 particle_fields[] = {
+    offsetof(Particles, position_x),
+    offsetof(Particles, position_y),
+    offsetof(Particles, velocity_x),
+    offsetof(Particles, velocity_y),
+    offsetof(Particles, life),
+    offsetof(Particles, size),
+    offsetof(Particles, color_r),
+    offsetof(Particles, color_g),
+    offsetof(Particles, color_b),
+    offsetof(Particles, color_a),
+    offsetof(Particles, color_step_r),
+    offsetof(Particles, color_step_g),
+    offsetof(Particles, color_step_b),
+    offsetof(Particles, color_step_a),
+};
+
+#define PARTICLE_FIELDS_COUNT (sizeof(particle_fields) / sizeof(particle_fields[0]))
+
+static float **particle_field(Particles *particles, u32 field) {
+    return (float **)((u8 *)particles + particle_fields[field]);
+}
+
+
+
+/**
+ * Updates particles from "start" to "end", both are multiples of PARTICLES_LANES.
+ */
+static void particles_update_range(Particles *particles, u32 start, u32 end) {
+    float dt = particles->delta_time;
+
+    Particle_Lane dt_lane       = (Particle_Lane) {0} + dt;
+    Particle_Lane drag_lane     = (Particle_Lane) {0} + fmaxf(1.0f - particles->drag * dt, 0.0f);
+    Particle_Lane gravity_x     = (Particle_Lane) {0} + particles->gravity.x * dt;
+    Particle_Lane gravity_y     = (Particle_Lane) {0} + particles->gravity.y * dt;
+
+    for (u32 i = start; i < end; i += PARTICLES_LANES) {
+        Particle_Lane *velocity_x = (Particle_Lane *)(particles->velocity_x + i);
+        Particle_Lane *velocity_y = (Particle_Lane *)(particles->velocity_y + i);
+        *velocity_x = *velocity_x * drag_lane + gravity_x;
+        *velocity_y = *velocity_y * drag_lane + gravity_y;
+
+        *(Particle_Lane *)(particles->position_x + i) += *velocity_x * dt_lane;
+        *(Particle_Lane *)(particles->position_y + i) += *velocity_y * dt_lane;
+
+        *(Particle_Lane *)(particles->life + i) -= dt_lane;
+
+        *(Particle_Lane *)(particles->color_r + i) += *(Particle_Lane *)(particles->color_step_r + i) * dt_lane;
+        *(Particle_Lane *)(particles->color_g + i) += *(Particle_Lane *)(particles->color_step_g + i) * dt_lane;
+        *(Particle_Lane *)(particles->color_b + i) += *(Particle_Lane *)(particles->color_step_b + i) * dt_lane;
+        *(Particle_Lane *)(particles->color_a + i) += *(Particle_Lane *)(particles->color_step_a + i) * dt_lane;
+    }
+}
+
+/**
+ * Moves alive particles from "start" to "end" to the front of the range, keeping their order, returns how many are alive.
+ */
+static u32 particles_compact_range(Particles *particles, u32 start, u32 end) {
+    u16 alive[PARTICLES_BLOCK];     // Offsets from "start", block fits into u16.
+    u32 alive_count = 0;
+    for (u32 i = start; i < end; i++) {
+        if (particles->life[i] > 0.0f) {
+            alive[alive_count++] = (u16)(i - start);
+        }
+    }
+
+    if (alive_count == end - start) {
+        return alive_count;
+    }
+
+    // Alive particle is never before its new place, so fields are compacted in place.
+    for (u32 f = 0; f < PARTICLE_FIELDS_COUNT; f++) {
+        float *field = *particle_field(particles, f) + start;
+        for (u32 i = 0; i < alive_count; i++) {
+            field[i] = field[alive[i]];
+        }
+    }
+
+    return alive_count;
+}
+
+/**
+ * Takes blocks until there are none left, called by workers and the updating thread.
+ * Each block is compacted right after it is updated, while it is still in cache.
+ */
+static void blocks_run(Particles *particles) {
+    u32 end = (particles->count + PARTICLES_LANES - 1) / PARTICLES_LANES * PARTICLES_LANES;
+    for (;;) {
+        u32 block = atomic_fetch_add(&particles->next_block, 1);
+        u32 start = block * PARTICLES_BLOCK;
+        if (start >= end) {
+            return;
+        }
+        particles_update_range(particles, start, mini(start + PARTICLES_BLOCK, end));
+        particles->blocks_alive[block] = particles_compact_range(particles, start, mini(start + PARTICLES_BLOCK, particles->count));
+    }
+}
+
+static void worker_procedure(void *data) {
+    Particles *particles = data;
+    u64 generation = 0;
+
+    mutex_lock(&particles->mutex);
+    for (;;) {
+        while (!particles->quit && particles->work_generation == generation) {
+            condition_wait(&particles->work_started, &particles->mutex, PARTICLES_WORKER_WAIT_MS);
+        }
+        if (particles->quit) {
+            break;
+        }
+        generation = particles->work_generation;
+        mutex_unlock(&particles->mutex);
+
+        blocks_run(particles);
+
+        mutex_lock(&particles->mutex);
+        particles->workers_busy--;
+        if (particles->workers_busy == 0) {
+            condition_signal(&particles->work_finished);
+        }
+    }
+    mutex_unlock(&particles->mutex);
+}
+
+/**
+ * Fills gaps that dead particles left at the end of compacted blocks with particles from the end of the last blocks, so arrays stay dense.
+ * Only as many particles are moved as there were dead ones.
+ */
+static void particles_join_blocks(Particles *particles) {
+    u32 blocks_count = (particles->count + PARTICLES_BLOCK - 1) / PARTICLES_BLOCK;
+    if (blocks_count == 0) {
+        return;
+    }
+
+    u32 *alive = particles->blocks_alive;
+    u32 first = 0;
+    u32 last = blocks_count - 1;
+    while (first < last) {
+        // Blocks before the last one are full sized.
+        u32 gap_start = first * PARTICLES_BLOCK + alive[first];
+        u32 gap_end = (first + 1) * PARTICLES_BLOCK;
+        if (gap_start == gap_end) {
+            first++;
+            continue;
+        }
+        if (alive[last] == 0) {
+            last--;
+            continue;
+        }
+
+        u32 moved = mini(gap_end - gap_start, alive[last]);
+        u32 source = last * PARTICLES_BLOCK + alive[last] - moved;
+        for (u32 f = 0; f < PARTICLE_FIELDS_COUNT; f++) {
+            float *field = *particle_field(particles, f);
+            memcpy(field + gap_start, field + source, moved * sizeof(float));
+        }
+
+        alive[first] += moved;
+        alive[last] -= moved;
+    }
+
+    particles->count = first * PARTICLES_BLOCK + alive[first];
+}
+
+
+
+void particles_init(Particles *particles, u32 capacity, s32 threads_count) {
+    *particles = (Particles) {0};
+
+    // Each array is a multiple of the alignment, so all of them stay aligned for lane loads.
+    u32 round = PARTICLES_ALIGNMENT / sizeof(float);
+    particles->capacity = (capacity + round - 1) / round * round;
+
+    u64 field_size = (u64)particles->capacity * sizeof(float);
+    particles->memory = allocator_zero_alloc(&std_allocator, field_size * PARTICLE_FIELDS_COUNT + PARTICLES_ALIGNMENT);
+
+    u8 *aligned = (u8 *)(((u64)particles->memory + PARTICLES_ALIGNMENT - 1) / PARTICLES_ALIGNMENT * PARTICLES_ALIGNMENT);
+    for (u32 f = 0; f < PARTICLE_FIELDS_COUNT; f++) {
+        *particle_field(particles, f) = (float *)(aligned + f * field_size);
+    }
+
+    particles->blocks_alive = allocator_zero_alloc(&std_allocator, (particles->capacity + PARTICLES_BLOCK - 1) / PARTICLES_BLOCK * sizeof(u32));
+
+    particles->mutex            = (Mutex) MUTEX_INIT;
+    particles->work_started     = (Condition) CONDITION_INIT;
+    particles->work_finished    = (Condition) CONDITION_INIT;
+
+    threads_count = mini(maxi(threads_count, 1), PARTICLES_MAX_THREADS);
+    for (s32 i = 0; i < threads_count - 1; i++) {
+        if (!thread_create(&particles->workers[particles->workers_count], worker_procedure, particles)) {
+            LOG_WARNING("Couldn't start particles worker, using %d threads.", particles->workers_count + 1);
+            break;
+        }
+        particles->workers_count++;
+    }
+}
+
+void particles_free(Particles *particles) {
+    mutex_lock(&particles->mutex);
+    particles->quit = true;
+    condition_broadcast(&particles->work_started);
+    mutex_unlock(&particles->mutex);
+
+    for (s32 i = 0; i < particles->workers_count; i++) {
+        thread_join(particles->workers[i]);
+    }
+
+    allocator_free(&std_allocator, particles->memory);
+    allocator_free(&std_allocator, particles->blocks_alive);
+    *particles = (Particles) {0};
+}
+
+bool particles_add(Particles *particles, Vec2f position, Vec2f velocity, float life, float size, Vec4f color_start, Vec4f color_end) {
+    if (particles->count >= particles->capacity || life <= 0.0f) {
+        return false;
+    }
+
+    u32 i = particles->count++;
+    particles->position_x[i]    = position.x;
+    particles->position_y[i]    = position.y;
+    particles->velocity_x[i]    = velocity.x;
+    particles->velocity_y[i]    = velocity.y;
+    particles->life[i]          = life;
+    particles->size[i]          = size;
+    particles->color_r[i]       = color_start.x;
+    particles->color_g[i]       = color_start.y;
+    particles->color_b[i]       = color_start.z;
+    particles->color_a[i]       = color_start.w;
+    particles->color_step_r[i]  = (color_end.x - color_start.x) / life;
+    particles->color_step_g[i]  = (color_end.y - color_start.y) / life;
+    particles->color_step_b[i]  = (color_end.z - color_start.z) / life;
+    particles->color_step_a[i]  = (color_end.w - color_start.w) / life;
+
+    return true;
+}
+
+void particles_emit(Particles *particles, Particle_Emitter *emitter, float delta_time) {
+    emitter->accumulator += emitter->rate * delta_time;
+
+    while (emitter->accumulator >= 1.0f) {
+        emitter->accumulator -= 1.0f;
+
+        Vec2f position = vec2f_make(
+            emitter->position.x + (randf() * 2.0f - 1.0f) * emitter->position_spread,
+            emitter->position.y + (randf() * 2.0f - 1.0f) * emitter->position_spread);
+        Vec2f velocity = vec2f_make(
+            emitter->velocity.x + (randf() * 2.0f - 1.0f) * emitter->velocity_spread,
+            emitter->velocity.y + (randf() * 2.0f - 1.0f) * emitter->velocity_spread);
+
+        float life = lerp(emitter->life_min, emitter->life_max, randf());
+        float size = lerp(emitter->size_min, emitter->size_max, randf());
+
+        if (!particles_add(particles, position, velocity, life, size, emitter->color_start, emitter->color_end)) {
+            // Whatever is owed is dropped, so full system doesn't burst when room frees up.
+            emitter->accumulator = 0.0f;
+            break;
+        }
+    }
+}
+
+void particles_update(Particles *particles, float delta_time) {
+    PROFILE_ZONE("particles_update");
+
+    if (particles->count == 0) {
+        return;
+    }
+
+    particles->delta_time = delta_time;
+    atomic_store(&particles->next_block, 0);
+
+    // Workers are only woken up when there is more than one block to share.
+    s32 workers = particles->count > PARTICLES_BLOCK ? particles->workers_count : 0;
+    if (workers > 0) {
+        mutex_lock(&particles->mutex);
+        particles->workers_busy = workers;
+        particles->work_generation++;
+        condition_broadcast(&particles->work_started);
+        mutex_unlock(&particles->mutex);
+    }
+
+    blocks_run(particles);
+
+    if (workers > 0) {
+        mutex_lock(&particles->mutex);
+        while (particles->workers_busy > 0) {
+            condition_wait(&particles->work_finished, &particles->mutex, PARTICLES_WORKER_WAIT_MS);
+        }
+        mutex_unlock(&particles->mutex);
+    }
+
+    particles_join_blocks(particles);
+}
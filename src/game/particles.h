@@ -0,0 +1,110 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+/**
+ * Particles.
+ * Particles are kept as Structure of Arrays, each field in an array of its own, so update reads and writes only floats it needs,
+ * and works on PARTICLES_LANES particles at once with GCC vector extensions, which are SSE on x86 and NEON on ARM without intrinsics.
+ *
+ * Update integrates velocity with gravity and drag, moves particles, ages them and moves their color towards the end color,
+ * color changes by a fixed step each second, which is set at emission so color reaches end color when particle dies.
+ * Particles are split into PARTICLES_BLOCK sized blocks that worker threads and the updating thread take until there are none left,
+ * each thread moves alive particles of its block to the front of the block right after updating it, then the updating thread fills
+ * gaps left at the ends of blocks with particles from the last blocks, so particles don't keep emission order.
+ *
+ * Particles are drawn by "draw_particles()" as sprite instances, which are written straight into the vertex buffer.
+ */
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/thread.h"
+
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#define PARTICLES_LANES         8
+#define PARTICLES_BLOCK         16384   // Particles updated by one thread at once, multiple of PARTICLES_LANES, at most 65536.
+#define PARTICLES_MAX_THREADS   16
+
+typedef struct particle_emitter {
+    Vec2f   position;
+    float   position_spread;    // Particles appear in a square with this half size around position.
+    float   rate;               // Particles per second.
+    Vec2f   velocity;
+    float   velocity_spread;    // Random velocity in -spread..spread added to each axis.
+    float   life_min;           // Seconds.
+    float   life_max;
+    float   size_min;
+    float   size_max;
+    Vec4f   color_start;
+    Vec4f   color_end;
+    float   accumulator;        // Part of particle that wasn't emitted yet.
+} Particle_Emitter;
+
+typedef struct particles {
+    u32     count;
+    u32     capacity;           // Multiple of PARTICLES_LANES, particles after count are padding that is updated, but never drawn.
+
+    // Fields, all arrays are in one allocation, each one is aligned to a cache line.
+    float   *position_x;
+    float   *position_y;
+    float   *velocity_x;
+    float   *velocity_y;
+    float   *life;              // Seconds left, particle is dead when it is not positive.
+    float   *size;
+    float   *color_r;
+    float   *color_g;
+    float   *color_b;
+    float   *color_a;
+    float   *color_step_r;      // Per second.
+    float   *color_step_g;
+    float   *color_step_b;
+    float   *color_step_a;
+    void    *memory;
+    u32     *blocks_alive;      // Alive particles at the front of each block after it is updated.
+
+    Vec2f   gravity;
+    float   drag;               // Part of velocity lost each second.
+
+    // Workers.
+    s32     workers_count;
+    Thread  workers[PARTICLES_MAX_THREADS];
+    Mutex   mutex;
+    Condition work_started;
+    Condition work_finished;
+    u64     work_generation;    // Incremented for every update, workers wait for it to change.
+    s32     workers_busy;
+    bool    quit;
+    atomic_uint next_block;
+    float   delta_time;         // Of the update in progress.
+} Particles;
+
+/**
+ * Allocates room for "capacity" particles, and starts "threads_count - 1" workers, updating thread is the last one.
+ * Threads count is clamped to 1..PARTICLES_MAX_THREADS.
+ */
+void particles_init(Particles *particles, u32 capacity, s32 threads_count);
+
+/**
+ * Stops workers and frees everything.
+ */
+void particles_free(Particles *particles);
+
+/**
+ * Emits particles emitter owes for "delta_time", particles that don't fit are dropped.
+ */
+void particles_emit(Particles *particles, Particle_Emitter *emitter, float delta_time);
+
+/**
+ * Adds single particle, color moves from start to end over its life.
+ * Returns false if there is no room.
+ */
+bool particles_add(Particles *particles, Vec2f position, Vec2f velocity, float life, float size, Vec4f color_start, Vec4f color_end);
+
+/**
+ * Moves particles by "delta_time" and removes dead ones, returns after all workers are done.
+ */
+void particles_update(Particles *particles, float delta_time);
+
+#endif
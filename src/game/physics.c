@@ -546,6 +546,7 @@ u32 phys_find_contanct_points_obb(OBB* obb1, OBB* obb2, Vec2f *points) {
 }
 
 // FINISH REFACTORING
+@Profile;
 void phys_update(Phys_Box **phys_boxes, s64 length, Time_Info *t) {
     float depth;
     Vec2f normal;
@@ -0,0 +1,255 @@
+#include "game/scrollback.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+
+#include <string.h>
+
+
+#define SCROLLBACK_INITIAL_CAPACITY 1024
+
+static Scrollback_Line *line_at(Scrollback *scrollback, u64 line) {
+    return &scrollback->lines[line & (scrollback->lines_capacity - 1)];
+}
+
+static Scrollback_Row *row_at(Scrollback *scrollback, u64 row) {
+    return &scrollback->rows[row & (scrollback->rows_capacity - 1)];
+}
+
+/**
+ * Doubles ring capacity, items keep their sequence numbers.
+ */
+static void *ring_grow(void *ring, u64 *capacity, u64 first, u64 next, u64 item_size) {
+    u64 new_capacity = *capacity * 2;
+    u8 *result = allocator_alloc(&std_allocator, new_capacity * item_size);
+
+    for (u64 i = first; i < next; i++) {
+        memcpy(result + (i & (new_capacity - 1)) * item_size, (u8 *)ring + (i & (*capacity - 1)) * item_size, item_size);
+    }
+
+    allocator_free(&std_allocator, ring);
+    *capacity = new_capacity;
+    return result;
+}
+
+static void rows_push(Scrollback *scrollback, Scrollback_Row row) {
+    if (scrollback->rows_next - scrollback->rows_first == scrollback->rows_capacity) {
+        scrollback->rows = ring_grow(scrollback->rows, &scrollback->rows_capacity, scrollback->rows_first, scrollback->rows_next, sizeof(Scrollback_Row));
+    }
+    *row_at(scrollback, scrollback->rows_next) = row;
+    scrollback->rows_next++;
+}
+
+/**
+ * Splits line into rows of at most wrap columns codepoints.
+ */
+static void rows_push_line(Scrollback *scrollback, u64 line) {
+    Scrollback_Line *l = line_at(scrollback, line);
+
+    if (scrollback->wrap_columns <= 0 || l->length == 0) {
+        rows_push(scrollback, (Scrollback_Row) { line, 0, l->length });
+        return;
+    }
+
+    u32 row_start = 0;
+    s32 columns = 0;
+    for (u32 i = 0; i < l->length; i++) {
+        // Continuation bytes don't start new codepoint.
+        if (((u8)l->data[i] & 0xC0) == 0x80) {
+            continue;
+        }
+
+        if (columns == scrollback->wrap_columns) {
+            rows_push(scrollback, (Scrollback_Row) { line, row_start, i - row_start });
+            row_start = i;
+            columns = 0;
+        }
+        columns++;
+    }
+    rows_push(scrollback, (Scrollback_Row) { line, row_start, l->length - row_start });
+}
+
+static void rows_pop_line(Scrollback *scrollback, u64 line) {
+    while (scrollback->rows_next > scrollback->rows_first && row_at(scrollback, scrollback->rows_next - 1)->line == line) {
+        scrollback->rows_next--;
+    }
+}
+
+/**
+ * Starts next chunk, if all chunks are used the oldest one is reused and its lines with their rows are dropped.
+ */
+static void chunk_next(Scrollback *scrollback) {
+    if (scrollback->chunk_next - scrollback->chunk_first == scrollback->chunks_max) {
+        u64 dropped = scrollback->chunk_first;
+        while (scrollback->lines_first < scrollback->lines_next && line_at(scrollback, scrollback->lines_first)->chunk == dropped) {
+            scrollback->lines_first++;
+        }
+        while (scrollback->rows_first < scrollback->rows_next && row_at(scrollback, scrollback->rows_first)->line < scrollback->lines_first) {
+            scrollback->rows_first++;
+        }
+        scrollback->chunk_first++;
+    }
+
+    char **chunk = &scrollback->chunks[scrollback->chunk_next % scrollback->chunks_max];
+    if (*chunk == NULL) {
+        *chunk = allocator_alloc(&std_allocator, SCROLLBACK_CHUNK_SIZE);
+    }
+
+    scrollback->chunk_next++;
+    scrollback->chunk_write = 0;
+}
+
+/**
+ * Reserves bytes in the newest chunk, starting next chunk if they don't fit.
+ * @Important: Length should be at most SCROLLBACK_CHUNK_SIZE.
+ */
+static char *chunk_reserve(Scrollback *scrollback, u32 length) {
+    if (scrollback->chunk_next == scrollback->chunk_first || scrollback->chunk_write + length > SCROLLBACK_CHUNK_SIZE) {
+        chunk_next(scrollback);
+    }
+
+    char *result = scrollback->chunks[(scrollback->chunk_next - 1) % scrollback->chunks_max] + scrollback->chunk_write;
+    scrollback->chunk_write += length;
+    return result;
+}
+
+/**
+ * Appends text without new lines, either continuing open line or starting a new one.
+ * @Important: Length should be at most SCROLLBACK_CHUNK_SIZE.
+ */
+static void append_piece(Scrollback *scrollback, char *text, u32 length, u8 type, bool terminated) {
+    u64 newest_chunk = scrollback->chunk_next - 1;
+
+    if (scrollback->lines_next > scrollback->lines_first) {
+        u64 last = scrollback->lines_next - 1;
+        Scrollback_Line *open = line_at(scrollback, last);
+
+        if (!open->terminated && (u64)open->length + length <= SCROLLBACK_CHUNK_SIZE) {
+            rows_pop_line(scrollback, last);
+
+            if (open->chunk == newest_chunk && scrollback->chunk_write + length <= SCROLLBACK_CHUNK_SIZE) {
+                // Open line is the last thing written, so it just grows in place.
+                (void)chunk_reserve(scrollback, length);
+                memcpy(open->data + open->length, text, length);
+            }
+            else {
+                // Moving line into the next chunk, newest chunk is never the one reused, since there are at least two.
+                char *data = chunk_reserve(scrollback, open->length + length);
+                memmove(data, open->data, open->length);
+                memcpy(data + open->length, text, length);
+                open->data = data;
+                open->chunk = scrollback->chunk_next - 1;
+            }
+
+            open->length += length;
+            open->terminated = terminated;
+            rows_push_line(scrollback, last);
+            return;
+        }
+
+        // Open line is too long, so it is closed and text goes on the new line.
+        open->terminated = true;
+    }
+
+    char *data = chunk_reserve(scrollback, length);
+    memcpy(data, text, length);
+
+    if (scrollback->lines_next - scrollback->lines_first == scrollback->lines_capacity) {
+        scrollback->lines = ring_grow(scrollback->lines, &scrollback->lines_capacity, scrollback->lines_first, scrollback->lines_next, sizeof(Scrollback_Line));
+    }
+
+    *line_at(scrollback, scrollback->lines_next) = (Scrollback_Line) {
+        .data       = data,
+        .length     = length,
+        .type       = type,
+        .terminated = terminated,
+        .chunk      = scrollback->chunk_next - 1,
+    };
+    scrollback->lines_next++;
+
+    rows_push_line(scrollback, scrollback->lines_next - 1);
+}
+
+
+
+void scrollback_init(Scrollback *scrollback, u64 max_bytes) {
+    *scrollback = (Scrollback) {0};
+
+    scrollback->chunks_max = (max_bytes + SCROLLBACK_CHUNK_SIZE - 1) / SCROLLBACK_CHUNK_SIZE;
+    if (scrollback->chunks_max < 2) {
+        scrollback->chunks_max = 2;
+    }
+    scrollback->chunks = allocator_zero_alloc(&std_allocator, scrollback->chunks_max * sizeof(char *));
+
+    scrollback->lines_capacity = SCROLLBACK_INITIAL_CAPACITY;
+    scrollback->lines = allocator_alloc(&std_allocator, scrollback->lines_capacity * sizeof(Scrollback_Line));
+
+    scrollback->rows_capacity = SCROLLBACK_INITIAL_CAPACITY;
+    scrollback->rows = allocator_alloc(&std_allocator, scrollback->rows_capacity * sizeof(Scrollback_Row));
+}
+
+void scrollback_free(Scrollback *scrollback) {
+    for (u64 i = 0; i < scrollback->chunks_max; i++) {
+        if (scrollback->chunks[i] != NULL) {
+            allocator_free(&std_allocator, scrollback->chunks[i]);
+        }
+    }
+    allocator_free(&std_allocator, scrollback->chunks);
+    allocator_free(&std_allocator, scrollback->lines);
+    allocator_free(&std_allocator, scrollback->rows);
+
+    *scrollback = (Scrollback) {0};
+}
+
+void scrollback_clear(Scrollback *scrollback) {
+    scrollback->chunk_first = scrollback->chunk_next;
+    scrollback->chunk_write = 0;
+    scrollback->lines_first = scrollback->lines_next;
+    scrollback->rows_first = scrollback->rows_next;
+}
+
+void scrollback_append(Scrollback *scrollback, char *text, s64 length, u8 type) {
+    s64 i = 0;
+    while (i < length) {
+        char *new_line = memchr(text + i, '\n', length - i);
+        s64 end = new_line == NULL ? length : new_line - text;
+
+        // Lines longer than chunk are broken.
+        while (end - i > SCROLLBACK_CHUNK_SIZE) {
+            append_piece(scrollback, text + i, SCROLLBACK_CHUNK_SIZE, type, true);
+            i += SCROLLBACK_CHUNK_SIZE;
+        }
+
+        append_piece(scrollback, text + i, (u32)(end - i), type, new_line != NULL);
+        i = end + (new_line != NULL ? 1 : 0);
+    }
+}
+
+void scrollback_set_wrap(Scrollback *scrollback, s32 columns) {
+    if (scrollback->wrap_columns == columns) {
+        return;
+    }
+
+    scrollback->wrap_columns = columns;
+
+    scrollback->rows_first = 0;
+    scrollback->rows_next = 0;
+    for (u64 i = scrollback->lines_first; i < scrollback->lines_next; i++) {
+        rows_push_line(scrollback, i);
+    }
+}
+
+u64 scrollback_rows_count(Scrollback *scrollback) {
+    return scrollback->rows_next - scrollback->rows_first;
+}
+
+String scrollback_row_from_bottom(Scrollback *scrollback, u64 index, u8 *type) {
+    Scrollback_Row *row = row_at(scrollback, scrollback->rows_next - 1 - index);
+    Scrollback_Line *line = line_at(scrollback, row->line);
+
+    if (type != NULL) {
+        *type = line->type;
+    }
+    return STR(row->length, line->data + row->offset);
+}
@@ -0,0 +1,92 @@
+#ifndef SCROLLBACK_H
+#define SCROLLBACK_H
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+
+/**
+ * Scrollback.
+ * Text is stored in fixed size chunks, that are allocated when needed, up to the max size given at init.
+ * When all chunks are used, the oldest one is reused and lines in it are dropped.
+ *
+ * Next to the text two ring arrays are kept:
+ *  - Lines, text between new lines, each line is whole in one chunk.
+ *  - Rows, visual lines, which are parts of lines that fit in wrap width, as line index plus byte offset and length.
+ * So getting any visible row is O(1), and drawing doesn't depend on amount of text stored.
+ *
+ * Text that doesn't end with '\n' stays open, and next appended text continues it.
+ * @Important: Wrapping counts codepoints, so it assumes monospaced font.
+ */
+
+#define SCROLLBACK_CHUNK_SIZE   65536   // Longest line, longer lines are broken into several.
+
+typedef struct scrollback_line {
+    char    *data;
+    u32     length;         // Without '\n'.
+    u8      type;           // Set by whoever appends, like message type.
+    bool    terminated;     // Ended with '\n', otherwise next appended text continues it.
+    u64     chunk;          // Sequence number of chunk data is in.
+} Scrollback_Line;
+
+typedef struct scrollback_row {
+    u64     line;           // Sequence number of the line.
+    u32     offset;         // Bytes from the start of the line.
+    u32     length;
+} Scrollback_Row;
+
+typedef struct scrollback {
+    char            **chunks;
+    u64             chunks_max;
+    u64             chunk_first;        // Sequence number of the oldest chunk in use.
+    u64             chunk_next;         // Sequence number of the next chunk, chunk_next - 1 is the one written to.
+    u32             chunk_write;        // Bytes written into the newest chunk.
+
+    Scrollback_Line *lines;             // Ring indexed by sequence number, power of two capacity.
+    u64             lines_capacity;
+    u64             lines_first;
+    u64             lines_next;
+
+    Scrollback_Row  *rows;              // Same as lines.
+    u64             rows_capacity;
+    u64             rows_first;
+    u64             rows_next;
+
+    s32             wrap_columns;       // 0 or less doesn't wrap.
+} Scrollback;
+
+/**
+ * Makes empty scrollback that stores at most "max_bytes" of text, rounded up to whole chunks, but not less than two chunks.
+ */
+void scrollback_init(Scrollback *scrollback, u64 max_bytes);
+
+void scrollback_free(Scrollback *scrollback);
+
+/**
+ * Removes all lines, chunks stay allocated to be reused.
+ */
+void scrollback_clear(Scrollback *scrollback);
+
+/**
+ * Appends text, splitting it into lines and rows.
+ * If last line is open, text continues it and keeps its type.
+ */
+void scrollback_append(Scrollback *scrollback, char *text, s64 length, u8 type);
+
+/**
+ * Sets wrap width in codepoints, if it changed rows of all lines are made again.
+ */
+void scrollback_set_wrap(Scrollback *scrollback, s32 columns);
+
+/**
+ * Returns count of rows.
+ */
+u64 scrollback_rows_count(Scrollback *scrollback);
+
+/**
+ * Returns text of the row, counting from the bottom, 0 being the last row, and writes its line type into "type".
+ * @Important: Text points into scrollback, and is valid until next append.
+ */
+String scrollback_row_from_bottom(Scrollback *scrollback, u64 index, u8 *type);
+
+#endif
@@ -0,0 +1,126 @@
+#include "game/spatial.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/structs.h"
+
+#include <math.h>
+#include <string.h>
+
+
+static s32 cell_coordinate(Spatial_Grid *grid, float value) {
+    // Clamping, so far away values don't overflow.
+    return (s32)fmaxf(fminf(floorf(value / grid->cell_size), 1.0e9f), -1.0e9f);
+}
+
+static u32 cell_bucket(s32 x, s32 y) {
+    return ((u32)x * 73856093u ^ (u32)y * 19349663u) & (SPATIAL_GRID_BUCKETS - 1);
+}
+
+/**
+ * Adds item to result if it wasn't added during this query and it touches the region.
+ */
+static void query_add(Spatial_Grid *grid, u32 item, AABB *region, u32 **result) {
+    if (grid->stamps[item] == grid->stamp) {
+        return;
+    }
+    grid->stamps[item] = grid->stamp;
+
+    if (aabb_touches_aabb(&grid->bounds[item], region)) {
+        array_list_append(result, item);
+    }
+}
+
+
+
+void spatial_grid_init(Spatial_Grid *grid, float cell_size) {
+    memset(grid->buckets, 0, sizeof(grid->buckets));
+    grid->cell_size     = cell_size;
+    grid->entries       = array_list_make(Spatial_Grid_Entry, 64, &std_allocator);
+    grid->large_items   = array_list_make(u32, 8, &std_allocator);
+    grid->bounds        = array_list_make(AABB, 16, &std_allocator);
+    grid->stamps        = array_list_make(u32, 16, &std_allocator);
+    grid->stamp         = 0;
+}
+
+void spatial_grid_free(Spatial_Grid *grid) {
+    array_list_free(&grid->entries);
+    array_list_free(&grid->large_items);
+    array_list_free(&grid->bounds);
+    array_list_free(&grid->stamps);
+}
+
+void spatial_grid_clear(Spatial_Grid *grid) {
+    memset(grid->buckets, 0, sizeof(grid->buckets));
+    array_list_clear(&grid->entries);
+    array_list_clear(&grid->large_items);
+    array_list_clear(&grid->bounds);
+    array_list_clear(&grid->stamps);
+}
+
+u32 spatial_grid_insert(Spatial_Grid *grid, AABB bounds) {
+    u32 item = array_list_length(&grid->bounds);
+    array_list_append(&grid->bounds, bounds);
+    array_list_append(&grid->stamps, grid->stamp);
+
+    s32 x0 = cell_coordinate(grid, bounds.p0.x);
+    s32 y0 = cell_coordinate(grid, bounds.p0.y);
+    s32 x1 = cell_coordinate(grid, bounds.p1.x);
+    s32 y1 = cell_coordinate(grid, bounds.p1.y);
+
+    if ((s64)(x1 - x0 + 1) * (s64)(y1 - y0 + 1) > SPATIAL_GRID_MAX_ITEM_CELLS) {
+        array_list_append(&grid->large_items, item);
+        return item;
+    }
+
+    for (s32 y = y0; y <= y1; y++) {
+        for (s32 x = x0; x <= x1; x++) {
+            u32 bucket = cell_bucket(x, y);
+            Spatial_Grid_Entry entry = {
+                .x      = x,
+                .y      = y,
+                .item   = item,
+                .next   = grid->buckets[bucket],
+            };
+            array_list_append(&grid->entries, entry);
+            grid->buckets[bucket] = array_list_length(&grid->entries);
+        }
+    }
+
+    return item;
+}
+
+void spatial_grid_query(Spatial_Grid *grid, AABB region, u32 **result) {
+    grid->stamp++;
+
+    u32 items_count = array_list_length(&grid->bounds);
+
+    s32 x0 = cell_coordinate(grid, region.p0.x);
+    s32 y0 = cell_coordinate(grid, region.p0.y);
+    s32 x1 = cell_coordinate(grid, region.p1.x);
+    s32 y1 = cell_coordinate(grid, region.p1.y);
+
+    // When region is huge compared to the amount of items, checking all of them is cheaper than walking cells.
+    if ((s64)(x1 - x0 + 1) * (s64)(y1 - y0 + 1) > (s64)items_count) {
+        for (u32 i = 0; i < items_count; i++) {
+            query_add(grid, i, &region, result);
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < array_list_length(&grid->large_items); i++) {
+        query_add(grid, grid->large_items[i], &region, result);
+    }
+
+    for (s32 y = y0; y <= y1; y++) {
+        for (s32 x = x0; x <= x1; x++) {
+            for (u32 link = grid->buckets[cell_bucket(x, y)]; link != 0; link = grid->entries[link - 1].next) {
+                Spatial_Grid_Entry *entry = &grid->entries[link - 1];
+                if (entry->x == x && entry->y == y) {
+                    query_add(grid, entry->item, &region, result);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+
+/**
+ * Spatial grid.
+ * Items are put into every grid cell their AABB touches, cells are kept in a hash table, so world doesn't have to be bounded.
+ * Query only walks cells of the region, so its cost depends on what is in the region, not on how many items there are.
+ *
+ * Items are numbered in insertion order, so they can be indicies of the array they come from.
+ * Grid isn't updated when items move, it is cleared and filled again.
+ */
+
+#define SPATIAL_GRID_BUCKETS            4096    // Power of two.
+#define SPATIAL_GRID_MAX_ITEM_CELLS     64      // Items that touch more cells are kept in a list that every query checks.
+
+typedef struct spatial_grid_entry {
+    s32 x;
+    s32 y;
+    u32 item;
+    u32 next;           // Next entry index + 1 in the same bucket, 0 is end.
+} Spatial_Grid_Entry;
+
+typedef struct spatial_grid {
+    float               cell_size;
+    u32                 buckets[SPATIAL_GRID_BUCKETS];  // First entry index + 1, 0 is empty.
+    Spatial_Grid_Entry  *entries;                       // Array list.
+    u32                 *large_items;                   // Array list.
+    AABB                *bounds;                        // Array list, indexed by item.
+    u32                 *stamps;                        // Array list, indexed by item, last query item was added to result in.
+    u32                 stamp;
+} Spatial_Grid;
+
+void spatial_grid_init(Spatial_Grid *grid, float cell_size);
+
+void spatial_grid_free(Spatial_Grid *grid);
+
+/**
+ * Removes all items, numbering starts from 0 again.
+ */
+void spatial_grid_clear(Spatial_Grid *grid);
+
+/**
+ * Adds item and returns its number.
+ */
+u32 spatial_grid_insert(Spatial_Grid *grid, AABB bounds);
+
+/**
+ * Appends numbers of items which bounds touch the region into "result" array list, each item once, in no specific order.
+ * If region covers more cells than there are items, all items are checked directly instead.
+ */
+void spatial_grid_query(Spatial_Grid *grid, AABB region, u32 **result);
+
+#endif
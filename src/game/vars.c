@@ -1,17 +1,13 @@
 #include "game/vars.h"
 
-#include "meta_generated.h"
-
-#include "game/game.h"
-#include "game/asset.h"
-#include "game/console.h"
-
 #include "core/core.h"
 #include "core/str.h"
+#include "core/num.h"
 #include "core/file.h"
 #include "core/structs.h"
 
 #include <stddef.h>
+#include <stdio.h>
 
 
 typedef struct vars_tree_builder {
@@ -369,7 +365,7 @@ void vars_load_file(String file_path, Vars_Tree *tree) {
                     return;
                 }
 
-                *(s64 *)current_key->data = str_parse_int(literal);
+                *(s64 *)current_key->data = num_parse_s64(literal);
 
                 current_key = NULL;
                 break;
@@ -379,7 +375,7 @@ void vars_load_file(String file_path, Vars_Tree *tree) {
                     return;
                 }
 
-                *(float *)current_key->data = str_parse_float(literal);
+                *(float *)current_key->data = num_parse_f32(literal);
 
                 current_key = NULL;
 
@@ -395,20 +391,3 @@ void vars_load_file(String file_path, Vars_Tree *tree) {
     allocator_free(&std_allocator, _content.data);
 }
 
-
-
-
-
-void vars_listen_to_changes(Vars_Tree *tree) {
-    u32 count;
-    const Asset_Change *changes;
-
-    if (asset_view_changes(&count, &changes)) {
-        for (u32 i = 0; i < count; i++) {
-            if (str_equals(changes[i].file_format, VARS_FILE_FORMAT)) {
-                console_log("Vars detected Asset Change: '%.*s'\n", UNPACK(changes[i].full_path));
-                vars_load_file(changes[i].full_path, tree);
-            }
-        }
-    }
-}
@@ -58,9 +58,4 @@ void vars_tree_print_node(Vars_Node *node, s64 depth);
  */
 void vars_load_file(String file_path, Vars_Tree *tree);
 
-/**
- * This function insures .vars files are listened to and properly loaded once any of those files are changed.
- */
-void vars_listen_to_changes();
-
 #endif
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "core/type.h"
 #include "core/typeinfo.h"
@@ -40,6 +41,21 @@ static Arena arena_type_info_enum_member; // @Leak.
 
 static Type_Info **type_table; // @Leak.
 
+// Type infos point into arenas and generated file refers to them by offset, so arenas can't move to grow, they are made big enough instead.
+#define META_ARENA_SIZE (256*KB)
+
+/**
+ * Same as "arena_alloc()", but meta can't go on without memory, so it exits with an error when arena is full.
+ */
+static void *meta_arena_alloc(Arena *arena, u64 size) {
+    void *ptr = arena_alloc(arena, size);
+    if (ptr == NULL) {
+        printf_err("Meta arena of %llu bytes is full, increase META_ARENA_SIZE.\n", (unsigned long long)arena->capacity);
+        exit(1);
+    }
+    return ptr;
+}
+
 
 
 // Maybe move current state of meta processing to a separate struct that might contain all of the info like current_file_name, etc.
@@ -53,8 +69,19 @@ static Type_Info **registered_functions; // @Leak.
 static String *registered_functions_headers; // @Leak.
 
 
+// Profile vars.
+typedef struct profile_insert {
+    s64 offset;         // Offset in the file content right after '{' of the function body.
+    char text[192];     // Zone that is inserted at the offset.
+} Profile_Insert;
+
+static Profile_Insert *profile_inserts; // @Leak.
+
+static const String PROFILE_INCLUDE = STR_BUFFER("#include \"core/profile.h\"\n#line 1\n");
+
+
 // @Important: We take responsability, of preserving all important strings even after contents of the file are disposed, it means all important typenames are copied into 'arena_strings'
-#define SAVE_STRING(str) (str).data = str_copy_to((str), arena_alloc(&arena_strings, (str).length))
+#define SAVE_STRING(str) (str).data = str_copy_to((str), meta_arena_alloc(&arena_strings, (str).length))
 
 
 
@@ -109,7 +136,7 @@ String type_table_add_pointer(String base_typename, s64 asterisk_count) {
     // Buffer will contain both actual typename and enum ready typename:
     // For example: "char***" and "char_ptr_ptr_ptr"     *sigh* . . . 
     // Yes this is stupid but it works well.
-    char *buffer = arena_alloc(&arena_strings,  (base_typename.length + asterisk_count)+ (base_typename.length + asterisk_count * TYPE_PTR_POSTFIX.length));
+    char *buffer = meta_arena_alloc(&arena_strings,  (base_typename.length + asterisk_count)+ (base_typename.length + asterisk_count * TYPE_PTR_POSTFIX.length));
 
     char *ptr_typename      = str_copy_to(base_typename, buffer);
     char *ptr_enum_typename = str_copy_to(base_typename, buffer + base_typename.length + asterisk_count);
@@ -136,7 +163,7 @@ String type_table_add_pointer(String base_typename, s64 asterisk_count) {
         }
 
         // Putting pointer.
-        Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+        Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
         *item = ((Type_Info) { POINTER, typename, POINTER_SIZE, POINTER_SIZE, .t_pointer = { base_type } });
         hash_table_put(&type_table, item, UNPACK(enum_typename));
     }
@@ -175,7 +202,7 @@ int type_table_add_typedef(String typename, String typedef_typename) {
     }
 
     // Putting typedef.
-    Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { TYPEDEF, typedef_typename, 0, 0, .t_typedef = { typedef_of } });
     hash_table_put(&type_table, item, UNPACK(typedef_typename) );
 
@@ -183,7 +210,7 @@ int type_table_add_typedef(String typename, String typedef_typename) {
 }
 
 void type_table_add_unknown(String typename) {
-    Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { UNKNOWN, typename, 0, 0 });
 
     hash_table_put(&type_table, item, UNPACK(typename));
@@ -191,7 +218,7 @@ void type_table_add_unknown(String typename) {
 
 
 Type_Info* type_table_add_struct(String typename) {
-    Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { STRUCT, typename, 0, 0, .t_struct = { 0, arena_type_info_struct_member.ptr } });
     hash_table_put(&type_table, item, UNPACK(typename));
     return item;
@@ -200,7 +227,7 @@ Type_Info* type_table_add_struct(String typename) {
 void type_table_add_struct_member(Type_Info *struct_type, String member_typename, String member_name) {
     Type_Info *member_type = *(Type_Info **)(hash_table_get(&type_table, UNPACK(member_typename)));
 
-    Type_Info_Struct_Member *member = arena_alloc(&arena_type_info_struct_member, sizeof(Type_Info_Struct_Member));
+    Type_Info_Struct_Member *member = meta_arena_alloc(&arena_type_info_struct_member, sizeof(Type_Info_Struct_Member));
 
     *member = ((Type_Info_Struct_Member) { member_type, member_name, 0 });
 
@@ -211,7 +238,7 @@ void type_table_add_struct_member(Type_Info *struct_type, String member_typename
 
 
 Type_Info* type_table_add_enum(String typename) {
-    Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { ENUM, typename, 4, 4, .t_enum = { true, 0, arena_type_info_enum_member.ptr } });
     hash_table_put(&type_table, item, UNPACK(typename));
     return item;
@@ -219,7 +246,7 @@ Type_Info* type_table_add_enum(String typename) {
 
 void type_table_add_enum_member(Type_Info *enum_type, String member_name, u64 value) {
     
-    Type_Info_Enum_Member *member = arena_alloc(&arena_type_info_enum_member, sizeof(Type_Info_Enum_Member));
+    Type_Info_Enum_Member *member = meta_arena_alloc(&arena_type_info_enum_member, sizeof(Type_Info_Enum_Member));
 
     *member = ((Type_Info_Enum_Member) { member_name, value });
 
@@ -241,7 +268,7 @@ Type_Info* type_table_add_function(Type_Info *return_type, String typename) {
     s64 index_of__m = str_find(definition_file, STR_BUFFER("_m"));
 
     if (index_of__m != -1) {
-        char *file_path = arena_alloc(&arena_strings, definition_file.length - 2);
+        char *file_path = meta_arena_alloc(&arena_strings, definition_file.length - 2);
         memcpy(file_path, definition_file.data, index_of__m);
         memcpy(file_path + index_of__m, definition_file.data + index_of__m + 2, definition_file.length - 2 - index_of__m);
         definition_file.data = file_path;
@@ -252,7 +279,7 @@ Type_Info* type_table_add_function(Type_Info *return_type, String typename) {
     }
 
 
-    Type_Info *item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    Type_Info *item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { FUNCTION, typename, 0, 0, .t_function = { return_type, 0, arena_type_info_function_argument.ptr, definition_file } });
     hash_table_put(&type_table, item, UNPACK(typename));
     return item;
@@ -261,7 +288,7 @@ Type_Info* type_table_add_function(Type_Info *return_type, String typename) {
 void type_table_add_function_argument(Type_Info *function_type, String arg_typename, String arg_name) {
     Type_Info *arg_type = *(Type_Info **)(hash_table_get(&type_table, UNPACK(arg_typename)));
 
-    Type_Info_Function_Argument *arg = arena_alloc(&arena_type_info_function_argument, sizeof(Type_Info_Function_Argument));
+    Type_Info_Function_Argument *arg = meta_arena_alloc(&arena_type_info_function_argument, sizeof(Type_Info_Function_Argument));
 
     *arg = ((Type_Info_Function_Argument) { arg_type, arg_name });
 
@@ -359,72 +386,76 @@ void registered_functions_init() {
     registered_functions_headers = array_list_make(String, 8, &std_allocator);
 }
 
+void profile_inserts_init() {
+    profile_inserts = array_list_make(Profile_Insert, 8, &std_allocator);
+}
+
 
 void type_table_init() {
-    arena_strings                       = arena_make(4*KB);
-    arena_type_info                     = arena_make(2*KB);
-    arena_type_info_function_argument   = arena_make(2*KB);
-    arena_type_info_struct_member       = arena_make(2*KB);
-    arena_type_info_enum_member         = arena_make(2*KB);
+    arena_strings                       = arena_make(META_ARENA_SIZE);
+    arena_type_info                     = arena_make(META_ARENA_SIZE);
+    arena_type_info_function_argument   = arena_make(META_ARENA_SIZE);
+    arena_type_info_struct_member       = arena_make(META_ARENA_SIZE);
+    arena_type_info_enum_member         = arena_make(META_ARENA_SIZE);
 
     type_table = hash_table_make(Type_Info *, 32, &std_allocator);
 
     Type_Info *item;
 
     // Most basic C types
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("int"), 4, 4, .t_integer = { 32, true } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("int") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("char"), 1, 1, .t_integer = { 8, false } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("char") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { FLOAT, CSTR("float"), 4, 4, .t_float = { 32 } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("float") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { BOOL, CSTR("bool"), 1, 1 });
     hash_table_put(&type_table, item, UNPACK_LITERAL("bool") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { VOID, CSTR("void"), 0, 0 });
     hash_table_put(&type_table, item, UNPACK_LITERAL("void") );
 
     // Custom int typedefs that are commonly used, making them as actual int meta types for simplicity.
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("s8"), 1, 1, .t_integer = { 8, true } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("s8") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("u8"), 1, 1, .t_integer = { 8, false } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("u8") );
 
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("s16"), 2, 2, .t_integer = { 16, true } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("s16") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("u16"), 2, 2, .t_integer = { 16, false } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("u16") );
 
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("s32"), 4, 4, .t_integer = { 32, true } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("s32") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("u32"), 4, 4, .t_integer = { 32, false } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("u32") );
 
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("s64"), 8, 8, .t_integer = { 64, true } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("s64") );
 
-    item = arena_alloc(&arena_type_info, sizeof(Type_Info));
+    item = meta_arena_alloc(&arena_type_info, sizeof(Type_Info));
     *item = ((Type_Info) { INTEGER, CSTR("u64"), 8, 8, .t_integer = { 64, false } });
     hash_table_put(&type_table, item, UNPACK_LITERAL("u64") );
 }
@@ -1003,6 +1034,153 @@ int meta_note_process_RegisterCommand(Lexer lexer, FILE *output_h) {
 
 
 
+void meta_replace_with_space(String metanote_str) {
+    for (s64 i = 0; i < metanote_str.length; i++) {
+        // Keeping new lines, so line numbers stay the same.
+        if (metanote_str.data[i] != '\n') {
+            metanote_str.data[i] = ' ';
+        }
+    }
+}
+
+/**
+ * This is a comment of what @Profile EXPECTS.
+ *
+ * [optional '(' [SYMBOL sample, threshold_us] ['='] [NUMBER] [optional ','] ... ')'] [';'] ... [SYMBOL function name] ['(...)'] ['{']
+ *  Examples:
+ *      @Profile;
+ *      void phys_update(...) {
+ *
+ *      @Profile(sample = 8, threshold_us = 20);
+ *      void vertex_buffer_draw_quads(...) {
+ *
+ * Zone named after the function is inserted right after '{' on the same line, so line numbers in the file stay the same.
+ * There is no explicit zone exit, PROFILE_NOTE closes the zone on every return path with cleanup attribute.
+ * Note is removed from the source with its arguments.
+ */
+int meta_note_process_Profile(Lexer lexer, Token note) {
+    Token next;
+
+    s64 sample_rate = 1;
+    s64 threshold_us = 0;
+
+    // Parsing optional arguments.
+    next = lexer_next_token(&lexer);
+    if (next.type == TOKEN_PARAN_OPEN) {
+        while (true) {
+            next = lexer_next_token(&lexer);
+
+            if (next.type == TOKEN_PARAN_CLOSE) break;
+
+            if (next.type == TOKEN_COMMA) continue;
+
+            if (parser_expect_token_type(&next, TOKEN_SYMBOL) != 0) {
+                return 1;
+            }
+
+            String argument = next.str;
+
+            if (parser_get_and_expect_token(&lexer, &next, TOKEN_ASSIGN) != 0) {
+                return 1;
+            }
+
+            if (parser_get_and_expect_token(&lexer, &next, TOKEN_NUMBER) != 0) {
+                return 1;
+            }
+
+            s64 value = str_parse_int(next.str);
+
+            if (str_equals(argument, CSTR("sample"))) {
+                if (value < 1) {
+                    printf_err("%s:%lld @Profile: Sample rate should be at least 1, got: '%.*s'\n", current_file_name, next.line_num, UNPACK(next.str));
+                    return 1;
+                }
+                sample_rate = value;
+            } else if (str_equals(argument, CSTR("threshold_us"))) {
+                if (value < 0) {
+                    printf_err("%s:%lld @Profile: Threshold can't be negative, got: '%.*s'\n", current_file_name, next.line_num, UNPACK(next.str));
+                    return 1;
+                }
+                threshold_us = value;
+            } else {
+                printf_err("%s:%lld @Profile: Unknown argument: '%.*s', expected 'sample' or 'threshold_us'.\n", current_file_name, next.line_num, UNPACK(argument));
+                return 1;
+            }
+        }
+
+        next = lexer_next_token(&lexer);
+    }
+
+    if (parser_expect_token_type(&next, TOKEN_SEMICOLON) != 0) {
+        return 1;
+    }
+
+    String note_full = STR(next.str.data + next.str.length - note.str.data, note.str.data);
+
+
+    // Function name is the last symbol before '('.
+    String function_name = {0};
+    while (true) {
+        next = lexer_next_token(&lexer);
+
+        if (next.type == TOKEN_PARAN_OPEN) break;
+
+        if (next.type == TOKEN_ZERO || next.type == TOKEN_SEMICOLON || next.type == TOKEN_CURLY_OPEN) {
+            printf_err("%s:%lld @Profile: Expected function definition after the note.\n", current_file_name, note.line_num);
+            return 1;
+        }
+
+        if (next.type == TOKEN_SYMBOL) {
+            function_name = next.str;
+        }
+    }
+
+    if (function_name.length == 0) {
+        printf_err("%s:%lld @Profile: Missing function name.\n", current_file_name, next.line_num);
+        return 1;
+    }
+
+    // Skipping arguments.
+    s64 depth = 1;
+    while (depth > 0) {
+        next = lexer_next_token(&lexer);
+
+        if (next.type == TOKEN_ZERO) {
+            printf_err("%s:%lld @Profile: Unexpected end of file in '%.*s' arguments.\n", current_file_name, next.line_num, UNPACK(function_name));
+            return 1;
+        }
+
+        if (next.type == TOKEN_PARAN_OPEN)  depth++;
+        if (next.type == TOKEN_PARAN_CLOSE) depth--;
+    }
+
+    // Only definitions can be profiled.
+    next = lexer_next_token(&lexer);
+    if (next.type != TOKEN_CURLY_OPEN) {
+        printf_err("%s:%lld @Profile: Expected '{' of '%.*s' body, only function definitions can be profiled.\n", current_file_name, next.line_num, UNPACK(function_name));
+        return 1;
+    }
+
+
+    Profile_Insert insert;
+    insert.offset = next.str.data + next.str.length - lexer.content.data;
+    (void)snprintf(insert.text, sizeof(insert.text), " PROFILE_NOTE(\"%.*s\", %lld, %lldull);", (int)function_name.length, function_name.data, (long long)sample_rate, (long long)threshold_us * 1000);
+
+    array_list_append(&profile_inserts, insert);
+
+    // Removing meta note with arguments from final source.
+    meta_replace_with_space(note_full);
+
+    return 0;
+}
+
+
+
+
+
+
+
+
 /**
  * END
  */
@@ -1010,14 +1188,51 @@ int meta_note_process_RegisterCommand(Lexer lexer, FILE *output_h) {
 
 
 
+/**
+ * Writes content with inserted profile zones, if there are any.
+ * Include of the profiler is prepended, followed by '#line 1', so line numbers stay the same.
+ */
+int meta_write_with_profile_inserts(String content, char *file_name) {
+    u32 inserts_count = array_list_length(&profile_inserts);
+    if (inserts_count == 0) {
+        return write_str_to_file(content, file_name);
+    }
+
+    s64 length = PROFILE_INCLUDE.length + content.length;
+    for (u32 i = 0; i < inserts_count; i++) {
+        length += strlen(profile_inserts[i].text);
+    }
+
+    String output = STR(0, allocator_alloc(&std_allocator, length));
+    if (output.data == NULL) {
+        printf_err("Couldn't allocate %lld bytes for profiled source '%s'\n", length, file_name);
+        return 1;
+    }
 
+    memcpy(output.data, PROFILE_INCLUDE.data, PROFILE_INCLUDE.length);
+    output.length += PROFILE_INCLUDE.length;
 
+    // Inserts are appended in order of the notes, so they are already sorted by offset.
+    s64 content_offset = 0;
+    for (u32 i = 0; i < inserts_count; i++) {
+        s64 text_length = strlen(profile_inserts[i].text);
 
+        memcpy(output.data + output.length, content.data + content_offset, profile_inserts[i].offset - content_offset);
+        output.length += profile_inserts[i].offset - content_offset;
+        content_offset = profile_inserts[i].offset;
 
-void meta_replace_with_space(String metanote_str) {
-    for (s64 i = 0; i < metanote_str.length; i++) {
-        metanote_str.data[i] = ' ';
+        memcpy(output.data + output.length, profile_inserts[i].text, text_length);
+        output.length += text_length;
     }
+
+    memcpy(output.data + output.length, content.data + content_offset, content.length - content_offset);
+    output.length += content.length - content_offset;
+
+    int result = write_str_to_file(output, file_name);
+
+    allocator_free(&std_allocator, output.data);
+
+    return result;
 }
 
 
@@ -1032,6 +1247,8 @@ int meta_process_file(char *file_name, FILE *output_h, char *output_path) {
 #endif
 
     current_file_name = file_name;
+
+    array_list_clear(&profile_inserts);
     
     String _content = read_file_into_str(current_file_name, &std_allocator);
 
@@ -1082,6 +1299,13 @@ int meta_process_file(char *file_name, FILE *output_h, char *output_path) {
                 goto metanote_remove_continue;
             }
 
+            if (str_equals(next.str, CSTR("@Profile"))) {
+                // Removes itself with arguments.
+                if (meta_note_process_Profile(lexer, next) != 0) 
+                    return 1;
+                continue;
+            }
+
             printf_err("%s:%lld Unknown meta note: '%.*s'.\n", current_file_name, lexer.line_num, UNPACK(next.str));
             return 1;
 
@@ -1105,7 +1329,7 @@ metanote_remove_continue:
 #endif
     
 
-    if (write_str_to_file(_content, src_file_name) != 0) {
+    if (meta_write_with_profile_inserts(_content, src_file_name) != 0) {
         printf_err("Couldn't create source file '%s'\n", src_file_name);
         return 1;
     }
@@ -1182,6 +1406,7 @@ int meta_process(int count, char **files, char *output_path) {
 #endif
 
     registered_functions_init();
+    profile_inserts_init();
     type_table_init();
 
     char *meta_generated_file_name = "src/meta_generated.h";
@@ -0,0 +1,90 @@
+#include "core/core.h"
+#include "core/str.h"
+
+#include "test/test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define TEST_DEFAULT_SEED 0x9E3779B97F4A7C15ull
+
+
+/**
+ *  How to use:
+ *
+ *      Run all tests, or only ones which names contain filter, returns 1 if any of them failed:
+ *      $ test.exe [-filter ...] [-seed ...]
+ *
+ *      Also run exhaustive tests, they take minutes:
+ *      $ test.exe -exhaustive
+ *
+ *      Rewrite checked in reference files with current results, instead of comparing against them:
+ *      $ test.exe -update [-filter ...]
+ *
+ */
+int main(int argc, char **argv) {
+
+    char *filter = NULL;
+    u64 seed = TEST_DEFAULT_SEED;
+    bool exhaustive = false;
+    bool update_references = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+
+        } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+
+        } else if (strcmp(argv[i], "-exhaustive") == 0) {
+            exhaustive = true;
+
+        } else if (strcmp(argv[i], "-update") == 0) {
+            update_references = true;
+
+        } else {
+            printf_err("Unknown or incomplete command line option: '%s'\n", argv[i]);
+            return 2;
+        }
+    }
+
+
+    struct {
+        Test_Case *cases;
+        s64 count;
+    } groups[] = {
+        { test_cases_core, test_cases_core_count },
+        { test_cases_game, test_cases_game_count },
+    };
+
+    s64 ran = 0;
+    s64 failed = 0;
+
+    for (s64 g = 0; g < (s64)(sizeof(groups) / sizeof(groups[0])); g++) {
+        for (s64 i = 0; i < groups[g].count; i++) {
+            Test_Case *test_case = groups[g].cases + i;
+
+            if (filter != NULL && strstr(test_case->name, filter) == NULL) {
+                continue;
+            }
+            if (test_case->exhaustive && !exhaustive) {
+                continue;
+            }
+
+            ran++;
+            if (!test_run(test_case, seed, update_references)) {
+                failed++;
+            }
+        }
+    }
+
+    if (failed > 0) {
+        printf_err("%lld of %lld tests failed.\n", (long long)failed, (long long)ran);
+        return 1;
+    }
+
+    printf_ok("%lld tests passed.\n", (long long)ran);
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include "test/test.h"
+
+#include "core/core.h"
+#include "core/type.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+
+
+
+bool test_check(Test *t, bool condition, const char *file, s32 line, const char *format, ...) {
+    t->checks++;
+    if (condition) {
+        return true;
+    }
+
+    t->failures++;
+    if (t->failures <= TEST_MAX_REPORTED_FAILURES) {
+        va_list args;
+        va_start(args, format);
+        (void)fprintf(stderr, "%s %s:%d: %s: ", debug_error_str, file, line, t->name);
+        (void)vfprintf(stderr, format, args);
+        (void)fprintf(stderr, "\n");
+        va_end(args);
+    }
+
+    return false;
+}
+
+void test_skip(Test *t, const char *reason) {
+    t->skipped = true;
+    (void)fprintf(stderr, "%s %s: skipped, %s.\n", debug_warning_str, t->name, reason);
+}
+
+u64 test_random(Test *t) {
+    t->random_state ^= t->random_state >> 12;
+    t->random_state ^= t->random_state << 25;
+    t->random_state ^= t->random_state >> 27;
+    return t->random_state * 0x2545F4914F6CDD1Dull;
+}
+
+s64 test_random_range(Test *t, s64 min, s64 max) {
+    return min + (s64)(test_random(t) % (u64)(max - min + 1));
+}
+
+
+
+bool test_run(Test_Case *test_case, u64 seed, bool update_references) {
+    Test t = {
+        .name               = test_case->name,
+        .random_state       = seed != 0 ? seed : 1,     // Xorshift state can't be 0.
+        .update_references  = update_references,
+    };
+
+    u64 start = get_time_ns();
+    test_case->procedure(&t);
+    u64 elapsed_ms = (get_time_ns() - start) / 1000000;
+
+    if (t.failures > TEST_MAX_REPORTED_FAILURES) {
+        (void)fprintf(stderr, "%s %s: %lld more failures weren't printed.\n", debug_error_str, t.name, (long long)(t.failures - TEST_MAX_REPORTED_FAILURES));
+    }
+
+    const char *status = t.failures > 0 ? debug_error_str : t.skipped ? debug_warning_str : debug_ok_str;
+    (void)fprintf(stderr, "%s %-36s %10lld checks %8llu ms\n", status, t.name, (long long)t.checks, (unsigned long long)elapsed_ms);
+
+    return t.failures == 0;
+}
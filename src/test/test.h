@@ -0,0 +1,84 @@
+#ifndef TEST_H
+#define TEST_H
+
+/**
+ * Tests.
+ *
+ * Each test is a procedure that checks its results with "test_expect()", test fails if any of the checks failed:
+ *
+ *      void test_foo(Test *t) {
+ *          s64 result = foo(3);
+ *          test_expect(t, result == 9, "foo(3) returned %lld", result);
+ *      }
+ *
+ * Randomized tests take their numbers from "test_random()", which is seeded the same way for every test,
+ * so failure can be reproduced by running the same test with the same seed.
+ */
+
+#include "core/type.h"
+
+#include <stdbool.h>
+
+
+#define TEST_MAX_REPORTED_FAILURES 16
+
+typedef struct test {
+    const char *name;
+    s64 checks;
+    s64 failures;
+    u64 random_state;
+    bool update_references;     // Tests that compare against checked in files rewrite them instead.
+    bool skipped;
+} Test;
+
+typedef void (*Test_Procedure)(Test *t);
+
+typedef struct test_case {
+    const char *name;
+    Test_Procedure procedure;
+    bool exhaustive;            // Takes minutes, only runs when asked for with "-exhaustive".
+} Test_Case;
+
+
+/**
+ * Counts the check, and prints the message with location if "condition" is false.
+ * Only first TEST_MAX_REPORTED_FAILURES failures of a test are printed, the rest are counted.
+ * Returns "condition", so test can stop early when the rest depends on it.
+ */
+#define test_expect(t, condition, format, ...) test_check(t, condition, __FILE__, __LINE__, format, ##__VA_ARGS__)
+
+bool test_check(Test *t, bool condition, const char *file, s32 line, const char *format, ...) __attribute__((format(printf, 5, 6)));
+
+/**
+ * Marks test as skipped with the reason, for tests that need something this machine doesn't have, like a display.
+ * Test still passes, so it should return right after.
+ */
+void test_skip(Test *t, const char *reason);
+
+/**
+ * Returns next pseudo random number of the test (xorshift64*).
+ */
+u64 test_random(Test *t);
+
+/**
+ * Returns pseudo random number in [ min, max ].
+ */
+s64 test_random_range(Test *t, s64 min, s64 max);
+
+
+
+/**
+ * Runs single test case, returns true if it passed.
+ */
+bool test_run(Test_Case *test_case, u64 seed, bool update_references);
+
+
+
+// Test cases, each module registers its own.
+extern Test_Case test_cases_core[];
+extern s64 test_cases_core_count;
+
+extern Test_Case test_cases_game[];
+extern s64 test_cases_game_count;
+
+#endif
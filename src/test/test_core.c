@@ -0,0 +1,543 @@
+#include "test/test.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/str.h"
+#include "core/num.h"
+#include "core/thread.h"
+#include "core/mathf.h"
+#include "core/log.h"
+#include "core/profile.h"
+#include "core/typeinfo.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * Numbers.
+ * Every float has to survive "num_format_f32()" -> "num_parse_f32()" bit for bit, NaNs only have to stay NaNs,
+ * since formatting doesn't keep their sign and payload.
+ */
+
+#define TEST_F32_SAMPLES            (1 << 20)
+#define TEST_F32_THREADS            16
+#define TEST_F32_REPORTED_BITS      4
+
+typedef struct test_f32_range {
+    u64 start;
+    u64 end;                            // Exclusive, so the whole range of 2^32 patterns fits.
+    u64 mismatches;
+    u32 mismatch_bits[TEST_F32_REPORTED_BITS];
+} Test_F32_Range;
+
+/**
+ * Returns true if "bits" round trip, writes parsed bits into "result".
+ */
+static bool test_f32_round_trip(u32 bits, u32 *result) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+
+    char buffer[NUM_F32_MAX_CHARS];
+    s64 length = num_format_f32(value, buffer);
+
+    float parsed = num_parse_f32(STR(length, buffer));
+    memcpy(result, &parsed, sizeof(*result));
+
+    if (isnan(value)) {
+        return isnan(parsed);
+    }
+    return *result == bits;
+}
+
+static void test_f32_range_procedure(void *data) {
+    Test_F32_Range *range = data;
+
+    for (u64 i = range->start; i < range->end; i++) {
+        u32 result;
+        if (!test_f32_round_trip((u32)i, &result)) {
+            if (range->mismatches < TEST_F32_REPORTED_BITS) {
+                range->mismatch_bits[range->mismatches] = (u32)i;
+            }
+            range->mismatches++;
+        }
+    }
+}
+
+static void test_num_f32_round_trip(Test *t) {
+    // Edges of every class first: zeros, smallest and largest subnormals and normals, infinities and NaNs.
+    u32 edges[] = {
+        0x00000000, 0x80000000, 0x00000001, 0x80000001, 0x007FFFFF, 0x00800000, 0x00800001,
+        0x3F800000, 0x3F7FFFFF, 0x3F800001, 0x7F7FFFFF, 0xFF7FFFFF, 0x7F800000, 0xFF800000,
+        0x7FC00000, 0xFFC00000, 0x7F800001, 0x4B000000, 0x4AFFFFFF, 0x5F000000, 0x2F800000,
+    };
+
+    for (u32 i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+        u32 result;
+        bool ok = test_f32_round_trip(edges[i], &result);
+        test_expect(t, ok, "0x%08X parsed back as 0x%08X", edges[i], result);
+    }
+
+    for (s64 i = 0; i < TEST_F32_SAMPLES; i++) {
+        u32 bits = (u32)test_random(t);
+        u32 result;
+        bool ok = test_f32_round_trip(bits, &result);
+        test_expect(t, ok, "0x%08X parsed back as 0x%08X", bits, result);
+    }
+}
+
+static void test_num_f32_round_trip_exhaustive(Test *t) {
+    Test_F32_Range ranges[TEST_F32_THREADS] = {0};
+    Thread threads[TEST_F32_THREADS];
+    bool started[TEST_F32_THREADS] = {0};
+
+    u64 total = 1ull << 32;
+    for (s32 i = 0; i < TEST_F32_THREADS; i++) {
+        ranges[i].start = total / TEST_F32_THREADS * i;
+        ranges[i].end   = total / TEST_F32_THREADS * (i + 1);
+
+        started[i] = thread_create(&threads[i], test_f32_range_procedure, &ranges[i]);
+        if (!started[i]) {
+            test_f32_range_procedure(&ranges[i]);
+        }
+    }
+
+    for (s32 i = 0; i < TEST_F32_THREADS; i++) {
+        if (started[i]) {
+            thread_join(threads[i]);
+        }
+    }
+
+    for (s32 i = 0; i < TEST_F32_THREADS; i++) {
+        for (u64 m = 0; m < ranges[i].mismatches && m < TEST_F32_REPORTED_BITS; m++) {
+            u32 result;
+            test_f32_round_trip(ranges[i].mismatch_bits[m], &result);
+            test_expect(t, false, "0x%08X parsed back as 0x%08X", ranges[i].mismatch_bits[m], result);
+        }
+        test_expect(t, ranges[i].mismatches == 0, "%llu patterns in [ 0x%08llX, 0x%08llX ) didn't round trip",
+            (unsigned long long)ranges[i].mismatches, (unsigned long long)ranges[i].start, (unsigned long long)ranges[i].end);
+    }
+}
+
+
+
+/**
+ * Strings.
+ * Vectorized scanning functions are compared against plain loops over random strings of random lengths and alignments.
+ * Strings are placed so they end right before an unreadable page, or cross the boundary between two readable pages,
+ * so reading past the end faults, and matches are planted at the first and last byte and at the page boundary.
+ */
+
+#define TEST_STR_ITERATIONS     200000
+#define TEST_STR_MAX_LENGTH     300
+#define TEST_STR_SEARCH_LENGTH  8
+
+// Mostly few letters and whitespace so matches are frequent, with bytes above 0x7F that are negative as char.
+static const char test_str_alphabet[] = { 'a', 'b', 'c', ' ', '\t', '\n', '\v', '\f', '\r', '\x08', '\x0E', '\x1F', '!', '\x80', '\xA0', '\xFF' };
+
+#if OS == WINDOWS
+
+#include <windows.h>
+
+static u64 test_page_size() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+}
+
+/**
+ * Returns two readable pages followed by an unreadable one.
+ */
+static char *test_guarded_pages_make(u64 page_size) {
+    char *pages = VirtualAlloc(NULL, page_size * 3, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    DWORD old_protection;
+    if (pages == NULL || !VirtualProtect(pages + page_size * 2, page_size, PAGE_NOACCESS, &old_protection)) {
+        return NULL;
+    }
+    return pages;
+}
+
+static void test_guarded_pages_free(char *pages, u64 page_size) {
+    (void)page_size;
+    VirtualFree(pages, 0, MEM_RELEASE);
+}
+
+#else
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+static u64 test_page_size() {
+    return (u64)sysconf(_SC_PAGESIZE);
+}
+
+static char *test_guarded_pages_make(u64 page_size) {
+    char *pages = mmap(NULL, page_size * 3, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pages == MAP_FAILED || mprotect(pages + page_size * 2, page_size, PROT_NONE) != 0) {
+        return NULL;
+    }
+    return pages;
+}
+
+static void test_guarded_pages_free(char *pages, u64 page_size) {
+    munmap(pages, page_size * 3);
+}
+
+#endif
+
+static bool test_is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static s64 test_find(String str, String search) {
+    if (search.length <= 0) {
+        return 0;
+    }
+    for (s64 i = 0; i + search.length <= str.length; i++) {
+        if (!memcmp(str.data + i, search.data, search.length)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static s64 test_find_char(String str, char c, bool right) {
+    for (s64 k = 0; k < str.length; k++) {
+        s64 i = right ? str.length - 1 - k : k;
+        if (str.data[i] == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static s64 test_find_space(String str, bool space, bool right) {
+    for (s64 k = 0; k < str.length; k++) {
+        s64 i = right ? str.length - 1 - k : k;
+        if (test_is_space(str.data[i]) == space) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static s64 test_count_chars(String str, char c) {
+    s64 count = 0;
+    for (s64 i = 0; i < str.length; i++) {
+        count += str.data[i] == c;
+    }
+    return count;
+}
+
+/**
+ * Picks where string of "length" starts inside of guarded pages.
+ */
+static char *test_str_place(Test *t, char *pages, u64 page_size, s64 length) {
+    switch (test_random(t) % 3) {
+        case 0:     return pages + page_size * 2 - length;                                          // Ends at the unreadable page.
+        case 1:     return pages + page_size - test_random_range(t, 0, length);                     // Crosses the page boundary.
+        default:    return pages + test_random_range(t, 0, page_size * 2 - length);                 // Anywhere.
+    }
+}
+
+/**
+ * Returns index of a byte worth planting a match at: first, last, the one at the page boundary, or any.
+ */
+static s64 test_str_match_index(Test *t, char *data, s64 length, char *boundary) {
+    switch (test_random(t) % 4) {
+        case 0:     return 0;
+        case 1:     return length - 1;
+        case 2:     return boundary >= data && boundary < data + length ? boundary - data : length - 1;
+        default:    return test_random_range(t, 0, length - 1);
+    }
+}
+
+static void test_str_scanning(Test *t) {
+    u64 page_size = test_page_size();
+    char *pages = test_guarded_pages_make(page_size);
+    if (!test_expect(t, pages != NULL, "couldn't allocate guarded pages")) {
+        return;
+    }
+    char *boundary = pages + page_size;
+
+    for (s64 iteration = 0; iteration < TEST_STR_ITERATIONS; iteration++) {
+        s64 length = test_random_range(t, 0, TEST_STR_MAX_LENGTH);
+        char *data = test_str_place(t, pages, page_size, length);
+
+        // Alphabet is cut randomly, so some strings have no whitespace, or nothing but it.
+        s64 alphabet_start = test_random_range(t, 0, sizeof(test_str_alphabet) - 1);
+        s64 alphabet_end = test_random_range(t, alphabet_start + 1, sizeof(test_str_alphabet));
+        for (s64 i = 0; i < length; i++) {
+            data[i] = test_str_alphabet[test_random_range(t, alphabet_start, alphabet_end - 1)];
+        }
+
+        String str = STR(length, data);
+        char c = test_str_alphabet[test_random(t) % sizeof(test_str_alphabet)];
+
+        if (length > 0) {
+            data[test_str_match_index(t, data, length, boundary)] = c;
+        }
+
+        // Search is either taken from the string itself, so it is found, ends at the match index, or is random.
+        char search_buffer[TEST_STR_SEARCH_LENGTH];
+        String search = STR(test_random_range(t, 0, mini(TEST_STR_SEARCH_LENGTH, length)), search_buffer);
+        if (search.length > 0 && test_random(t) % 4 != 0) {
+            s64 end = test_str_match_index(t, data, length, boundary) + 1;
+            s64 start = maxi(end - search.length, 0);
+            search = STR(end - start, data + start);
+        } else {
+            for (s64 i = 0; i < search.length; i++) {
+                search_buffer[i] = test_str_alphabet[test_random_range(t, alphabet_start, alphabet_end - 1)];
+            }
+        }
+
+        String eaten = str_eat_spaces(str);
+        s64 expected_eaten = test_find_space(str, false, false);
+        expected_eaten = expected_eaten == -1 ? length : expected_eaten;
+
+#define TEST_STR_EXPECT(actual, expected, name) \
+        test_expect(t, (actual) == (expected), name " returned %lld instead of %lld, length %lld, offset %lld", \
+            (long long)(actual), (long long)(expected), (long long)length, (long long)((u64)data & (page_size - 1)))
+
+        TEST_STR_EXPECT(str_find(str, search),                  test_find(str, search),                 "str_find");
+        TEST_STR_EXPECT(str_find_char_left(str, c),             test_find_char(str, c, false),          "str_find_char_left");
+        TEST_STR_EXPECT(str_find_char_right(str, c),            test_find_char(str, c, true),           "str_find_char_right");
+        TEST_STR_EXPECT(str_count_chars(str, c),                test_count_chars(str, c),               "str_count_chars");
+        TEST_STR_EXPECT(str_find_whitespace_left(str),          test_find_space(str, true, false),      "str_find_whitespace_left");
+        TEST_STR_EXPECT(str_find_whitespace_right(str),         test_find_space(str, true, true),       "str_find_whitespace_right");
+        TEST_STR_EXPECT(str_find_non_whitespace_left(str),      test_find_space(str, false, false),     "str_find_non_whitespace_left");
+        TEST_STR_EXPECT(str_find_non_whitespace_right(str),     test_find_space(str, false, true),      "str_find_non_whitespace_right");
+        TEST_STR_EXPECT(eaten.data - data,                      expected_eaten,                         "str_eat_spaces");
+        TEST_STR_EXPECT(eaten.length,                           length - expected_eaten,                "str_eat_spaces length");
+
+#undef TEST_STR_EXPECT
+    }
+
+    test_guarded_pages_free(pages, page_size);
+}
+
+/**
+ * "str_format()" has to write the same bytes and return the same length as snprintf, truncated or not.
+ */
+#define TEST_FORMAT_ITERATIONS  20000
+#define TEST_FORMAT_MAX_LENGTH  48
+
+static char *test_format_strings[] = { NULL, "", "abc", "longer string than precision" };
+
+static void test_str_format(Test *t) {
+    for (s64 iteration = 0; iteration < TEST_FORMAT_ITERATIONS; iteration++) {
+        char actual[TEST_FORMAT_MAX_LENGTH];
+        char expected[TEST_FORMAT_MAX_LENGTH];
+        s64 capacity = test_random_range(t, 0, TEST_FORMAT_MAX_LENGTH);
+
+        char *string = test_format_strings[test_random(t) % (sizeof(test_format_strings) / sizeof(test_format_strings[0]))];
+        s32 integer = (s32)test_random(t);
+        double real = (double)(s32)test_random(t) / (1 << (test_random(t) % 16));
+
+#define TEST_FORMAT_EXPECT(format, ...) do { \
+            String result = str_format(STR(capacity, actual), format, __VA_ARGS__); \
+            s64 length = snprintf(expected, capacity, format, __VA_ARGS__); \
+            test_expect(t, result.length == length && (capacity == 0 || strcmp(actual, expected) == 0), \
+                "'%s' wrote '%.*s' (%lld) instead of '%.*s' (%lld), capacity %lld", format, \
+                capacity > 0 ? (int)strlen(actual) : 0, actual, (long long)result.length, \
+                capacity > 0 ? (int)strlen(expected) : 0, expected, (long long)length, (long long)capacity); \
+        } while (0)
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-overflow"
+#pragma GCC diagnostic ignored "-Wformat-truncation"
+        TEST_FORMAT_EXPECT("%s|%.3s|%.7s", string, string, string);
+        TEST_FORMAT_EXPECT("[%12s] %c", string, 'x');
+        TEST_FORMAT_EXPECT("%d, %5i, %u%%", integer, integer, (u32)integer);
+        TEST_FORMAT_EXPECT("%lld %hhd %hu", (long long)integer * 3, integer, integer);
+        TEST_FORMAT_EXPECT("%f %.2f %10.3f", real, real, real);
+#pragma GCC diagnostic pop
+
+#undef TEST_FORMAT_EXPECT
+    }
+}
+
+/**
+ * "format_any()" prints the same as snprintf with "%d", "%u" and "%f", with terminator, since callers print its buffer as C string.
+ */
+static void test_format_any(Test *t) {
+    Type_Info s32_type = { .type = INTEGER, .size = 4, .t_integer = { 32, true } };
+    Type_Info u64_type = { .type = INTEGER, .size = 8, .t_integer = { 64, false } };
+    Type_Info f32_type = { .type = FLOAT,   .size = 4, .t_float = { 32 } };
+
+    for (s64 iteration = 0; iteration < TEST_FORMAT_ITERATIONS; iteration++) {
+        char actual[TEST_FORMAT_MAX_LENGTH];
+        char expected[TEST_FORMAT_MAX_LENGTH];
+        s64 capacity = test_random_range(t, 1, TEST_FORMAT_MAX_LENGTH);
+
+        s32 integer = (s32)test_random(t);
+        unsigned long long unsigned_integer = test_random(t);
+        u32 bits = (u32)test_random(t);
+        float real;
+        memcpy(&real, &bits, sizeof(real));
+
+#define TEST_FORMAT_ANY_EXPECT(type, value, format) do { \
+            memset(actual, '#', sizeof(actual)); \
+            String result = format_any((Any) { &type, &value }, STR(capacity, actual)); \
+            s64 length = snprintf(expected, capacity, format, value); \
+            test_expect(t, result.length == length && strcmp(actual, expected) == 0, \
+                "'%s' wrote '%.*s' (%lld) instead of '%s' (%lld), capacity %lld", format, \
+                (int)strnlen(actual, capacity), actual, (long long)result.length, expected, (long long)length, (long long)capacity); \
+        } while (0)
+
+        TEST_FORMAT_ANY_EXPECT(s32_type, integer,             "%d");
+        TEST_FORMAT_ANY_EXPECT(u64_type, unsigned_integer,    "%llu");
+        TEST_FORMAT_ANY_EXPECT(f32_type, real,                "%f");
+
+#undef TEST_FORMAT_ANY_EXPECT
+    }
+}
+
+
+
+/**
+ * Logging.
+ * Bursts bigger than a ring from one thread, and from threads that come and go, have to be written completely.
+ */
+
+#define TEST_LOG_BURST          80000
+#define TEST_LOG_THREADS        4
+#define TEST_LOG_ROUNDS         100
+#define TEST_LOG_THREAD_RECORDS 2000
+
+static void test_log_thread_procedure(void *data) {
+    (void)data;
+    for (s32 i = 0; i < TEST_LOG_THREAD_RECORDS; i++) {
+        LOG_WARNING("Record %d of %s.", i, "short lived thread");
+    }
+}
+
+static s64 test_count_lines(FILE *file) {
+    rewind(file);
+    s64 lines = 0;
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+        lines += c == '\n';
+    }
+    return lines;
+}
+
+static void test_log_burst(Test *t) {
+    FILE *output = tmpfile();
+    if (!test_expect(t, output != NULL, "couldn't create temporary file")) {
+        return;
+    }
+    log_set_output(output);
+
+    for (s32 i = 0; i < TEST_LOG_BURST; i++) {
+        LOG_WARNING("Record %d of %s.", i, "burst");
+    }
+
+    s64 threads_count = 0;
+    for (s32 round = 0; round < TEST_LOG_ROUNDS; round++) {
+        Thread threads[TEST_LOG_THREADS];
+        bool started[TEST_LOG_THREADS];
+        for (s32 i = 0; i < TEST_LOG_THREADS; i++) {
+            started[i] = thread_create(&threads[i], test_log_thread_procedure, NULL);
+            threads_count += started[i];
+        }
+        for (s32 i = 0; i < TEST_LOG_THREADS; i++) {
+            if (started[i]) {
+                thread_join(threads[i]);
+            }
+        }
+    }
+
+    log_set_output(stderr);
+
+    s64 expected = TEST_LOG_BURST + threads_count * TEST_LOG_THREAD_RECORDS;
+    s64 lines = test_count_lines(output);
+    test_expect(t, lines == expected, "%lld records were written instead of %lld", (long long)lines, (long long)expected);
+
+    (void)fclose(output);
+}
+
+
+
+/**
+ * Profiler.
+ * Threads that come and go, more of them than PROFILE_MAX_THREADS, are all profiled, and their zone names are escaped in the trace.
+ */
+
+#define TEST_PROFILE_ROUNDS     8
+#define TEST_PROFILE_THREADS    4
+#define TEST_PROFILE_ZONE       "short \"lived\" \\ thread"
+#define TEST_PROFILE_TRACE      "bin/profile_trace.json"
+
+static void test_profile_thread_procedure(void *data) {
+    (void)data;
+    PROFILE_ZONE(TEST_PROFILE_ZONE);
+}
+
+static void test_profile_threads(Test *t) {
+#ifndef PROFILE_ENABLED
+    test_skip(t, "profiler is compiled out");
+    return;
+#else
+    // Drops what earlier tests recorded, so it doesn't push events of this one out of the frame.
+    profile_frame_end();
+
+    for (s32 round = 0; round < TEST_PROFILE_ROUNDS; round++) {
+        Thread threads[TEST_PROFILE_THREADS];
+        bool started[TEST_PROFILE_THREADS];
+        s64 started_count = 0;
+        for (s32 i = 0; i < TEST_PROFILE_THREADS; i++) {
+            started[i] = thread_create(&threads[i], test_profile_thread_procedure, NULL);
+            started_count += started[i];
+        }
+        for (s32 i = 0; i < TEST_PROFILE_THREADS; i++) {
+            if (started[i]) {
+                thread_join(threads[i]);
+            }
+        }
+
+        profile_frame_end();
+
+        Profile_Frame *frame = profile_frame_get(0);
+        s64 recorded = 0;
+        for (s64 i = 0; i < frame->event_count; i++) {
+            recorded += strcmp(frame->events[i].name, TEST_PROFILE_ZONE) == 0;
+        }
+        test_expect(t, recorded == started_count, "round %d recorded %lld zones of %lld threads", round, (long long)recorded, (long long)started_count);
+    }
+
+    if (!test_expect(t, profile_dump_chrome_trace(TEST_PROFILE_TRACE), "couldn't write '%s'", TEST_PROFILE_TRACE)) {
+        return;
+    }
+
+    FILE *trace = fopen(TEST_PROFILE_TRACE, "r");
+    if (!test_expect(t, trace != NULL, "couldn't read '%s'", TEST_PROFILE_TRACE)) {
+        return;
+    }
+
+    char line[256];
+    bool escaped = false;
+    while (!escaped && fgets(line, sizeof(line), trace) != NULL) {
+        escaped = strstr(line, "\"name\":\"short \\\"lived\\\" \\\\ thread\"") != NULL;
+    }
+    (void)fclose(trace);
+
+    test_expect(t, escaped, "zone name isn't escaped in '%s'", TEST_PROFILE_TRACE);
+#endif
+}
+
+
+
+
+Test_Case test_cases_core[] = {
+    { "str_scanning",                   test_str_scanning },
+    { "str_format",                     test_str_format },
+    { "format_any",                     test_format_any },
+    { "log_burst",                      test_log_burst },
+    { "profile_threads",                test_profile_threads },
+
+    { "num_f32_round_trip",             test_num_f32_round_trip },
+    { "num_f32_round_trip_exhaustive",  test_num_f32_round_trip_exhaustive,     .exhaustive = true },
+};
+
+s64 test_cases_core_count = sizeof(test_cases_core) / sizeof(test_cases_core[0]);
@@ -0,0 +1,601 @@
+#include "test/test.h"
+
+#include "game/atlas.h"
+#include "game/graphics.h"
+#include "game/particles.h"
+
+#include "core/core.h"
+#include "core/type.h"
+#include "core/mathf.h"
+#include "core/file.h"
+#include "core/structs.h"
+#include "core/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+
+/**
+ * Skyline packer.
+ * Random rects are packed until packer is full, every placed rect has to be inside of the area and not overlap any other.
+ */
+
+#define TEST_SKYLINE_ROUNDS     200
+#define TEST_SKYLINE_MAX_RECTS  4096
+
+typedef struct test_rect {
+    s32 x;
+    s32 y;
+    s32 width;
+    s32 height;
+} Test_Rect;
+
+static bool test_rects_overlap(Test_Rect *a, Test_Rect *b) {
+    return a->x < b->x + b->width && b->x < a->x + a->width && a->y < b->y + b->height && b->y < a->y + a->height;
+}
+
+static void test_skyline_pack(Test *t) {
+    static Skyline skyline;
+    static Test_Rect rects[TEST_SKYLINE_MAX_RECTS];
+
+    for (s32 round = 0; round < TEST_SKYLINE_ROUNDS; round++) {
+        s32 width = (s32)test_random_range(t, 1, 512);
+        s32 height = (s32)test_random_range(t, 1, 512);
+        skyline_init(&skyline, width, height);
+
+        // Some rounds pack rects of similar size, like glyphs, others of any size up to the whole area.
+        s32 max_size = test_random(t) % 2 ? 16 : maxi(width, height) + 1;
+        s32 rects_count = 0;
+        s32 misses = 0;
+
+        while (rects_count < TEST_SKYLINE_MAX_RECTS && misses < 64) {
+            Test_Rect rect = {
+                .width  = (s32)test_random_range(t, 1, max_size),
+                .height = (s32)test_random_range(t, 1, max_size),
+            };
+
+            if (!skyline_pack(&skyline, rect.width, rect.height, &rect.x, &rect.y)) {
+                misses++;
+                continue;
+            }
+
+            bool inside = rect.x >= 0 && rect.y >= 0 && rect.x + rect.width <= width && rect.y + rect.height <= height;
+            test_expect(t, inside, "round %d: %dx%d rect placed at %d, %d, outside of %dx%d area", round, rect.width, rect.height, rect.x, rect.y, width, height);
+
+            for (s32 i = 0; i < rects_count; i++) {
+                test_expect(t, !test_rects_overlap(&rect, &rects[i]), "round %d: %dx%d rect at %d, %d overlaps %dx%d rect at %d, %d",
+                    round, rect.width, rect.height, rect.x, rect.y, rects[i].width, rects[i].height, rects[i].x, rects[i].y);
+            }
+
+            rects[rects_count++] = rect;
+        }
+
+        // Nodes always cover the whole width without gaps.
+        s32 x = 0;
+        for (s32 i = 0; i < skyline.nodes_count; i++) {
+            test_expect(t, skyline.nodes[i].x == x && skyline.nodes[i].width > 0, "round %d: node %d is at %d with width %d, expected at %d",
+                round, i, skyline.nodes[i].x, skyline.nodes[i].width, x);
+            x = skyline.nodes[i].x + skyline.nodes[i].width;
+        }
+        test_expect(t, x == width, "round %d: nodes end at %d, area width is %d", round, x, width);
+    }
+
+    // Rects that can't fit are refused.
+    skyline_init(&skyline, 64, 64);
+    s32 x, y;
+    test_expect(t, !skyline_pack(&skyline, 65, 1, &x, &y), "rect wider than area was packed");
+    test_expect(t, !skyline_pack(&skyline, 1, 65, &x, &y), "rect taller than area was packed");
+    test_expect(t, !skyline_pack(&skyline, 0, 1, &x, &y), "empty rect was packed");
+    test_expect(t, skyline_pack(&skyline, 64, 64, &x, &y) && x == 0 && y == 0, "rect of the whole area wasn't packed at 0, 0");
+    test_expect(t, !skyline_pack(&skyline, 1, 1, &x, &y), "rect was packed into full area");
+}
+
+
+
+
+/**
+ * Software frame.
+ * Fixed scene is drawn by software backend without window and compared with checked in reference, "-update" rewrites the reference.
+ * Scene is untextured, since software backend reads textures back from GL.
+ */
+
+#define TEST_FRAME_WIDTH        64
+#define TEST_FRAME_HEIGHT       48
+#define TEST_FRAME_TOLERANCE    2       // Per channel, rasterizer can round a bit differently between compilers.
+#define TEST_FRAME_REFERENCE    "src/test/reference/software_frame.ppm"
+#define TEST_FRAME_OUTPUT       "bin/software_frame.ppm"
+
+static void test_frame_quad(float x0, float y0, float x1, float y1, Vec4f color) {
+    u32 packed = vertex_pack_color(color);
+    Quad_Vertex quad[VERTICIES_PER_QUAD] = {
+        { .position = { x0, y0 }, .color = packed, .texture = VERTEX_SLOT_NONE, .mask = VERTEX_SLOT_NONE },
+        { .position = { x1, y0 }, .color = packed, .texture = VERTEX_SLOT_NONE, .mask = VERTEX_SLOT_NONE },
+        { .position = { x0, y1 }, .color = packed, .texture = VERTEX_SLOT_NONE, .mask = VERTEX_SLOT_NONE },
+        { .position = { x1, y1 }, .color = packed, .texture = VERTEX_SLOT_NONE, .mask = VERTEX_SLOT_NONE },
+    };
+    draw_quad_data((float *)quad, 1);
+}
+
+static void test_software_frame(Test *t) {
+    graphics_init_headless();
+    render_backend_set(RENDER_BACKEND_SOFTWARE, TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT);
+    render_clear_color_set(vec4f_make(0.1f, 0.1f, 0.15f, 1.0f));
+
+    // Only fields render queue uses, ids differ so commands have different state.
+    Matrix4f projection = screen_calculate_projection(TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT);
+    Shader quad_shader_a    = { .id = 1, .vertex_stride = QUAD_VERTEX_STRIDE, .projection = projection };
+    Shader quad_shader_b    = { .id = 2, .vertex_stride = QUAD_VERTEX_STRIDE, .projection = projection };
+    Shader line_shader      = { .id = 3, .vertex_stride = 7, .projection = projection };
+    Quad_Drawer quad_drawer_a   = { .program = &quad_shader_a };
+    Quad_Drawer quad_drawer_b   = { .program = &quad_shader_b };
+    Line_Drawer line_drawer     = { .program = &line_shader };
+
+    // Submitted out of layer order.
+    render_layer_set(RENDER_LAYER_UI);
+    draw_begin(&quad_drawer_b);
+    test_frame_quad(2.0f, 2.0f, 14.0f, 10.0f, vec4f_make(1.0f, 0.9f, 0.2f, 1.0f));
+    draw_end();
+
+    // Translucent quads overlap with different shaders, blue one is submitted later, so it should be on top of red one.
+    render_layer_set(RENDER_LAYER_WORLD);
+    draw_begin(&quad_drawer_a);
+    test_frame_quad(4.0f, 4.0f, 60.0f, 44.0f, vec4f_make(0.2f, 0.6f, 0.3f, 1.0f));
+    draw_end();
+
+    draw_begin(&quad_drawer_b);
+    test_frame_quad(10.0f, 10.0f, 40.0f, 34.0f, vec4f_make(1.0f, 0.1f, 0.1f, 0.6f));
+    draw_end();
+
+    draw_begin(&quad_drawer_a);
+    test_frame_quad(24.0f, 18.0f, 54.0f, 40.0f, vec4f_make(0.1f, 0.2f, 1.0f, 0.6f));
+    draw_end();
+
+    float lines[2 * 7] = {
+        6.0f,  42.0f, 0.0f,     1.0f, 1.0f, 1.0f, 1.0f,
+        58.0f, 6.0f,  0.0f,     1.0f, 1.0f, 1.0f, 0.8f,
+    };
+    line_draw_begin(&line_drawer);
+    draw_line_data(lines, 1);
+    line_draw_end();
+
+    Window_Info window = { .ptr = NULL, .width = TEST_FRAME_WIDTH, .height = TEST_FRAME_HEIGHT };
+    render_present(&window);
+
+    char *path = t->update_references ? TEST_FRAME_REFERENCE : TEST_FRAME_OUTPUT;
+    bool saved = render_software_save(path);
+    render_backend_set(RENDER_BACKEND_GL, 0, 0);
+    if (!test_expect(t, saved, "couldn't save frame into '%s'", path) || t->update_references) {
+        return;
+    }
+
+    u64 frame_size, reference_size;
+    u8 *frame = read_file_into_buffer(TEST_FRAME_OUTPUT, &frame_size, &std_allocator);
+    u8 *reference = read_file_into_buffer(TEST_FRAME_REFERENCE, &reference_size, &std_allocator);
+
+    char header[32];
+    u64 header_length = (u64)snprintf(header, sizeof(header), "P6\n%d %d\n255\n", TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT);
+    u64 size = header_length + TEST_FRAME_WIDTH * TEST_FRAME_HEIGHT * 3;
+
+    if (test_expect(t, reference != NULL && reference_size == size && memcmp(reference, header, header_length) == 0, "reference '%s' is missing or isn't %dx%d PPM",
+            TEST_FRAME_REFERENCE, TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT)
+        && test_expect(t, frame != NULL && frame_size == size, "frame '%s' isn't %dx%d PPM", TEST_FRAME_OUTPUT, TEST_FRAME_WIDTH, TEST_FRAME_HEIGHT)) {
+
+        s64 mismatches = 0;
+        s64 first = -1;
+        for (u64 i = header_length; i < size; i++) {
+            if (abs((s32)frame[i] - (s32)reference[i]) > TEST_FRAME_TOLERANCE) {
+                first = first < 0 ? (s64)(i - header_length) / 3 : first;
+                mismatches++;
+            }
+        }
+        test_expect(t, mismatches == 0, "%lld channels differ from reference, first at pixel %lld, %lld (from the top), frame is left in '%s'",
+            (long long)mismatches, (long long)(first % TEST_FRAME_WIDTH), (long long)(first / TEST_FRAME_WIDTH), TEST_FRAME_OUTPUT);
+    }
+
+    if (frame != NULL) {
+        allocator_free(&std_allocator, frame);
+    }
+    if (reference != NULL) {
+        allocator_free(&std_allocator, reference);
+    }
+}
+
+
+
+/**
+ * Draw lists.
+ * Several threads record quads into lists of their own at the same time, after merging submitted quads should be in list order,
+ * each list's quads in the order they were recorded, with slots pointing at the same textures they were recorded with.
+ * Quad's position is its list and index, so where it ended up tells where it came from.
+ */
+
+#define TEST_DRAW_LISTS         6
+#define TEST_DRAW_LIST_QUADS    1000    // List "i" records "i" times that many, first one stays empty.
+#define TEST_DRAW_SHARED_ID     7
+#define TEST_DRAW_PAUSE_QUADS   250     // Jobs pause that often, so they interleave even on a single core.
+
+typedef struct test_draw_job {
+    Draw_List *list;
+    s32 index;
+    atomic_bool *go;
+} Test_Draw_Job;
+
+// Texture and mask every quad is recorded with, mask is NULL for some of them, texture ids of different lists partly overlap.
+static void test_draw_quad_textures(s32 list, s32 quad, Texture *texture, Texture *mask) {
+    *texture = (Texture) { .id = (quad + list) % 3 == 0 ? TEST_DRAW_SHARED_ID : 100 + list };
+    *mask = (Texture) { .id = 200 + list, .distance_field = quad % 4 == 1 };
+}
+
+static void test_draw_job_procedure(void *data) {
+    Test_Draw_Job *job = data;
+
+    // All jobs record at once.
+    while (!atomic_load(job->go)) {
+        thread_yield();
+    }
+
+    draw_list_begin(job->list);
+    for (s32 q = 0; q < job->index * TEST_DRAW_LIST_QUADS; q++) {
+        if (q % TEST_DRAW_PAUSE_QUADS == 0) {
+            thread_sleep_ms(1);
+        }
+
+        Texture texture, mask;
+        test_draw_quad_textures(job->index, q, &texture, &mask);
+
+        Quad_Vertex vertex = {
+            .position   = { (float)job->index, (float)q },
+            .color      = 0xFFFFFFFF,
+            .texture    = vertex_pack_slot(add_texture_to_slots(&texture)),
+            .mask       = q % 2 ? vertex_pack_mask_slot(&mask) : VERTEX_SLOT_NONE,
+        };
+        Quad_Vertex quad[VERTICIES_PER_QUAD] = { vertex, vertex, vertex, vertex };
+        draw_quad_data((float *)quad, 1);
+    }
+    draw_list_end();
+}
+
+static void test_draw_lists(Test *t) {
+    graphics_init_headless();
+
+    Shader shader = { .id = 1, .vertex_stride = QUAD_VERTEX_STRIDE };
+    Quad_Drawer drawer = { .program = &shader };
+
+    Draw_List lists[TEST_DRAW_LISTS];
+    Test_Draw_Job jobs[TEST_DRAW_LISTS];
+    Thread threads[TEST_DRAW_LISTS];
+    bool started[TEST_DRAW_LISTS];
+    atomic_bool go = false;
+
+    draw_begin(&drawer);
+
+    for (s32 i = 0; i < TEST_DRAW_LISTS; i++) {
+        lists[i] = draw_list_make();
+        jobs[i] = (Test_Draw_Job) { .list = &lists[i], .index = i, .go = &go };
+        started[i] = thread_create(&threads[i], test_draw_job_procedure, &jobs[i]);
+        test_expect(t, started[i], "couldn't start thread %d", i);
+    }
+    atomic_store(&go, true);
+
+    for (s32 i = 0; i < TEST_DRAW_LISTS; i++) {
+        if (started[i]) {
+            thread_join(threads[i]);
+        }
+    }
+
+    // Merged quads are taken from the cache, it holds exactly what was submitted, with texture ids of the shared slots.
+    Draw_List submitted = draw_list_make();
+    draw_lists_merge(lists, TEST_DRAW_LISTS);
+    draw_end_cached(&submitted);
+
+    u32 expected_quads = 0;
+    for (s32 i = 0; i < TEST_DRAW_LISTS; i++) {
+        expected_quads += started[i] ? i * TEST_DRAW_LIST_QUADS : 0;
+    }
+
+    u32 quads = array_list_length(&submitted.verticies) / QUAD_VERTEX_STRIDE / VERTICIES_PER_QUAD;
+    if (test_expect(t, quads == expected_quads, "%u quads were submitted instead of %u", quads, expected_quads)) {
+        Quad_Vertex *vertex = (Quad_Vertex *)submitted.verticies;
+
+        for (s32 i = 0; i < TEST_DRAW_LISTS; i++) {
+            for (s32 q = 0; started[i] && q < i * TEST_DRAW_LIST_QUADS; q++, vertex += VERTICIES_PER_QUAD) {
+                if (!test_expect(t, vertex->position.x == (float)i && vertex->position.y == (float)q, "quad %d of list %d is quad %d of list %d",
+                        (s32)vertex->position.y, (s32)vertex->position.x, q, i)) {
+                    continue;
+                }
+
+                Texture texture, mask;
+                test_draw_quad_textures(i, q, &texture, &mask);
+
+                u8 texture_slot = vertex->texture;
+                test_expect(t, texture_slot < submitted.textures_count && submitted.textures[texture_slot] == texture.id,
+                    "quad %d of list %d has texture slot %u, expected texture %u", q, i, texture_slot, texture.id);
+
+                if (q % 2 == 0) {
+                    test_expect(t, vertex->mask == VERTEX_SLOT_NONE, "quad %d of list %d got mask slot %u", q, i, vertex->mask);
+                    continue;
+                }
+
+                u8 mask_slot = vertex->mask & ~VERTEX_SLOT_DISTANCE_FIELD;
+                bool distance_field = (vertex->mask & VERTEX_SLOT_DISTANCE_FIELD) != 0;
+                test_expect(t, mask_slot < submitted.textures_count && submitted.textures[mask_slot] == mask.id && distance_field == mask.distance_field,
+                    "quad %d of list %d has mask slot %u, expected mask %u", q, i, vertex->mask, mask.id);
+            }
+        }
+    }
+
+    // Frame is dropped, there is no window to draw into.
+    Window_Info window = {0};
+    render_present(&window);
+
+    draw_list_free(&submitted);
+    for (s32 i = 0; i < TEST_DRAW_LISTS; i++) {
+        draw_list_free(&lists[i]);
+    }
+}
+
+
+
+/**
+ * Vertex stream wrap.
+ * Needs GL context, test.exe is built with orphan mode of the stream, where wrapping the ring orphans the buffer, so draws that read
+ * verticies written before have to be issued before it. Frame with merged draws, long enough to wrap the ring, is traced,
+ * and between writes and the orphaning that follows them there has to be a draw.
+ */
+
+#define TEST_STREAM_COMMANDS    80
+#define TEST_STREAM_QUADS       1000    // Quad is 80 bytes, so all commands together take more than 4 MB ring.
+#define TEST_STREAM_TRACE       "bin/vertex_stream_trace.txt"
+
+/**
+ * Makes hidden 64x64 window with current GL context, skips the test and returns false if there is none.
+ */
+static bool test_gl_context_make(Test *t, SDL_Window **sdl_window, SDL_GLContext *context) {
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        test_skip(t, "SDL video couldn't initialize");
+        return false;
+    }
+
+    (void)SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    (void)SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    (void)SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+    *sdl_window = SDL_CreateWindow("test", 0, 0, 64, 64, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    *context = *sdl_window != NULL ? SDL_GL_CreateContext(*sdl_window) : NULL;
+    if (*context == NULL || SDL_GL_MakeCurrent(*sdl_window, *context) < 0 || glewInit() != GLEW_OK) {
+        test_skip(t, "there is no GL context");
+        if (*context != NULL) {
+            SDL_GL_DeleteContext(*context);
+        }
+        if (*sdl_window != NULL) {
+            SDL_DestroyWindow(*sdl_window);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+static void test_vertex_stream_wrap(Test *t) {
+    SDL_Window *sdl_window;
+    SDL_GLContext context;
+    if (!test_gl_context_make(t, &sdl_window, &context)) {
+        return;
+    }
+
+    graphics_init();
+
+    Shader shader = shader_load("res/shader/quad.glsl");
+    if (!test_expect(t, shader.id != 0, "couldn't load 'res/shader/quad.glsl', tests should run from the project root")) {
+        return;
+    }
+
+    Quad_Drawer drawer;
+    drawer_init(&drawer, &shader);
+
+    Matrix4f projection = screen_calculate_projection(64, 64);
+    shader_update_projection(&shader, &projection);
+
+    static Quad_Vertex quads[TEST_STREAM_QUADS * VERTICIES_PER_QUAD];
+    for (s32 i = 0; i < TEST_STREAM_QUADS * VERTICIES_PER_QUAD; i++) {
+        quads[i] = (Quad_Vertex) {
+            .position   = { (float)(i % 64), (float)(i / 4 % 64) },
+            .color      = 0xFFFFFFFF,
+            .texture    = VERTEX_SLOT_NONE,
+            .mask       = VERTEX_SLOT_NONE,
+        };
+    }
+
+    // Commands of the same state, so their writes are merged into pending draws.
+    for (s32 c = 0; c < TEST_STREAM_COMMANDS; c++) {
+        draw_begin(&drawer);
+        draw_quad_data((float *)quads, TEST_STREAM_QUADS);
+        draw_end();
+    }
+
+    Window_Info window = { .ptr = sdl_window, .width = 64, .height = 64 };
+    if (test_expect(t, graphics_trace_frame(TEST_STREAM_TRACE), "couldn't trace into '%s'", TEST_STREAM_TRACE)) {
+        render_present(&window);
+
+        FILE *trace = fopen(TEST_STREAM_TRACE, "r");
+        if (test_expect(t, trace != NULL, "couldn't read '%s'", TEST_STREAM_TRACE)) {
+            char line[256];
+            s32 line_number = 0;
+            s32 orphans = 0;
+            bool written = false;
+
+            while (fgets(line, sizeof(line), trace) != NULL) {
+                line_number++;
+                if (strncmp(line, "glBufferSubData(", 16) == 0) {
+                    written = true;
+                } else if (strncmp(line, "glDraw", 6) == 0) {
+                    written = false;
+                } else if (strncmp(line, "glBufferData(", 13) == 0 && strstr(line, "NULL") != NULL) {
+                    orphans++;
+                    test_expect(t, !written, "'%s' line %d: buffer is orphaned before verticies written into it were drawn", TEST_STREAM_TRACE, line_number);
+                }
+            }
+            test_expect(t, orphans > 0, "stream wasn't wrapped, there is no orphaning in '%s'", TEST_STREAM_TRACE);
+
+            (void)fclose(trace);
+        }
+    }
+
+    drawer_free(&drawer);
+    shader_unload(&shader);
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(sdl_window);
+}
+
+
+
+
+/**
+ * Atlas repack.
+ * Needs GL context. Image reloaded with different size repacks the atlas, which decodes images on the load worker,
+ * so handles keep old images until "texture_loads_update()" gets all of them, and then every handle shows its own pixels.
+ */
+
+#define TEST_ATLAS_IMAGE_A      "bin/test_atlas_a.ppm"
+#define TEST_ATLAS_IMAGE_B      "bin/test_atlas_b.ppm"
+#define TEST_ATLAS_MAX_FRAMES   1000
+
+static bool test_atlas_image_write(char *path, s32 size, u8 r, u8 g, u8 b) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    fprintf(file, "P6\n%d %d\n255\n", size, size);
+    for (s32 i = 0; i < size * size; i++) {
+        u8 pixel[3] = { r, g, b };
+        fwrite(pixel, 1, sizeof(pixel), file);
+    }
+    return fclose(file) == 0;
+}
+
+static void test_atlas_texture_expect(Test *t, Texture *texture, u8 *page, s32 size, u8 r, u8 g, u8 b) {
+    test_expect(t, texture->width == size && texture->height == size, "texture is %dx%d, expected %dx%d", texture->width, texture->height, size, size);
+
+    s32 x = (s32)((texture->region.uv0.x + texture->region.uv1.x) * 0.5f * ATLAS_PAGE_SIZE);
+    s32 y = (s32)((texture->region.uv0.y + texture->region.uv1.y) * 0.5f * ATLAS_PAGE_SIZE);
+    u8 *pixel = page + ((u64)y * ATLAS_PAGE_SIZE + x) * 4;
+    test_expect(t, pixel[0] == r && pixel[1] == g && pixel[2] == b, "texture center is (%d, %d, %d), expected (%d, %d, %d)", pixel[0], pixel[1], pixel[2], r, g, b);
+}
+
+static void test_atlas_repack(Test *t) {
+    SDL_Window *sdl_window;
+    SDL_GLContext context;
+    if (!test_gl_context_make(t, &sdl_window, &context)) {
+        return;
+    }
+
+    graphics_init();
+    atlas_init();
+
+    if (!test_expect(t, test_atlas_image_write(TEST_ATLAS_IMAGE_A, 8, 255, 0, 0) && test_atlas_image_write(TEST_ATLAS_IMAGE_B, 4, 0, 255, 0), "couldn't write test images into 'bin/'")) {
+        return;
+    }
+
+    Texture *a = atlas_texture_load(TEST_ATLAS_IMAGE_A);
+    Texture *b = atlas_texture_load(TEST_ATLAS_IMAGE_B);
+    if (!test_expect(t, a != NULL && b != NULL, "couldn't load test images")) {
+        return;
+    }
+
+    (void)test_atlas_image_write(TEST_ATLAS_IMAGE_B, 16, 0, 0, 255);
+    (void)atlas_texture_load(TEST_ATLAS_IMAGE_B);
+    test_expect(t, b->width == 4, "repack didn't wait for decodes, reloaded image is already %dx%d", b->width, b->height);
+
+    for (s32 frame = 0; frame < TEST_ATLAS_MAX_FRAMES && texture_loads_pending() > 0; frame++) {
+        texture_loads_update();
+        thread_sleep_ms(1);
+    }
+    test_expect(t, texture_loads_pending() == 0, "images weren't decoded in %d frames", TEST_ATLAS_MAX_FRAMES);
+
+    Texture_Load_Completion completion;
+    while (texture_load_completed(&completion)) {
+        test_expect(t, !completion.failed, "couldn't decode '%s'", completion.path);
+    }
+
+    if (test_expect(t, a->id == b->id, "test images should fit on one page")) {
+        u8 *page = malloc(ATLAS_PAGE_SIZE * ATLAS_PAGE_SIZE * 4);
+        glBindTexture(GL_TEXTURE_2D, a->id);
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, page);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        test_atlas_texture_expect(t, a, page, 8, 255, 0, 0);
+        test_atlas_texture_expect(t, b, page, 16, 0, 0, 255);
+        free(page);
+    }
+
+    atlas_free();
+    SDL_GL_DeleteContext(context);
+    SDL_DestroyWindow(sdl_window);
+}
+
+
+
+/**
+ * Particles update.
+ * Every particle carries its index in "size", some of them die in each update, and afterwards exactly the alive ones have to be left,
+ * whichever block they were in and whichever thread updated it.
+ */
+
+#define TEST_PARTICLES_ROUNDS       20
+#define TEST_PARTICLES_CAPACITY     (PARTICLES_BLOCK * 4 + 1000)
+
+static void test_particles_update(Test *t) {
+    static bool alive[TEST_PARTICLES_CAPACITY];
+    static bool seen[TEST_PARTICLES_CAPACITY];
+
+    Particles particles;
+    particles_init(&particles, TEST_PARTICLES_CAPACITY, 3);
+
+    for (s32 round = 0; round < TEST_PARTICLES_ROUNDS; round++) {
+        particles.count = 0;
+
+        // Rounds die from none to all, so blocks are left full, empty and partly full.
+        u32 count = (u32)test_random_range(t, 0, TEST_PARTICLES_CAPACITY);
+        u32 dead_percent = round == 0 ? 0 : round == 1 ? 100 : (u32)test_random_range(t, 0, 100);
+        u32 alive_count = 0;
+        for (u32 i = 0; i < count; i++) {
+            alive[i] = (u32)test_random_range(t, 0, 99) >= dead_percent;
+            alive_count += alive[i];
+            particles_add(&particles, VEC2F_ORIGIN, VEC2F_ORIGIN, alive[i] ? 2.0f : 0.5f, (float)i, VEC4F_WHITE, VEC4F_BLACK);
+        }
+
+        particles_update(&particles, 1.0f);
+
+        if (!test_expect(t, particles.count == alive_count, "round %d: %u particles left of %u, expected %u", round, particles.count, count, alive_count)) {
+            continue;
+        }
+
+        memset(seen, 0, sizeof(seen));
+        for (u32 i = 0; i < particles.count; i++) {
+            u32 index = (u32)particles.size[i];
+            if (!test_expect(t, index < count && alive[index] && !seen[index], "round %d: particle %u at %u is dead or left twice", round, index, i)) {
+                break;
+            }
+            seen[index] = true;
+            test_expect(t, particles.life[i] == 1.0f, "round %d: particle %u has life %f, its fields were mixed up", round, index, particles.life[i]);
+        }
+    }
+
+    particles_free(&particles);
+}
+
+
+
+Test_Case test_cases_game[] = {
+    { "skyline_pack",                   test_skyline_pack },
+    { "software_frame",                 test_software_frame },
+    { "draw_lists",                     test_draw_lists },
+    { "vertex_stream_wrap",             test_vertex_stream_wrap },
+    { "atlas_repack",                   test_atlas_repack },
+    { "particles_update",               test_particles_update },
+};
+
+s64 test_cases_game_count = sizeof(test_cases_game) / sizeof(test_cases_game[0]);